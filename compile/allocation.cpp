@@ -86,11 +86,6 @@ std::stringstream compiler::allocate(const Allocation& alloc_stmt) {
 			alloc_data.get_qualities().add_quality(SymbolQuality::STATIC);
 		}
 
-		// we have some special things we need to do when we allocate constants
-		if (alloc_data.get_qualities().is_const()) {
-			// todo: evaluate the constant and add it to the constant table
-		}
-
 		// perform the allocation
 		if (alloc_data.get_qualities().is_dynamic()) {
             // if we have a const here, throw an exception -- constants may not be dynamic
@@ -145,8 +140,7 @@ std::stringstream compiler::allocate(const Allocation& alloc_stmt) {
 
 			// ensure we handle alloc-init for dynamic objects
 			if (alloc_stmt.was_initialized()) {
-				auto initial_value = alloc_stmt.get_initial_value();
-				allocation_ss << this->handle_alloc_init(allocated, *initial_value, alloc_stmt.get_line_number()).str();
+				allocation_ss << this->handle_alloc_init(alloc_stmt, allocated).str();
 
 				allocated.set_initialized();
 			}
@@ -161,8 +155,12 @@ std::stringstream compiler::allocate(const Allocation& alloc_stmt) {
 			// we need to determine the width suffix (db, dw, resb, resw, etc)
 			size_t w = allocated.get_data_type().get_width();
 
+			// vectors are written lane by lane
+			if (allocated.get_data_type().get_primary() == VECTOR) {
+				w = allocated.get_data_type().get_subtype().get_width();
+			}
 			// since arrays must contain a known-width type, we can just get the width of the subtype
-			if (allocated.get_data_type().get_primary() == ARRAY) {
+			else if (allocated.get_data_type().get_primary() == ARRAY) {
                 const DataType &subtype = allocated.get_data_type().get_subtype();
                 if (subtype.get_qualities().is_dynamic()) {
                     w = sin_widths::PTR_WIDTH;
@@ -205,20 +203,41 @@ std::stringstream compiler::allocate(const Allocation& alloc_stmt) {
 			// form the instruction
 			if (alloc_data.get_primary() == ARRAY) {
 				alloc_instruction << allocated.get_name() << " dd " <<
-					std::to_string(allocated.get_data_type().get_array_length()) << std::endl;
+					std::to_string(alloc_data.get_array_length()) << std::endl;
 				
 				// if the array was initialized, supply our array; else, initialize to a zeroed array
 				if (alloc_stmt.was_initialized()) {
 					alloc_instruction << "d" << width_suffix << " " << initial_value << std::endl;
 				}
 				else {
-					alloc_instruction << "times " << allocated.get_data_type().get_array_length() <<
+					alloc_instruction << "times " << alloc_data.get_array_length() <<
 						" d" << width_suffix << " 0" << std::endl;
 				}
 			}
 			else if (alloc_data.get_primary() == STRUCT) {
 				alloc_instruction << allocated.get_name() << " times " << data_width << " db 0" << std::endl;
 			}
+			else if (alloc_data.get_primary() == VECTOR) {
+				// vectors may be initialized with a value for each lane or a single value for all of them
+				if (!initial_value.empty() && alloc_stmt.get_initial_value()->get_expression_type() == LIST) {
+					if (static_cast<const ListExpression&>(*alloc_stmt.get_initial_value()).get_list().size() != alloc_data.get_array_length()) {
+						throw CompilerException(
+							"Expected " + std::to_string(alloc_data.get_array_length()) + " values for vector (one per lane)",
+							compiler_errors::TYPE_ERROR,
+							alloc_stmt.get_line_number()
+						);
+					}
+
+					initial_value.pop_back();	// lists have a trailing comma
+					alloc_instruction << allocated.get_name() << " d" << width_suffix << " " << initial_value << std::endl;
+				}
+				else if (!initial_value.empty()) {
+					alloc_instruction << allocated.get_name() << " times " << alloc_data.get_array_length() << " d" << width_suffix << " " << initial_value << std::endl;
+				}
+				else {
+					alloc_instruction << allocated.get_name() << " res" << width_suffix << " " << alloc_data.get_array_length() << std::endl;
+				}
+			}
 			else {
 				if (alloc_stmt.was_initialized()) {
 					alloc_instruction << allocated.get_name() << " d" << width_suffix << " " << initial_value << std::endl;
@@ -235,7 +254,8 @@ std::stringstream compiler::allocate(const Allocation& alloc_stmt) {
 			}
 			else if (
 				(allocated.was_initialized() && alloc_stmt.get_initial_value()->is_const()) ||
-				alloc_data.get_primary() == ARRAY
+				alloc_data.get_primary() == ARRAY ||
+				(alloc_data.get_primary() == VECTOR && !initial_value.empty())
 			) {
 				// static, non-const, initialized data
 				this->data_segment << alloc_instruction.str() << std::endl;
@@ -256,6 +276,11 @@ std::stringstream compiler::allocate(const Allocation& alloc_stmt) {
 			// add the symbol to the table
 			if (alloc_stmt.was_initialized()) allocated.set_initialized();
 			this->add_symbol(allocated, alloc_stmt.get_line_number());
+
+			// global constants may be used in other compile-time constants, including the functions those call
+			if (alloc_data.get_qualities().is_const() && this->current_scope_name == "global") {
+				this->evaluator.add_constant(alloc_stmt, allocated);
+			}
 		}
 		else {
 			// must be automatic memory
@@ -325,11 +350,8 @@ std::stringstream compiler::allocate(const Allocation& alloc_stmt) {
 
 			// initialize it, if necessary
 			if (alloc_stmt.was_initialized()) {
-				// get the initial value
-				auto &initial_value = *alloc_stmt.get_initial_value();
-
-				// make an assignment of 'initial_value' to 'allocated'
-				allocation_ss << this->handle_alloc_init(allocated, initial_value, alloc_stmt.get_line_number()).str();
+				// make an assignment of the initial value to 'allocated'
+				allocation_ss << this->handle_alloc_init(alloc_stmt, allocated).str();
 
 				// mark the symbol as initialized
 				allocated.set_initialized();
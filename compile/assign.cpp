@@ -41,22 +41,52 @@ std::stringstream compiler::handle_assignment(const Assignment &a) {
 
     std::stringstream handle_ss;
 
+    // a string or dynamic array on its last use may hand its buffer over instead of being copied
+    if (
+        a.get_statement_type() == ASSIGNMENT &&
+        a.get_lvalue().get_expression_type() == IDENTIFIER &&
+        this->is_moved_assignment(lhs_type, a.get_rvalue())
+    ) {
+        return this->move_buffer(this->symbols.find(static_cast<const Identifier&>(a.get_lvalue()).getValue()), a.get_rvalue(), a.get_line_number());
+    }
+
+    // strings and dynamic arrays may share their buffers; if so, one that is shared must be copied before it is modified
+    if (!this->shared_names.empty()) {
+        std::string root = cow_util::get_root(a.get_lvalue());
+        if (this->shared_names.count(root) && cow_util::is_shareable(this->symbols.find(root).get_data_type())) {
+            symbol &dest = this->symbols.find(root);
+            if (
+                a.get_statement_type() == ASSIGNMENT &&
+                a.get_lvalue().get_expression_type() == IDENTIFIER &&
+                this->is_shared_assignment(root, dest.get_data_type(), a.get_rvalue())
+            ) {
+                return this->share_buffer(dest, this->symbols.find(static_cast<const Identifier&>(a.get_rvalue()).getValue()));
+            }
+            else if (!this->unique_names.count(root)) {
+                handle_ss << this->ensure_unique(root).str();
+            }
+        }
+    }
+
     // if we have an indexed expression as the lvalue, we need a special case (for code generation)
     if (a.get_lvalue().get_expression_type() == INDEXED) {
         // make sure that the type is actually indexable/subscriptable
         auto &idx = static_cast<const Indexed&>(a.get_lvalue());
-        if (!is_subscriptable(
-                expression_util::get_expression_data_type(
-                    idx.get_to_index(), 
-                    this->symbols, 
-                    this->structs,
-                    a.get_line_number()
-                ).get_primary()
-            )
-        ) {
+        DataType to_index_type = expression_util::get_expression_data_type(
+            idx.get_to_index(),
+            this->symbols,
+            this->structs,
+            a.get_line_number()
+        );
+        if (!is_subscriptable(to_index_type.get_primary())) {
             throw TypeNotSubscriptableException(a.get_line_number());
         }
 
+        // a vector assigned to an array element is stored to that element and those following it
+        if (to_index_type.get_primary() == ARRAY && rhs_type.get_primary() == VECTOR) {
+            return this->store_vector(idx, a.get_rvalue(), a.get_line_number());
+        }
+
         // overwrite p.second with the actual destination fetch code
         std::stringstream overwrite;
 
@@ -79,7 +109,7 @@ std::stringstream compiler::handle_assignment(const Assignment &a) {
     return handle_ss;
 }
 
-std::stringstream compiler::handle_alloc_init(const symbol &sym, const Expression& rvalue, unsigned int line) {
+std::stringstream compiler::handle_alloc_init(const Allocation &alloc_stmt, const symbol &sym) {
     /*
 
     handle_alloc_init
@@ -89,11 +119,22 @@ std::stringstream compiler::handle_alloc_init(const symbol &sym, const Expressio
 
     */
 
+    const Expression &rvalue = *alloc_stmt.get_initial_value();
+    unsigned int line = alloc_stmt.get_line_number();
+
     auto p = assign_utilities::fetch_destination_operand(sym, this->symbols, line, RBX, true);
     auto rhs_type = expression_util::get_expression_data_type(rvalue, this->symbols, this->structs, line);
 
     reg src_reg = sym.get_data_type().get_primary() == FLOAT ? XMM0 : RAX;
 
+    // the symbol may take or share the initial value's buffer instead of copying it
+    if (this->is_moved_assignment(sym.get_data_type(), rvalue)) {
+        return this->move_buffer(sym, rvalue, line);
+    }
+    else if (this->is_shared_assignment(alloc_stmt.get_name(), sym.get_data_type(), rvalue)) {
+        return this->share_buffer(sym, this->symbols.find(static_cast<const Identifier&>(rvalue).getValue()));
+    }
+
     // we need to have a special case for ref<T> initialization
     /*if (sym.get_data_type().get_primary() == REFERENCE) {
         // wrap the rvalue in a unary address-of expression
@@ -110,6 +151,164 @@ std::stringstream compiler::handle_alloc_init(const symbol &sym, const Expressio
     //}
 }
 
+bool compiler::is_shared_assignment(const std::string &dest, const DataType &dest_type, const Expression &rvalue) {
+    /*
+
+    is_shared_assignment
+    Determines whether an assignment of 'rvalue' to the name 'dest' shares its buffer rather than copying it
+
+    Both must be names that may share their buffers in the current function (see compile_util/cow_util.h), and their types must allow it
+
+    */
+
+    if (rvalue.get_expression_type() != IDENTIFIER || !this->shared_names.count(dest)) {
+        return false;
+    }
+
+    const std::string &src_name = static_cast<const Identifier&>(rvalue).getValue();
+    if (src_name == dest || !this->shared_names.count(src_name)) {
+        return false;
+    }
+
+    symbol &src = this->symbols.find(src_name);
+    return cow_util::can_share(dest_type, src.get_data_type());
+}
+
+std::stringstream compiler::share_buffer(const symbol &dest, const symbol &src) {
+    /*
+
+    share_buffer
+    Makes 'dest' refer to the buffer of 'src' rather than copying it
+
+    The reference count of the buffer is incremented, and that of the old buffer is decremented (in that order, in case they are the same). Neither symbol is a parameter, so both are below RBP.
+
+    */
+
+    std::stringstream share_ss;
+    std::string dest_location = "[rbp - " + std::to_string(dest.get_offset()) + "]";
+    std::string src_location = "[rbp - " + std::to_string(src.get_offset()) + "]";
+
+    share_ss << push_used_registers(this->reg_stack.peek(), true).str();
+    share_ss << "\t" << "mov rdi, " << src_location << std::endl;
+    share_ss << function_util::call_sre_function(magic_numbers::SRE_ADD_REF);
+    share_ss << "\t" << "mov rdi, " << dest_location << std::endl;
+    share_ss << function_util::call_sre_function(magic_numbers::SRE_FREE);
+    share_ss << "\t" << "mov rax, " << src_location << std::endl;
+    share_ss << "\t" << "mov " << dest_location << ", rax" << std::endl;
+    share_ss << pop_used_registers(this->reg_stack.peek(), true).str();
+
+    return share_ss;
+}
+
+bool compiler::is_moved_assignment(const DataType &dest_type, const Expression &rvalue) {
+    /*
+
+    is_moved_assignment
+    Determines whether an assignment of 'rvalue' moves its buffer rather than copying it
+
+    The rvalue must be a name on its last use (see compile_util/move_util.h), and the types must be the same as those required to share a buffer
+
+    */
+
+    if (rvalue.get_expression_type() != IDENTIFIER || !this->last_uses.count(&rvalue)) {
+        return false;
+    }
+
+    symbol &src = this->symbols.find(static_cast<const Identifier&>(rvalue).getValue());
+    return cow_util::can_share(dest_type, src.get_data_type());
+}
+
+std::stringstream compiler::move_buffer(const symbol &dest, const Expression &rvalue, unsigned int line) {
+    /*
+
+    move_buffer
+    Hands the buffer of the name 'rvalue' to 'dest'
+
+    The old buffer of 'dest' is freed, and it takes the pointer of the source as it is; the source is then marked as freed so that it isn't freed again when it goes out of scope. Neither symbol is a parameter, so both are below RBP.
+
+    */
+
+    std::stringstream move_ss;
+    auto &id = static_cast<const Identifier&>(rvalue);
+    symbol &src = *this->lookup(id.getValue(), line);
+    if (!src.was_initialized()) {
+        throw ReferencedBeforeInitializationException(src.get_name(), line);
+    }
+
+    std::string dest_location = "[rbp - " + std::to_string(dest.get_offset()) + "]";
+    std::string src_location = "[rbp - " + std::to_string(src.get_offset()) + "]";
+
+    move_ss << push_used_registers(this->reg_stack.peek(), true).str();
+    move_ss << "\t" << "mov rdi, " << dest_location << std::endl;
+    move_ss << function_util::call_sre_function(magic_numbers::SRE_FREE);
+    move_ss << "\t" << "mov rax, " << src_location << std::endl;
+    move_ss << "\t" << "mov " << dest_location << ", rax" << std::endl;
+    move_ss << pop_used_registers(this->reg_stack.peek(), true).str();
+
+    src.free();
+    return move_ss;
+}
+
+std::stringstream compiler::ensure_unique(const std::string &name) {
+    /*
+
+    ensure_unique
+    Copies the buffer of a name that may be shared, if it is, so that it may be modified
+
+    If the buffer's reference count is anything other than 1, a new buffer is allocated, the old one's contents (including the length, and for strings, the null terminator) are copied into it byte for byte, and the old buffer's count is decremented.
+
+    @param  name    The name of the string or dynamic array
+    @return The generated code
+
+    */
+
+    std::stringstream unique_ss;
+    symbol &sym = this->symbols.find(name);
+    const DataType &t = sym.get_data_type();
+    std::string location = "[rbp - " + std::to_string(sym.get_offset()) + "]";
+    std::string done_label = magic_numbers::UNIQUE_LABEL + std::to_string(this->scope_block_num);
+    this->scope_block_num += 1;
+
+    unique_ss << push_used_registers(this->reg_stack.peek(), true).str();
+    unique_ss << "\t" << "mov rdi, " << location << std::endl;
+    unique_ss << function_util::call_sre_function(magic_numbers::SRE_GET_RC);
+    unique_ss << "\t" << "cmp eax, 1" << std::endl;
+    unique_ss << "\t" << "je " << done_label << std::endl;
+
+    // allocate the copy; RCX gets the number of bytes to copy
+    unique_ss << "\t" << "mov rax, " << location << std::endl;
+    if (t.get_primary() == STRING) {
+        unique_ss << "\t" << "mov esi, [rax]" << std::endl;
+        unique_ss << "\t" << "push rsi" << std::endl;
+        unique_ss << function_util::call_sincall_subroutine("sinl_string_alloc");
+        unique_ss << "\t" << "pop rcx" << std::endl;
+        unique_ss << "\t" << "add ecx, " << sin_widths::INT_WIDTH + sin_widths::CHAR_WIDTH << std::endl;
+    }
+    else {
+        unique_ss << "\t" << "mov edi, [rax]" << std::endl;
+        unique_ss << "\t" << "imul edi, " << t.get_subtype().get_width() << std::endl;
+        unique_ss << "\t" << "add edi, " << sin_widths::INT_WIDTH << std::endl;
+        unique_ss << "\t" << "push rdi" << std::endl;
+        unique_ss << "\t" << "mov rsi, 0" << std::endl;
+        unique_ss << function_util::call_sre_function(magic_numbers::SRE_REQUEST_RESOURCE);
+        unique_ss << "\t" << "pop rcx" << std::endl;
+    }
+
+    unique_ss << "\t" << "mov rdi, rax" << std::endl;
+    unique_ss << "\t" << "mov rsi, " << location << std::endl;
+    unique_ss << "\t" << "rep movsb" << std::endl;
+
+    // replace the shared buffer with the copy
+    unique_ss << "\t" << "mov rdi, " << location << std::endl;
+    unique_ss << "\t" << "mov " << location << ", rax" << std::endl;
+    unique_ss << function_util::call_sre_function(magic_numbers::SRE_FREE);
+
+    unique_ss << done_label << ":" << std::endl;
+    unique_ss << pop_used_registers(this->reg_stack.peek(), true).str();
+
+    return unique_ss;
+}
+
 std::stringstream compiler::assign(
     const DataType& lhs_type,
     const DataType &rhs_type,
@@ -131,7 +330,11 @@ std::stringstream compiler::assign(
     // get the source register
     reg src_reg = rhs_type.get_primary() == FLOAT ? XMM0 : RAX;
 
-    if (lhs_type.is_compatible(rhs_type)) {
+    if (lhs_type.get_primary() == VECTOR) {
+        // vectors may also be assigned lists, scalars, and array elements
+        handle_assign << this->assign_vector(lhs_type, rhs_type, dest, rvalue, line).str();
+    }
+    else if (lhs_type.is_compatible(rhs_type)) {
         // first, call sre_free on the lhs if we have a managed pointer (and it's not alloc-init)
         if (lhs_type.get_primary() == PTR && lhs_type.get_qualities().is_managed() && !is_alloc_init) {
             handle_assign << push_used_registers(this->reg_stack.peek(), true).str();
@@ -144,6 +347,11 @@ std::stringstream compiler::assign(
         auto handle_p = this->evaluate_expression(rvalue, line, &lhs_type); // ensure we give evaluate_expression the lhs type as a hint
         handle_assign << handle_p.first;
         bool do_free = handle_p.second > 0;
+
+        // a temporary string (e.g., one returned by a function) may give its buffer to the destination rather than being copied
+        // only a concatenation is known to have built a new buffer; any other temporary's reference count must be checked first, which requires SRE_GET_RC
+        bool is_concatenation = rvalue.get_expression_type() == BINARY && static_cast<const Binary&>(rvalue).get_operator() == PLUS;
+        bool take_buffer = this->_opt_level > 0 && do_free && lhs_type.get_primary() == STRING && !dest.in_register && (is_concatenation || this->_sre_get_rc);
         
         handle_assign << dest.fetch_instructions;
 
@@ -151,7 +359,16 @@ std::stringstream compiler::assign(
         std::string src = register_usage::get_register_name(src_reg, lhs_type);
 
         // make the assignment
-        if (lhs_type.get_primary() == TUPLE) {
+        std::vector<eightbyte> parts;
+        if ((lhs_type.get_primary() == TUPLE || lhs_type.get_primary() == STRUCT) && get_eightbytes(lhs_type, parts, &this->structs)) {
+            // small tuples and structs are copied with a move per eightbyte, through R15
+            for (auto part: parts) {
+                part.is_float = false;
+                handle_assign << move_eightbyte(part, R15, "[rax]", true);
+                handle_assign << move_eightbyte(part, R15, "[rbx]", false);
+            }
+        }
+        else if (lhs_type.get_primary() == TUPLE) {
             handle_assign << push_used_registers(this->reg_stack.peek(), true).str();
 
             // set up our registers/arguments
@@ -214,15 +431,62 @@ std::stringstream compiler::assign(
             }
             // todo: other copy types
 
-            // call the function
-            handle_assign << function_util::call_sincall_subroutine(proc_name);
-
-            // now, if we had a string, we need to move the returned address into where the string is located
-            if (lhs_type.get_primary() == STRING) {
+            if (take_buffer && is_concatenation) {
+                // the result of a concatenation is always a new buffer, so it may be stored as it is
+                handle_assign << "\t" << "mov rax, rsi" << std::endl;
                 handle_assign << "\t" << assign_instruction << std::endl;
+                handle_assign << function_util::call_sre_function(magic_numbers::SRE_FREE);
+                do_free = false;
+            }
+            else if (take_buffer) {
+                /*
+
+                If nothing else refers to the temporary, its buffer is stored in place of the destination's, and the old buffer is freed instead of it.
+                Otherwise, it is copied as usual. R15 holds the destination's address, so the old buffer may be reloaded from there.
+
+                */
+
+                std::string copy_label = magic_numbers::TAKE_COPY_LABEL + std::to_string(this->scope_block_num);
+                std::string done_label = magic_numbers::TAKE_DONE_LABEL + std::to_string(this->scope_block_num);
+                this->scope_block_num += 1;
+
+                handle_assign << "\t" << "push rdi" << std::endl;
+                handle_assign << "\t" << "push rsi" << std::endl;
+                handle_assign << "\t" << "mov rdi, rsi" << std::endl;
+                handle_assign << function_util::call_sre_function(magic_numbers::SRE_GET_RC);
+                handle_assign << "\t" << "pop rsi" << std::endl;
+                handle_assign << "\t" << "cmp eax, 1" << std::endl;
+                handle_assign << "\t" << "jne " << copy_label << std::endl;
+                handle_assign << "\t" << "mov rax, rsi" << std::endl;
+                handle_assign << "\t" << assign_instruction << std::endl;
+                handle_assign << "\t" << "jmp " << done_label << std::endl;
+                handle_assign << copy_label << ":" << std::endl;
+                handle_assign << "\t" << "mov [rsp], rsi" << std::endl;
+                handle_assign << "\t" << "mov rdi, [r15]" << std::endl;
+                handle_assign << function_util::call_sincall_subroutine(proc_name);
+                handle_assign << "\t" << assign_instruction << std::endl;
+                handle_assign << done_label << ":" << std::endl;
+                handle_assign << "\t" << "pop rdi" << std::endl;
+                handle_assign << function_util::call_sre_function(magic_numbers::SRE_FREE);
+
+                // the temporary has been dealt with, but it is still on the stack
+                do_free = false;
+            }
+            else {
+                // call the function
+                handle_assign << function_util::call_sincall_subroutine(proc_name);
+
+                // now, if we had a string, we need to move the returned address into where the string is located
+                if (lhs_type.get_primary() == STRING) {
+                    handle_assign << "\t" << assign_instruction << std::endl;
+                }
             }
 
             handle_assign << pop_used_registers(this->reg_stack.peek(), true).str();
+
+            if (take_buffer) {
+                handle_assign << "\t" << "add rsp, " << sin_widths::PTR_WIDTH << std::endl;
+            }
         }
         else {
             // move 'src' into 'p.first'
@@ -116,7 +116,71 @@ std::string compile_time_evaluator::evaluate_unary(const Unary & exp, const std:
 
 std::string compile_time_evaluator::evaluate_binary(const Binary & exp, const std::string& scope_name, unsigned int scope_level, unsigned int line)
 {
-	return std::string();
+	/*
+
+	evaluate_binary
+	Evaluates a binary expression
+
+	Binary expressions are executed by the interpreter so that their results match those of the generated code exactly
+
+	*/
+
+	std::unique_ptr<Literal> folded = this->fold(exp);
+	if (!folded) {
+		throw CompilerException("Could not evaluate compile-time constant; " + this->interp.get_reason(), compiler_errors::NON_CONST_VALUE_ERROR, line);
+	}
+
+	return folded->get_value();
+}
+
+std::string compile_time_evaluator::evaluate_call(const Procedure & exp, const std::string& scope_name, unsigned int scope_level, unsigned int line)
+{
+	/*
+
+	evaluate_call
+	Evaluates a call to a function defined in this file by executing it with the interpreter
+
+	The function must be pure -- see interpreter.h for exactly what it may do
+
+	*/
+
+	std::unique_ptr<Literal> folded = this->fold(exp);
+	if (!folded) {
+		throw CompilerException("Could not evaluate compile-time constant; " + this->interp.get_reason(), compiler_errors::NON_CONST_VALUE_ERROR, line);
+	}
+
+	return folded->get_value();
+}
+
+std::unique_ptr<Literal> compile_time_evaluator::fold(const Expression &to_fold)
+{
+	/*
+
+	fold
+	Attempts to evaluate an expression at compile time
+
+	Names that aren't local to a function being executed are looked up in the constant table
+
+	@param	to_fold	The expression to evaluate
+	@return	A literal containing the result, or nullptr if the expression can't be evaluated
+
+	*/
+
+	return this->interp.evaluate(to_fold, [this](const std::string &name) -> std::unique_ptr<Literal> {
+		try {
+			const_symbol c = this->lookup(name, "global", 0, 0);
+
+			// vector constants hold a list of lane values, which can't be represented as a literal
+			if (c.get_data_type().get_primary() == VECTOR) {
+				return nullptr;
+			}
+
+			return std::make_unique<Literal>(c.get_data_type(), c.get_value());
+		}
+		catch (CompilerException &e) {
+			return nullptr;
+		}
+	});
 }
 
 std::string compile_time_evaluator::evaluate_expression(const Expression &to_evaluate, const std::string& scope_name, unsigned int scope_level, unsigned int line)
@@ -148,6 +212,14 @@ std::string compile_time_evaluator::evaluate_expression(const Expression &to_eva
 		auto &unary = static_cast<const Unary&>(to_evaluate);
 		evaluated_expression = this->evaluate_unary(unary, scope_name, scope_level, line);
 	}
+	else if (to_evaluate.get_expression_type() == BINARY) {
+		auto &binary = static_cast<const Binary&>(to_evaluate);
+		evaluated_expression = this->evaluate_binary(binary, scope_name, scope_level, line);
+	}
+	else if (to_evaluate.get_expression_type() == CALL_EXP) {
+		auto &call = static_cast<const Procedure&>(to_evaluate);
+		evaluated_expression = this->evaluate_call(call, scope_name, scope_level, line);
+	}
 	else if (to_evaluate.get_expression_type() == LIST) {
 		// for lists, just evaluate each element individually and concatenate
 		auto &l = static_cast<const ListExpression&>(to_evaluate);
@@ -17,6 +17,7 @@ This file contains the function/class declarations required for the compiler's c
 #include "const_symbol.h"
 #include "symbol_table.h"
 #include "struct_table.h"
+#include "interpreter.h"
 #include "../../util/Exceptions.h"
 #include "../../parser/Statement.h"	// includes "Expression.h""
 
@@ -35,6 +36,7 @@ class compile_time_evaluator {
 	// data members
 	symbol_table* constants;
 	struct_table* structs;	// it must have access to the struct table in case we have access to const members
+	interpreter interp;	// executes operators and calls to pure functions
 	
 	/*
 	
@@ -42,6 +44,7 @@ class compile_time_evaluator {
 		- lookup
 		- remove_symbols_in_scope
 		- add_constant
+		- add_function
 
 	*/
 
@@ -53,8 +56,12 @@ class compile_time_evaluator {
 	std::string evaluate_lvalue(const Identifier& exp, const std::string& scope_name, unsigned int scope_level, unsigned int line);
 	std::string evaluate_unary(const Unary & exp, const std::string& scope_name, unsigned int scope_level, unsigned int line);
 	std::string evaluate_binary(const Binary & exp, const std::string& scope_name, unsigned int scope_level, unsigned int line);
+	std::string evaluate_call(const Procedure & exp, const std::string& scope_name, unsigned int scope_level, unsigned int line);
 public:
 	void add_constant(const Allocation &alloc, const symbol &s);	// located in utility file
+	void add_function(const FunctionDefinition &def);	// located in utility file
+
+	std::unique_ptr<Literal> fold(const Expression &to_fold);
 
 	std::string evaluate_expression(const Expression &to_evaluate, const std::string& scope_name, unsigned int scope_level, unsigned int line);
 
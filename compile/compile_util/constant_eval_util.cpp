@@ -37,6 +37,20 @@ void compile_time_evaluator::add_constant(const Allocation & alloc, const symbol
     }
 }
 
+void compile_time_evaluator::add_function(const FunctionDefinition & def)
+{
+	/*
+
+	add_function
+	Makes a function available to be called in compile-time constants
+
+	The definition must outlive the evaluator's use of it
+
+	*/
+
+	this->interp.add_function(def);
+}
+
 const const_symbol& compile_time_evaluator::lookup(const std::string& sym_name, const std::string& scope_name, unsigned int scope_level, unsigned int line) const {
 	/*
 
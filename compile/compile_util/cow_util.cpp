@@ -0,0 +1,447 @@
+/*
+
+SIN Compiler Toolchain (x86 target)
+cow_util.cpp
+Copyright 2021 Riley Lannon
+
+Implementation of the copy-on-write utilities
+
+*/
+
+#include <vector>
+
+#include "cow_util.h"
+#include "../function_symbol.h"
+
+namespace
+{
+    struct function_facts {
+        bool opaque;    // contains inline assembly
+
+        std::vector<std::pair<std::string, std::string>> shares;    // assignments that may share a buffer
+        std::unordered_set<std::string> escaped;    // names whose buffers may be modified without being named
+        std::unordered_set<std::string> conflicts;  // names that a loop both shares and modifies
+
+        function_facts()
+            : opaque(false)
+        {
+        }
+    };
+
+    // the names modified and shared in a loop
+    struct loop_facts {
+        std::unordered_set<std::string> modified;
+        std::unordered_set<std::string> shared;
+    };
+
+    bool get_share(const Expression &lvalue, const Expression &rvalue, std::string &dest, std::string &src) {
+        if (lvalue.get_expression_type() != IDENTIFIER || rvalue.get_expression_type() != IDENTIFIER) {
+            return false;
+        }
+
+        dest = static_cast<const Identifier&>(lvalue).getValue();
+        src = static_cast<const Identifier&>(rvalue).getValue();
+        return dest != src;
+    }
+
+    bool is_candidate(const std::string &name, const function_info &fn, DataType &t) {
+        return fn.get_local_type(name, t) && !fn.is_param(name) && cow_util::is_shareable(t);
+    }
+
+    bool passes_by_value(const Procedure &call, size_t arg_no, const function_info &fn, symbol_table &symbols) {
+        // a string passed to a SIN function is copied (or lent to a function that never modifies it); dynamic arrays are passed as they are
+        if (call.get_func_name().get_expression_type() != IDENTIFIER) {
+            return false;
+        }
+
+        std::string name = static_cast<const Identifier&>(call.get_func_name()).getValue();
+        if (!symbols.contains(name)) {
+            return false;
+        }
+
+        symbol &sym = symbols.find(name);
+        if (sym.get_symbol_type() != FUNCTION_SYMBOL) {
+            return false;
+        }
+
+        auto &func_sym = static_cast<function_symbol&>(sym);
+        auto &params = func_sym.get_formal_parameters();
+        if (func_sym.get_calling_convention() != SINCALL || func_sym.is_method() || arg_no >= params.size()) {
+            return false;
+        }
+
+        const DataType &param_type = params[arg_no]->get_data_type();
+        if (param_type.get_primary() == REFERENCE || param_type.get_primary() == PTR) {
+            return false;
+        }
+
+        auto &arg = call.get_arg(arg_no);
+        DataType arg_type;
+        return arg.get_expression_type() != IDENTIFIER || (
+            fn.get_local_type(static_cast<const Identifier&>(arg).getValue(), arg_type) &&
+            arg_type.get_primary() == STRING
+        );
+    }
+
+    void collect_expression(const Expression &e, const function_info &fn, symbol_table &symbols, function_facts &facts) {
+        switch (e.get_expression_type()) {
+            case LIST:
+                for (auto member: static_cast<const ListExpression&>(e).get_list()) {
+                    collect_expression(*member, fn, symbols, facts);
+                }
+                break;
+            case INDEXED:
+            {
+                auto &idx = static_cast<const Indexed&>(e);
+                collect_expression(idx.get_to_index(), fn, symbols, facts);
+                collect_expression(idx.get_index_value(), fn, symbols, facts);
+                break;
+            }
+            case BINARY:
+            {
+                auto &b = static_cast<const Binary&>(e);
+                collect_expression(b.get_left(), fn, symbols, facts);
+                collect_expression(b.get_right(), fn, symbols, facts);
+                break;
+            }
+            case UNARY:
+            {
+                auto &u = static_cast<const Unary&>(e);
+                if (u.get_operator() == ADDRESS) {
+                    facts.escaped.insert(cow_util::get_root(u.get_operand()));
+                }
+                collect_expression(u.get_operand(), fn, symbols, facts);
+                break;
+            }
+            case CALL_EXP:
+            case PROC_EXP:
+            {
+                auto &proc = static_cast<const Procedure&>(e);
+                if (proc.get_func_name().get_expression_type() == BINARY) {
+                    facts.escaped.insert(cow_util::get_root(proc.get_func_name()));    // the object a method is called on
+                }
+
+                for (size_t i = 0; i < proc.get_num_args(); i++) {
+                    if (!passes_by_value(proc, i, fn, symbols)) {
+                        facts.escaped.insert(cow_util::get_root(proc.get_arg(i)));
+                    }
+                    collect_expression(proc.get_arg(i), fn, symbols, facts);
+                }
+                break;
+            }
+            case CAST:
+                collect_expression(static_cast<const Cast&>(e).get_exp(), fn, symbols, facts);
+                break;
+            case ATTRIBUTE:
+                collect_expression(static_cast<const AttributeSelection&>(e).get_selected(), fn, symbols, facts);
+                break;
+            default:
+                break;
+        }
+    }
+
+    void collect_statement(
+        const Statement &s,
+        const function_info &fn,
+        symbol_table &symbols,
+        function_facts &facts,
+        std::vector<loop_facts*> &loops
+    ) {
+        // records a statement that would share 'src' with 'dest', if both are candidates
+        auto add_share = [&](const std::string &dest, const std::string &src) {
+            DataType dest_type, src_type;
+            if (!is_candidate(dest, fn, dest_type) || !is_candidate(src, fn, src_type) || !cow_util::can_share(dest_type, src_type)) {
+                return false;
+            }
+
+            facts.shares.push_back(std::make_pair(dest, src));
+            for (auto loop: loops) {
+                loop->shared.insert(dest);
+                loop->shared.insert(src);
+            }
+            return true;
+        };
+
+        switch (s.get_statement_type()) {
+            case ALLOCATION:
+            {
+                auto &alloc = static_cast<const Allocation&>(s);
+                if (alloc.get_initial_value()) {
+                    const Expression &init = *alloc.get_initial_value();
+                    std::string src;
+                    if (init.get_expression_type() == IDENTIFIER) {
+                        src = static_cast<const Identifier&>(init).getValue();
+                        if (alloc.get_type_information().get_primary() == REFERENCE) {
+                            facts.escaped.insert(src);
+                        }
+                        else if (src != alloc.get_name()) {
+                            add_share(alloc.get_name(), src);
+                        }
+                    }
+                    collect_expression(init, fn, symbols, facts);
+                }
+                break;
+            }
+            case ASSIGNMENT:
+            case COMPOUND_ASSIGNMENT:
+            {
+                auto &assign = static_cast<const Assignment&>(s);
+                std::string dest, src;
+                if (
+                    s.get_statement_type() == COMPOUND_ASSIGNMENT ||
+                    !get_share(assign.get_lvalue(), assign.get_rvalue(), dest, src) ||
+                    !add_share(dest, src)
+                ) {
+                    std::string root = cow_util::get_root(assign.get_lvalue());
+                    for (auto loop: loops) {
+                        loop->modified.insert(root);
+                    }
+                }
+                collect_expression(assign.get_lvalue(), fn, symbols, facts);
+                collect_expression(assign.get_rvalue(), fn, symbols, facts);
+                break;
+            }
+            case MOVEMENT:
+            {
+                auto &move = static_cast<const Assignment&>(s);
+                facts.escaped.insert(cow_util::get_root(move.get_lvalue()));
+                facts.escaped.insert(cow_util::get_root(move.get_rvalue()));
+                break;
+            }
+            case RETURN_STATEMENT:
+                collect_expression(static_cast<const ReturnStatement&>(s).get_return_exp(), fn, symbols, facts);
+                break;
+            case IF_THEN_ELSE:
+            {
+                auto &ite = static_cast<const IfThenElse&>(s);
+                collect_expression(ite.get_condition(), fn, symbols, facts);
+                if (ite.get_if_branch()) collect_statement(*ite.get_if_branch(), fn, symbols, facts, loops);
+                if (ite.get_else_branch()) collect_statement(*ite.get_else_branch(), fn, symbols, facts, loops);
+                break;
+            }
+            case WHILE_LOOP:
+            {
+                auto &loop = static_cast<const WhileLoop&>(s);
+                collect_expression(loop.get_condition(), fn, symbols, facts);
+
+                // a name that is both shared and modified in a loop would need to be checked on every iteration
+                loop_facts current;
+                loops.push_back(&current);
+                if (loop.get_branch()) collect_statement(*loop.get_branch(), fn, symbols, facts, loops);
+                loops.pop_back();
+
+                for (auto &name: current.modified) {
+                    if (current.shared.count(name)) {
+                        facts.conflicts.insert(name);
+                    }
+                }
+                break;
+            }
+            case CALL:
+                collect_expression(static_cast<const Call&>(s), fn, symbols, facts);
+                break;
+            case FREE_MEMORY:
+                collect_expression(static_cast<const FreeMemory&>(s).get_freed_memory(), fn, symbols, facts);
+                break;
+            case SCOPE_BLOCK:
+                for (auto stmt: static_cast<const ScopedBlock&>(s).get_statements().statements_list) {
+                    collect_statement(*stmt, fn, symbols, facts, loops);
+                }
+                break;
+            case INLINE_ASM:
+                facts.opaque = true;
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+bool cow_util::is_shareable(const DataType &t) {
+    /*
+
+    is_shareable
+    Determines whether values of the given type may share their buffers
+
+    Arrays may only share their buffers if they are dynamic and their elements don't need to be freed; a copy of their buffer is made byte for byte
+
+    */
+
+    if (t.get_qualities().is_static() || t.get_qualities().is_const()) {
+        return false;
+    }
+    else if (t.get_primary() == STRING) {
+        return true;
+    }
+    else if (t.get_primary() == ARRAY && t.get_qualities().is_dynamic()) {
+        Type subtype = t.get_subtype().get_primary();
+        return (subtype == INT || subtype == FLOAT || subtype == BOOL || subtype == CHAR) && !t.get_subtype().get_qualities().is_dynamic();
+    }
+    else {
+        return false;
+    }
+}
+
+bool cow_util::can_share(const DataType &dest, const DataType &src) {
+    /*
+
+    can_share
+    Determines whether a value of type 'src' may share its buffer with one of type 'dest'
+
+    Copying an array never changes its length, so arrays may only share buffers if both have the same, constant, length
+
+    */
+
+    if (!is_shareable(dest) || !(dest == src)) {
+        return false;
+    }
+    else if (dest.get_primary() == ARRAY) {
+        auto dest_length = dest.get_array_length_expression();
+        auto src_length = src.get_array_length_expression();
+        return (
+            dest_length && dest_length->is_const() &&
+            src_length && src_length->is_const() &&
+            dest.get_array_length() == src.get_array_length()
+        );
+    }
+    else {
+        return true;
+    }
+}
+
+std::string cow_util::get_root(const Expression &lvalue) {
+    // the name whose data an lvalue refers to, if any
+    switch (lvalue.get_expression_type()) {
+        case IDENTIFIER:
+            return static_cast<const Identifier&>(lvalue).getValue();
+        case INDEXED:
+            return get_root(static_cast<const Indexed&>(lvalue).get_to_index());
+        case BINARY:
+            return static_cast<const Binary&>(lvalue).get_operator() == DOT ? get_root(static_cast<const Binary&>(lvalue).get_left()) : "";
+        default:
+            return "";
+    }
+}
+
+void cow_util::get_modified_names(const Statement &s, const std::unordered_set<std::string> &shared, std::set<std::string> &modified) {
+    /*
+
+    get_modified_names
+    Collects the names that are assigned to, or whose elements are, in a statement
+
+    Assignments that share a buffer (between two names in 'shared') don't modify it, so they aren't included
+
+    */
+
+    switch (s.get_statement_type()) {
+        case ASSIGNMENT:
+        case COMPOUND_ASSIGNMENT:
+        {
+            auto &assign = static_cast<const Assignment&>(s);
+            std::string dest, src;
+            if (
+                s.get_statement_type() == COMPOUND_ASSIGNMENT ||
+                !get_share(assign.get_lvalue(), assign.get_rvalue(), dest, src) ||
+                !shared.count(dest) ||
+                !shared.count(src)
+            ) {
+                modified.insert(get_root(assign.get_lvalue()));
+            }
+            break;
+        }
+        case IF_THEN_ELSE:
+        {
+            auto &ite = static_cast<const IfThenElse&>(s);
+            if (ite.get_if_branch()) get_modified_names(*ite.get_if_branch(), shared, modified);
+            if (ite.get_else_branch()) get_modified_names(*ite.get_else_branch(), shared, modified);
+            break;
+        }
+        case WHILE_LOOP:
+        {
+            auto &loop = static_cast<const WhileLoop&>(s);
+            if (loop.get_branch()) get_modified_names(*loop.get_branch(), shared, modified);
+            break;
+        }
+        case SCOPE_BLOCK:
+            for (auto stmt: static_cast<const ScopedBlock&>(s).get_statements().statements_list) {
+                get_modified_names(*stmt, shared, modified);
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+std::unordered_set<std::string> cow_util::find_shared_names(
+    const FunctionDefinition &def,
+    const function_info &fn,
+    symbol_table &symbols
+) {
+    /*
+
+    find_shared_names
+    Determines which of a function's locals may share their buffers
+
+    A local string or dynamic array may share its buffer if it is assigned another (or the other is assigned to it) and neither one's buffer may be modified without being named -- i.e., neither one has its address taken, is bound to a reference, is moved, or is passed to a function that might modify it. If a loop both shares and modifies a name, the name isn't shared, so that a single check before the loop covers all of the modifications in it.
+
+    @param  def The function to analyze
+    @param  fn  Information about the function's locals
+    @param  symbols The symbol table, used to look up the functions that are called
+    @return The names that may share their buffers
+
+    */
+
+    function_facts facts;
+    std::vector<loop_facts*> loops;
+    for (auto stmt: def.get_procedure().statements_list) {
+        collect_statement(*stmt, fn, symbols, facts, loops);
+    }
+
+    std::unordered_set<std::string> shared;
+    if (facts.opaque) {
+        return shared;
+    }
+
+    for (auto &share: facts.shares) {
+        if (
+            !facts.escaped.count(share.first) && !facts.escaped.count(share.second) &&
+            !facts.conflicts.count(share.first) && !facts.conflicts.count(share.second)
+        ) {
+            shared.insert(share.first);
+            shared.insert(share.second);
+        }
+    }
+
+    return shared;
+}
+
+bool cow_util::find_escaped_names(
+    const FunctionDefinition &def,
+    const function_info &fn,
+    symbol_table &symbols,
+    std::unordered_set<std::string> &escaped
+) {
+    /*
+
+    find_escaped_names
+    Determines which of a function's names may be accessed without being named
+
+    These are the names that have their address taken, are bound to a reference, are moved, or are passed to a function that might modify them (see find_shared_names).
+
+    @param  def The function to analyze
+    @param  fn  Information about the function's locals
+    @param  symbols The symbol table, used to look up the functions that are called
+    @param  escaped Filled with the names that escape
+    @return False if the function contains inline assembly, in which case any name may escape
+
+    */
+
+    function_facts facts;
+    std::vector<loop_facts*> loops;
+    for (auto stmt: def.get_procedure().statements_list) {
+        collect_statement(*stmt, fn, symbols, facts, loops);
+    }
+
+    escaped = facts.escaped;
+    return !facts.opaque;
+}
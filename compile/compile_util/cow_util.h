@@ -0,0 +1,42 @@
+#pragma once
+
+/*
+
+SIN Compiler Toolchain (x86 target)
+cow_util.h
+Copyright 2021 Riley Lannon
+
+Utilities for copy-on-write assignment of strings and dynamic arrays
+
+Assigning one string (or dynamic array) to another normally copies its contents. Instead, when both are locals whose buffers can only be modified by name, the assignment may share the source's buffer and increment its reference count; the buffer is then copied by the first statement that modifies either name while its count is above one. Because the names can't be modified through pointers, references, or calls, the compiler knows exactly where that check is needed.
+
+*/
+
+#include <set>
+#include <string>
+#include <unordered_set>
+
+#include "symbol_table.h"
+#include "../../parser/Statement.h"
+#include "../opt/function_info.h"
+
+namespace cow_util
+{
+    bool is_shareable(const DataType &t);
+    bool can_share(const DataType &dest, const DataType &src);
+
+    std::string get_root(const Expression &lvalue);
+    void get_modified_names(const Statement &s, const std::unordered_set<std::string> &shared, std::set<std::string> &modified);
+
+    std::unordered_set<std::string> find_shared_names(
+        const FunctionDefinition &def,
+        const function_info &fn,
+        symbol_table &symbols
+    );
+    bool find_escaped_names(
+        const FunctionDefinition &def,
+        const function_info &fn,
+        symbol_table &symbols,
+        std::unordered_set<std::string> &escaped
+    );
+}
@@ -0,0 +1,411 @@
+/*
+
+SIN Compiler Toolchain (x86 target)
+division_util.cpp
+Copyright 2021 Riley Lannon
+
+Implementation of the constant division utilities
+
+*/
+
+#include <sstream>
+#include <limits>
+
+#include "division_util.h"
+
+namespace
+{
+    uint64_t word_mask(unsigned int bits) {
+        return (bits == 64) ? std::numeric_limits<uint64_t>::max() : ((uint64_t)1 << bits) - 1;
+    }
+
+    bool is_power_of_two(uint64_t value, unsigned int &exponent) {
+        if (value == 0 || (value & (value - 1)) != 0) {
+            return false;
+        }
+
+        exponent = 0;
+        while ((value >> exponent) != 1) {
+            exponent += 1;
+        }
+        return true;
+    }
+
+    std::string get_immediate(uint64_t value) {
+        std::stringstream imm;
+        imm << "0x" << std::hex << value;
+        return imm.str();
+    }
+}
+
+division_util::unsigned_magic division_util::get_unsigned_magic(uint64_t divisor, unsigned int bits) {
+    /*
+
+    get_unsigned_magic
+    Computes the multiplier and shift for unsigned division of an N-bit value by a constant
+
+    This is the 'magicu2' algorithm from Hacker's Delight (10-8); all arithmetic is done modulo 2^N.
+    If the required multiplier is N+1 bits wide, 'add' is set and the quotient must be computed as:
+        t = mulhi(x, multiplier); q = (((x - t) >> 1) + t) >> (shift - 1)
+    otherwise:
+        q = mulhi(x, multiplier) >> shift
+
+    @param  divisor The divisor; must be at least 1
+    @param  bits    The width of the operation, in bits
+    @return The magic number information
+
+    */
+
+    const uint64_t mask = word_mask(bits);
+    const uint64_t min_signed = (uint64_t)1 << (bits - 1);  // 2^(N-1)
+    const uint64_t max_signed = min_signed - 1;
+
+    unsigned_magic magic;
+    magic.add = false;
+
+    unsigned int p = bits - 1;
+    uint64_t q = max_signed / divisor;
+    uint64_t r = max_signed - q * divisor;
+    uint64_t p_pow = 0;  // 2^(p - N)
+    uint64_t delta;
+
+    do {
+        p += 1;
+        p_pow = (p == bits) ? 1 : ((p_pow * 2) & mask);
+
+        if (r + 1 >= divisor - r) {
+            if (q >= max_signed) magic.add = true;
+            q = (2 * q + 1) & mask;
+            r = (2 * r + 1 - divisor) & mask;
+        }
+        else {
+            if (q >= min_signed) magic.add = true;
+            q = (2 * q) & mask;
+            r = (2 * r + 1) & mask;
+        }
+
+        delta = divisor - 1 - r;
+    } while (p < 2 * bits && p_pow < delta);
+
+    magic.multiplier = (q + 1) & mask;
+    magic.shift = p - bits;
+
+    return magic;
+}
+
+division_util::signed_magic division_util::get_signed_magic(int64_t divisor, unsigned int bits) {
+    /*
+
+    get_signed_magic
+    Computes the multiplier and shift for signed division of an N-bit value by a constant
+
+    This is the 'magic' algorithm from Hacker's Delight (10-1); all arithmetic is done modulo 2^N.
+    The quotient is then computed as:
+        q = mulhs(x, multiplier)
+        q += x if divisor > 0 and multiplier < 0; q -= x if divisor < 0 and multiplier > 0
+        q >>= shift (arithmetic)
+        q += (q >>> (N - 1))
+
+    @param  divisor The divisor; must satisfy 2 <= |divisor| <= 2^(N-1)
+    @param  bits    The width of the operation, in bits
+    @return The magic number information
+
+    */
+
+    const uint64_t mask = word_mask(bits);
+    const uint64_t min_signed = (uint64_t)1 << (bits - 1);
+
+    uint64_t abs_divisor = (divisor < 0) ? (0 - (uint64_t)divisor) : (uint64_t)divisor;
+    uint64_t t = min_signed + ((divisor < 0) ? 1 : 0);
+    uint64_t abs_nc = t - 1 - t % abs_divisor;
+
+    unsigned int p = bits - 1;
+    uint64_t q1 = min_signed / abs_nc;
+    uint64_t r1 = min_signed - q1 * abs_nc;
+    uint64_t q2 = min_signed / abs_divisor;
+    uint64_t r2 = min_signed - q2 * abs_divisor;
+    uint64_t delta;
+
+    do {
+        p += 1;
+
+        q1 = (2 * q1) & mask;
+        r1 = (2 * r1) & mask;
+        if (r1 >= abs_nc) {
+            q1 += 1;
+            r1 -= abs_nc;
+        }
+
+        q2 = (2 * q2) & mask;
+        r2 = (2 * r2) & mask;
+        if (r2 >= abs_divisor) {
+            q2 += 1;
+            r2 -= abs_divisor;
+        }
+
+        delta = abs_divisor - r2;
+    } while (q1 < delta || (q1 == delta && r1 == 0));
+
+    signed_magic magic;
+    magic.multiplier = (q2 + 1) & mask;
+    if (divisor < 0) {
+        magic.multiplier = (0 - magic.multiplier) & mask;
+    }
+    magic.shift = p - bits;
+
+    return magic;
+}
+
+bool division_util::get_constant_divisor(const Expression &divisor, const DataType &dividend_type, bool is_signed, int64_t &value) {
+    /*
+
+    get_constant_divisor
+    Determines whether the divisor of an integer division is a constant that can be lowered
+
+    The divisor must be an integer literal (or, for signed division, a negated one) that is representable in the dividend's width. Division by zero is left alone so that it faults at runtime, as it would otherwise.
+
+    @param  divisor The right-hand operand of the division
+    @param  dividend_type   The type of the left-hand operand
+    @param  is_signed   Whether the division is signed
+    @param  value   Where the divisor's value is written
+    @return Whether the divisor can be lowered
+
+    */
+
+    size_t width = dividend_type.get_width();
+    if (width != sin_widths::SHORT_WIDTH && width != sin_widths::INT_WIDTH && width != sin_widths::LONG_WIDTH) {
+        return false;
+    }
+    unsigned int bits = width * 8;
+
+    const Expression *operand = &divisor;
+    bool negate = false;
+    if (divisor.get_expression_type() == UNARY && static_cast<const Unary&>(divisor).get_operator() == UNARY_MINUS) {
+        operand = &static_cast<const Unary&>(divisor).get_operand();
+        negate = true;
+    }
+
+    if (operand->get_expression_type() != LITERAL) {
+        return false;
+    }
+
+    auto &literal = static_cast<const Literal&>(*operand);
+    if (literal.get_data_type().get_primary() != INT) {
+        return false;
+    }
+
+    uint64_t magnitude;
+    try {
+        magnitude = std::stoull(literal.get_value(), nullptr, 10);
+    }
+    catch (std::exception &e) {
+        return false;
+    }
+
+    if (magnitude == 0) {
+        return false;
+    }
+
+    if (is_signed) {
+        // the value must be in [-2^(N-1), 2^(N-1) - 1]
+        uint64_t limit = (uint64_t)1 << (bits - 1);
+        if (negate ? (magnitude > limit) : (magnitude >= limit)) {
+            return false;
+        }
+        value = negate ? (int64_t)(0 - magnitude) : (int64_t)magnitude;
+    }
+    else {
+        // unsigned divisors must fit in N bits (and in an int64_t, so that they may be passed around)
+        if (negate || magnitude > word_mask(bits) || magnitude > (uint64_t)std::numeric_limits<int64_t>::max()) {
+            return false;
+        }
+        value = (int64_t)magnitude;
+    }
+
+    return true;
+}
+
+std::string division_util::extend_dividend(const DataType &dividend_type, bool is_signed) {
+    /*
+
+    extend_dividend
+    Extends the dividend in RAX into RDX for 'div' or 'idiv'
+
+    Signed dividends must be sign-extended (with CWD, CDQ, or CQO); zeroing RDX would make any negative dividend a large positive one
+
+    */
+
+    std::stringstream ext_ss;
+
+    if (is_signed && dividend_type.get_width() == sin_widths::SHORT_WIDTH) {
+        ext_ss << "\t" << "cwd" << std::endl;
+    }
+    else if (is_signed && dividend_type.get_width() == sin_widths::INT_WIDTH) {
+        ext_ss << "\t" << "cdq" << std::endl;
+    }
+    else if (is_signed && dividend_type.get_width() == sin_widths::LONG_WIDTH) {
+        ext_ss << "\t" << "cqo" << std::endl;
+    }
+    else {
+        ext_ss << "\t" << "mov " << register_usage::get_register_name(RDX, dividend_type) << ", 0" << std::endl;
+    }
+
+    return ext_ss.str();
+}
+
+std::string division_util::divide_by_constant(
+    int64_t divisor,
+    const DataType &dividend_type,
+    bool is_signed,
+    bool remainder,
+    const register_usage &r
+) {
+    /*
+
+    divide_by_constant
+    Generates code to divide the value in RAX by a constant without using 'div' or 'idiv'
+
+    Quotients truncate toward zero, and remainders have the sign of the dividend, exactly as with 'idiv'. The result is left in RAX. RBX and RDX are clobbered (RDX is preserved if it is in use).
+
+    @param  divisor The divisor, as obtained by get_constant_divisor
+    @param  dividend_type   The type of the dividend
+    @param  is_signed   Whether the division is signed
+    @param  remainder   Whether we want the remainder (modulo) rather than the quotient
+    @param  r   The register usage for the current scope
+    @return A string containing the generated code
+
+    */
+
+    std::stringstream div_ss;
+
+    const unsigned int bits = dividend_type.get_width() * 8;
+    const std::string rax_name = register_usage::get_register_name(RAX, dividend_type);
+    const std::string rbx_name = register_usage::get_register_name(RBX, dividend_type);
+    const std::string rdx_name = register_usage::get_register_name(RDX, dividend_type);
+
+    uint64_t abs_divisor = (divisor < 0) ? (0 - (uint64_t)divisor) : (uint64_t)divisor;
+    unsigned int exponent;
+
+    // division by 1 or -1 never requires a multiplication
+    if (abs_divisor == 1) {
+        if (remainder) {
+            div_ss << "\t" << "xor " << rax_name << ", " << rax_name << std::endl;
+        }
+        else if (divisor < 0) {
+            div_ss << "\t" << "neg " << rax_name << std::endl;
+        }
+
+        return div_ss.str();
+    }
+
+    // powers of two use shifts; signed values must be biased so that the shift rounds toward zero
+    if (is_power_of_two(abs_divisor, exponent)) {
+        if (!is_signed) {
+            if (remainder) {
+                uint64_t mask = abs_divisor - 1;
+                if (mask <= (uint64_t)std::numeric_limits<int32_t>::max()) {
+                    div_ss << "\t" << "and " << rax_name << ", " << get_immediate(mask) << std::endl;
+                }
+                else {
+                    div_ss << "\t" << "mov " << rbx_name << ", " << get_immediate(mask) << std::endl;
+                    div_ss << "\t" << "and " << rax_name << ", " << rbx_name << std::endl;
+                }
+            }
+            else {
+                div_ss << "\t" << "shr " << rax_name << ", " << exponent << std::endl;
+            }
+        }
+        else {
+            // rbx = x + (x < 0 ? 2^k - 1 : 0)
+            div_ss << "\t" << "mov " << rbx_name << ", " << rax_name << std::endl;
+            div_ss << "\t" << "sar " << rbx_name << ", " << bits - 1 << std::endl;
+            div_ss << "\t" << "shr " << rbx_name << ", " << bits - exponent << std::endl;
+            div_ss << "\t" << "add " << rbx_name << ", " << rax_name << std::endl;
+
+            if (remainder) {
+                // x - ((x + bias) with the low k bits cleared)
+                div_ss << "\t" << "sar " << rbx_name << ", " << exponent << std::endl;
+                div_ss << "\t" << "shl " << rbx_name << ", " << exponent << std::endl;
+                div_ss << "\t" << "sub " << rax_name << ", " << rbx_name << std::endl;
+            }
+            else {
+                div_ss << "\t" << "sar " << rbx_name << ", " << exponent << std::endl;
+                div_ss << "\t" << "mov " << rax_name << ", " << rbx_name << std::endl;
+                if (divisor < 0) {
+                    div_ss << "\t" << "neg " << rax_name << std::endl;
+                }
+            }
+        }
+
+        return div_ss.str();
+    }
+
+    // all other divisors multiply by the magic number and take the high half of the product (in rdx)
+    bool preserve_rdx = r.is_in_use(RDX);
+    if (preserve_rdx) {
+        div_ss << "\t" << "push rdx" << std::endl;
+    }
+    div_ss << "\t" << "push rax" << std::endl;  // the dividend is needed again after the multiplication
+
+    if (is_signed) {
+        signed_magic magic = get_signed_magic(divisor, bits);
+        bool negative_multiplier = (magic.multiplier >> (bits - 1)) & 1;
+
+        div_ss << "\t" << "mov " << rbx_name << ", " << get_immediate(magic.multiplier) << std::endl;
+        div_ss << "\t" << "imul " << rbx_name << std::endl;
+
+        if (divisor > 0 && negative_multiplier) {
+            div_ss << "\t" << "add " << rdx_name << ", [rsp]" << std::endl;
+        }
+        else if (divisor < 0 && !negative_multiplier) {
+            div_ss << "\t" << "sub " << rdx_name << ", [rsp]" << std::endl;
+        }
+
+        if (magic.shift > 0) {
+            div_ss << "\t" << "sar " << rdx_name << ", " << magic.shift << std::endl;
+        }
+
+        // add one if the quotient is negative so that it truncates toward zero
+        div_ss << "\t" << "mov " << rax_name << ", " << rdx_name << std::endl;
+        div_ss << "\t" << "shr " << rax_name << ", " << bits - 1 << std::endl;
+        div_ss << "\t" << "add " << rax_name << ", " << rdx_name << std::endl;
+    }
+    else {
+        unsigned_magic magic = get_unsigned_magic((uint64_t)divisor, bits);
+
+        div_ss << "\t" << "mov " << rbx_name << ", " << get_immediate(magic.multiplier) << std::endl;
+        div_ss << "\t" << "mul " << rbx_name << std::endl;
+
+        if (magic.add) {
+            div_ss << "\t" << "mov " << rax_name << ", [rsp]" << std::endl;
+            div_ss << "\t" << "sub " << rax_name << ", " << rdx_name << std::endl;
+            div_ss << "\t" << "shr " << rax_name << ", 1" << std::endl;
+            div_ss << "\t" << "add " << rax_name << ", " << rdx_name << std::endl;
+            if (magic.shift > 1) {
+                div_ss << "\t" << "shr " << rax_name << ", " << magic.shift - 1 << std::endl;
+            }
+        }
+        else {
+            div_ss << "\t" << "mov " << rax_name << ", " << rdx_name << std::endl;
+            if (magic.shift > 0) {
+                div_ss << "\t" << "shr " << rax_name << ", " << magic.shift << std::endl;
+            }
+        }
+    }
+
+    // the remainder is x - q * d
+    if (remainder) {
+        div_ss << "\t" << "mov " << rbx_name << ", " << divisor << std::endl;
+        div_ss << "\t" << "imul " << rax_name << ", " << rbx_name << std::endl;
+        div_ss << "\t" << "mov " << rbx_name << ", " << rax_name << std::endl;
+        div_ss << "\t" << "mov " << rax_name << ", [rsp]" << std::endl;
+        div_ss << "\t" << "sub " << rax_name << ", " << rbx_name << std::endl;
+    }
+
+    div_ss << "\t" << "add rsp, 8" << std::endl;
+    if (preserve_rdx) {
+        div_ss << "\t" << "pop rdx" << std::endl;
+    }
+
+    return div_ss.str();
+}
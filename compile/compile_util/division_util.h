@@ -0,0 +1,50 @@
+#pragma once
+
+/*
+
+SIN Compiler Toolchain (x86 target)
+division_util.h
+Copyright 2021 Riley Lannon
+
+Utilities for integer division and modulo by compile-time constants
+
+Division is one of the slowest integer instructions, so when the divisor is known at compile time, the quotient is instead computed with a multiplication by a "magic number" and a shift (see Granlund & Montgomery, "Division by Invariant Integers using Multiplication", and Warren, "Hacker's Delight", ch. 10). Division by a power of two is reduced to a shift.
+
+*/
+
+#include <string>
+#include <cinttypes>
+
+#include "register_usage.h"
+#include "../../parser/Expression.h"
+#include "../../util/DataType.h"
+#include "../../util/data_widths.h"
+
+namespace division_util
+{
+    struct unsigned_magic {
+        uint64_t multiplier;
+        bool add;   // whether the multiplier needed one more bit than the word size
+        unsigned int shift;
+    };
+
+    struct signed_magic {
+        uint64_t multiplier;    // as an N-bit two's complement value
+        unsigned int shift;
+    };
+
+    unsigned_magic get_unsigned_magic(uint64_t divisor, unsigned int bits);
+    signed_magic get_signed_magic(int64_t divisor, unsigned int bits);
+
+    bool get_constant_divisor(const Expression &divisor, const DataType &dividend_type, bool is_signed, int64_t &value);
+
+    std::string extend_dividend(const DataType &dividend_type, bool is_signed);
+
+    std::string divide_by_constant(
+        int64_t divisor,
+        const DataType &dividend_type,
+        bool is_signed,
+        bool remainder,
+        const register_usage &r
+    );
+}
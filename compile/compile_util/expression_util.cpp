@@ -242,6 +242,15 @@ DataType expression_util::get_expression_data_type(
             if (t.get_primary() == ARRAY) {
                 type_information = t.get_subtype();
             }
+            else if (t.get_primary() == VECTOR) {
+                // indexing a vector with a list of lanes shuffles it; otherwise, we select a single lane
+                if (idx.get_index_value().get_expression_type() == LIST) {
+                    type_information = t;
+                }
+                else {
+                    type_information = t.get_subtype();
+                }
+            }
             else if (t.get_primary() == STRING) {
                 type_information = DataType(
                     Type::CHAR
@@ -350,8 +359,12 @@ DataType expression_util::get_expression_data_type(
                 DataType left = expression_util::get_expression_data_type(binary.get_left(), symbols, structs, line);
                 DataType right = expression_util::get_expression_data_type(binary.get_right(), symbols, structs, line);
 
+                // vectors have their own rules (scalars are broadcast, and comparisons produce masks)
+                if (left.get_primary() == VECTOR || right.get_primary() == VECTOR) {
+                    type_information = expression_util::get_vector_result_type(binary.get_operator(), left, right, line);
+                }
                 // ensure the types are compatible
-                if (left.is_compatible(right)) {
+                else if (left.is_compatible(right)) {
                     // check for in/equality operators -- these will return booleans instead of the original type!
                     exp_operator op = binary.get_operator();
                     if (op == EQUAL || op == NOT_EQUAL || op == GREATER || op == GREATER_OR_EQUAL || op == LESS || op == LESS_OR_EQUAL) {
@@ -429,6 +442,22 @@ DataType expression_util::get_expression_data_type(
         }
         case ATTRIBUTE:
         {
+            // horizontal reductions of vectors produce a single lane
+            auto &attr = static_cast<const AttributeSelection&>(to_eval);
+            if (attr.get_attribute() == SUM || attr.get_attribute() == MINIMUM || attr.get_attribute() == MAXIMUM) {
+                DataType selected = expression_util::get_expression_data_type(attr.get_selected(), symbols, structs, line);
+                if (selected.get_primary() != VECTOR) {
+                    throw CompilerException(
+                        "The sum, min, and max attributes may only be used with vectors",
+                        compiler_errors::UNKNOWN_ATTRIBUTE,
+                        line
+                    );
+                }
+
+                type_information = selected.get_subtype();
+                break;
+            }
+
             type_information.set_primary(INT);
             type_information.add_qualities(
                 std::vector<SymbolQuality>{
@@ -446,6 +475,150 @@ DataType expression_util::get_expression_data_type(
     return type_information;
 }
 
+DataType expression_util::get_vector_result_type(
+    exp_operator op,
+    const DataType &left,
+    const DataType &right,
+    unsigned int line
+) {
+    /*
+
+    get_vector_result_type
+    Determines the type of a binary expression with a vector operand
+
+    Both operands may be vectors with the same number of lanes, or one may be a scalar of the same primary type as the lanes, which is broadcast to every lane.
+    Lanes must also have the same width, except with the bitwise operators, which may combine any two vectors of the same shape (e.g., a mask with a 'float' vector); their result has the type of the left operand.
+    The relational operators compare each pair of lanes and produce a mask -- a vector of 'int' (or 'long int' for 8-byte lanes) in which each lane is all ones where the comparison was true and zero where it was false.
+    Shifts take a scalar 'int' count for the right operand.
+
+    @param  op  The operator
+    @param  left    The type of the left operand
+    @param  right   The type of the right operand
+    @param  line    The line number where the expression occurs
+    @return The type of the result
+
+    */
+
+    const DataType &vector_type = (left.get_primary() == VECTOR) ? left : right;
+    const DataType &other = (left.get_primary() == VECTOR) ? right : left;
+    DataType lane = vector_type.get_subtype();
+    bool bitwise = (op == BIT_AND || op == BIT_OR || op == BIT_XOR);
+    bool shift = (op == LEFT_SHIFT || op == RIGHT_SHIFT);
+
+    if (shift) {
+        if (left.get_primary() != VECTOR || right.get_primary() != INT || lane.get_primary() != INT) {
+            throw UndefinedOperatorError("bitshift", line);
+        }
+        else if (op == RIGHT_SHIFT && lane.get_width() == sin_widths::LONG_WIDTH && !lane.get_qualities().is_unsigned()) {
+            // there is no arithmetic right shift of quadwords before AVX-512
+            throw UndefinedOperatorError("bitshift", line);
+        }
+
+        return left;
+    }
+
+    // the operands must agree in shape
+    if (other.get_primary() == VECTOR) {
+        if (
+            other.get_array_length() != vector_type.get_array_length() ||
+            (!bitwise && !other.is_compatible(vector_type)) ||
+            (bitwise && other.get_width() != vector_type.get_width())
+        ) {
+            throw TypeException(line);
+        }
+    }
+    else if (other.get_primary() != lane.get_primary()) {
+        throw TypeException(line);
+    }
+
+    bool is_float = lane.get_primary() == FLOAT;
+    bool is_long = lane.get_width() == sin_widths::LONG_WIDTH;
+
+    switch (op) {
+        case PLUS:
+        case MINUS:
+        case BIT_AND:
+        case BIT_OR:
+        case BIT_XOR:
+            return left.get_primary() == VECTOR ? left : right;
+        case MULT:
+            // there is no packed quadword multiplication before AVX-512
+            if (is_long && !is_float) {
+                throw UndefinedOperatorError("multiplication", line);
+            }
+            return vector_type;
+        case DIV:
+            if (!is_float) {
+                throw UndefinedOperatorError("division", line);
+            }
+            return vector_type;
+        case EQUAL:
+        case NOT_EQUAL:
+        case LESS:
+        case GREATER:
+        case LESS_OR_EQUAL:
+        case GREATER_OR_EQUAL:
+        {
+            // comparisons produce masks
+            DataType mask(VECTOR, DataType(INT), symbol_qualities());
+            if (is_long) {
+                DataType mask_lane(INT);
+                mask_lane.add_quality(LONG);
+                mask.set_subtype(mask_lane);
+            }
+            mask.set_array_length(vector_type.get_array_length());
+            return mask;
+        }
+        case MODULO:
+            throw UndefinedOperatorError("modulo", line);
+        default:
+            throw CompilerException(
+                "This operator is not defined for vectors",
+                compiler_errors::UNDEFINED_OPERATOR_ERROR,
+                line
+            );
+    }
+}
+
+size_t expression_util::get_vector_lane(const Indexed &lane, const DataType &vector_type, unsigned int line) {
+    /*
+
+    get_vector_lane
+    Gets the lane selected by indexing a vector
+
+    Vector lanes live in registers, so they can't be selected at runtime; the index must be an integer literal within the vector's bounds.
+
+    @param  lane    The indexed expression selecting the lane
+    @param  vector_type The type of the vector being indexed
+    @param  line    The line number where the expression occurs
+    @return The number of the selected lane
+
+    */
+
+    const Expression &index = lane.get_index_value();
+    if (
+        index.get_expression_type() != LITERAL ||
+        static_cast<const Literal&>(index).get_data_type().get_primary() != INT
+    ) {
+        throw CompilerException(
+            "Vector lanes must be selected with an integer literal",
+            compiler_errors::TYPE_ERROR,
+            line
+        );
+    }
+
+    long long selected = std::stoll(static_cast<const Literal&>(index).get_value());
+    if (selected < 0 || static_cast<size_t>(selected) >= vector_type.get_array_length()) {
+        throw CompilerException(
+            "Vector lane out of range",
+            compiler_errors::OUT_OF_BOUNDS,
+            line
+        );
+    }
+
+    return static_cast<size_t>(selected);
+}
+
 size_t expression_util::get_width(
     DataType &alloc_data,
     compile_time_evaluator &evaluator,
@@ -38,6 +38,15 @@ namespace expression_util {
         const DataType *type_hint = nullptr
     );
 
+    DataType get_vector_result_type(
+        exp_operator op,
+        const DataType &left,
+        const DataType &right,
+        unsigned int line
+    );
+
+    size_t get_vector_lane(const Indexed &lane, const DataType &vector_type, unsigned int line);
+
     size_t get_width(
         DataType &alloc_data,
         compile_time_evaluator &evaluator,
@@ -13,24 +13,79 @@ Copyright 2020 Riley Lannon
 
 #include "utilities.h"
 
-std::string function_util::call_sincall_subroutine(std::string name) {
-    // Sets up a stack frame, calls a function, restores frame
+std::string function_util::call_sincall_subroutine(std::string name, bool internal) {
+    /*
+
+    call_sincall_subroutine
+    Sets up a stack frame, calls a function, and restores the frame
+
+    If the callee is a SIN function defined in this compilation unit, we know it returns with RSP pointing at the frame base and that nothing relies on the saved flags, so we can use a lighter sequence:
+        - the slot for RFLAGS is reserved but not written, so parameter offsets are the same for both sequences
+        - 'mov rsp, rbp' is unnecessary after the call
+
+    @param  name    The name of the function to call
+    @param  internal    Whether the callee is a SIN function defined in this unit
+    @return A string containing the generated code
+
+    */
     
     std::stringstream call_ss;
 
-    call_ss << "\t" << "pushfq" << std::endl;
-    call_ss << "\t" << "push rbp" << std::endl;
-    call_ss << "\t" << "mov rbp, rsp" << std::endl;
-    call_ss << "\t" << "call " << name << std::endl;
-    call_ss << "\t" << "mov rsp, rbp" << std::endl;
-    call_ss << "\t" << "pop rbp" << std::endl;
-    call_ss << "\t" << "popfq" << std::endl;
+    if (internal) {
+        call_ss << "\t" << "sub rsp, 8" << std::endl;
+        call_ss << "\t" << "push rbp" << std::endl;
+        call_ss << "\t" << "mov rbp, rsp" << std::endl;
+        call_ss << "\t" << "call " << name << std::endl;
+        call_ss << "\t" << "pop rbp" << std::endl;
+        call_ss << "\t" << "add rsp, 8" << std::endl;
+    }
+    else {
+        call_ss << "\t" << "pushfq" << std::endl;
+        call_ss << "\t" << "push rbp" << std::endl;
+        call_ss << "\t" << "mov rbp, rsp" << std::endl;
+        call_ss << "\t" << "call " << name << std::endl;
+        call_ss << "\t" << "mov rsp, rbp" << std::endl;
+        call_ss << "\t" << "pop rbp" << std::endl;
+        call_ss << "\t" << "popfq" << std::endl;
+    }
 
     return call_ss.str();
 }
 
-template function_symbol function_util::create_function_symbol(const FunctionDefinition&, bool, bool, const std::string&, unsigned int, bool);
-template function_symbol function_util::create_function_symbol(const Declaration&, bool, bool, const std::string&, unsigned int, bool);
+static bool set_struct_width(DataType &t, struct_table *structs, unsigned int line) {
+    /*
+
+    set_struct_width
+    Gives a struct type passed or returned by value its width from the struct table
+
+    @param  t   The type to update
+    @param  structs The struct table, if available
+    @param  line    The line where the type is used
+    @return Whether the width was set
+
+    */
+
+    if (
+        !structs ||
+        t.get_primary() != STRUCT ||
+        t.get_qualities().is_dynamic() ||
+        t.get_qualities().is_static() ||
+        !structs->contains(t.get_struct_name())
+    ) {
+        return false;
+    }
+
+    struct_info &info = structs->find(t.get_struct_name(), line);
+    if (!info.is_width_known()) {
+        return false;
+    }
+
+    t.set_struct_width(info.get_width());
+    return true;
+}
+
+template function_symbol function_util::create_function_symbol(const FunctionDefinition&, bool, bool, const std::string&, unsigned int, bool, struct_table*);
+template function_symbol function_util::create_function_symbol(const Declaration&, bool, bool, const std::string&, unsigned int, bool, struct_table*);
 template <typename T>
 function_symbol function_util::create_function_symbol(
     const T& def,
@@ -38,7 +93,8 @@ function_symbol function_util::create_function_symbol(
     bool defined,
     const std::string& scope_name,
     unsigned int scope_level,
-    bool is_method
+    bool is_method,
+    struct_table *structs
 ) {
     /*
 
@@ -47,7 +103,10 @@ function_symbol function_util::create_function_symbol(
 
     This function is responsible for turning the Statement objects containing parameters into symbol objects, but it _does not_ add them to the symbol table (as it is not a member of compiler)
 
+    If the struct table is supplied, struct parameters and return types are given their widths so that small structs may be passed and returned in registers (see get_eightbytes)
+
     @param  def The definition or declaration from which to create our symbol
+    @param  structs The struct table, if available
     @return A symbol containing the function signature
 
     */
@@ -127,6 +186,20 @@ function_symbol function_util::create_function_symbol(
             throw CompilerException("Invalid statement type in function signature", compiler_errors::ILLEGAL_OPERATION_ERROR, def.get_line_number());
         }
 
+        // struct widths are only known once the struct has been defined
+        DataType param_type = param_sym.get_data_type();
+        if (set_struct_width(param_type, structs, def.get_line_number())) {
+            param_sym = symbol(
+                param_sym.get_name(),
+                param_sym.get_scope_name(),
+                param_sym.get_scope_level(),
+                param_type,
+                param_sym.get_offset(),
+                param_sym.is_defined(),
+                param_sym.get_line_defined()
+            );
+        }
+
         // ensure the first parameter is 'this' if we need it
         if (i == 0 && is_method && !has_this_parameter) {
             // ensure we have a typename of 'this', make sure it's the right type
@@ -172,16 +245,21 @@ function_symbol function_util::create_function_symbol(
         );
     }
 
+    // so is the width of a returned struct
+    DataType return_type = def.get_type_information();
+    set_struct_width(return_type, structs, def.get_line_number());
+
     // construct the object
     function_symbol to_return(
         name,
-        def.get_type_information(),
+        return_type,
         formal_parameters,
         scope_name,
         scope_level,
         def.get_calling_convention(),
         defined,
-        def.get_line_number()
+        def.get_line_number(),
+        structs
     );
 
     // finally, return the function symbol
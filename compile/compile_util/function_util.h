@@ -28,10 +28,11 @@ namespace function_util
         bool defined=true,
         const std::string& scope_name = "global",
         unsigned int scope_level = 0, 
-        bool is_method = false
+        bool is_method = false,
+        struct_table *structs = nullptr
     );
 
-    std::string call_sincall_subroutine(std::string name);
+    std::string call_sincall_subroutine(std::string name, bool internal = false);
 
     bool returns(StatementBlock to_check);
 }
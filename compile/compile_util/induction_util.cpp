@@ -0,0 +1,627 @@
+/*
+
+SIN Compiler Toolchain (x86 target)
+induction_util.cpp
+Copyright 2021 Riley Lannon
+
+Implementation of the induction variable utilities
+
+*/
+
+#include <unordered_map>
+#include <unordered_set>
+
+#include "induction_util.h"
+
+namespace
+{
+    struct loop_facts {
+        bool has_call;
+        bool has_indirect_store;
+        bool opaque;
+
+        std::unordered_set<std::string> allocated;  // names allocated in the loop
+        std::unordered_set<std::string> written;    // names changed by anything other than a step
+        std::unordered_map<std::string, std::vector<std::pair<const Statement*, long long>>> steps;
+        std::unordered_map<std::string, unsigned int> uses;    // outside of steps
+        std::vector<const Indexed*> accesses;   // unchecked accesses to named arrays
+
+        loop_facts()
+            : has_call(false)
+            , has_indirect_store(false)
+            , opaque(false)
+        {
+        }
+    };
+
+    bool get_step(const Statement &s, std::string &name, long long &delta) {
+        // a step is 'let i += c', 'let i -= c', or the same written as 'let i = i + c'
+        if (s.get_statement_type() != ASSIGNMENT && s.get_statement_type() != COMPOUND_ASSIGNMENT) {
+            return false;
+        }
+
+        auto &assign = static_cast<const Assignment&>(s);
+        if (assign.get_lvalue().get_expression_type() != IDENTIFIER || assign.get_rvalue().get_expression_type() != BINARY) {
+            return false;
+        }
+
+        name = static_cast<const Identifier&>(assign.get_lvalue()).getValue();
+        auto &b = static_cast<const Binary&>(assign.get_rvalue());
+        if (
+            (b.get_operator() != PLUS && b.get_operator() != MINUS) ||
+            b.get_left().get_expression_type() != IDENTIFIER ||
+            static_cast<const Identifier&>(b.get_left()).getValue() != name ||
+            !induction_util::get_int_literal(b.get_right(), delta)
+        ) {
+            return false;
+        }
+
+        if (b.get_operator() == MINUS) {
+            delta = -delta;
+        }
+        return true;
+    }
+
+    std::string get_root(const Expression &lvalue) {
+        switch (lvalue.get_expression_type()) {
+            case IDENTIFIER:
+                return static_cast<const Identifier&>(lvalue).getValue();
+            case INDEXED:
+                return get_root(static_cast<const Indexed&>(lvalue).get_to_index());
+            case BINARY:
+                return get_root(static_cast<const Binary&>(lvalue).get_left());
+            default:
+                return "";
+        }
+    }
+
+    void collect_expression(const Expression &e, loop_facts &facts) {
+        switch (e.get_expression_type()) {
+            case IDENTIFIER:
+                facts.uses[static_cast<const Identifier&>(e).getValue()] += 1;
+                break;
+            case INDEXED:
+            {
+                auto &idx = static_cast<const Indexed&>(e);
+                if (!idx.is_bounds_checked() && idx.get_to_index().get_expression_type() == IDENTIFIER) {
+                    facts.accesses.push_back(&idx);
+                }
+                collect_expression(idx.get_to_index(), facts);
+                collect_expression(idx.get_index_value(), facts);
+                break;
+            }
+            case LIST:
+                for (auto member: static_cast<const ListExpression&>(e).get_list()) {
+                    collect_expression(*member, facts);
+                }
+                break;
+            case BINARY:
+            {
+                auto &b = static_cast<const Binary&>(e);
+                collect_expression(b.get_left(), facts);
+                if (b.get_operator() != DOT) {
+                    collect_expression(b.get_right(), facts);
+                }
+                break;
+            }
+            case UNARY:
+                collect_expression(static_cast<const Unary&>(e).get_operand(), facts);
+                break;
+            case CAST:
+                collect_expression(static_cast<const Cast&>(e).get_exp(), facts);
+                break;
+            case ATTRIBUTE:
+                collect_expression(static_cast<const AttributeSelection&>(e).get_selected(), facts);
+                break;
+            case CALL_EXP:
+            case PROC_EXP:
+                facts.has_call = true;
+                break;
+            default:
+                break;
+        }
+    }
+
+    void write_lvalue(const Expression &lvalue, loop_facts &facts) {
+        // writing to an element doesn't move the array, but anything else changes the name it is rooted in
+        if (lvalue.get_expression_type() == INDEXED) {
+            return;
+        }
+
+        std::string root = get_root(lvalue);
+        if (root.empty() || lvalue.get_expression_type() == UNARY) {
+            facts.has_indirect_store = true;
+        }
+        else {
+            facts.written.insert(root);
+        }
+    }
+
+    void collect_statement(const Statement &s, loop_facts &facts, symbol_table &symbols) {
+        switch (s.get_statement_type()) {
+            case ALLOCATION:
+            {
+                auto &alloc = static_cast<const Allocation&>(s);
+                if (alloc.get_type_information().get_primary() == REFERENCE) {
+                    facts.has_indirect_store = true;
+                }
+                else {
+                    facts.allocated.insert(alloc.get_name());
+                }
+                facts.written.insert(alloc.get_name());
+                if (alloc.get_initial_value()) {
+                    collect_expression(*alloc.get_initial_value(), facts);
+                }
+                break;
+            }
+            case ASSIGNMENT:
+            case COMPOUND_ASSIGNMENT:
+            {
+                auto &assign = static_cast<const Assignment&>(s);
+                std::string name;
+                long long delta;
+                if (get_step(s, name, delta)) {
+                    facts.steps[name].push_back(std::make_pair(&s, delta));
+                    break;
+                }
+
+                // assigning to a reference writes to whatever it refers to
+                if (assign.get_lvalue().get_expression_type() == IDENTIFIER) {
+                    std::string target = static_cast<const Identifier&>(assign.get_lvalue()).getValue();
+                    if (
+                        !facts.allocated.count(target) &&
+                        (!symbols.contains(target) || symbols.find(target).get_data_type().get_primary() == REFERENCE)
+                    ) {
+                        facts.has_indirect_store = true;
+                    }
+                }
+
+                write_lvalue(assign.get_lvalue(), facts);
+                collect_expression(assign.get_lvalue(), facts);
+                collect_expression(assign.get_rvalue(), facts);
+                break;
+            }
+            case MOVEMENT:
+            {
+                auto &move = static_cast<const Movement&>(s);
+                write_lvalue(move.get_lvalue(), facts);
+                write_lvalue(move.get_rvalue(), facts);
+                collect_expression(move.get_lvalue(), facts);
+                collect_expression(move.get_rvalue(), facts);
+                break;
+            }
+            case FREE_MEMORY:
+            {
+                auto &free_stmt = static_cast<const FreeMemory&>(s);
+                write_lvalue(free_stmt.get_freed_memory(), facts);
+                collect_expression(free_stmt.get_freed_memory(), facts);
+                break;
+            }
+            case RETURN_STATEMENT:
+                collect_expression(static_cast<const ReturnStatement&>(s).get_return_exp(), facts);
+                break;
+            case IF_THEN_ELSE:
+            {
+                auto &ite = static_cast<const IfThenElse&>(s);
+                collect_expression(ite.get_condition(), facts);
+                if (ite.get_if_branch()) collect_statement(*ite.get_if_branch(), facts, symbols);
+                if (ite.get_else_branch()) collect_statement(*ite.get_else_branch(), facts, symbols);
+                break;
+            }
+            case WHILE_LOOP:
+            {
+                auto &loop = static_cast<const WhileLoop&>(s);
+                collect_expression(loop.get_condition(), facts);
+                if (loop.get_branch()) collect_statement(*loop.get_branch(), facts, symbols);
+                break;
+            }
+            case SCOPE_BLOCK:
+                for (auto stmt: static_cast<const ScopedBlock&>(s).get_statements().statements_list) {
+                    collect_statement(*stmt, facts, symbols);
+                }
+                break;
+            case CALL:
+                facts.has_call = true;
+                break;
+            default:
+                // inline assembly may do anything at all
+                facts.opaque = true;
+                break;
+        }
+    }
+
+    bool is_invariant_name(const std::string &name, const loop_facts &facts, const function_info &fn, symbol_table &symbols) {
+        // a name the loop doesn't change, directly or (for names that aren't locals, or whose address has escaped) through a pointer
+        if (facts.written.count(name) || facts.steps.count(name) || !symbols.contains(name)) {
+            return false;
+        }
+        else if (fn.is_local(name)) {
+            return !fn.is_address_taken(name);
+        }
+        return !facts.has_indirect_store;
+    }
+
+    // the results of a search for a loop
+    enum loop_search {
+        NOT_FOUND,
+        USED_AFTER,
+        UNUSED_AFTER,
+        OUT_OF_SCOPE    // unused after, and the name's scope ends before any enclosing loop repeats
+    };
+
+    loop_search find_loop(const Statement &s, const Statement &loop, const std::string &name);
+
+    loop_search find_loop(const StatementBlock &block, const Statement &loop, const std::string &name) {
+        /*
+
+        Looks for the loop in a block, and whether the name is used after it
+
+        */
+
+        auto &list = block.statements_list;
+        for (size_t i = 0; i < list.size(); i++) {
+            loop_search found = (list[i].get() == &loop) ? UNUSED_AFTER : find_loop(*list[i], loop, name);
+            if (found != UNUSED_AFTER) {
+                if (found == NOT_FOUND) {
+                    continue;
+                }
+                return found;
+            }
+
+            for (size_t j = i + 1; j < list.size(); j++) {
+                if (induction_util::mentions(*list[j], name)) {
+                    return USED_AFTER;
+                }
+            }
+
+            // if the name was allocated in this block, an enclosing loop allocates it again on its next iteration
+            for (size_t j = 0; j < i; j++) {
+                if (list[j]->get_statement_type() == ALLOCATION && static_cast<const Allocation&>(*list[j]).get_name() == name) {
+                    return OUT_OF_SCOPE;
+                }
+            }
+            return UNUSED_AFTER;
+        }
+
+        return NOT_FOUND;
+    }
+
+    loop_search find_loop(const Statement &s, const Statement &loop, const std::string &name) {
+        switch (s.get_statement_type()) {
+            case SCOPE_BLOCK:
+                return find_loop(static_cast<const ScopedBlock&>(s).get_statements(), loop, name);
+            case IF_THEN_ELSE:
+            {
+                auto &ite = static_cast<const IfThenElse&>(s);
+                for (auto branch: { ite.get_if_branch(), ite.get_else_branch() }) {
+                    if (branch) {
+                        loop_search found = (branch == &loop) ? UNUSED_AFTER : find_loop(*branch, loop, name);
+                        if (found != NOT_FOUND) {
+                            return found;
+                        }
+                    }
+                }
+                return NOT_FOUND;
+            }
+            case WHILE_LOOP:
+            {
+                // otherwise, the next iteration of an enclosing loop may use the name
+                auto branch = static_cast<const WhileLoop&>(s).get_branch();
+                if (!branch) {
+                    return NOT_FOUND;
+                }
+
+                loop_search found = (branch == &loop) ? USED_AFTER : find_loop(*branch, loop, name);
+                return (found == NOT_FOUND || found == OUT_OF_SCOPE) ? found : USED_AFTER;
+            }
+            default:
+                return NOT_FOUND;
+        }
+    }
+}
+
+namespace induction_util
+{
+    bool get_int_literal(const Expression &e, long long &value) {
+        if (e.get_expression_type() != LITERAL) {
+            return false;
+        }
+
+        auto &literal = static_cast<const Literal&>(e);
+        if (literal.get_data_type().get_primary() != INT) {
+            return false;
+        }
+
+        try {
+            value = std::stoll(literal.get_value());
+        }
+        catch (std::exception &) {
+            return false;
+        }
+        return true;
+    }
+
+    bool mentions(const Expression &e, const std::string &name) {
+        switch (e.get_expression_type()) {
+            case IDENTIFIER:
+                return static_cast<const Identifier&>(e).getValue() == name;
+            case INDEXED:
+            {
+                auto &idx = static_cast<const Indexed&>(e);
+                return mentions(idx.get_to_index(), name) || mentions(idx.get_index_value(), name);
+            }
+            case LIST:
+                for (auto member: static_cast<const ListExpression&>(e).get_list()) {
+                    if (mentions(*member, name)) {
+                        return true;
+                    }
+                }
+                return false;
+            case BINARY:
+            {
+                auto &b = static_cast<const Binary&>(e);
+                return mentions(b.get_left(), name) || (b.get_operator() != DOT && mentions(b.get_right(), name));
+            }
+            case UNARY:
+                return mentions(static_cast<const Unary&>(e).get_operand(), name);
+            case CAST:
+                return mentions(static_cast<const Cast&>(e).get_exp(), name);
+            case ATTRIBUTE:
+                return mentions(static_cast<const AttributeSelection&>(e).get_selected(), name);
+            case CALL_EXP:
+            case PROC_EXP:
+            {
+                auto &proc = static_cast<const Procedure&>(e);
+                return mentions(proc.get_func_name(), name) || mentions(proc.get_args(), name);
+            }
+            default:
+                return false;
+        }
+    }
+
+    bool mentions(const Statement &s, const std::string &name) {
+        switch (s.get_statement_type()) {
+            case ALLOCATION:
+            {
+                auto &alloc = static_cast<const Allocation&>(s);
+                return alloc.get_name() == name || (alloc.get_initial_value() && mentions(*alloc.get_initial_value(), name));
+            }
+            case ASSIGNMENT:
+            case COMPOUND_ASSIGNMENT:
+            {
+                auto &assign = static_cast<const Assignment&>(s);
+                return mentions(assign.get_lvalue(), name) || mentions(assign.get_rvalue(), name);
+            }
+            case MOVEMENT:
+            {
+                auto &move = static_cast<const Movement&>(s);
+                return mentions(move.get_lvalue(), name) || mentions(move.get_rvalue(), name);
+            }
+            case FREE_MEMORY:
+                return mentions(static_cast<const FreeMemory&>(s).get_freed_memory(), name);
+            case RETURN_STATEMENT:
+                return mentions(static_cast<const ReturnStatement&>(s).get_return_exp(), name);
+            case IF_THEN_ELSE:
+            {
+                auto &ite = static_cast<const IfThenElse&>(s);
+                return mentions(ite.get_condition(), name) ||
+                    (ite.get_if_branch() && mentions(*ite.get_if_branch(), name)) ||
+                    (ite.get_else_branch() && mentions(*ite.get_else_branch(), name));
+            }
+            case WHILE_LOOP:
+            {
+                auto &loop = static_cast<const WhileLoop&>(s);
+                return mentions(loop.get_condition(), name) || (loop.get_branch() && mentions(*loop.get_branch(), name));
+            }
+            case SCOPE_BLOCK:
+                for (auto stmt: static_cast<const ScopedBlock&>(s).get_statements().statements_list) {
+                    if (mentions(*stmt, name)) {
+                        return true;
+                    }
+                }
+                return false;
+            case CALL:
+                return mentions(static_cast<const Expression&>(static_cast<const Call&>(s)), name);
+            default:
+                // inline assembly may refer to anything
+                return true;
+        }
+    }
+
+    bool is_used_after(const StatementBlock &body, const Statement &loop, const std::string &name) {
+        /*
+
+        is_used_after
+        Determines whether a name may be used once a loop has finished
+
+        Anything mentioned after the loop in the function is considered used, as is anything in an enclosing loop that is not allocated again on its next iteration; if the loop can't be found, the name is assumed to be used
+
+        */
+
+        loop_search found = find_loop(body, loop, name);
+        return found == NOT_FOUND || found == USED_AFTER;
+    }
+
+    std::vector<induction_variable> analyze_loop(
+        const WhileLoop &loop,
+        const StatementBlock &body,
+        const function_info &fn,
+        symbol_table &symbols
+    ) {
+        /*
+
+        analyze_loop
+        Finds the induction variables of a loop and the array accesses that may use pointers derived from them
+
+        Only loops without calls or inline assembly are considered. An induction variable must be a 32-bit integer local whose address is never taken, and which the loop changes only by adding or subtracting constants. An access 'a[i]', 'a[i + c]', or 'a[i - c]' may use a derived pointer if its bounds check was removed by the optimizer, and 'a' is an array or string that the loop doesn't change.
+
+        */
+
+        std::vector<induction_variable> ivs;
+
+        loop_facts facts;
+        collect_expression(loop.get_condition(), facts);
+        if (loop.get_branch()) {
+            collect_statement(*loop.get_branch(), facts, symbols);
+        }
+
+        if (facts.has_call || facts.opaque) {
+            return ivs;
+        }
+
+        std::unordered_map<std::string, size_t> iv_index;
+        for (auto &s: facts.steps) {
+            const std::string &name = s.first;
+            if (facts.written.count(name) || !fn.is_local(name) || fn.is_address_taken(name) || !symbols.contains(name)) {
+                continue;
+            }
+
+            const DataType &t = symbols.find(name).get_data_type();
+            if (t.get_primary() != INT || t.get_width() != 4) {
+                continue;
+            }
+
+            induction_variable iv;
+            iv.name = name;
+            iv.is_signed = t.get_qualities().is_signed();
+            iv.steps = s.second;
+            iv.limit = nullptr;
+            iv.inclusive = false;
+            iv_index[name] = ivs.size();
+            ivs.push_back(iv);
+        }
+
+        // group the accesses by the pointer they can use
+        std::unordered_map<std::string, unsigned int> reduced_uses;
+        for (auto idx: facts.accesses) {
+            // get the induction variable and offset
+            const Expression &index = idx->get_index_value();
+            const Expression *name_exp = &index;
+            long long offset = 0;
+            if (index.get_expression_type() == BINARY) {
+                auto &b = static_cast<const Binary&>(index);
+                if (b.get_operator() == PLUS && get_int_literal(b.get_right(), offset)) {
+                    name_exp = &b.get_left();
+                }
+                else if (b.get_operator() == PLUS && get_int_literal(b.get_left(), offset)) {
+                    name_exp = &b.get_right();
+                }
+                else if (b.get_operator() == MINUS && get_int_literal(b.get_right(), offset)) {
+                    name_exp = &b.get_left();
+                    offset = -offset;
+                }
+                else {
+                    continue;
+                }
+            }
+
+            if (name_exp->get_expression_type() != IDENTIFIER) {
+                continue;
+            }
+
+            auto it = iv_index.find(static_cast<const Identifier&>(*name_exp).getValue());
+            std::string array = static_cast<const Identifier&>(idx->get_to_index()).getValue();
+            if (it == iv_index.end() || !is_invariant_name(array, facts, fn, symbols)) {
+                continue;
+            }
+
+            // the element width, as used by compiler::get_exp_address
+            const DataType &array_type = symbols.find(array).get_data_type();
+            size_t width;
+            if (array_type.get_primary() == STRING) {
+                width = 1;
+            }
+            else if (array_type.get_primary() == ARRAY) {
+                Type element = array_type.get_subtype().get_primary();
+                width = array_type.get_subtype().get_width();
+                if ((element != INT && element != FLOAT && element != BOOL && element != CHAR) || (width != 1 && width != 2 && width != 4 && width != 8)) {
+                    continue;
+                }
+            }
+            else {
+                continue;
+            }
+
+            induction_variable &iv = ivs[it->second];
+            reduced_uses[iv.name] += 1;
+
+            bool found = false;
+            for (auto &p: iv.pointers) {
+                if (p.array == array && p.offset == offset) {
+                    p.accesses.push_back(idx);
+                    found = true;
+                    break;
+                }
+            }
+
+            if (!found) {
+                derived_pointer p;
+                p.array = array;
+                p.array_exp = &idx->get_to_index();
+                p.offset = offset;
+                p.width = width;
+                p.accesses.push_back(idx);
+                iv.pointers.push_back(p);
+            }
+        }
+
+        // if the exit test is the only other use of a variable, and it isn't used after the loop, the test may compare pointers instead
+        if (loop.get_condition().get_expression_type() == BINARY) {
+            auto &condition = static_cast<const Binary&>(loop.get_condition());
+            auto it = iv_index.end();
+            if ((condition.get_operator() == LESS || condition.get_operator() == LESS_OR_EQUAL) && condition.get_left().get_expression_type() == IDENTIFIER) {
+                it = iv_index.find(static_cast<const Identifier&>(condition.get_left()).getValue());
+            }
+
+            if (it != iv_index.end()) {
+                induction_variable &iv = ivs[it->second];
+                const Expression &limit = condition.get_right();
+
+                // the limit must not change in the loop, and must be compared with the same signedness
+                bool valid_limit = false;
+                long long value;
+                if (get_int_literal(limit, value)) {
+                    valid_limit = value >= 0;
+                }
+                else if (limit.get_expression_type() == IDENTIFIER) {
+                    std::string name = static_cast<const Identifier&>(limit).getValue();
+                    if (is_invariant_name(name, facts, fn, symbols)) {
+                        const DataType &t = symbols.find(name).get_data_type();
+                        valid_limit = t.get_primary() == INT && t.get_width() == 4 && t.get_qualities().is_signed() == iv.is_signed;
+                    }
+                }
+                else if (limit.get_expression_type() == ATTRIBUTE) {
+                    auto &attr = static_cast<const AttributeSelection&>(limit);
+                    valid_limit = !iv.is_signed && attr.get_attribute() == LENGTH && attr.get_selected().get_expression_type() == IDENTIFIER &&
+                        is_invariant_name(static_cast<const Identifier&>(attr.get_selected()).getValue(), facts, fn, symbols);
+                }
+
+                // the pointer only tracks the variable while neither wraps around, so it must only ever count up
+                bool increasing = true;
+                for (auto &step: iv.steps) {
+                    increasing = increasing && step.second > 0;
+                }
+
+                if (
+                    valid_limit &&
+                    increasing &&
+                    !iv.pointers.empty() &&
+                    facts.uses[iv.name] == reduced_uses[iv.name] + 1 &&
+                    !is_used_after(body, loop, iv.name)
+                ) {
+                    iv.limit = &limit;
+                    iv.inclusive = condition.get_operator() == LESS_OR_EQUAL;
+                }
+            }
+        }
+
+        // only keep the variables we can do something with
+        std::vector<induction_variable> reducible;
+        for (auto &iv: ivs) {
+            if (!iv.pointers.empty()) {
+                reducible.push_back(iv);
+            }
+        }
+        return reducible;
+    }
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+/*
+
+SIN Compiler Toolchain (x86 target)
+induction_util.h
+Copyright 2021 Riley Lannon
+
+Utilities for the strength reduction of array accesses in 'while' loops
+
+An access 'a[i]' normally computes 'a + 4 + i * width' from scratch. When 'i' is an induction variable -- it is only ever changed in the loop by adding or subtracting a constant -- the address of the element changes by a constant, too, so the loop can carry it as a pointer that is advanced whenever 'i' is. If, after that, 'i' is only used to test whether the loop should continue, the test can compare the pointer against the address of the final element instead, and 'i' no longer needs to be updated at all.
+
+*/
+
+#include <string>
+#include <vector>
+
+#include "symbol_table.h"
+#include "../../parser/Statement.h"
+#include "../opt/function_info.h"
+
+namespace induction_util
+{
+    // a pointer to 'array[iv + offset]'
+    struct derived_pointer {
+        std::string array;
+        const Expression *array_exp;
+        long long offset;
+        size_t width;   // of an element
+        std::vector<const Indexed*> accesses;
+    };
+
+    struct induction_variable {
+        std::string name;
+        bool is_signed;
+        std::vector<std::pair<const Statement*, long long>> steps;  // the statements that update it, and by how much
+        std::vector<derived_pointer> pointers;
+
+        // if the exit test is 'iv < limit' (or '<=') and the variable is otherwise unused, the test may compare the first pointer instead
+        const Expression *limit;
+        bool inclusive;
+    };
+
+    bool get_int_literal(const Expression &e, long long &value);
+
+    bool mentions(const Expression &e, const std::string &name);
+    bool mentions(const Statement &s, const std::string &name);
+    bool is_used_after(const StatementBlock &body, const Statement &loop, const std::string &name);
+
+    std::vector<induction_variable> analyze_loop(
+        const WhileLoop &loop,
+        const StatementBlock &body,
+        const function_info &fn,
+        symbol_table &symbols
+    );
+}
@@ -0,0 +1,736 @@
+/*
+
+SIN Toolchain (x86 target)
+interpreter.cpp
+Copyright 2021 Riley Lannon
+
+Implementation of the compile-time interpreter
+
+*/
+
+#include <limits>
+
+#include "interpreter.h"
+
+interpreter::evaluation_failure::evaluation_failure(const std::string &reason)
+	: reason(reason)
+{
+}
+
+interpreter::value::value(const DataType &type, long long scalar)
+	: type(type)
+	, scalar(scalar)
+	, initialized(true)
+{
+}
+
+interpreter::value::value(const DataType &type)
+	: type(type)
+	, scalar(0)
+	, initialized(false)
+{
+}
+
+void interpreter::step() {
+	this->steps += 1;
+	if (this->steps > MAX_STEPS) {
+		throw evaluation_failure("the evaluation exceeded " + std::to_string(MAX_STEPS) + " steps");
+	}
+}
+
+void interpreter::get_int_range(const DataType &t, long long &min, long long &max) {
+	/*
+
+	get_int_range
+	Gets the range of values an integer type may hold
+
+	Values are held in a 'long long', so the upper half of 'unsigned long int' is out of range
+
+	*/
+
+	unsigned int bits = t.get_width() * 8;
+	if (bits >= 64) {
+		min = t.get_qualities().is_signed() ? std::numeric_limits<long long>::min() : 0;
+		max = std::numeric_limits<long long>::max();
+	}
+	else if (t.get_qualities().is_signed()) {
+		min = -(1LL << (bits - 1));
+		max = (1LL << (bits - 1)) - 1;
+	}
+	else {
+		min = 0;
+		max = (1LL << bits) - 1;
+	}
+}
+
+bool interpreter::fits(const DataType &t, long long v) {
+	long long min, max;
+	get_int_range(t, min, max);
+	return v >= min && v <= max;
+}
+
+bool interpreter::is_scalar_type(const DataType &t) {
+	return (t.get_primary() == INT || t.get_primary() == BOOL) && !t.get_qualities().is_static();
+}
+
+interpreter::value interpreter::convert(const value &v, const DataType &to) {
+	/*
+
+	convert
+	Converts a value to the type of the data it is being stored in or passed as
+
+	The conversion must not change the value; a value that doesn't fit in the new type fails
+
+	*/
+
+	if (!is_scalar_type(to) || v.type.get_primary() != to.get_primary()) {
+		throw evaluation_failure("unsupported type");
+	}
+	else if (to.get_primary() == INT && !fits(to, v.scalar)) {
+		throw evaluation_failure("a value does not fit in its type");
+	}
+
+	return value(to, v.scalar);
+}
+
+void interpreter::release_scope() {
+	// leaves the innermost scope of the current frame, releasing the memory held by its arrays
+	for (auto &local: this->frames.back().scopes.back()) {
+		this->memory -= local.second.elements.size() * local.second.type.get_subtype().get_width();
+	}
+	this->frames.back().scopes.pop_back();
+}
+
+interpreter::value *interpreter::find_local(const std::string &name) {
+	auto &scopes = this->frames.back().scopes;
+	for (auto it = scopes.rbegin(); it != scopes.rend(); it++) {
+		auto found = it->find(name);
+		if (found != it->end()) {
+			return &found->second;
+		}
+	}
+
+	return nullptr;
+}
+
+interpreter::value &interpreter::get_lvalue(const Expression &e, size_t &index, bool &is_element) {
+	/*
+
+	get_lvalue
+	Finds the local data named by an lvalue expression -- either a variable or an element of a local array
+
+	@param	e	The lvalue expression
+	@param	index	Set to the element index if the lvalue is an array element
+	@param	is_element	Set to whether the lvalue is an array element
+	@return	The variable (or array containing the element)
+
+	*/
+
+	is_element = false;
+
+	if (e.get_expression_type() == IDENTIFIER) {
+		auto &name = static_cast<const Identifier&>(e).getValue();
+		value *v = this->find_local(name);
+		if (!v) {
+			throw evaluation_failure("'" + name + "' is not local to the function");
+		}
+		return *v;
+	}
+	else if (e.get_expression_type() == INDEXED) {
+		auto &idx = static_cast<const Indexed&>(e);
+		value i = this->evaluate_expression(idx.get_index_value());
+
+		size_t inner_index;
+		bool inner_is_element;
+		value &array = this->get_lvalue(idx.get_to_index(), inner_index, inner_is_element);
+		if (inner_is_element || array.type.get_primary() != ARRAY || i.type.get_primary() != INT) {
+			throw evaluation_failure("unsupported type");
+		}
+		else if (i.scalar < 0 || (unsigned long long)i.scalar >= array.elements.size()) {
+			throw evaluation_failure("an index is out of bounds");
+		}
+
+		index = (size_t)i.scalar;
+		is_element = true;
+		return array;
+	}
+
+	throw evaluation_failure("unsupported expression");
+}
+
+void interpreter::store(const Expression &lvalue, const value &v) {
+	size_t index;
+	bool is_element;
+	value &target = this->get_lvalue(lvalue, index, is_element);
+
+	if (is_element) {
+		value converted = convert(v, target.type.get_subtype());
+		target.elements[index] = converted.scalar;
+		target.elements_initialized[index] = true;
+	}
+	else if (target.type.get_qualities().is_const()) {
+		throw evaluation_failure("assignment to const data");
+	}
+	else {
+		target = convert(v, target.type);
+	}
+}
+
+interpreter::value interpreter::evaluate_arithmetic(exp_operator op, const value &left, const value &right) {
+	/*
+
+	evaluate_arithmetic
+	Evaluates an operator on two integers the way the generated code would
+
+	The operation is carried out at the width of the left operand, and the result has the type of the wider operand. Values are only produced when they are the same regardless of these widths and of signedness, so:
+		* the result must fit in both the left operand's type and the result type
+		* if the operands differ in signedness, neither may be negative
+
+	*/
+
+	const long long max = std::numeric_limits<long long>::max();
+	const long long min = std::numeric_limits<long long>::min();
+
+	long long a = left.scalar;
+	long long b = right.scalar;
+
+	if (left.type.get_qualities().is_signed() != right.type.get_qualities().is_signed() && (a < 0 || b < 0)) {
+		throw evaluation_failure("signed/unsigned mismatch on a negative value");
+	}
+
+	switch (op) {
+		case EQUAL:
+			return value(DataType(BOOL), a == b);
+		case NOT_EQUAL:
+			return value(DataType(BOOL), a != b);
+		case GREATER:
+			return value(DataType(BOOL), a > b);
+		case LESS:
+			return value(DataType(BOOL), a < b);
+		case GREATER_OR_EQUAL:
+			return value(DataType(BOOL), a >= b);
+		case LESS_OR_EQUAL:
+			return value(DataType(BOOL), a <= b);
+		default:
+			break;
+	}
+
+	long long result;
+	switch (op) {
+		case PLUS:
+			if ((b > 0 && a > max - b) || (b < 0 && a < min - b)) {
+				throw evaluation_failure("integer overflow");
+			}
+			result = a + b;
+			break;
+		case MINUS:
+			if ((b < 0 && a > max + b) || (b > 0 && a < min + b)) {
+				throw evaluation_failure("integer overflow");
+			}
+			result = a - b;
+			break;
+		case MULT:
+			if (a != 0 && b != 0) {
+				bool overflow = (a > 0)
+					? ((b > 0) ? a > max / b : b < min / a)
+					: ((b > 0) ? a < min / b : b < max / a);
+				if (overflow) {
+					throw evaluation_failure("integer overflow");
+				}
+			}
+			result = a * b;
+			break;
+		case DIV:
+		case MODULO:
+			if (b == 0) {
+				throw evaluation_failure("division by zero");
+			}
+			else if (a == min && b == -1) {
+				throw evaluation_failure("integer overflow");
+			}
+			result = (op == DIV) ? a / b : a % b;
+			break;
+		case BIT_AND:
+		case BIT_OR:
+		case BIT_XOR:
+			// the register names used depend on each operand's width, so only operands of the same width are evaluated
+			if (left.type.get_width() != right.type.get_width()) {
+				throw evaluation_failure("width mismatch");
+			}
+			result = (op == BIT_AND) ? (a & b) : (op == BIT_OR) ? (a | b) : (a ^ b);
+			break;
+		case LEFT_SHIFT:
+		case RIGHT_SHIFT:
+		{
+			if (b < 0 || b >= (long long)left.type.get_width() * 8) {
+				throw evaluation_failure("shift count out of range");
+			}
+
+			if (op == LEFT_SHIFT) {
+				long long factor = 1LL << b;
+				if ((b == 63) || (a > 0 && a > max / factor) || (a < 0 && a < min / factor)) {
+					throw evaluation_failure("integer overflow");
+				}
+				result = a * factor;
+			}
+			else {
+				// signed values use an arithmetic shift, which rounds toward negative infinity
+				result = (a >= 0) ? (a >> b) : -((-(a + 1)) >> b) - 1;
+			}
+			break;
+		}
+		default:
+			throw evaluation_failure("unsupported operator");
+	}
+
+	DataType result_type = (left.type.get_width() >= right.type.get_width()) ? left.type : right.type;
+	if (!fits(left.type, result) || !fits(result_type, result)) {
+		throw evaluation_failure("integer overflow");
+	}
+
+	return value(result_type, result);
+}
+
+interpreter::value interpreter::evaluate_binary(const Binary &b) {
+	exp_operator op = b.get_operator();
+
+	// the logical operators short-circuit, just like the generated code
+	if (op == AND || op == OR) {
+		bool left = this->evaluate_condition(b.get_left());
+		if (left == (op == OR)) {
+			return value(DataType(BOOL), left);
+		}
+		return value(DataType(BOOL), this->evaluate_condition(b.get_right()));
+	}
+
+	value left = this->evaluate_expression(b.get_left());
+	value right = this->evaluate_expression(b.get_right());
+
+	if (left.type.get_primary() == BOOL && right.type.get_primary() == BOOL) {
+		switch (op) {
+			case EQUAL:
+				return value(DataType(BOOL), left.scalar == right.scalar);
+			case NOT_EQUAL:
+			case XOR:
+				return value(DataType(BOOL), left.scalar != right.scalar);
+			default:
+				throw evaluation_failure("unsupported operator");
+		}
+	}
+	else if (left.type.get_primary() == INT && right.type.get_primary() == INT) {
+		return this->evaluate_arithmetic(op, left, right);
+	}
+
+	throw evaluation_failure("unsupported type");
+}
+
+interpreter::value interpreter::evaluate_unary(const Unary &u) {
+	value operand = this->evaluate_expression(u.get_operand());
+
+	if (operand.type.get_primary() == BOOL && u.get_operator() == NOT) {
+		return value(operand.type, !operand.scalar);
+	}
+	else if (operand.type.get_primary() == INT) {
+		long long result;
+		switch (u.get_operator()) {
+			case UNARY_PLUS:
+				return operand;
+			case UNARY_MINUS:
+				if (operand.scalar == std::numeric_limits<long long>::min()) {
+					throw evaluation_failure("integer overflow");
+				}
+				result = -operand.scalar;
+				break;
+			case BIT_NOT:
+			{
+				long long min, max;
+				get_int_range(operand.type, min, max);
+				if (min < 0) {
+					result = ~operand.scalar;
+				}
+				else if (operand.type.get_width() < 8) {
+					result = max - operand.scalar;
+				}
+				else {
+					throw evaluation_failure("integer overflow");
+				}
+				break;
+			}
+			default:
+				throw evaluation_failure("unsupported operator");
+		}
+
+		if (!fits(operand.type, result)) {
+			throw evaluation_failure("integer overflow");
+		}
+		return value(operand.type, result);
+	}
+
+	throw evaluation_failure("unsupported operator");
+}
+
+interpreter::value interpreter::evaluate_call(const Procedure &call) {
+	/*
+
+	evaluate_call
+	Executes a call to a function defined in the program
+
+	*/
+
+	if (call.get_func_name().get_expression_type() != IDENTIFIER) {
+		throw evaluation_failure("unsupported call");
+	}
+
+	auto &name = static_cast<const Identifier&>(call.get_func_name()).getValue();
+	auto it = this->functions.find(name);
+	if (it == this->functions.end()) {
+		throw evaluation_failure("'" + name + "' is not a function that can be evaluated at compile time");
+	}
+
+	const FunctionDefinition &def = *it->second;
+	auto params = def.get_formal_parameters();
+	if (params.size() != call.get_num_args()) {
+		throw evaluation_failure("wrong number of arguments to '" + name + "'");
+	}
+	else if (this->frames.size() >= MAX_CALL_DEPTH) {
+		throw evaluation_failure("calls were nested more than " + std::to_string(MAX_CALL_DEPTH) + " deep");
+	}
+
+	// evaluate the arguments in the caller's frame, then bind them in the callee's
+	std::unordered_map<std::string, value> bound;
+	for (size_t i = 0; i < params.size(); i++) {
+		if (params[i]->get_statement_type() != ALLOCATION) {
+			throw evaluation_failure("unsupported parameter");
+		}
+
+		auto &param = static_cast<const Allocation&>(*params[i]);
+		value arg = this->evaluate_expression(call.get_arg(i));
+		bound.insert(std::make_pair(param.get_name(), convert(arg, param.get_type_information())));
+	}
+
+	frame f;
+	f.scopes.push_back(std::move(bound));
+	this->frames.push_back(std::move(f));
+
+	exec_result result = this->execute_block(def.get_procedure());
+	std::unique_ptr<value> returned = std::move(this->frames.back().return_value);
+	this->release_scope();
+	this->frames.pop_back();
+
+	if (result != RETURNED || !returned) {
+		throw evaluation_failure("'" + name + "' did not return a value");
+	}
+
+	return convert(*returned, def.get_type_information());
+}
+
+bool interpreter::evaluate_condition(const Expression &e) {
+	value v = this->evaluate_expression(e);
+	if (v.type.get_primary() != BOOL) {
+		throw evaluation_failure("unsupported type");
+	}
+	return v.scalar != 0;
+}
+
+interpreter::value interpreter::evaluate_expression(const Expression &e) {
+	this->step();
+
+	switch (e.get_expression_type()) {
+		case LITERAL:
+		{
+			auto &literal = static_cast<const Literal&>(e);
+			const DataType &t = literal.get_data_type();
+
+			if (t.get_primary() == BOOL) {
+				if (literal.get_value() == "true") {
+					return value(t, 1);
+				}
+				else if (literal.get_value() == "false") {
+					return value(t, 0);
+				}
+			}
+			else if (t.get_primary() == INT) {
+				try {
+					size_t pos;
+					long long v = std::stoll(literal.get_value(), &pos, 10);
+					if (pos == literal.get_value().size() && fits(t, v)) {
+						return value(t, v);
+					}
+				}
+				catch (std::exception &e) {
+					// handled below
+				}
+			}
+
+			throw evaluation_failure("unsupported literal");
+		}
+		case IDENTIFIER:
+		{
+			auto &name = static_cast<const Identifier&>(e).getValue();
+			value *local = this->frames.empty() ? nullptr : this->find_local(name);
+			if (local) {
+				if (!is_scalar_type(local->type)) {
+					throw evaluation_failure("unsupported type");
+				}
+				else if (!local->initialized) {
+					throw evaluation_failure("'" + name + "' is used before it is assigned");
+				}
+				return *local;
+			}
+
+			// a name that isn't local must be a global constant
+			std::unique_ptr<Literal> constant = this->constants ? this->constants(name) : nullptr;
+			if (!constant) {
+				throw evaluation_failure("'" + name + "' is not a compile-time constant");
+			}
+			return this->evaluate_expression(*constant);
+		}
+		case INDEXED:
+		{
+			if (this->frames.empty()) {
+				throw evaluation_failure("unsupported expression");
+			}
+
+			size_t index;
+			bool is_element;
+			value &array = this->get_lvalue(e, index, is_element);
+			if (!array.elements_initialized[index]) {
+				throw evaluation_failure("an array element is used before it is assigned");
+			}
+			return value(array.type.get_subtype(), array.elements[index]);
+		}
+		case ATTRIBUTE:
+		{
+			auto &attr = static_cast<const AttributeSelection&>(e);
+			if (attr.get_attribute() != LENGTH || attr.get_selected().get_expression_type() != IDENTIFIER || this->frames.empty()) {
+				throw evaluation_failure("unsupported attribute");
+			}
+
+			value *array = this->find_local(static_cast<const Identifier&>(attr.get_selected()).getValue());
+			if (!array || array->type.get_primary() != ARRAY) {
+				throw evaluation_failure("unsupported attribute");
+			}
+
+			return value(attr.get_data_type(), (long long)array->elements.size());
+		}
+		case BINARY:
+			return this->evaluate_binary(static_cast<const Binary&>(e));
+		case UNARY:
+			return this->evaluate_unary(static_cast<const Unary&>(e));
+		case CALL_EXP:
+			return this->evaluate_call(static_cast<const Procedure&>(e));
+		default:
+			throw evaluation_failure("unsupported expression");
+	}
+}
+
+void interpreter::allocate(const Allocation &alloc) {
+	const DataType &t = alloc.get_type_information();
+
+	if (is_scalar_type(t)) {
+		if (alloc.was_initialized()) {
+			this->frames.back().scopes.back().insert(
+				std::make_pair(alloc.get_name(), convert(this->evaluate_expression(*alloc.get_initial_value()), t))
+			);
+		}
+		else {
+			this->frames.back().scopes.back().insert(std::make_pair(alloc.get_name(), value(t)));
+		}
+	}
+	else if (t.get_primary() == ARRAY && !t.get_qualities().is_static() && is_scalar_type(t.get_subtype()) && t.get_array_length_expression()) {
+		value length = this->evaluate_expression(*t.get_array_length_expression());
+		if (length.type.get_primary() != INT || length.scalar < 0) {
+			throw evaluation_failure("invalid array length");
+		}
+
+		size_t bytes = (size_t)length.scalar * t.get_subtype().get_width();
+		if ((size_t)length.scalar > MAX_MEMORY || this->memory + bytes > MAX_MEMORY) {
+			throw evaluation_failure("the evaluation exceeded " + std::to_string(MAX_MEMORY) + " bytes of memory");
+		}
+		this->memory += bytes;
+
+		value array(t);
+		array.initialized = true;
+		array.elements.resize((size_t)length.scalar, 0);
+		array.elements_initialized.resize((size_t)length.scalar, false);
+
+		if (alloc.was_initialized()) {
+			auto &init = *alloc.get_initial_value();
+			if (init.get_expression_type() != LIST) {
+				throw evaluation_failure("unsupported array initializer");
+			}
+
+			auto members = static_cast<const ListExpression&>(init).get_list();
+			if (members.size() != array.elements.size()) {
+				throw evaluation_failure("the initializer list does not match the array length");
+			}
+
+			for (size_t i = 0; i < members.size(); i++) {
+				array.elements[i] = convert(this->evaluate_expression(*members[i]), t.get_subtype()).scalar;
+				array.elements_initialized[i] = true;
+			}
+		}
+
+		this->frames.back().scopes.back().insert(std::make_pair(alloc.get_name(), std::move(array)));
+	}
+	else {
+		throw evaluation_failure("unsupported allocation");
+	}
+}
+
+interpreter::exec_result interpreter::execute_block(const StatementBlock &block) {
+	for (auto s: block.statements_list) {
+		if (this->execute(*s) == RETURNED) {
+			return RETURNED;
+		}
+	}
+
+	return NORMAL;
+}
+
+interpreter::exec_result interpreter::execute(const Statement &s) {
+	/*
+
+	execute
+	Executes a single statement in the current frame
+
+	Every branch and loop body gets its own scope, just as in the generated code
+
+	*/
+
+	this->step();
+
+	switch (s.get_statement_type()) {
+		case ALLOCATION:
+			this->allocate(static_cast<const Allocation&>(s));
+			return NORMAL;
+		case ASSIGNMENT:
+		case COMPOUND_ASSIGNMENT:
+		{
+			// the rvalue of a compound assignment already includes the operation
+			auto &assign = static_cast<const Assignment&>(s);
+			value v = this->evaluate_expression(assign.get_rvalue());
+			this->store(assign.get_lvalue(), v);
+			return NORMAL;
+		}
+		case RETURN_STATEMENT:
+		{
+			auto &ret = static_cast<const ReturnStatement&>(s);
+			value v = this->evaluate_expression(ret.get_return_exp());
+			this->frames.back().return_value.reset(new value(v));
+			return RETURNED;
+		}
+		case CALL:
+		{
+			// the callee can't have side effects, so its result can be discarded
+			this->evaluate_call(static_cast<const Call&>(s));
+			return NORMAL;
+		}
+		case SCOPE_BLOCK:
+		case IF_THEN_ELSE:
+		case WHILE_LOOP:
+		{
+			const Statement *body = nullptr;
+			bool loop = s.get_statement_type() == WHILE_LOOP;
+
+			if (s.get_statement_type() == SCOPE_BLOCK) {
+				body = &s;
+			}
+			else if (s.get_statement_type() == IF_THEN_ELSE) {
+				auto &ite = static_cast<const IfThenElse&>(s);
+				body = this->evaluate_condition(ite.get_condition()) ? ite.get_if_branch() : ite.get_else_branch();
+			}
+
+			do {
+				if (loop) {
+					auto &w = static_cast<const WhileLoop&>(s);
+					if (!this->evaluate_condition(w.get_condition())) {
+						break;
+					}
+					body = w.get_branch();
+				}
+
+				if (!body) {
+					continue;
+				}
+
+				// run the body in a new scope, releasing any arrays it allocated afterwards
+				this->frames.back().scopes.emplace_back();
+				exec_result result = (body->get_statement_type() == SCOPE_BLOCK)
+					? this->execute_block(static_cast<const ScopedBlock&>(*body).get_statements())
+					: this->execute(*body);
+
+				this->release_scope();
+
+				if (result == RETURNED) {
+					return RETURNED;
+				}
+			} while (loop);
+
+			return NORMAL;
+		}
+		default:
+			throw evaluation_failure("unsupported statement");
+	}
+}
+
+void interpreter::add_function(const FunctionDefinition &def) {
+	// 'extern' functions may be replaced at link time, so only their declarations are reliable
+	if (!def.get_type_information().get_qualities().is_extern()) {
+		this->functions[def.get_name()] = &def;
+	}
+}
+
+void interpreter::clear_functions() {
+	this->functions.clear();
+}
+
+std::unique_ptr<Literal> interpreter::evaluate(const Expression &e, std::function<std::unique_ptr<Literal>(const std::string&)> constants) {
+	/*
+
+	evaluate
+	Evaluates an expression at compile time
+
+	@param	e	The expression to evaluate
+	@param	constants	Returns the value of a global constant given its name, or nullptr if there is no such constant
+	@return	A literal containing the result, or nullptr if the expression could not be evaluated (see get_reason)
+
+	*/
+
+	this->constants = constants;
+	this->frames.clear();
+	this->steps = 0;
+	this->memory = 0;
+	this->reason.clear();
+
+	std::unique_ptr<Literal> result;
+	try {
+		value v = this->evaluate_expression(e);
+		if (v.type.get_primary() == BOOL) {
+			result = std::make_unique<Literal>(v.type, v.scalar ? "true" : "false");
+		}
+		else if (v.type.get_primary() == INT) {
+			result = std::make_unique<Literal>(v.type, std::to_string(v.scalar));
+		}
+		else {
+			this->reason = "unsupported type";
+		}
+	}
+	catch (evaluation_failure &f) {
+		this->reason = f.reason;
+	}
+
+	this->frames.clear();
+	this->constants = nullptr;
+	return result;
+}
+
+const std::string &interpreter::get_reason() const {
+	return this->reason;
+}
+
+interpreter::interpreter()
+	: steps(0)
+	, memory(0)
+{
+}
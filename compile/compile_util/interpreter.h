@@ -0,0 +1,105 @@
+#pragma once
+
+/*
+
+SIN Toolchain (x86 target)
+interpreter.h
+Copyright 2021 Riley Lannon
+
+An interpreter for the SIN AST, used to evaluate calls to pure functions at compile time
+
+*/
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <memory>
+#include <functional>
+
+#include "../../parser/Statement.h"	// includes "Expression.h"
+#include "../../util/DataType.h"
+
+class interpreter {
+	/*
+
+	interpreter
+	Executes expressions -- including calls to functions defined in the program -- on constant operands
+
+	A function may be executed if everything it does can be carried out without touching state outside of its own frame: it may use integers and booleans, local arrays of them, and the control flow statements, and it may call other functions that meet the same requirements. Anything else -- pointers, references, strings, floats, inline assembly, reading or writing non-const globals, or calling 'extern' or 'decl' functions -- stops the evaluation, and the caller falls back to generating code as usual.
+	Results are exact or not produced at all: any operation that would overflow its type, divide by zero, index out of bounds, or read uninitialized data fails instead of guessing what the generated code would do.
+
+	Every evaluation is limited to MAX_STEPS statements and expressions, MAX_CALL_DEPTH nested calls, and MAX_MEMORY bytes of array storage, so a call that never terminates (or is simply too expensive) can't stall the compiler.
+
+	*/
+
+	static const unsigned long MAX_STEPS = 1000000;
+	static const unsigned int MAX_CALL_DEPTH = 256;
+	static const size_t MAX_MEMORY = 1 << 20;
+
+	// thrown internally when an expression can't be evaluated; caught by 'evaluate'
+	class evaluation_failure {
+	public:
+		std::string reason;
+		evaluation_failure(const std::string &reason);
+	};
+
+	struct value {
+		DataType type;	// INT, BOOL, or ARRAY of INT or BOOL
+		long long scalar;
+		bool initialized;
+		std::vector<long long> elements;	// for arrays
+		std::vector<bool> elements_initialized;
+
+		value(const DataType &type, long long scalar);
+		value(const DataType &type);
+	};
+
+	enum exec_result {
+		NORMAL,
+		RETURNED
+	};
+
+	struct frame {
+		std::vector<std::unordered_map<std::string, value>> scopes;
+		std::unique_ptr<value> return_value;
+	};
+
+	std::unordered_map<std::string, const FunctionDefinition*> functions;
+	std::function<std::unique_ptr<Literal>(const std::string&)> constants;	// looks up the values of global constants
+	std::vector<frame> frames;
+
+	unsigned long steps;
+	size_t memory;
+	std::string reason;
+
+	void step();
+
+	static void get_int_range(const DataType &t, long long &min, long long &max);
+	static bool fits(const DataType &t, long long v);
+	static bool is_scalar_type(const DataType &t);
+	static value convert(const value &v, const DataType &to);
+
+	void release_scope();
+	value *find_local(const std::string &name);
+	value &get_lvalue(const Expression &e, size_t &index, bool &is_element);
+	void store(const Expression &lvalue, const value &v);
+
+	value evaluate_binary(const Binary &b);
+	value evaluate_arithmetic(exp_operator op, const value &left, const value &right);
+	value evaluate_unary(const Unary &u);
+	value evaluate_call(const Procedure &call);
+	value evaluate_expression(const Expression &e);
+	bool evaluate_condition(const Expression &e);
+
+	void allocate(const Allocation &alloc);
+	exec_result execute_block(const StatementBlock &block);
+	exec_result execute(const Statement &s);
+public:
+	void add_function(const FunctionDefinition &def);
+	void clear_functions();
+
+	std::unique_ptr<Literal> evaluate(const Expression &e, std::function<std::unique_ptr<Literal>(const std::string&)> constants);
+	const std::string &get_reason() const;
+
+	interpreter();
+};
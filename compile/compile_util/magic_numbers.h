@@ -18,6 +18,7 @@ namespace magic_numbers {
     const std::string SRE_REQUEST_RESOURCE = "%[SRE_REQUEST_RESOURCE]";
     const std::string SRE_REALLOCATE = "%[SRE_REALLOCATE]";
     const std::string SRE_ADD_REF = "%[SRE_ADD_REF]";
+    const std::string SRE_GET_RC = "%[SRE_GET_RC]";
     const std::string SRE_FREE = "%[SRE_FREE]";
     const std::string SINL_RTE_OUT_OF_BOUNDS = "%[SINL_RTE_OUT_OF_BOUNDS]";
 
@@ -25,11 +26,19 @@ namespace magic_numbers {
     const std::string CONST_STRING_LABEL = "sinl_strc_";
     const std::string LIST_LITERAL_LABEL = "sinl_list_";
     const std::string FLOAT_LITERAL_LABEL = "sinl_fltc_";
+    const std::string VECTOR_CONSTANT_LABEL = "sinl_vecc_";
     const std::string ITE_LABEL = ".sinl_ite_";
     const std::string ITE_ELSE_LABEL = ".sinl_ite_else_";
     const std::string ITE_DONE_LABEL = ".sinl_ite_done_";
     const std::string WHILE_LABEL = ".sinl_while_";
+    const std::string WHILE_BODY_LABEL = ".sinl_while_body_";
     const std::string WHILE_DONE_LABEL = ".sinl_while_done_";
+    const std::string CONDITION_SKIP_LABEL = ".sinl_cond_skip_";
+    const std::string VECTOR_BODY_LABEL = ".sinl_vector_body_";
+    const std::string VECTOR_SKIP_LABEL = ".sinl_vector_skip_";
+    const std::string UNIQUE_LABEL = ".sinl_unique_";
+    const std::string TAKE_COPY_LABEL = ".sinl_take_copy_";
+    const std::string TAKE_DONE_LABEL = ".sinl_take_done_";
     const std::string SINGLE_PRECISION_MASK_LABEL = "sinl_sp_mask";
     const std::string DOUBLE_PRECISION_MASK_LABEL = "sinl_dp_mask";
 
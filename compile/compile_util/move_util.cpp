@@ -0,0 +1,235 @@
+/*
+
+SIN Compiler Toolchain (x86 target)
+move_util.cpp
+Copyright 2021 Riley Lannon
+
+Implementation of the last-use utilities
+
+*/
+
+#include <vector>
+
+#include "move_util.h"
+#include "cow_util.h"
+#include "induction_util.h"
+#include "../function_symbol.h"
+
+namespace
+{
+    struct move_facts {
+        const function_info &fn;
+        symbol_table &symbols;
+        const std::unordered_set<std::string> &shared;
+        std::unordered_set<std::string> escaped;
+        std::unordered_set<const Expression*> last_uses;
+
+        move_facts(const function_info &fn, symbol_table &symbols, const std::unordered_set<std::string> &shared)
+            : fn(fn)
+            , symbols(symbols)
+            , shared(shared)
+        {
+        }
+    };
+
+    // an identifier that may be moved, and the name it refers to
+    typedef std::pair<const Expression*, std::string> move_candidate;
+
+    bool is_movable(const std::string &name, const move_facts &facts, DataType &t) {
+        return facts.fn.get_local_type(name, t) &&
+            !facts.fn.is_param(name) &&
+            cow_util::is_shareable(t) &&
+            !facts.escaped.count(name);
+    }
+
+    bool takes_ownership(const Procedure &call, size_t arg_no, symbol_table &symbols) {
+        // a SIN function owns (and frees) the strings passed to it by value
+        if (call.get_func_name().get_expression_type() != IDENTIFIER) {
+            return false;
+        }
+
+        std::string name = static_cast<const Identifier&>(call.get_func_name()).getValue();
+        if (!symbols.contains(name)) {
+            return false;
+        }
+
+        symbol &sym = symbols.find(name);
+        if (sym.get_symbol_type() != FUNCTION_SYMBOL) {
+            return false;
+        }
+
+        auto &func_sym = static_cast<function_symbol&>(sym);
+        auto &params = func_sym.get_formal_parameters();
+        return func_sym.get_calling_convention() == SINCALL &&
+            !func_sym.is_method() &&
+            arg_no < params.size() &&
+            params[arg_no]->get_data_type().get_primary() == STRING;
+    }
+
+    void get_moved_args(const Expression &e, const Expression *lvalue, const move_facts &facts, std::vector<move_candidate> &moves) {
+        // the arguments of a call that makes up an entire expression; those mentioned anywhere else in the statement are evaluated twice, so they can't be moved
+        if (e.get_expression_type() != CALL_EXP && e.get_expression_type() != PROC_EXP) {
+            return;
+        }
+
+        auto &call = static_cast<const Procedure&>(e);
+        for (size_t i = 0; i < call.get_num_args(); i++) {
+            auto &arg = call.get_arg(i);
+            if (arg.get_expression_type() != IDENTIFIER || !takes_ownership(call, i, facts.symbols)) {
+                continue;
+            }
+
+            std::string name = static_cast<const Identifier&>(arg).getValue();
+            DataType t;
+            if (!is_movable(name, facts, t) || t.get_primary() != STRING || facts.shared.count(name)) {
+                continue;
+            }
+
+            bool repeated = induction_util::mentions(call.get_func_name(), name) || (lvalue && induction_util::mentions(*lvalue, name));
+            for (size_t j = 0; j < call.get_num_args() && !repeated; j++) {
+                repeated = j != i && induction_util::mentions(call.get_arg(j), name);
+            }
+
+            if (!repeated) {
+                moves.push_back(std::make_pair(&arg, name));
+            }
+        }
+    }
+
+    void get_moves(const Statement &s, const move_facts &facts, std::vector<move_candidate> &moves) {
+        // the identifiers that a statement would copy, and which it could move instead
+        auto add_copy = [&](const std::string &dest, const Expression &rvalue) {
+            if (rvalue.get_expression_type() != IDENTIFIER) {
+                get_moved_args(rvalue, nullptr, facts, moves);
+                return;
+            }
+
+            std::string src = static_cast<const Identifier&>(rvalue).getValue();
+            DataType dest_type, src_type;
+            if (src == dest || !is_movable(dest, facts, dest_type) || !is_movable(src, facts, src_type) || !cow_util::can_share(dest_type, src_type)) {
+                return;
+            }
+
+            // a buffer that may be shared may only be moved to a name that checks it before modifying it
+            if (!facts.shared.count(src) || facts.shared.count(dest)) {
+                moves.push_back(std::make_pair(&rvalue, src));
+            }
+        };
+
+        switch (s.get_statement_type()) {
+            case ALLOCATION:
+            {
+                auto &alloc = static_cast<const Allocation&>(s);
+                if (alloc.get_initial_value()) {
+                    add_copy(alloc.get_name(), *alloc.get_initial_value());
+                }
+                break;
+            }
+            case ASSIGNMENT:
+            {
+                auto &assign = static_cast<const Assignment&>(s);
+                if (assign.get_lvalue().get_expression_type() == IDENTIFIER) {
+                    add_copy(static_cast<const Identifier&>(assign.get_lvalue()).getValue(), assign.get_rvalue());
+                }
+                else {
+                    get_moved_args(assign.get_rvalue(), &assign.get_lvalue(), facts, moves);
+                }
+                break;
+            }
+            case RETURN_STATEMENT:
+                get_moved_args(static_cast<const ReturnStatement&>(s).get_return_exp(), nullptr, facts, moves);
+                break;
+            case CALL:
+                get_moved_args(static_cast<const Expression&>(static_cast<const Call&>(s)), nullptr, facts, moves);
+                break;
+            default:
+                break;
+        }
+    }
+
+    void walk_block(const StatementBlock &block, move_facts &facts);
+
+    void walk_statement(const Statement &s, move_facts &facts) {
+        switch (s.get_statement_type()) {
+            case IF_THEN_ELSE:
+            {
+                auto &ite = static_cast<const IfThenElse&>(s);
+                if (ite.get_if_branch()) walk_statement(*ite.get_if_branch(), facts);
+                if (ite.get_else_branch()) walk_statement(*ite.get_else_branch(), facts);
+                break;
+            }
+            case WHILE_LOOP:
+            {
+                auto &loop = static_cast<const WhileLoop&>(s);
+                if (loop.get_branch()) walk_statement(*loop.get_branch(), facts);
+                break;
+            }
+            case SCOPE_BLOCK:
+                walk_block(static_cast<const ScopedBlock&>(s).get_statements(), facts);
+                break;
+            default:
+                break;
+        }
+    }
+
+    void walk_block(const StatementBlock &block, move_facts &facts) {
+        // only the names allocated in a block end their lifetimes with it
+        std::unordered_set<std::string> allocated;
+        auto &statements = block.statements_list;
+        for (size_t i = 0; i < statements.size(); i++) {
+            const Statement &s = *statements[i];
+
+            std::vector<move_candidate> moves;
+            get_moves(s, facts, moves);
+            for (auto &m: moves) {
+                if (!allocated.count(m.second)) {
+                    continue;
+                }
+
+                bool used = false;
+                for (size_t j = i + 1; j < statements.size() && !used; j++) {
+                    used = induction_util::mentions(*statements[j], m.second);
+                }
+
+                if (!used) {
+                    facts.last_uses.insert(m.first);
+                }
+            }
+
+            if (s.get_statement_type() == ALLOCATION) {
+                allocated.insert(static_cast<const Allocation&>(s).get_name());
+            }
+            walk_statement(s, facts);
+        }
+    }
+}
+
+std::unordered_set<const Expression*> move_util::find_last_uses(
+    const FunctionDefinition &def,
+    const function_info &fn,
+    symbol_table &symbols,
+    const std::unordered_set<std::string> &shared
+) {
+    /*
+
+    find_last_uses
+    Finds the identifiers in a function whose value may be moved rather than copied
+
+    These are the sources of assignments 'let b = a' (or 'alloc string b: a') between two locals that could share their buffers (see cow_util::can_share), and strings passed by value to SIN functions, where 'a' is on its last use. A move is preferred to sharing the buffer, but if 'a' may share its buffer, so must 'b', and a shared string must still be copied when passed to a function. Arguments may only be moved from a call that makes up an entire statement, initial value, right-hand side of an assignment, or 'return' value, so that it is certain to be called once.
+
+    @param  def The function to analyze
+    @param  fn  Information about the function's locals
+    @param  symbols The symbol table, used to look up the functions that are called
+    @param  shared  The names that may share their buffers
+    @return The identifiers that may be moved
+
+    */
+
+    move_facts facts(fn, symbols, shared);
+    if (!cow_util::find_escaped_names(def, fn, symbols, facts.escaped)) {
+        return facts.last_uses;
+    }
+
+    walk_block(def.get_procedure(), facts);
+    return facts.last_uses;
+}
@@ -0,0 +1,32 @@
+#pragma once
+
+/*
+
+SIN Compiler Toolchain (x86 target)
+move_util.h
+Copyright 2021 Riley Lannon
+
+Utilities for moving strings and dynamic arrays on their last use
+
+Assigning a string (or dynamic array) to another copies its contents, as does passing a string to a function by value, and the original is freed when it goes out of scope. If the original is never used again, it may hand its buffer over instead: the destination takes its pointer, and it is no longer freed when its scope ends. Returning a local is already handled this way (see compiler::sincall_return).
+
+A use is the last if the name is a local allocated in the same block as the statement, no later statement in that block mentions it, and it can't be accessed without being named (see cow_util::find_escaped_names). As the compiler generates code in program order, anything after the statement in the name's scope is compiled after it has been moved.
+
+*/
+
+#include <string>
+#include <unordered_set>
+
+#include "symbol_table.h"
+#include "../../parser/Statement.h"
+#include "../opt/function_info.h"
+
+namespace move_util
+{
+    std::unordered_set<const Expression*> find_last_uses(
+        const FunctionDefinition &def,
+        const function_info &fn,
+        symbol_table &symbols,
+        const std::unordered_set<std::string> &shared
+    );
+}
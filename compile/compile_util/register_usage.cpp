@@ -208,6 +208,7 @@ std::string register_usage::store_all_symbols()
         if (it->second.contained)
         {
             store_ss << store_symbol(*it->second.contained).str();
+            it->second.contained->set_register(NO_REGISTER);  // the symbol now lives in memory; don't read it from a register that may be overwritten
             it->second.contained = nullptr;
             it->second.in_use = false;
         }
@@ -323,16 +324,21 @@ std::string register_usage::get_register_name(const reg to_get) {
 }
 
 std::string register_usage::get_register_name(const reg to_get, const DataType& t) {
+    // Get the string value of a register name based on the width of the type
+    return get_register_name(to_get, t.get_width());
+}
+
+std::string register_usage::get_register_name(const reg to_get, const size_t width) {
     // Get the string value of a register name based on its width
     std::unordered_map<reg, std::string>::const_iterator it;
     bool found = false;
-    if (t.get_width() == 4) {
+    if (width == 4) {
         it = reg_32_strings.find(to_get);
         found = it != reg_32_strings.end();
-    } else if (t.get_width() == 2) {
+    } else if (width == 2) {
         it = reg_16_strings.find(to_get);
         found = it != reg_16_strings.end();
-    } else if (t.get_width() == 1) {
+    } else if (width == 1) {
         it = reg_8_strings.find(to_get);
         found = it != reg_8_strings.end();
     } else {
@@ -78,6 +78,7 @@ public:
     // get the name of a register
     static std::string get_register_name(const reg to_get);    // full 64-bit register
     static std::string get_register_name(const reg to_get, const DataType& t); // get the appropriate name based on type width
+    static std::string get_register_name(const reg to_get, const size_t width); // get the name of the register's low 'width' bytes
 
     register_usage();
     ~register_usage();
@@ -164,6 +164,7 @@ std::vector<symbol> symbol_table::get_symbols_to_free(std::string name, unsigned
 		* is marked as dynamic
 		* is a pointer
 		* is a reference
+	and that haven't been freed (i.e., moved on their last use).
 	We also need to see if we have an array or a tuple, iterate through their contained types, and see if anything needs to be freed there. If so, add the array/tuple to the vector.
 
 	*/
@@ -182,7 +183,7 @@ std::vector<symbol> symbol_table::get_symbols_to_free(std::string name, unsigned
 	) {
         // todo: some of this could be done when we create the DataType or symbol objects
 		symbol &s = this->find(l.pop_back().name);
-		if (s.get_symbol_type() == VARIABLE && s.get_data_type().must_free())
+		if (s.get_symbol_type() == VARIABLE && s.get_data_type().must_free() && !s.was_freed())
             v.push_back(s);
 	}
 
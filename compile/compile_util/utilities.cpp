@@ -7,6 +7,8 @@ Some utility functions for the compiler
 
 */
 
+#include <algorithm>
+
 #include "utilities.h"
 
 namespace function_util {
@@ -22,7 +24,8 @@ namespace function_util {
         bool defined=true,
         const std::string& scope_name = "global",
         unsigned int scope_level = 0, 
-        bool is_method = false
+        bool is_method = false,
+        struct_table *structs = nullptr
     );
 }
 
@@ -36,6 +39,24 @@ bool is_valid_cast(const DataType &old_type, const DataType &new_type) {
 
     */
 
+    // vectors may be converted lane-by-lane to vectors of the same shape, and scalars may be broadcast to them
+    if (new_type.get_primary() == VECTOR) {
+        if (old_type.get_primary() == VECTOR) {
+            return old_type.get_array_length() == new_type.get_array_length() &&
+                old_type.get_subtype().get_width() == new_type.get_subtype().get_width() &&
+                (
+                    old_type.get_subtype().get_primary() == new_type.get_subtype().get_primary() ||
+                    old_type.get_subtype().get_width() == sin_widths::INT_WIDTH
+                );
+        }
+        else {
+            return old_type.get_primary() == new_type.get_subtype().get_primary();
+        }
+    }
+    else if (old_type.get_primary() == VECTOR) {
+        return false;
+    }
+
     return !(
         old_type.get_primary() == STRING || 
         old_type.get_primary() == ARRAY || 
@@ -48,7 +69,7 @@ bool is_valid_cast(const DataType &old_type, const DataType &new_type) {
 }
 
 bool is_subscriptable(const Type t) {
-    return (t == ARRAY || t == STRING);
+    return (t == ARRAY || t == STRING || t == VECTOR);
 }
 
 std::stringstream cast(const DataType &old_type, const DataType &new_type, const unsigned int line, const bool is_strict) {
@@ -227,6 +248,163 @@ bool can_pass_in_register(const DataType& to_check) {
     return can_pass;
 }
 
+bool get_eightbytes(const DataType& t, std::vector<eightbyte>& parts, struct_table *structs) {
+    /*
+
+    get_eightbytes
+    Splits a small tuple or struct into the eightbytes that are passed (or returned) in registers
+
+    A tuple or struct qualifies if it is neither dynamic nor static, is at most 16 bytes wide, and all of its members are integers, floats, booleans, or characters. Each eightbyte is passed in an XMM register if all of the members it contains are floats, and in a general-purpose register otherwise. As eightbytes are moved with a single instruction, each one must be 1, 2, 4, or 8 bytes wide.
+    Struct members are only known once the struct has been defined, so structs are only split if the struct table is supplied.
+
+    @param  t   The type to split
+    @param  parts   Receives the eightbytes, in order
+    @param  structs The struct table, if available
+    @return Whether the type may be passed in registers
+
+    */
+
+    parts.clear();
+    if (
+        (t.get_primary() != TUPLE && t.get_primary() != STRUCT) ||
+        t.get_qualities().is_dynamic() ||
+        t.get_qualities().is_static()
+    ) {
+        return false;
+    }
+
+    // get the members, in order, and the total width
+    size_t width = 0;
+    std::vector<DataType> members;
+    if (t.get_primary() == TUPLE) {
+        width = t.get_width();
+        members = t.get_contained_types();
+    }
+    else {
+        if (!structs || !structs->contains(t.get_struct_name())) {
+            return false;
+        }
+
+        struct_info &info = structs->find(t.get_struct_name(), 0);
+        if (!info.is_width_known()) {
+            return false;
+        }
+        width = info.get_width();
+
+        // function members don't occupy space in the struct
+        std::vector<symbol*> data_members;
+        for (auto member: info.get_all_members()) {
+            if (member->get_symbol_type() != FUNCTION_SYMBOL) {
+                data_members.push_back(member);
+            }
+        }
+        std::sort(data_members.begin(), data_members.end(), [](const symbol *a, const symbol *b) {
+            return a->get_offset() < b->get_offset();
+        });
+        for (auto member: data_members) {
+            members.push_back(member->get_data_type());
+        }
+    }
+
+    if (width == 0 || width > 16) {
+        return false;
+    }
+
+    for (size_t offset = 0; offset < width; offset += 8) {
+        eightbyte part;
+        part.offset = offset;
+        part.width = std::min<size_t>(8, width - offset);
+        part.is_float = true;
+        if (part.width != 1 && part.width != 2 && part.width != 4 && part.width != 8) {
+            return false;
+        }
+        parts.push_back(part);
+    }
+
+    size_t member_offset = 0;
+    for (auto &member: members) {
+        Type primary = member.get_primary();
+        if (
+            (primary != INT && primary != FLOAT && primary != BOOL && primary != CHAR) ||
+            member.get_qualities().is_dynamic() ||
+            member.get_width() == 0
+        ) {
+            return false;
+        }
+
+        // a member that straddles two eightbytes (or isn't a float) makes each of them an integer
+        size_t first = member_offset / 8;
+        size_t last = (member_offset + member.get_width() - 1) / 8;
+        for (size_t i = first; i <= last && i < parts.size(); i++) {
+            if (primary != FLOAT || first != last) {
+                parts[i].is_float = false;
+            }
+        }
+        member_offset += member.get_width();
+    }
+
+    return member_offset == width;
+}
+
+std::vector<reg> get_return_registers(const std::vector<eightbyte>& parts) {
+    // Returns the register for each eightbyte of a returned tuple -- RAX and then RDX for integers, XMM0 and then XMM1 for floats
+
+    std::vector<reg> regs;
+    size_t next_integer = 0;
+    size_t next_float = 0;
+    for (auto &part: parts) {
+        if (part.is_float) {
+            regs.push_back(next_float++ ? XMM1 : XMM0);
+        }
+        else {
+            regs.push_back(next_integer++ ? RDX : RAX);
+        }
+    }
+
+    return regs;
+}
+
+std::string move_eightbyte(const eightbyte& part, const reg r, const std::string& address, const bool load) {
+    /*
+
+    move_eightbyte
+    Generates the instruction to load an eightbyte into (or store it from) a register
+
+    @param  part    The eightbyte to move
+    @param  r   The register that holds it
+    @param  address The memory operand of the tuple, e.g., '[rbp + 16]', without the eightbyte's offset
+    @param  load    Whether to load the register (rather than store it)
+    @return The instruction, including its tab and newline
+
+    */
+
+    std::string instruction;
+    std::string reg_name;
+    if (part.is_float) {
+        instruction = part.width == 4 ? "movss" : "movsd";
+        reg_name = register_usage::get_register_name(r);
+    }
+    else {
+        instruction = "mov";
+        reg_name = register_usage::get_register_name(r, part.width);
+    }
+
+    std::string operand = address;
+    if (part.offset) {
+        operand.insert(operand.size() - 1, " + " + std::to_string(part.offset));
+    }
+
+    std::stringstream move_ss;
+    if (load) {
+        move_ss << "\t" << instruction << " " << reg_name << ", " << operand << std::endl;
+    }
+    else {
+        move_ss << "\t" << instruction << " " << operand << ", " << reg_name << std::endl;
+    }
+
+    return move_ss.str();
+}
+
 std::string get_rax_name_variant(const DataType& t, const unsigned int line) {
 	/*
 	
@@ -250,6 +428,39 @@ std::string get_rax_name_variant(const DataType& t, const unsigned int line) {
 	return reg_string;
 }
 
+std::string get_condition_code(const exp_operator op, const bool use_unsigned, const unsigned int line) {
+    /*
+
+    get_condition_code
+    Gets the condition code suffix (for SETcc/Jcc) corresponding to a comparison operator
+
+    Unsigned comparisons (and floating-point comparisons, as ucomiss/ucomisd set CF and ZF) must use the above/below variants
+
+    @param  op  The comparison operator
+    @param  use_unsigned    Whether the comparison should use the unsigned condition codes
+    @param  line    The line number where the comparison occurs (for error handling)
+    @return The condition code suffix, e.g. 'e' or 'ge'
+
+    */
+
+    switch (op) {
+    case exp_operator::EQUAL:
+        return "e";
+    case exp_operator::NOT_EQUAL:
+        return "ne";
+    case exp_operator::GREATER:
+        return use_unsigned ? "a" : "g";
+    case exp_operator::LESS:
+        return use_unsigned ? "b" : "l";
+    case exp_operator::GREATER_OR_EQUAL:
+        return use_unsigned ? "ae" : "ge";
+    case exp_operator::LESS_OR_EQUAL:
+        return use_unsigned ? "be" : "le";
+    default:
+        throw CompilerException("Undefined operator", compiler_errors::UNDEFINED_ERROR, line);
+    }
+}
+
 struct_info define_struct(const StructDefinition &definition, compile_time_evaluator &cte) {
     /*
     
@@ -608,7 +819,8 @@ std::string decrement_rc(
     struct_table &structs,
     std::string scope,
     unsigned int level,
-    bool is_function
+    bool is_function,
+    const std::string &transferred
 ) {
     /*
 
@@ -621,6 +833,7 @@ std::string decrement_rc(
     @param  scope   The name of the scope we are looking in
     @param  level   The level of the scope we are leaving
     @param  is_function If we are in a function, we need to free data that's below the scope level as well
+    @param  transferred The name of a symbol whose reference is being handed to the caller, if any; it is skipped, as its decrement would cancel the increment made for the caller
 
     */
 
@@ -632,6 +845,12 @@ std::string decrement_rc(
 
     // get the local variables that need to be freed
     auto v = symbols.get_symbols_to_free(scope, level, is_function);
+    if (!transferred.empty()) {
+        v.erase(
+            std::remove_if(v.begin(), v.end(), [&](const symbol &s) { return s.get_name() == transferred; }),
+            v.end()
+        );
+    }
 
     // now we need to look at the structs in the scope that we are leaving and see if we need to decrement any of their memebers
     auto local_structs = symbols.get_local_structs(scope, level, is_function);
@@ -746,3 +965,39 @@ std::string decrement_rc_util(
 
     return dec_ss.str();
 }
+
+std::string release_temporary(register_usage &regs, const DataType &t) {
+    /*
+
+    release_temporary
+    Frees a temporary reference left on the stack by an expression's evaluation while preserving the evaluated value (in RAX or XMM0)
+
+    @param    regs    The registers currently in use
+    @param    t    The type of the evaluated expression
+    @return    A string containing the generated code
+
+    */
+
+    std::stringstream release_ss;
+
+    if (t.get_primary() == FLOAT) {
+        release_ss << "\t" << "movq r13, xmm0" << std::endl;
+    }
+    else {
+        release_ss << "\t" << "mov r13, rax" << std::endl;
+    }
+
+    release_ss << "\t" << "pop rdi" << std::endl;
+    release_ss << push_used_registers(regs, true).str();
+    release_ss << function_util::call_sre_function(magic_numbers::SRE_FREE);
+    release_ss << pop_used_registers(regs, true).str();
+
+    if (t.get_primary() == FLOAT) {
+        release_ss << "\t" << "movq xmm0, r13" << std::endl;
+    }
+    else {
+        release_ss << "\t" << "mov rax, r13" << std::endl;
+    }
+
+    return release_ss.str();
+}
@@ -43,8 +43,20 @@ std::stringstream cast(const DataType &old_type, const DataType &new_type, const
 
 bool can_pass_in_register(const DataType& to_check);
 
+// a part of a small tuple or struct that is passed in a single register
+struct eightbyte {
+    size_t offset;
+    size_t width;   // 1, 2, 4, or 8 bytes
+    bool is_float;  // uses an XMM register
+};
+bool get_eightbytes(const DataType& t, std::vector<eightbyte>& parts, struct_table *structs = nullptr);
+std::vector<reg> get_return_registers(const std::vector<eightbyte>& parts);
+std::string move_eightbyte(const eightbyte& part, const reg r, const std::string& address, const bool load);
+
 std::string get_rax_name_variant(const DataType& t, const unsigned int line);
 
+std::string get_condition_code(const exp_operator op, const bool use_unsigned, const unsigned int line);
+
 struct_info define_struct(const StructDefinition &definition, compile_time_evaluator &cte);
 
 template<typename T>
@@ -68,13 +80,16 @@ std::stringstream pop_used_registers(const register_usage& regs, bool ignore_ab
 std::string get_address(const symbol &s, const reg r);
 std::string get_struct_member_address(const symbol &struct_symbol, struct_table &structs, const std::string& member_name, const reg r);
 
+std::string release_temporary(register_usage &regs, const DataType &t);
+
 std::string decrement_rc(
     register_usage &r,
     symbol_table &symbols,
     struct_table &structs,
     std::string scope,
     unsigned int level,
-    bool is_function
+    bool is_function,
+    const std::string &transferred = ""
 );
 std::string decrement_rc_util(
     std::vector<symbol> &to_free,
@@ -0,0 +1,465 @@
+/*
+
+SIN Compiler Toolchain (x86 target)
+vector_util.cpp
+Copyright 2021 Riley Lannon
+
+Implementation of the vectorization utilities
+
+*/
+
+#include <algorithm>
+#include <unordered_set>
+
+#include "vector_util.h"
+#include "induction_util.h"
+#include "../opt/program_info.h"
+
+namespace
+{
+    bool get_element_kind(const DataType &t, vector_util::element_kind &kind) {
+        if (t.get_primary() == INT && t.get_width() == sin_widths::INT_WIDTH) {
+            kind = vector_util::VECTOR_INT;
+        }
+        else if (t.get_primary() == FLOAT && t.get_width() == sin_widths::FLOAT_WIDTH) {
+            kind = vector_util::VECTOR_FLOAT;
+        }
+        else if (t.get_primary() == FLOAT && t.get_width() == sin_widths::DOUBLE_WIDTH) {
+            kind = vector_util::VECTOR_DOUBLE;
+        }
+        else {
+            return false;
+        }
+        return true;
+    }
+
+    bool is_plain_local(const std::string &name, const function_info &fn, symbol_table &symbols) {
+        // a local that lives in the stack frame and can't be modified without being named
+        if (!fn.is_local(name) || fn.is_address_taken(name) || !symbols.contains(name)) {
+            return false;
+        }
+
+        auto &sym = symbols.find(name);
+        const DataType &t = sym.get_data_type();
+        return sym.get_register() == NO_REGISTER && !t.is_reference_type() && !t.get_qualities().is_static();
+    }
+
+    bool is_index(const Expression &e, const std::string &index) {
+        return e.get_expression_type() == IDENTIFIER && static_cast<const Identifier&>(e).getValue() == index;
+    }
+
+    class loop_analysis {
+        const function_info &fn;
+        symbol_table &symbols;
+        vector_util::vector_loop &plan;
+        bool has_kind;
+        std::unordered_set<std::string> written;    // the index, accumulators, and temporaries
+        std::unordered_set<std::string> defined;    // the temporaries allocated so far
+
+        bool set_kind(const DataType &t) {
+            vector_util::element_kind kind;
+            if (!get_element_kind(t, kind) || (this->has_kind && kind != this->plan.kind)) {
+                return false;
+            }
+
+            this->has_kind = true;
+            this->plan.kind = kind;
+            this->plan.width = t.get_width();
+            return true;
+        }
+
+        bool add_array(const std::string &name) {
+            // arrays must be arrays of our element type, and must not be anything the loop writes as a scalar
+            if (name == this->plan.index || !symbols.contains(name)) {
+                return false;
+            }
+
+            auto &sym = this->symbols.find(name);
+            const DataType &t = sym.get_data_type();
+            if (t.get_primary() != ARRAY || sym.get_register() != NO_REGISTER || !this->set_kind(t.get_subtype())) {
+                return false;
+            }
+
+            if (std::find(this->plan.arrays.begin(), this->plan.arrays.end(), name) == this->plan.arrays.end()) {
+                this->plan.arrays.push_back(name);
+            }
+            return true;
+        }
+    public:
+        bool check_value(const Expression &e) {
+            switch (e.get_expression_type()) {
+                case INDEXED:
+                {
+                    auto &idx = static_cast<const Indexed&>(e);
+                    return idx.get_to_index().get_expression_type() == IDENTIFIER &&
+                        is_index(idx.get_index_value(), this->plan.index) &&
+                        this->add_array(static_cast<const Identifier&>(idx.get_to_index()).getValue());
+                }
+                case IDENTIFIER:
+                {
+                    // a temporary allocated earlier in the iteration, or a scalar the loop doesn't change
+                    std::string name = static_cast<const Identifier&>(e).getValue();
+                    if (this->defined.count(name)) {
+                        return true;
+                    }
+                    else if (this->written.count(name) || !this->symbols.contains(name)) {
+                        return false;
+                    }
+
+                    auto &sym = this->symbols.find(name);
+                    const DataType &t = sym.get_data_type();
+                    if (sym.get_register() != NO_REGISTER || t.is_reference_type() || !this->set_kind(t)) {
+                        return false;
+                    }
+                    break;
+                }
+                case LITERAL:
+                {
+                    Type primary = static_cast<const Literal&>(e).get_data_type().get_primary();
+                    if (primary != INT && primary != FLOAT) {
+                        return false;
+                    }
+                    break;
+                }
+                case BINARY:
+                {
+                    auto &b = static_cast<const Binary&>(e);
+                    return (b.get_operator() == PLUS || b.get_operator() == MINUS || b.get_operator() == MULT || b.get_operator() == DIV) &&
+                        this->check_value(b.get_left()) &&
+                        this->check_value(b.get_right());
+                }
+                default:
+                    return false;
+            }
+
+            // names and literals are broadcast once, before the loop
+            std::string key = program_info::expression_key(e);
+            for (auto invariant: this->plan.invariants) {
+                if (program_info::expression_key(*invariant) == key) {
+                    return true;
+                }
+            }
+            this->plan.invariants.push_back(&e);
+            return true;
+        }
+
+        bool check_statement(const Statement &s) {
+            vector_util::vector_statement vs;
+            vs.subtract = false;
+            if (s.get_statement_type() == ALLOCATION) {
+                // a temporary that lives only as long as the iteration
+                auto &alloc = static_cast<const Allocation&>(s);
+                const DataType &t = alloc.get_type_information();
+                if (
+                    !alloc.get_initial_value() ||
+                    t.get_qualities().is_static() || t.get_qualities().is_dynamic() ||
+                    this->written.count(alloc.get_name()) ||
+                    this->fn.is_address_taken(alloc.get_name()) ||
+                    !this->set_kind(t)
+                ) {
+                    return false;
+                }
+
+                vs.temporary = alloc.get_name();
+                vs.value = alloc.get_initial_value();
+                this->written.insert(vs.temporary);
+                this->plan.temporaries.push_back(vs.temporary);
+                this->plan.statements.push_back(vs);
+                return true;
+            }
+            else if (s.get_statement_type() != ASSIGNMENT && s.get_statement_type() != COMPOUND_ASSIGNMENT) {
+                return false;
+            }
+
+            auto &assign = static_cast<const Assignment&>(s);
+            const Expression &lvalue = assign.get_lvalue();
+            const Expression &rvalue = assign.get_rvalue();
+
+            if (lvalue.get_expression_type() == INDEXED) {
+                // an element-wise store, 'let x[i] = ...'
+                auto &idx = static_cast<const Indexed&>(lvalue);
+                if (idx.get_to_index().get_expression_type() != IDENTIFIER || !is_index(idx.get_index_value(), this->plan.index)) {
+                    return false;
+                }
+
+                vs.array = static_cast<const Identifier&>(idx.get_to_index()).getValue();
+                vs.value = &rvalue;
+                if (!this->add_array(vs.array)) {
+                    return false;
+                }
+
+                if (std::find(this->plan.stored.begin(), this->plan.stored.end(), vs.array) == this->plan.stored.end()) {
+                    this->plan.stored.push_back(vs.array);
+                }
+            }
+            else if (lvalue.get_expression_type() == IDENTIFIER && rvalue.get_expression_type() == BINARY) {
+                // a reduction, 'let s += ...', 'let s -= ...', or the same written out
+                vs.accumulator = static_cast<const Identifier&>(lvalue).getValue();
+                auto &b = static_cast<const Binary&>(rvalue);
+                if (b.get_operator() != PLUS && b.get_operator() != MINUS) {
+                    return false;
+                }
+
+                if (is_index(b.get_left(), vs.accumulator)) {
+                    vs.value = &b.get_right();
+                    vs.subtract = b.get_operator() == MINUS;
+                }
+                else if (b.get_operator() == PLUS && is_index(b.get_right(), vs.accumulator)) {
+                    vs.value = &b.get_left();
+                }
+                else {
+                    return false;
+                }
+
+                if (
+                    vs.accumulator == this->plan.index ||
+                    this->written.count(vs.accumulator) ||
+                    !is_plain_local(vs.accumulator, this->fn, this->symbols) ||
+                    !this->set_kind(this->symbols.find(vs.accumulator).get_data_type())
+                ) {
+                    return false;
+                }
+                this->written.insert(vs.accumulator);
+                this->plan.accumulators.push_back(vs.accumulator);
+            }
+            else {
+                return false;
+            }
+
+            this->plan.statements.push_back(vs);
+            return true;
+        }
+
+        bool check_operations(const Expression &e) {
+            // once we know the element type, literals must match it, and integers can't be divided (there is no packed integer division)
+            bool is_int = this->plan.kind == vector_util::VECTOR_INT;
+            if (e.get_expression_type() == LITERAL) {
+                return (static_cast<const Literal&>(e).get_data_type().get_primary() == INT) == is_int;
+            }
+            else if (e.get_expression_type() == BINARY) {
+                auto &b = static_cast<const Binary&>(e);
+                if (is_int && b.get_operator() == DIV) {
+                    return false;
+                }
+
+                this->plan.uses_int_multiply = this->plan.uses_int_multiply || (is_int && b.get_operator() == MULT);
+                return this->check_operations(b.get_left()) && this->check_operations(b.get_right());
+            }
+            return true;
+        }
+
+        bool check_names() {
+            // an accumulator may only appear in its own statement
+            for (auto &vs: this->plan.statements) {
+                if (vs.accumulator.empty()) {
+                    continue;
+                }
+
+                for (auto &other: this->plan.statements) {
+                    if (induction_util::mentions(*other.value, vs.accumulator)) {
+                        return false;
+                    }
+                }
+
+                for (auto &array: this->plan.arrays) {
+                    if (array == vs.accumulator) {
+                        return false;
+                    }
+                }
+
+                for (auto &temporary: this->plan.temporaries) {
+                    if (temporary == vs.accumulator) {
+                        return false;
+                    }
+                }
+            }
+
+            // temporaries mustn't hide any of the arrays
+            for (auto &temporary: this->plan.temporaries) {
+                if (std::find(this->plan.arrays.begin(), this->plan.arrays.end(), temporary) != this->plan.arrays.end()) {
+                    return false;
+                }
+            }
+
+            return true;
+        }
+
+        void define(const std::string &temporary) {
+            if (!temporary.empty()) {
+                this->defined.insert(temporary);
+            }
+        }
+
+        bool check_kind() {
+            // literals alone don't tell us which type the loop works on
+            return this->has_kind;
+        }
+
+        loop_analysis(const function_info &fn, symbol_table &symbols, vector_util::vector_loop &plan)
+            : fn(fn)
+            , symbols(symbols)
+            , plan(plan)
+            , has_kind(false)
+        {
+            this->written.insert(plan.index);
+        }
+    };
+}
+
+namespace vector_util
+{
+    unsigned int registers_needed(const Expression &e, const vector_loop &plan) {
+        /*
+
+        registers_needed
+        Gets the number of vector registers needed to compute a value, not counting those that hold the invariants
+
+        The left operand is computed into a register, and the right into the next one, unless it is an invariant
+
+        */
+
+        if (e.get_expression_type() != BINARY) {
+            return 1;
+        }
+
+        auto &b = static_cast<const Binary&>(e);
+        unsigned int left = registers_needed(b.get_left(), plan);
+        if (b.get_right().get_expression_type() != INDEXED && b.get_right().get_expression_type() != BINARY) {
+            return left;
+        }
+        return std::max(left, registers_needed(b.get_right(), plan) + 1);
+    }
+
+    bool analyze_loop(const WhileLoop &loop, const function_info &fn, symbol_table &symbols, vector_loop &plan) {
+        /*
+
+        analyze_loop
+        Determines whether a loop can be vectorized, and, if so, how
+
+        */
+
+        plan = vector_loop();
+        plan.uses_int_multiply = false;
+        plan.registers = 0;
+
+        // the condition must be 'i < n'
+        if (loop.get_condition().get_expression_type() != BINARY || !loop.get_branch() || loop.get_branch()->get_statement_type() != SCOPE_BLOCK) {
+            return false;
+        }
+
+        auto &condition = static_cast<const Binary&>(loop.get_condition());
+        if (condition.get_operator() != LESS || condition.get_left().get_expression_type() != IDENTIFIER) {
+            return false;
+        }
+
+        plan.index = static_cast<const Identifier&>(condition.get_left()).getValue();
+        if (!is_plain_local(plan.index, fn, symbols)) {
+            return false;
+        }
+
+        const DataType &index_type = symbols.find(plan.index).get_data_type();
+        if (index_type.get_primary() != INT || index_type.get_width() != sin_widths::INT_WIDTH || index_type.get_qualities().is_signed()) {
+            return false;
+        }
+
+        // the body must be a sequence of stores and reductions, followed by the step
+        auto &body = static_cast<const ScopedBlock&>(*loop.get_branch()).get_statements().statements_list;
+        if (body.size() < 2) {
+            return false;
+        }
+
+        std::string step_name;
+        long long step;
+        auto &last = *body.back();
+        if (last.get_statement_type() != ASSIGNMENT && last.get_statement_type() != COMPOUND_ASSIGNMENT) {
+            return false;
+        }
+
+        auto &step_assign = static_cast<const Assignment&>(last);
+        if (
+            !is_index(step_assign.get_lvalue(), plan.index) ||
+            step_assign.get_rvalue().get_expression_type() != BINARY ||
+            static_cast<const Binary&>(step_assign.get_rvalue()).get_operator() != PLUS ||
+            !is_index(static_cast<const Binary&>(step_assign.get_rvalue()).get_left(), plan.index) ||
+            !induction_util::get_int_literal(static_cast<const Binary&>(step_assign.get_rvalue()).get_right(), step) ||
+            step != 1
+        ) {
+            return false;
+        }
+
+        loop_analysis analysis(fn, symbols, plan);
+        for (size_t i = 0; i + 1 < body.size(); i++) {
+            if (!analysis.check_statement(*body[i])) {
+                return false;
+            }
+        }
+
+        for (auto &vs: plan.statements) {
+            if (!analysis.check_value(*vs.value)) {
+                return false;
+            }
+            analysis.define(vs.temporary);
+        }
+
+        if (!analysis.check_kind() || !analysis.check_names()) {
+            return false;
+        }
+
+        for (auto &vs: plan.statements) {
+            if (!analysis.check_operations(*vs.value)) {
+                return false;
+            }
+        }
+
+        // the limit must be an unsigned value the loop doesn't change
+        const Expression &limit = condition.get_right();
+        long long value;
+        if (induction_util::get_int_literal(limit, value)) {
+            if (value < 0) {
+                return false;
+            }
+        }
+        else if (limit.get_expression_type() == IDENTIFIER) {
+            std::string name = static_cast<const Identifier&>(limit).getValue();
+            if (name == plan.index || !symbols.contains(name)) {
+                return false;
+            }
+
+            for (auto &vs: plan.statements) {
+                if (vs.accumulator == name) {
+                    return false;
+                }
+            }
+
+            auto &sym = symbols.find(name);
+            const DataType &t = sym.get_data_type();
+            if (
+                t.get_primary() != INT || t.get_width() != sin_widths::INT_WIDTH || t.get_qualities().is_signed() ||
+                sym.get_register() != NO_REGISTER || t.is_reference_type()
+            ) {
+                return false;
+            }
+        }
+        else if (limit.get_expression_type() == ATTRIBUTE) {
+            auto &attr = static_cast<const AttributeSelection&>(limit);
+            if (attr.get_attribute() != LENGTH || attr.get_selected().get_expression_type() != IDENTIFIER) {
+                return false;
+            }
+
+            std::string name = static_cast<const Identifier&>(attr.get_selected()).getValue();
+            if (!symbols.contains(name) || symbols.find(name).get_data_type().get_primary() != ARRAY || symbols.find(name).get_register() != NO_REGISTER) {
+                return false;
+            }
+        }
+        else {
+            return false;
+        }
+        plan.limit = &limit;
+
+        for (auto &vs: plan.statements) {
+            plan.registers = std::max(plan.registers, registers_needed(*vs.value, plan));
+        }
+
+        return true;
+    }
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+/*
+
+SIN Compiler Toolchain (x86 target)
+vector_util.h
+Copyright 2021 Riley Lannon
+
+Utilities for the vectorization of 'while' loops
+
+A loop like
+    while (i < a:len) {
+        let c[i] = a[i] * k + b[i];
+        let sum += a[i];
+        let i += 1;
+    }
+computes each element independently of the others, so several of them can be computed at once with packed SSE (or AVX) instructions. A loop qualifies if its condition is 'i < n' for an unsigned 'int' local 'i' and an unsigned, loop-invariant 'n'; its last statement is 'let i += 1' (or 'let i = i + 1'); and every other statement either stores to 'x[i]', accumulates into a scalar local with '+=' or '-=', or allocates a local to hold a value for the rest of the iteration. Values may only be computed from elements 'x[i]', loop-invariant names, and literals with '+', '-', '*', and (for floating-point types) '/', and every element involved must have the same type -- 'int', 'float', or 'double' ('long float').
+
+*/
+
+#include <string>
+#include <vector>
+
+#include "symbol_table.h"
+#include "../../parser/Statement.h"
+#include "../opt/function_info.h"
+
+namespace vector_util
+{
+    enum element_kind {
+        VECTOR_INT,
+        VECTOR_FLOAT,
+        VECTOR_DOUBLE
+    };
+
+    struct vector_statement {
+        const Expression *value;    // computed for each element
+        std::string array;  // the array the value is stored in, if any
+        std::string accumulator;    // the name the value is accumulated into, if any
+        std::string temporary;  // the name allocated to hold the value, if any (e.g., by common subexpression elimination)
+        bool subtract;  // whether the accumulator subtracts the value
+    };
+
+    struct vector_loop {
+        std::string index;
+        const Expression *limit;
+        element_kind kind;
+        size_t width;   // the width of an element
+
+        std::vector<std::string> arrays;    // every array accessed, in order of appearance
+        std::vector<std::string> stored;    // the arrays that are stored to
+        std::vector<std::string> accumulators;
+        std::vector<std::string> temporaries;   // these are held in vector registers for the whole iteration
+        std::vector<const Expression*> invariants;  // the names and literals used in computations, which get broadcast before the loop
+        std::vector<vector_statement> statements;
+
+        bool uses_int_multiply;
+        unsigned int registers; // the number of vector registers needed to evaluate the largest value
+    };
+
+    unsigned int registers_needed(const Expression &e, const vector_loop &plan);
+    bool analyze_loop(const WhileLoop &loop, const function_info &fn, symbol_table &symbols, vector_loop &plan);
+}
@@ -9,6 +9,8 @@ Copyright 2019 Riley Lannon
 
 */
 
+#include <cstdlib>
+
 #include "compiler.h"
 #include "compile_util/function_util.h"
 
@@ -249,7 +251,17 @@ std::stringstream compiler::compile_statement(const Statement &s, function_symbo
         case ASSIGNMENT:
         {
             auto &assign_stmt = static_cast<const Assignment&>(s);
-            compile_ss << this->handle_assignment(assign_stmt).str() << std::endl;
+            if (!this->removed_steps.count(&assign_stmt)) {
+                compile_ss << this->handle_assignment(assign_stmt).str() << std::endl;
+            }
+
+            // if this steps an induction variable, advance the pointers derived from it
+            auto steps = this->induction_steps.find(&assign_stmt);
+            if (steps != this->induction_steps.end()) {
+                for (auto &step: steps->second) {
+                    compile_ss << "\t" << (step.second < 0 ? "sub" : "add") << " qword [rbp - " << step.first << "], " << std::llabs(step.second) << std::endl;
+                }
+            }
             break;
         }
         case RETURN_STATEMENT:
@@ -276,25 +288,20 @@ std::stringstream compiler::compile_statement(const Statement &s, function_symbo
 			size_t current_scope_num = this->scope_block_num;
 			this->scope_block_num += 1; // increment the scope number now in case we have recursive conditionals
 			
-			// then we need to evaluate the expression; if the final result is 'true', we continue in the tree; else, we branch to 'else'
-			// if there is no else statement, it falls through to 'done'
-            auto condition_p = this->evaluate_expression(ite.get_condition(), ite.get_line_number());
-			compile_ss << condition_p.first;
-            // todo: count
-            
-            compile_ss << "\t" << "cmp al, 1" << std::endl;
-            compile_ss << "\t" << "jne " << magic_numbers::ITE_ELSE_LABEL << current_scope_num << std::endl;	// compare the result of RAX with 0; if true, then the condition was false, and we should jump
+			// then we need to evaluate the condition; if it is 'true', we continue in the tree; else, we branch to 'else'
+			// if there is no else statement, we branch straight to 'done'
+			std::string false_label = (ite.get_else_branch() ? magic_numbers::ITE_ELSE_LABEL : magic_numbers::ITE_DONE_LABEL) + std::to_string(current_scope_num);
+			compile_ss << this->evaluate_condition(ite.get_condition(), false_label, false, ite.get_line_number()).str();
 			
 			// compile the branch
 			compile_ss << this->compile_statement(*ite.get_if_branch(), signature).str();
             compile_ss << this->reg_stack.peek().store_all_symbols();
 
-			// now, we need to jump to "done" to ensure the "else" branch is not automatically executed
-			compile_ss << "\t" << "jmp " << magic_numbers::ITE_DONE_LABEL << current_scope_num << std::endl;
-			compile_ss << magic_numbers::ITE_ELSE_LABEL << current_scope_num << ":" << std::endl;
-            
-			// compile the branch, if one exists
+			// compile the else branch, if one exists
 			if (ite.get_else_branch()) {
+				// we need to jump to "done" to ensure the "else" branch is not automatically executed
+				compile_ss << "\t" << "jmp " << magic_numbers::ITE_DONE_LABEL << current_scope_num << std::endl;
+				compile_ss << magic_numbers::ITE_ELSE_LABEL << current_scope_num << ":" << std::endl;
 				compile_ss << this->compile_statement(*ite.get_else_branch(), signature).str();
                 compile_ss << this->reg_stack.peek().store_all_symbols();
 			}
@@ -310,23 +317,83 @@ std::stringstream compiler::compile_statement(const Statement &s, function_symbo
             // store all variables currently in registers
             compile_ss << reg_stack.peek().store_all_symbols();
 
-            // create a loop heading, evaluate the condition
+            /*
+
+            The loop is rotated so that the condition is tested at the bottom:
+                    jmp .sinl_while_N
+                .sinl_while_body_N:
+                    <body>
+                .sinl_while_N:
+                    <condition; jump to .sinl_while_body_N if true>
+                .sinl_while_done_N:
+            This means each iteration only takes the one conditional branch
+
+            */
+
             auto current_block_num = this->scope_block_num;
             this->scope_block_num += 1;
-            auto condition_p = this->evaluate_expression(while_stmt.get_condition(), while_stmt.get_line_number());
+            std::string body_label = magic_numbers::WHILE_BODY_LABEL + std::to_string(current_block_num);
+
+            // shared strings and arrays that the loop modifies are copied once, before the loop, rather than checked on every iteration (see compile_util/cow_util.h)
+            auto previous_unique = this->unique_names;
+            if (!this->shared_names.empty()) {
+                std::set<std::string> modified;
+                cow_util::get_modified_names(*while_stmt.get_branch(), this->shared_names, modified);
+                for (auto &name: modified) {
+                    if (
+                        this->shared_names.count(name) &&
+                        !this->unique_names.count(name) &&
+                        this->symbols.contains(name) &&
+                        cow_util::is_shareable(this->symbols.find(name).get_data_type())
+                    ) {
+                        compile_ss << this->ensure_unique(name).str();
+                        this->unique_names.insert(name);
+                    }
+                }
+            }
 
-            compile_ss << magic_numbers::WHILE_LABEL << current_block_num << ":" << std::endl;
-            compile_ss << condition_p.first;
-            // todo: count
-            compile_ss << "\t" << "cmp al, 1" << std::endl;
-            compile_ss << "\t" << "jne " << magic_numbers::WHILE_DONE_LABEL << current_block_num << std::endl;
+            // if the loop works on arrays element by element, process as many elements as we can with vector instructions first
+            compile_ss << this->vectorize_loop(while_stmt, current_block_num).str();
+
+            // carry array addresses as pointers, where we can (only for this loop -- the pointers are gone once it ends)
+            auto previous_pointers = this->induction_pointers;
+            auto previous_steps = this->induction_steps;
+            auto previous_removed = this->removed_steps;
+            std::string condition;
+            size_t reserved;
+            compile_ss << this->reduce_loop(while_stmt, body_label, condition, reserved).str();
+            compile_ss << reg_stack.peek().store_all_symbols();
+
+            if (condition.empty()) {
+                condition = this->evaluate_condition(
+                    while_stmt.get_condition(),
+                    body_label,
+                    true,
+                    while_stmt.get_line_number()
+                ).str();
+            }
+
+            compile_ss << "\t" << "jmp " << magic_numbers::WHILE_LABEL << current_block_num << std::endl;
+            compile_ss << body_label << ":" << std::endl;
 
             // compile the loop body
             compile_ss << this->compile_statement(*while_stmt.get_branch(), signature).str();
             compile_ss << reg_stack.peek().store_all_symbols();
-            compile_ss << "\t" << "jmp " << magic_numbers::WHILE_LABEL << current_block_num << std::endl;
+
+            // test the condition
+            compile_ss << magic_numbers::WHILE_LABEL << current_block_num << ":" << std::endl;
+            compile_ss << condition;
 
             compile_ss << magic_numbers::WHILE_DONE_LABEL << current_block_num << ":" << std::endl;
+
+            if (reserved) {
+                compile_ss << "\t" << "add rsp, " << reserved << std::endl;
+                this->max_offset -= reserved;
+            }
+            this->induction_pointers = previous_pointers;
+            this->induction_steps = previous_steps;
+            this->removed_steps = previous_removed;
+            this->unique_names = previous_unique;
             break;
         }
         case FUNCTION_DEFINITION:
@@ -335,11 +402,11 @@ std::stringstream compiler::compile_statement(const Statement &s, function_symbo
 
 			// ensure the function has a return value in all control paths
 			if (general_utilities::returns(def_stmt.get_procedure())) {
-                if (def_stmt.get_calling_convention() == SINCALL) {
+                if (def_stmt.get_calling_convention() == SINCALL || def_stmt.get_calling_convention() == SYSTEM_V) {
                     compile_ss << this->define_function(def_stmt).str() << std::endl;
                 } else {
                     throw CompilerException(
-                        "Currently, defining non-sincall functions is not supported",
+                        "Currently, only sincall and System V (c64) functions may be defined",
                         compiler_errors::UNSUPPORTED_FEATURE,
                         def_stmt.get_line_number()
                     );
@@ -498,7 +565,11 @@ std::stringstream compiler::compile_ast(StatementBlock &ast, function_symbol *si
         size_t reserved_space = this->symbols.leave_scope(this->current_scope_name, this->current_scope_level);
 
         // note we don't need to do have an "add rsp" instruction if we just had a return statement (it's unreachable)
-        if ((this->current_scope_level != 1) && (ast.statements_list.back()->get_statement_type() != RETURN_STATEMENT)) {
+        // blocks may be empty, either as written or once dead code has been removed
+        if (
+            (this->current_scope_level != 1) &&
+            (ast.statements_list.empty() || ast.statements_list.back()->get_statement_type() != RETURN_STATEMENT)
+        ) {
             compile_ss << "\t" << "add rsp, " << reserved_space << std::endl;
             this->max_offset -= reserved_space;
         }
@@ -568,7 +639,12 @@ std::stringstream compiler::process_include(std::string include_filename, unsign
                     // create the function symbol
                     auto sym = function_util::create_function_symbol(
                         *f,
-                        false
+                        false,
+                        true,
+                        "global",
+                        0,
+                        false,
+                        &this->structs
                     );
                     this->add_symbol(sym, f->get_line_number());
                 }
@@ -603,7 +679,7 @@ std::stringstream compiler::process_include(std::string include_filename, unsign
     return include_ss;
 }
 
-void compiler::generate_asm(const std::string& infile_name, std::string outfile_name) {
+bool compiler::generate_asm(const std::string& infile_name, std::string outfile_name) {
     /*
 
     generate_asm
@@ -615,6 +691,7 @@ void compiler::generate_asm(const std::string& infile_name, std::string outfile_
 
     @param  filename    The name of the file we wish to compile
     @param  p   The parser object that will be used to parse the file
+    @return Whether the program was compiled and written to the outfile
 
     */
 
@@ -636,6 +713,20 @@ void compiler::generate_asm(const std::string& infile_name, std::string outfile_
         StatementBlock ast = sin_parser->create_ast();
         delete sin_parser;
 
+        // run the optimization pipeline selected by the optimization level
+        if (this->_opt_level > 0) {
+            std::cout << "Optimizing..." << std::endl;
+            pass_manager passes(this->_opt_level);
+            passes.run(ast);
+        }
+
+        // functions defined in this file may be called in compile-time constants; the AST outlives code generation
+        for (auto s: ast.statements_list) {
+            if (s->get_statement_type() == FUNCTION_DEFINITION) {
+                this->evaluator.add_function(static_cast<const FunctionDefinition&>(*s));
+            }
+        }
+
         // The code we are generating will go in the text segment -- writes to the data and bss sections will be done as needed in other functions
 		std::cout << "Generating code..." << std::endl;
         this->text_segment << "%ifndef _SRE_INCLUDE_" << std::endl;
@@ -796,13 +887,19 @@ void compiler::generate_asm(const std::string& infile_name, std::string outfile_
 
         // close the outfile
         outfile.close();
+        if (outfile.fail()) {
+            std::cout << "Could not write to '" << outfile_name << "'" << std::endl;
+            return false;
+        }
 
 		// print a message saying compilation has finished
 		std::cout << "Compilation finished successfully." << std::endl;
+        return true;
     } catch (std::exception &e) {
         // todo: exception handling should be improved
         std::cout << "An error occurred during compilation:" << std::endl;
         std::cout << e.what() << std::endl;
+        return false;
     }
 }
 
@@ -826,20 +923,28 @@ bool compiler::is_in_scope(symbol &sym) {
     );
 }
 
-compiler::compiler(bool allow_unsafe, bool strict, bool use_micro)
+compiler::compiler(bool allow_unsafe, bool strict, bool use_micro, unsigned int opt_level, target_cpu cpu, bool fp_reassociate, bool fp_contract, bool sre_get_rc)
     : evaluator(&this->structs)
     , _allow_unsafe(allow_unsafe)
     , _strict(strict)
     , _micro_mode(use_micro)
+    , _opt_level(opt_level)
+    , _cpu(cpu)
+    , _fp_reassociate(fp_reassociate)
+    , _fp_contract(fp_contract)
+    , _sre_get_rc(sre_get_rc)
 {
     // initialize our number trackers
     this->strc_num = 0;
     this->strcmp_num = 0;
     this->fltc_num = 0;
     this->rtbounds_num = 0;
+    this->condition_num = 0;
     this->list_literal_num = 0;
     this->scope_block_num = 0;
+    this->vecc_num = 0;
     this->max_offset = 8;   // should be 8 (a qword) because of the way the x86 stack works
+    this->current_definition = nullptr;
     
     // initialize the scope
     this->current_scope_name = "global";
@@ -14,6 +14,7 @@ Copyright 2019 Riley Lannon
 #include <string>
 #include <sstream>
 #include <unordered_map>
+#include <unordered_set>
 #include <set>
 
 #include "symbol.h"
@@ -29,6 +30,12 @@ Copyright 2019 Riley Lannon
 #include "compile_util/expression_util.h"
 #include "compile_util/assign_util.h"
 #include "compile_util/magic_numbers.h"
+#include "compile_util/induction_util.h"
+#include "compile_util/vector_util.h"
+#include "compile_util/cow_util.h"
+#include "compile_util/move_util.h"
+
+#include "opt/pass_manager.h"
 
 class compiler {
     /*
@@ -45,6 +52,11 @@ class compiler {
 	const bool _micro_mode;
 	const bool _strict;
 	const bool _allow_unsafe;
+	const unsigned int _opt_level;
+	const target_cpu _cpu;
+	const bool _fp_reassociate;	// whether floating-point sums may be computed in a different order
+	const bool _fp_contract;	// whether floating-point multiplies and adds may be fused
+	const bool _sre_get_rc;	// whether the SRE provides SRE_GET_RC
 
     // todo: break code generation into multiple friend classes
 
@@ -75,6 +87,8 @@ class compiler {
 	size_t list_literal_num;
 	size_t scope_block_num;
 	size_t rtbounds_num;
+	size_t condition_num;
+	size_t vecc_num;
 
 	// We should have stringstreams for the text, rodata, data, and bss segments
 	std::stringstream text_segment;
@@ -85,6 +99,49 @@ class compiler {
 	// We must also keep track of the maximum offset within the current stack frame -- use for new variables, calls, etc.
     size_t max_offset;
 
+	// strength reduction of array accesses in loops (see compile_util/induction_util.h)
+	const FunctionDefinition *current_definition;	// the function being compiled, if any
+	function_info current_locals;
+	std::unordered_map<const Indexed*, size_t> induction_pointers;	// access -> stack offset of the pointer it uses
+	std::unordered_map<const Statement*, std::vector<std::pair<size_t, long long>>> induction_steps;	// step -> the pointers it advances, and by how much
+	std::unordered_set<const Statement*> removed_steps;	// steps of variables no longer needed
+	std::stringstream reduce_loop(const WhileLoop &loop, const std::string &body_label, std::string &condition, size_t &reserved);
+
+	// copy-on-write assignment of strings and dynamic arrays (see compile_util/cow_util.h)
+	std::unordered_set<std::string> shared_names;	// locals in the current function that may share their buffers
+	std::unordered_set<std::string> unique_names;	// shared names known to be unique for the rest of the current loop
+	bool is_shared_assignment(const std::string &dest, const DataType &dest_type, const Expression &rvalue);
+	std::stringstream share_buffer(const symbol &dest, const symbol &src);
+	std::stringstream ensure_unique(const std::string &name);
+
+	// moving strings and dynamic arrays on their last use (see compile_util/move_util.h)
+	std::unordered_set<const Expression*> last_uses;	// identifiers in the current function whose value may be moved
+	bool is_moved_assignment(const DataType &dest_type, const Expression &rvalue);
+	std::stringstream move_buffer(const symbol &dest, const Expression &rvalue, unsigned int line);
+
+	// vectorization of loops over arrays (see compile_util/vector_util.h)
+	std::stringstream vectorize_loop(const WhileLoop &loop, size_t block_num);
+	std::string evaluate_vector(const Expression &e, const vector_util::vector_loop &plan, const std::vector<reg> &bases, unsigned int temp);
+
+	// SIMD vector types (see compile/vector_expressions.cpp)
+	std::string evaluate_vector_expression(const Expression &e, const DataType &type, unsigned int line, unsigned int n = 0);
+	std::string evaluate_vector_scalar(const Expression &e, const DataType &lane, unsigned int line, unsigned int n);
+	std::string evaluate_vector_list(const ListExpression &l, const DataType &type, unsigned int line, unsigned int n);
+	std::string evaluate_vector_binary(const Binary &b, unsigned int line);
+	std::string evaluate_vector_unary(const Unary &u, const DataType &type, unsigned int line);
+	std::string evaluate_vector_shuffle(const Indexed &s, const DataType &type, unsigned int line);
+	std::string evaluate_vector_lane(const Indexed &lane, unsigned int line);
+	std::string evaluate_vector_reduction(const AttributeSelection &attr, unsigned int line);
+	std::string get_vector_element_address(const Indexed &element, const DataType &type, unsigned int line);
+	std::stringstream assign_vector(
+		const DataType &lhs_type,
+		const DataType &rhs_type,
+		const assign_utilities::destination_information &dest,
+		const Expression &rvalue,
+		unsigned int line
+	);
+	std::stringstream store_vector(const Indexed &element, const Expression &rvalue, unsigned int line);
+
 	// compile an entire statement block
 	std::stringstream compile_ast(StatementBlock &ast, function_symbol *signature = nullptr);
 
@@ -97,11 +154,7 @@ class compiler {
 	// assignments
 	std::stringstream handle_assignment(const Assignment &a);	// copy assignment
 	std::stringstream handle_move(const Movement &m);	// move assignment
-	std::stringstream handle_alloc_init(
-		const symbol &sym,
-		const Expression &rvalue,
-		unsigned int line
-	);
+	std::stringstream handle_alloc_init(const Allocation &alloc_stmt, const symbol &sym);
 	std::stringstream assign(
 		const DataType& lhs_type,
 		const DataType &rhs_type,
@@ -132,12 +185,16 @@ class compiler {
     std::stringstream sincall(const function_symbol& s, std::vector<const Expression*> args, unsigned int line);
     std::stringstream sincall(const function_symbol& s, std::vector<std::unique_ptr<Expression>>& args, unsigned int line);
 
-	std::stringstream system_v_call(const function_symbol& s, std::vector<Expression*> args, unsigned int line);
-	std::stringstream win64_call(const function_symbol& s, std::vector<Expression*> args, unsigned int line);
+	std::stringstream system_v_call(const function_symbol& s, std::vector<const Expression*> args, unsigned int line);
+	std::stringstream win64_call(const function_symbol& s, std::vector<const Expression*> args, unsigned int line);
 
 	// returns
 	std::stringstream handle_return(const ReturnStatement &ret, function_symbol &signature);
+	const function_symbol *get_tail_callee(const ReturnStatement &ret, const function_symbol &signature);
+	std::stringstream sincall_tail_call(const Procedure &call, const function_symbol &callee, unsigned int line);
 	std::stringstream sincall_return(const ReturnStatement &ret, DataType return_type);
+	std::stringstream sincall_return_tuple(const ReturnStatement &ret, const DataType &return_type);
+	std::stringstream system_v_return(const ReturnStatement &ret, DataType return_type);
 
 	// utilities that require compiler's data members
 	std::stringstream get_exp_address(const Expression &to_evaluate, reg r, unsigned int line);
@@ -151,6 +208,13 @@ class compiler {
 	std::stringstream evaluate_indexed(const Indexed &to_evaluate, unsigned int line);
 	std::stringstream evaluate_unary(const Unary &to_evaluate, unsigned int line, const DataType *type_hint = nullptr);
 	std::pair<std::string, size_t> evaluate_binary(const Binary &to_evaluate, unsigned int line, const DataType *type_hint = nullptr);
+	std::stringstream evaluate_logical(const Binary &to_evaluate, unsigned int line);
+	std::string evaluate_fp_contraction(const Binary &to_evaluate, unsigned int line);
+	std::pair<std::string, size_t> evaluate_string_concatenation(const Binary &to_evaluate, unsigned int line);
+	void get_concatenation_operands(const Expression &e, std::vector<const Expression*> &operands, unsigned int line);
+	void check_binary_operands(const DataType &left_type, const DataType &right_type, unsigned int line);
+	std::stringstream evaluate_condition(const Expression &condition, const std::string &target, bool jump_if, unsigned int line);
+	std::stringstream evaluate_comparison(const Binary &condition, const std::string &target, bool jump_if, unsigned int line);
 	std::stringstream get_address_of(const Unary &u, reg r, unsigned int line);
 
 	// process an included file
@@ -160,8 +224,8 @@ class compiler {
 	void _warn(const std::string& message, const unsigned int code, const unsigned int line);
 public:
     // the compiler's entry function
-    void generate_asm(const std::string& infile_name, std::string outfile_name);
+    bool generate_asm(const std::string& infile_name, std::string outfile_name);
 
-    compiler(bool allow_unsafe, bool strict, bool use_micro);
+    compiler(bool allow_unsafe, bool strict, bool use_micro, unsigned int opt_level = 0, target_cpu cpu = X86_64, bool fp_reassociate = false, bool fp_contract = false, bool sre_get_rc = false);
     ~compiler();
 };
@@ -0,0 +1,333 @@
+/*
+
+SIN Toolchain (x86 target)
+conditionals.cpp
+Copyright 2020 Riley Lannon
+
+Code generation for conditions used by control flow statements (if/else and while)
+
+Rather than evaluating a condition into AL and testing the result, these functions generate a conditional jump directly from the comparison of the original operands. Logical operators are lowered through branch inversion, so no intermediate boolean values need to be materialized.
+
+*/
+
+#include <limits>
+
+#include "compiler.h"
+#include "compile_util/function_util.h"
+
+bool get_immediate_operand(const Expression &operand, const DataType &left_type, std::string &immediate) {
+	/*
+
+	get_immediate_operand
+	Determines whether the right-hand operand of a comparison may be encoded as an immediate value
+
+	@param	operand	The right-hand operand
+	@param	left_type	The type of the left-hand operand
+	@param	immediate	Where the immediate value should be written, if one could be obtained
+	@return	Whether the operand can be used as an immediate
+
+	*/
+
+	if (operand.get_expression_type() != LITERAL) {
+		return false;
+	}
+
+	auto &literal = static_cast<const Literal&>(operand);
+	Type primary = literal.get_data_type().get_primary();
+	if (primary != left_type.get_primary()) {
+		return false;
+	}
+
+	if (primary == INT) {
+		// cmp only takes a sign-extended 32-bit immediate; integer literals are always written in base 10, so a leading zero doesn't make one octal
+		try {
+			long long value = std::stoll(literal.get_value(), nullptr, 10);
+			if (value < std::numeric_limits<int32_t>::min() || value > std::numeric_limits<int32_t>::max()) {
+				return false;
+			}
+			immediate = std::to_string(value);
+		}
+		catch (std::exception &e) {
+			return false;
+		}
+	}
+	else if (primary == CHAR) {
+		immediate = "`" + literal.get_value() + "`";
+	}
+	else if (primary == BOOL) {
+		if (literal.get_value() == "true") {
+			immediate = "1";
+		}
+		else if (literal.get_value() == "false") {
+			immediate = "0";
+		}
+		else {
+			return false;
+		}
+	}
+	else {
+		return false;
+	}
+
+	return true;
+}
+
+std::stringstream compiler::evaluate_condition(const Expression &condition, const std::string &target, bool jump_if, unsigned int line) {
+	/*
+
+	evaluate_condition
+	Generates code to jump to a label based on the result of a condition
+
+	Comparisons generate a 'cmp' (or 'ucomiss'/'ucomisd') followed directly by the appropriate Jcc instruction
+	Logical 'not' simply inverts the sense of the jump, and 'and'/'or' are lowered through branch inversion; the right operand is only evaluated if the left one did not already decide the result
+	Any other expression is evaluated normally and its result tested
+
+	@param	condition	The condition to evaluate
+	@param	target	The label to which we jump
+	@param	jump_if	Whether we jump when the condition is true (or when it is false)
+	@param	line	The line number where the condition occurs
+	@return	A stringstream containing the generated code
+
+	*/
+
+	std::stringstream cond_ss;
+
+	if (condition.get_expression_type() == LITERAL) {
+		auto &literal = static_cast<const Literal&>(condition);
+		if (literal.get_data_type().get_primary() == BOOL) {
+			// the result is known at compile time; either always jump or never jump
+			if ((literal.get_value() == "true") == jump_if) {
+				cond_ss << "\t" << "jmp " << target << std::endl;
+			}
+			return cond_ss;
+		}
+	}
+	else if (condition.get_expression_type() == UNARY) {
+		auto &u = static_cast<const Unary&>(condition);
+		if (u.get_operator() == NOT) {
+			DataType operand_type = expression_util::get_expression_data_type(u.get_operand(), this->symbols, this->structs, line);
+			if (operand_type.get_primary() != BOOL) {
+				throw UnaryTypeNotSupportedError(line);
+			}
+
+			return this->evaluate_condition(u.get_operand(), target, !jump_if, line);
+		}
+	}
+	else if (condition.get_expression_type() == BINARY) {
+		auto &b = static_cast<const Binary&>(condition);
+		exp_operator op = b.get_operator();
+
+		if (op == AND || op == OR) {
+			DataType left_type = expression_util::get_expression_data_type(b.get_left(), this->symbols, this->structs, line);
+			DataType right_type = expression_util::get_expression_data_type(b.get_right(), this->symbols, this->structs, line);
+			if (left_type.get_primary() != BOOL || right_type.get_primary() != BOOL) {
+				throw UndefinedOperatorError(op == AND ? "logical-and" : "logical-or", line);
+			}
+
+			/*
+
+			If the left operand alone decides the result in the direction we jump, it can jump to the target directly:
+				(a and b), jump if false:	a false -> target; b false -> target
+				(a or b), jump if true:	a true -> target; b true -> target
+			Otherwise, the left operand must skip over the right operand's test:
+				(a and b), jump if true:	a false -> skip; b true -> target
+				(a or b), jump if false:	a true -> skip; b false -> target
+
+			*/
+
+			if ((op == AND) != jump_if) {
+				cond_ss << this->evaluate_condition(b.get_left(), target, jump_if, line).str();
+				cond_ss << this->evaluate_condition(b.get_right(), target, jump_if, line).str();
+			}
+			else {
+				std::string skip_label = magic_numbers::CONDITION_SKIP_LABEL + std::to_string(this->condition_num);
+				this->condition_num += 1;
+
+				cond_ss << this->evaluate_condition(b.get_left(), skip_label, !jump_if, line).str();
+				cond_ss << this->evaluate_condition(b.get_right(), target, jump_if, line).str();
+				cond_ss << skip_label << ":" << std::endl;
+			}
+
+			return cond_ss;
+		}
+		else if (general_utilities::is_relational(op)) {
+			DataType left_type = expression_util::get_expression_data_type(b.get_left(), this->symbols, this->structs, line);
+			Type primary = left_type.get_primary();
+
+			// strings still require the comparison routine in evaluate_binary, and vector comparisons are rejected below
+			if (
+				expression_util::get_expression_data_type(b.get_right(), this->symbols, this->structs, line).get_primary() == VECTOR
+			) {
+				primary = VECTOR;
+			}
+			else if (primary == INT || primary == CHAR || primary == BOOL || primary == PTR || primary == FLOAT) {
+				return this->evaluate_comparison(b, target, jump_if, line);
+			}
+		}
+	}
+
+	// any other condition gets evaluated and its result tested
+	DataType condition_type = expression_util::get_expression_data_type(condition, this->symbols, this->structs, line);
+	if (condition_type.get_primary() == VECTOR) {
+		throw CompilerException(
+			"Vector comparisons produce masks rather than booleans; reduce the mask (e.g., with 'min' or 'max') to test it",
+			compiler_errors::TYPE_ERROR,
+			line
+		);
+	}
+
+	auto condition_p = this->evaluate_expression(condition, line);
+	cond_ss << condition_p.first;
+	if (condition_p.second) {
+		cond_ss << release_temporary(this->reg_stack.peek(), condition_type);
+	}
+
+	cond_ss << "\t" << "test al, al" << std::endl;
+	cond_ss << "\t" << (jump_if ? "jnz " : "jz ") << target << std::endl;
+
+	return cond_ss;
+}
+
+std::stringstream compiler::evaluate_comparison(const Binary &condition, const std::string &target, bool jump_if, unsigned int line) {
+	/*
+
+	evaluate_comparison
+	Generates a comparison of two operands followed by a conditional jump
+
+	The operands are evaluated in the same manner as they are in evaluate_binary, but the comparison sets EFLAGS for the Jcc rather than a SETcc. Where the right operand is a literal that fits in an immediate, it is not evaluated into a register at all.
+
+	@param	condition	The comparison
+	@param	target	The label to which we jump
+	@param	jump_if	Whether we jump when the comparison is true (or when it is false)
+	@param	line	The line number where the comparison occurs
+	@return	A stringstream containing the generated code
+
+	*/
+
+	std::stringstream cmp_ss;
+
+	DataType left_type = expression_util::get_expression_data_type(
+		condition.get_left(),
+		this->symbols,
+		this->structs,
+		line
+	);
+	DataType right_type = expression_util::get_expression_data_type(
+		condition.get_right(),
+		this->symbols,
+		this->structs,
+		line,
+		&left_type
+	);
+
+	if (!left_type.is_compatible(right_type)) {
+		throw TypeException(line);
+	}
+
+	this->check_binary_operands(left_type, right_type, line);
+
+	// evaluate the left-hand side
+	auto lhs_pair = this->evaluate_expression(condition.get_left(), line);
+	cmp_ss << lhs_pair.first;
+	if (lhs_pair.second) {
+		cmp_ss << release_temporary(this->reg_stack.peek(), left_type);
+	}
+
+	bool use_unsigned = false;
+	std::string immediate;
+
+	if (left_type.get_primary() == FLOAT) {
+		// "push" xmm0
+		cmp_ss << "\t" << "sub rsp, 16" << std::endl;
+		cmp_ss << "\t" << "movdqu [rsp], xmm0" << std::endl;
+
+		auto rhs_pair = this->evaluate_expression(condition.get_right(), line);
+		cmp_ss << rhs_pair.first;
+		if (rhs_pair.second) {
+			cmp_ss << release_temporary(this->reg_stack.peek(), right_type);
+		}
+
+		cmp_ss << "\t" << ((right_type.get_width() == sin_widths::DOUBLE_WIDTH) ? "movsd" : "movss") << " xmm1, xmm0" << std::endl;
+		cmp_ss << "\t" << "movdqu xmm0, [rsp]" << std::endl;
+		cmp_ss << "\t" << "add rsp, 16" << std::endl;
+
+		// if the widths differ, both operands are compared as doubles
+		size_t data_width = left_type.get_width();
+		if (right_type.get_primary() == FLOAT && left_type.get_width() != right_type.get_width()) {
+			if (left_type.get_width() == sin_widths::DOUBLE_WIDTH) {
+				cmp_ss << "\t" << "cvtss2sd xmm1, xmm1" << std::endl;
+			}
+			else {
+				cmp_ss << "\t" << "cvtss2sd xmm0, xmm0" << std::endl;
+			}
+
+			data_width = sin_widths::DOUBLE_WIDTH;
+		}
+
+		/*
+
+		ucomiss/ucomisd set the flags like an unsigned comparison would, but an unordered result (either operand is NaN) sets ZF, PF, and CF at once, and every comparison but '!=' must then be false
+		So < and <= swap their operands to use 'above' and 'above or equal', which are false for NaN, and equality checks PF as well; since the opposite of a comparison isn't its negated operator when NaN is involved, jumping when it is false uses the inverted condition code instead
+
+		*/
+
+		exp_operator op = condition.get_operator();
+		bool swap = op == LESS || op == LESS_OR_EQUAL;
+		cmp_ss << "\t" << ((data_width == sin_widths::DOUBLE_WIDTH) ? "ucomisd" : "ucomiss") << (swap ? " xmm1, xmm0" : " xmm0, xmm1") << std::endl;
+
+		if (op == EQUAL || op == NOT_EQUAL) {
+			if ((op == EQUAL) == jump_if) {
+				// jump only if equal and ordered
+				std::string skip_label = magic_numbers::CONDITION_SKIP_LABEL + std::to_string(this->condition_num);
+				this->condition_num += 1;
+
+				cmp_ss << "\t" << "jp " << skip_label << std::endl;
+				cmp_ss << "\t" << "je " << target << std::endl;
+				cmp_ss << skip_label << ":" << std::endl;
+			}
+			else {
+				cmp_ss << "\t" << "jne " << target << std::endl;
+				cmp_ss << "\t" << "jp " << target << std::endl;
+			}
+		}
+		else {
+			bool strict = op == LESS || op == GREATER;
+			if (jump_if) {
+				cmp_ss << "\t" << (strict ? "ja " : "jae ") << target << std::endl;
+			}
+			else {
+				cmp_ss << "\t" << (strict ? "jbe " : "jb ") << target << std::endl;
+			}
+		}
+
+		return cmp_ss;
+	}
+	else {
+		std::string rax_name = register_usage::get_register_name(RAX, left_type);
+
+		if (get_immediate_operand(condition.get_right(), left_type, immediate)) {
+			cmp_ss << "\t" << "cmp " << rax_name << ", " << immediate << std::endl;
+		}
+		else {
+			cmp_ss << "\t" << "push rax" << std::endl;
+
+			auto rhs_pair = this->evaluate_expression(condition.get_right(), line);
+			cmp_ss << rhs_pair.first;
+			if (rhs_pair.second) {
+				cmp_ss << release_temporary(this->reg_stack.peek(), right_type);
+			}
+
+			cmp_ss << "\t" << "mov rbx, rax" << std::endl;
+			cmp_ss << "\t" << "pop rax" << std::endl;
+			cmp_ss << "\t" << "cmp " << rax_name << ", " << register_usage::get_register_name(RBX, left_type) << std::endl;
+		}
+
+		use_unsigned = left_type.get_qualities().is_unsigned() && right_type.get_qualities().is_unsigned();
+	}
+
+	// if we jump when the comparison is false, we jump on the inverse comparison
+	exp_operator op = jump_if ? condition.get_operator() : general_utilities::negate_relational(condition.get_operator());
+	cmp_ss << "\t" << "j" << get_condition_code(op, use_unsigned, line) << " " << target << std::endl;
+
+	return cmp_ss;
+}
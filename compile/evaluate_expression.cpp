@@ -10,8 +10,6 @@ Generates code for evaluating an expression. This data will be loaded into regis
 #include "compiler.h"
 #include "compile_util/function_util.h"
 
-// todo: add evaluation of expressions labeled 'constexpr'
-
 // todo: create an expression evaluation class and give it access to compiler members?
 std::pair<std::string, size_t> compiler::evaluate_expression(
     const Expression &to_evaluate,
@@ -42,6 +40,14 @@ std::pair<std::string, size_t> compiler::evaluate_expression(
     std::stringstream evaluation_ss;
     size_t count = 0;
 
+    // expressions marked 'constexpr' (and operations on literals) are replaced by their values where they can be computed at compile time; otherwise, they are evaluated at runtime like any other
+    if (to_evaluate.is_const() && to_evaluate.get_expression_type() != LITERAL) {
+        std::unique_ptr<Literal> folded = this->evaluator.fold(to_evaluate);
+        if (folded) {
+            return this->evaluate_expression(*folded, line, type_hint);
+        }
+    }
+
     // The expression evaluation depends on the expression's type
     switch (to_evaluate.get_expression_type()) {
         case LITERAL:
@@ -66,6 +72,18 @@ std::pair<std::string, size_t> compiler::evaluate_expression(
         {
             // get the address and dereference
             DataType t = expression_util::get_expression_data_type(to_evaluate, this->symbols, this->structs, line);
+            auto &idx = static_cast<const Indexed&>(to_evaluate);
+            if (t.get_primary() == VECTOR) {
+                evaluation_ss << this->evaluate_vector_expression(to_evaluate, t, line);
+                break;
+            }
+            else if (
+                expression_util::get_expression_data_type(idx.get_to_index(), this->symbols, this->structs, line).get_primary() == VECTOR
+            ) {
+                evaluation_ss << this->evaluate_vector_lane(idx, line);
+                break;
+            }
+
             evaluation_ss << this->get_exp_address(to_evaluate, RBX, line).str();
             evaluation_ss << "\t" << "mov " << register_usage::get_register_name(RAX, t) << ", [rbx]" << std::endl;
             break;
@@ -74,6 +92,12 @@ std::pair<std::string, size_t> compiler::evaluate_expression(
         {
             // evaluate a list expression
 
+            // lists assigned to vectors give the value of each lane
+            if (type_hint && type_hint->get_primary() == VECTOR) {
+                evaluation_ss << this->evaluate_vector_expression(to_evaluate, *type_hint, line);
+                break;
+            }
+
             // todo: would it be better to just iterate on an assignment and copy into the list? or is it better to use array_copy (as we are doing now)?
             
             // create our label
@@ -265,8 +289,12 @@ std::pair<std::string, size_t> compiler::evaluate_expression(
                 // check to make sure the typecast itself is valid (follows the rules)
                 DataType old_type = expression_util::get_expression_data_type(c.get_exp(), this->symbols, this->structs, line);
                 if (is_valid_cast(old_type, c.get_new_type())) {
+                    // vectors are converted lane-by-lane, and scalars are broadcast to them
+                    if (c.get_new_type().get_primary() == VECTOR) {
+                        evaluation_ss << this->evaluate_vector_expression(c, c.get_new_type(), line);
+                    }
                     // if we are casting a literal integer or float to itself (but with a different width), create a new Literal
-                    if (
+                    else if (
                         (c.get_exp().get_expression_type() == LITERAL) &&
                         (old_type.get_primary() == c.get_new_type().get_primary()) &&
                         (old_type.get_primary() == INT || old_type.get_primary() == FLOAT)
@@ -300,6 +328,21 @@ std::pair<std::string, size_t> compiler::evaluate_expression(
         {
             auto &attr = static_cast<const AttributeSelection&>(to_evaluate);
             auto t = expression_util::get_expression_data_type(attr.get_selected(), this->symbols, this->structs, line);
+
+            // the reductions are only defined for vectors
+            if (attr.get_attribute() == SUM || attr.get_attribute() == MINIMUM || attr.get_attribute() == MAXIMUM) {
+                if (t.get_primary() != VECTOR) {
+                    throw CompilerException(
+                        "The sum, min, and max attributes may only be used with vectors",
+                        compiler_errors::UNKNOWN_ATTRIBUTE,
+                        line
+                    );
+                }
+
+                evaluation_ss << this->evaluate_vector_reduction(attr, line);
+                break;
+            }
+
             auto attr_p = this->evaluate_expression(attr.get_selected(), line, type_hint);
 
             // we have a limited number of attributes
@@ -327,6 +370,10 @@ std::pair<std::string, size_t> compiler::evaluate_expression(
                     auto s = this->get_struct_info(t.get_struct_name(), line);
                     evaluation_ss << "\t" << "mov eax, 1" << std::endl; // todo: we need a get_fields method
                 }
+                else if (t.get_primary() == VECTOR) {
+                    // the number of lanes
+                    evaluation_ss << "\t" << "mov eax, " << t.get_array_length() << std::endl;
+                }
                 else {
                     evaluation_ss << "\t" << "mov eax, 1" << std::endl;
                 }
@@ -572,6 +619,10 @@ std::stringstream compiler::evaluate_identifier(const Identifier &to_evaluate, u
                 // void types should generate a compiler error -- they cannot be evaluated
                 throw VoidException(line);
             }
+            else if (sym.get_data_type().get_primary() == VECTOR) {
+                // vectors are loaded into XMM0 (or YMM0)
+                eval_ss << this->evaluate_vector_expression(to_evaluate, sym.get_data_type(), line);
+            }
             else if (can_pass_in_register(sym.get_data_type())) {
 
                 // todo: utilize expression_util::load_into_register
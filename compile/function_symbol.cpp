@@ -7,7 +7,10 @@ Implementation of the function_symbol class
 
 */
 
+#include <algorithm>
+
 #include "function_symbol.h"
+#include "compile_util/utilities.h"
 
 bool function_symbol::matches(const function_symbol& right) const {
 	/*
@@ -58,6 +61,21 @@ const register_usage& function_symbol::get_arg_regs() const {
     return this->arg_regs;
 }
 
+std::vector<reg> function_symbol::get_tuple_registers(size_t index) const {
+    // Returns the registers holding each eightbyte of a tuple or struct parameter (empty if it is passed on the stack)
+    std::vector<reg> regs;
+    auto &param = *this->formal_parameters[index];
+    if (param.get_register() != NO_REGISTER) {
+        regs.push_back(param.get_register());
+
+        auto it = this->upper_regs.find(index);
+        if (it != this->upper_regs.end()) {
+            regs.push_back(it->second);
+        }
+    }
+    return regs;
+}
+
 function_symbol::function_symbol(
 	std::string function_name, 
 	DataType return_type, 
@@ -66,7 +84,8 @@ function_symbol::function_symbol(
     unsigned int scope_level, 
 	calling_convention call_con, 
 	bool defined,
-	unsigned int line_defined
+	unsigned int line_defined,
+	struct_table *structs
 ) :
 	symbol(
 		function_name,
@@ -84,6 +103,7 @@ function_symbol::function_symbol(
     specialized constructor
 
     This constructor will construct an object for the function signature and determine which arguments can be passed in which registers
+    Small structs may only be passed in registers if the struct table is supplied (see get_eightbytes)
 
     */
 
@@ -112,7 +132,8 @@ function_symbol::function_symbol(
 		if (call_con == calling_convention::SINCALL) {
 			// determine the register for each of our formal parameters
 			bool can_pass_in_reg = true;	// once we have one argument passed on the stack, all subsequent arguments will be
-			for (auto sym : this->formal_parameters) {
+			for (size_t index = 0; index < this->formal_parameters.size(); index++) {
+				auto sym = this->formal_parameters[index];
 				
 				// todo:
 				/*
@@ -131,9 +152,43 @@ function_symbol::function_symbol(
 				
 				// which register is used (or whether a register is used at all) depends on the primary type of the symbol
 				Type primary_type = sym->get_data_type().get_primary();
-				
+				const reg integer_registers[] = { RSI, RDI, RCX, RDX, R8, R9 };
+				const reg float_registes[] = { XMM0, XMM1, XMM2, XMM3, XMM4, XMM5 };
+
+				// small tuples and structs are split into eightbytes, each of which is passed in the next register of its class
+				std::vector<eightbyte> parts;
+				if (can_pass_in_reg && get_eightbytes(sym->get_data_type(), parts, structs)) {
+					std::vector<reg> to_use;
+					for (auto &part: parts) {
+						const reg *candidates = part.is_float ? float_registes : integer_registers;
+						unsigned short i = 0;
+						while (i < 6 && (this->arg_regs.is_in_use(candidates[i]) || std::find(to_use.begin(), to_use.end(), candidates[i]) != to_use.end())) {
+							i++;
+						}
+
+						if (i < 6) {
+							to_use.push_back(candidates[i]);
+						}
+					}
+
+					// if any part doesn't fit, the whole object goes on the stack (as must all subsequent arguments)
+					if (to_use.size() == parts.size()) {
+						for (auto r: to_use) {
+							this->arg_regs.set(r, sym.get());
+						}
+
+						// marking a register sets the symbol's register, too, so the first must be set last
+						sym->set_register(to_use[0]);
+						if (to_use.size() > 1) {
+							this->upper_regs[index] = to_use[1];
+						}
+					}
+					else {
+						can_pass_in_reg = false;
+					}
+				}
 				// assign the register, if possible
-				if (
+				else if (
                     can_pass_in_reg && 
                     (
                         primary_type != ARRAY && 
@@ -143,11 +198,9 @@ function_symbol::function_symbol(
                 ) {
 					// pass in the primary type; the get_available_register function will be able to handle it
 					reg to_use = NO_REGISTER;
-					const reg integer_registers[] = { RSI, RDI, RCX, RDX, R8, R9 };
-					const reg float_registes[] = { XMM0, XMM1, XMM2, XMM3, XMM4, XMM5 };
 
 					bool found = false;
-					if (primary_type == FLOAT) {
+					if (primary_type == FLOAT || primary_type == VECTOR) {
 						unsigned short i = 0;
 						while (i < 6 && !found) {
 							if (this->arg_regs.is_in_use(float_registes[i])) {
@@ -193,6 +246,57 @@ function_symbol::function_symbol(
 				}
 			}
 		}
+		else if (call_con == calling_convention::SYSTEM_V) {
+			/*
+
+			The System V ABI classifies each argument separately; integral and pointer arguments take the next free register of RDI, RSI, RDX, RCX, R8, R9 and floating-point arguments take the next of XMM0 - XMM7
+			Any argument that doesn't fit goes on the stack in an eightbyte slot, but unlike SINCALL, subsequent arguments may still use registers
+
+			Offsets are for the frame set up by a System V function defined in SIN:
+				- arguments passed in registers get space (for spilling) below rbp, like local variables
+				- arguments passed on the stack are above the saved registers and return address
+
+			*/
+
+			const reg integer_registers[] = { RDI, RSI, RDX, RCX, R8, R9 };
+			const reg float_registers[] = { XMM0, XMM1, XMM2, XMM3, XMM4, XMM5, XMM6, XMM7 };
+			size_t next_integer = 0;
+			size_t next_float = 0;
+
+			int register_offset = 0;
+			int memory_offset = -general_utilities::SYSTEM_V_PARAMETER_OFFSET;
+
+			for (auto sym : this->formal_parameters) {
+				Type primary_type = sym->get_data_type().get_primary();
+				size_t obj_width = sym->get_data_type().get_width();
+				reg to_use = NO_REGISTER;
+
+				// aggregates are always passed in memory
+				if (primary_type != ARRAY && primary_type != STRUCT && primary_type != TUPLE) {
+					if (primary_type == FLOAT) {
+						if (next_float < 8) {
+							to_use = float_registers[next_float];
+							next_float += 1;
+						}
+					}
+					else if (next_integer < 6) {
+						to_use = integer_registers[next_integer];
+						next_integer += 1;
+					}
+				}
+
+				sym->set_register(to_use);
+				if (to_use == NO_REGISTER) {
+					sym->set_offset(memory_offset);
+					memory_offset -= ((obj_width + 7) / 8) * 8;	// every argument occupies a whole number of eightbytes
+				}
+				else {
+					register_offset += obj_width;
+					sym->set_offset(register_offset);
+					this->arg_regs.set(to_use, sym.get());
+				}
+			}
+		}
 		else {
 			throw CompilerException("Currently, no other calling conventions are supported", compiler_errors::INVALID_SYMBOL_TYPE_ERROR, 0);
 		}
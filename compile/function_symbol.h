@@ -13,6 +13,8 @@ Contains the declaration of the function_symbol class
 #include "compile_util/register_usage.h"
 #include "../util/general_utilities.h"
 
+class struct_table;
+
 class function_symbol: public symbol {
     /*
 
@@ -24,6 +26,7 @@ class function_symbol: public symbol {
     // Function arguments -- formal parameters should be stored as symbols (they are considered local variables, so they will be pushed first)
     std::vector< std::shared_ptr< symbol > > formal_parameters;
     register_usage arg_regs;    // the registers used by this signature
+    std::unordered_map<size_t, reg> upper_regs;    // the registers holding the second eightbyte of tuple and struct parameters, by position
     bool _method;
 
     // calling convention -- defaults to SIN
@@ -37,6 +40,7 @@ public:
     calling_convention get_calling_convention() const;
 
     const register_usage& get_arg_regs() const;
+    std::vector<reg> get_tuple_registers(size_t index) const;
 
     // constructors
     function_symbol(
@@ -47,7 +51,8 @@ public:
         unsigned int scope_level,
         calling_convention call_con = SINCALL,
         bool defined = true,
-        unsigned int line_defined = 0
+        unsigned int line_defined = 0,
+        struct_table *structs = nullptr
     );
     function_symbol();
     ~function_symbol();
@@ -32,7 +32,11 @@ std::stringstream compiler::handle_declaration(const Declaration& decl_stmt) {
         function_symbol sym = function_util::create_function_symbol(
             decl_stmt,
             !decl_stmt.get_type_information().get_qualities().is_extern(),
-            false
+            false,
+            "global",
+            0,
+            false,
+            &this->structs
         );
         this->add_symbol(sym, decl_stmt.get_line_number());
         if (this->externals.count(sym.get_name())) {
@@ -70,12 +74,51 @@ std::stringstream compiler::define_function(const FunctionDefinition &definition
     
     */
 
-    function_symbol func_sym = function_util::create_function_symbol(definition);
-    return this->define_function(
+    // like declarations, 'extern' functions are not mangled so that they may be referenced by other languages
+    function_symbol func_sym = function_util::create_function_symbol(
+        definition,
+        !definition.get_type_information().get_qualities().is_extern(),
+        true,
+        "global",
+        0,
+        false,
+        &this->structs
+    );
+
+    // the loops in the function may need to know about its locals (see compiler::reduce_loop)
+    const FunctionDefinition *previous_definition = this->current_definition;
+    function_info previous_locals = this->current_locals;
+    this->current_definition = &definition;
+    this->current_locals.analyze(definition);
+
+    // so may the assignments that share strings and arrays (see compile_util/cow_util.h); a shared buffer can only be copied when it is modified if the SRE can tell us its reference count
+    auto previous_shared = this->shared_names;
+    auto previous_unique = this->unique_names;
+    this->shared_names.clear();
+    this->unique_names.clear();
+    if (this->_opt_level > 0 && this->_sre_get_rc) {
+        this->shared_names = cow_util::find_shared_names(definition, this->current_locals, this->symbols);
+    }
+
+    // and those that move them on their last use (see compile_util/move_util.h)
+    auto previous_last_uses = this->last_uses;
+    this->last_uses.clear();
+    if (this->_opt_level > 0) {
+        this->last_uses = move_util::find_last_uses(definition, this->current_locals, this->symbols, this->shared_names);
+    }
+
+    std::stringstream definition_ss = this->define_function(
         func_sym,
         definition.get_procedure(),
         definition.get_line_number()
     );
+
+    this->current_definition = previous_definition;
+    this->current_locals = previous_locals;
+    this->shared_names = previous_shared;
+    this->unique_names = previous_unique;
+    this->last_uses = previous_last_uses;
+    return definition_ss;
 }
 
 std::stringstream compiler::define_function(function_symbol &func_sym, StatementBlock prog, unsigned int line) {
@@ -162,9 +205,15 @@ std::stringstream compiler::define_function(function_symbol &func_sym, Statement
     // now, we have to iterate over the function symbol's parameters and add them to our symbol table
     // todo: optimize by enabling symbol table additions in template function?
     std::unordered_map<symbol*, reg> arg_regs;
-    for (auto sym: func_sym.get_formal_parameters()) {
-        // add the parameter symbol to the table
-        symbol &inserted = this->add_symbol(sym, line);
+    std::vector<symbol*> vector_params;
+    std::vector<std::pair<symbol*, size_t>> tuple_params;  // and their positions (structs included)
+    auto &formal_parameters = func_sym.get_formal_parameters();
+    for (size_t i = 0; i < formal_parameters.size(); i++) {
+        auto sym = formal_parameters[i];
+
+        // add a copy of the parameter symbol to the table
+        // the body spills and reloads the copy, so the signature's registers stay intact for calls (including recursive ones)
+        symbol &inserted = this->add_symbol(*sym, line);
         
 		// if r was passed in a register, then we must add it to arg_regs
 		reg r = sym->get_register();
@@ -172,30 +221,118 @@ std::stringstream compiler::define_function(function_symbol &func_sym, Statement
             arg_regs.insert(
                 std::make_pair<>(&inserted, sym->get_register())
             );
+
+            if (sym->get_data_type().get_primary() == VECTOR) {
+                vector_params.push_back(&inserted);
+            }
+            else if (sym->get_data_type().get_primary() == TUPLE || sym->get_data_type().get_primary() == STRUCT) {
+                tuple_params.push_back(std::make_pair(&inserted, i));
+            }
         }
     }
 
-    // get the register_usage object from func_sym and push that
+    // get the register_usage object from func_sym and push that, pointing its registers at the copies in the table
     this->reg_stack.push_back(func_sym.get_arg_regs());
+    for (auto &p: arg_regs) {
+        this->reg_stack.peek().set(p.second, p.first);
+    }
 
     // add a label for the function
     definition_ss << func_sym.get_name() << ":" << std::endl;
     // note: we don't need to account for parameters passed in registers as these will be located *above* the return address
     // it is the *caller's* responsibility to allocate this data
 
-    // since we will be using the 'call' instruction, we must increase our stack offset by the width of a pointer so that we don't overwrite the return address
-    // we don't need to adjust RSP manually, though, as that was done by the "call" instruction
-    this->max_offset += sin_widths::PTR_WIDTH;
+    if (func_sym.get_calling_convention() == SYSTEM_V) {
+        /*
 
-    // now, compile the procedure using compiler::compile_ast, passing in this function's signature
-    procedure_ss = this->compile_ast(prog, &func_sym);
+        In the System V ABI, the callee sets up its own frame, and it must preserve RBX, RBP, and R12 - R15
+        Once the frame is set up, arguments passed on the stack are above rbp (see function_symbol) and the arguments passed in registers get space below it so that they may be spilled like any other local
+
+        */
+
+        definition_ss << "\t" << "push rbp" << std::endl;
+        definition_ss << "\t" << "push rbx" << std::endl;
+        definition_ss << "\t" << "push r12" << std::endl;
+        definition_ss << "\t" << "push r13" << std::endl;
+        definition_ss << "\t" << "push r14" << std::endl;
+        definition_ss << "\t" << "push r15" << std::endl;
+        definition_ss << "\t" << "mov rbp, rsp" << std::endl;
+
+        if (func_sym.get_data_type().get_primary() == VECTOR) {
+            throw CompilerException(
+                "Vectors may not be returned from functions using the System V calling convention",
+                compiler_errors::UNSUPPORTED_FEATURE,
+                line
+            );
+        }
+
+        for (auto sym: func_sym.get_formal_parameters()) {
+            if (sym->get_data_type().get_primary() == VECTOR) {
+                throw CompilerException(
+                    "Vectors may not be passed to functions using the System V calling convention",
+                    compiler_errors::UNSUPPORTED_FEATURE,
+                    line
+                );
+            }
+            else if (!can_pass_in_register(sym->get_data_type())) {
+                throw CompilerException(
+                    "Aggregates may not be passed by value to functions using the System V calling convention (pass a pointer instead)",
+                    compiler_errors::UNSUPPORTED_FEATURE,
+                    line
+                );
+            }
+            else if (sym->get_register() != NO_REGISTER) {
+                this->max_offset += sym->get_data_type().get_width();
+            }
+        }
+        if (this->max_offset != 0) {
+            definition_ss << "\t" << "sub rsp, " << this->max_offset << std::endl;
+        }
+    }
+    else {
+        // since we will be using the 'call' instruction, we must increase our stack offset by the width of a pointer so that we don't overwrite the return address
+        // we don't need to adjust RSP manually, though, as that was done by the "call" instruction
+        this->max_offset += sin_widths::PTR_WIDTH;
+
+        // vectors passed in registers are stored to their slots on entry, as XMM0 - XMM2 are scratch registers for vector expressions
+        for (auto param: vector_params) {
+            if (param->get_data_type().get_width() == 32 && this->_cpu < X86_64_V3) {
+                throw CompilerException(
+                    "256-bit vectors require AVX2 (use --march=x86-64-v3)",
+                    compiler_errors::UNSUPPORTED_FEATURE,
+                    line
+                );
+            }
+
+            std::string name = register_usage::get_register_name(param->get_register());
+            if (param->get_data_type().get_width() == 32) {
+                name[0] = 'y';
+            }
+            definition_ss << "\t" << (this->_cpu >= X86_64_V3 ? "vmovups" : "movups") << " [rbp + " << -param->get_offset() << "], " << name << std::endl;
+
+            this->reg_stack.peek().clear(param->get_register());
+            param->set_register(NO_REGISTER);
+        }
+
+        // so are small tuples and structs, which are passed one eightbyte per register (see get_eightbytes)
+        for (auto &p: tuple_params) {
+            symbol *param = p.first;
+            std::vector<eightbyte> parts;
+            get_eightbytes(param->get_data_type(), parts, &this->structs);
+            std::vector<reg> regs = func_sym.get_tuple_registers(p.second);
+            std::string address = "[rbp + " + std::to_string(-param->get_offset()) + "]";
+            for (size_t i = 0; i < parts.size(); i++) {
+                definition_ss << move_eightbyte(parts[i], regs[i], address, false);
+                this->reg_stack.peek().clear(regs[i]);
+            }
 
-    // after compiling the AST, we need to restore the registers that our parameter symbols were contained in
-    // otherwise, when the function is called, we won't know what registers to pass arguments in
-    for (auto it = arg_regs.begin(); it != arg_regs.end(); it++) {
-        it->first->set_register(it->second);
+            param->set_register(NO_REGISTER);
+        }
     }
 
+    // now, compile the procedure using compiler::compile_ast, passing in this function's signature
+    procedure_ss = this->compile_ast(prog, &func_sym);
+
     // now, put everything together in definition_ss by adding procedure_ss onto the end
     definition_ss << procedure_ss.str() << std::endl;
 
@@ -275,11 +412,8 @@ std::pair<std::string, size_t> compiler::call_function(const Procedure &to_call,
             call_ss << this->sincall(func_sym, to_pass, line).str(); // todo: return this function's result directly?
 		}
 		else if (func_sym.get_calling_convention() == calling_convention::SYSTEM_V) {
-			throw CompilerException(
-                "System V calling convention (AMD64) currently unsupported",
-                compiler_errors::UNSUPPORTED_ERROR,
-                line
-            );
+            // System V AMD64 ABI
+            call_ss << this->system_v_call(func_sym, to_pass, line).str();
 		}
         else if (func_sym.get_calling_convention() == calling_convention::WIN_64) {
             throw CompilerException(
@@ -362,6 +496,12 @@ std::stringstream compiler::sincall(const function_symbol& s, std::vector<const
             total_offset += s->get_data_type().get_width();
         }
 
+        // a small tuple or struct is returned in registers, so space is set aside above the parameters to store it once the call returns
+        std::vector<eightbyte> returned_parts;
+        if (get_eightbytes(s.get_data_type(), returned_parts, &this->structs)) {
+            total_offset += s.get_data_type().get_width();
+        }
+
         // we only need to subtract from rsp if the adjustment is non-zero
         // do this now so that pushing values to the stack in evaluate_expression() doesn't overwrite parameters
         // and, if we have no parameters, we won't have to do any of this
@@ -369,6 +509,14 @@ std::stringstream compiler::sincall(const function_symbol& s, std::vector<const
             sincall_ss << "\t" << "sub rsp, " << total_offset << std::endl;
         }
         
+        // the stack offsets of references lent to borrowed parameters that the caller must release after the call
+        std::vector<size_t> to_release;
+
+        // vector, tuple, and struct parameters passed in registers
+        std::vector<const symbol*> vector_args;
+        std::vector<size_t> tuple_args;
+        std::string vector_move = this->_cpu >= X86_64_V3 ? "vmovups" : "movups";
+
         // iterate over our arguments, ensure the types match and that we have an appropriate number
         for (size_t i = 0; i < args.size(); i++) {
             // get the argument and its corresponding symbol
@@ -386,6 +534,52 @@ std::stringstream compiler::sincall(const function_symbol& s, std::vector<const
             auto arg_p = this->evaluate_expression(*arg, line, &arg_type);
             sincall_ss << arg_p.first;
 
+            // vectors are written to their slots; those passed in registers are loaded just before the call, as the evaluation of later arguments could clobber them
+            if (param.get_data_type().get_primary() == VECTOR) {
+                size_t param_offset = -param.get_offset() - general_utilities::BASE_PARAMETER_OFFSET;
+                std::string vector_reg = param.get_data_type().get_width() == 32 ? "ymm0" : "xmm0";
+                sincall_ss << "\t" << vector_move << " [rsp + " << param_offset << "], " << vector_reg << std::endl;
+                if (param.get_register() != NO_REGISTER) {
+                    vector_args.push_back(&param);
+                }
+
+                param.set_initialized();
+                continue;
+            }
+
+            // tuples and structs are evaluated to their addresses, and are copied into their slots in the same way
+            Type param_primary = param.get_data_type().get_primary();
+            if ((param_primary == TUPLE || param_primary == STRUCT) && !param.get_data_type().get_qualities().is_dynamic()) {
+                size_t param_offset = -param.get_offset() - general_utilities::BASE_PARAMETER_OFFSET;
+                std::string address = "[rsp + " + std::to_string(param_offset) + "]";
+
+                // small ones are copied with plain moves, through RBX
+                std::vector<eightbyte> parts;
+                if (get_eightbytes(param.get_data_type(), parts, &this->structs)) {
+                    for (auto part: parts) {
+                        part.is_float = false;
+                        sincall_ss << move_eightbyte(part, RBX, "[rax]", true);
+                        sincall_ss << move_eightbyte(part, RBX, address, false);
+                    }
+
+                    if (param.get_register() != NO_REGISTER) {
+                        tuple_args.push_back(i);
+                    }
+                }
+                else {
+                    sincall_ss << "\t" << "lea r15, " << address << std::endl;
+                    sincall_ss << push_used_registers(this->reg_stack.peek(), true).str();
+                    sincall_ss << "\t" << "mov rsi, rax" << std::endl;
+                    sincall_ss << "\t" << "mov rdi, r15" << std::endl;
+                    sincall_ss << "\t" << "mov rcx, " << param.get_data_type().get_width() << std::endl;
+                    sincall_ss << "\t" << "rep movsb" << std::endl;
+                    sincall_ss << pop_used_registers(this->reg_stack.peek(), true).str();
+                }
+
+                param.set_initialized();
+                continue;
+            }
+
             std::string reg_name = get_rax_name_variant(param.get_data_type(), line);
             auto destination_operand = assign_utilities::fetch_destination_operand(
                 param, 
@@ -396,6 +590,26 @@ std::stringstream compiler::sincall(const function_symbol& s, std::vector<const
             );
             bool copy_constructed = true;
 
+            /*
+
+            Borrowed parameters refer to the caller's object rather than a copy, and the callee doesn't free them (see opt/rc_elimination.h).
+            Locals, literals, and temporaries can be lent directly, as the callee has no other way to modify them; anything else (e.g., global data) is still copied.
+            Temporaries and copies must then be released by the caller once the call returns.
+
+            */
+
+            bool borrowed = param.get_data_type().get_qualities().is_borrowed() && param.get_data_type().get_primary() == STRING;
+            bool lent = false;
+            if (borrowed) {
+                if (arg_p.second || arg->get_expression_type() == LITERAL) {
+                    lent = true;
+                }
+                else if (arg->get_expression_type() == IDENTIFIER) {
+                    symbol *arg_sym = this->lookup(static_cast<const Identifier*>(arg)->getValue(), line);
+                    lent = !arg_sym->get_data_type().get_qualities().is_static() && arg_sym->get_scope_name() != "global";
+                }
+            }
+
             // get the offset (rsp+) for this parameter
             // note if we have to adjust the RC, the position will be one quadword *above* RSP because we push first, then do lea
             size_t param_offset = -param.get_offset() - general_utilities::BASE_PARAMETER_OFFSET;
@@ -414,8 +628,28 @@ std::stringstream compiler::sincall(const function_symbol& s, std::vector<const
                 }
             }
 
+            /*
+
+            A new string, or a local one on its last use (see compile_util/move_util.h), is handed to the callee rather than copied.
+            Only concatenations are known to build a new buffer; other temporaries, such as those returned by calls, may share theirs (e.g., with a global), so they are still copied.
+
+            */
+            bool moved = false;
+            if (!lent && this->_opt_level > 0 && param.get_data_type().get_primary() == STRING) {
+                if (arg_p.second) {
+                    moved = arg->get_expression_type() == BINARY && static_cast<const Binary*>(arg)->get_operator() == PLUS;
+                }
+                else if (arg->get_expression_type() == IDENTIFIER && this->last_uses.count(arg)) {
+                    moved = true;
+                    this->lookup(static_cast<const Identifier*>(arg)->getValue(), line)->free();
+                }
+            }
+
             // if we had a dynamic or string type, we have to construct it regardless (pass by value)
-            if (param.get_data_type().get_primary() == STRING) {
+            if (lent || moved) {
+                copy_constructed = false;
+            }
+            else if (param.get_data_type().get_primary() == STRING) {
                 // to construct a string, we load the address where the parameter wil be stored into rdi
                 sincall_ss << "\t" << "lea rdi, [rsp + " << param_offset << "]" << std::endl;
                 sincall_ss << push_used_registers(this->reg_stack.peek(), true).str();
@@ -431,7 +665,12 @@ std::stringstream compiler::sincall(const function_symbol& s, std::vector<const
             }
 
             // if we needed to adjust the RC
-            if (arg_p.second) {
+            if (arg_p.second && (lent || moved)) {
+                // the temporary is the string being lent or moved (still in RAX); a lent one is released after the call
+                sincall_ss << "\t" << "add rsp, " << sin_widths::PTR_WIDTH << std::endl;
+                param_offset -= sin_widths::PTR_WIDTH;
+            }
+            else if (arg_p.second) {
                 sincall_ss << "\t" << "pop rdi" << std::endl;   // free the original string to free
                 sincall_ss << function_util::call_sre_function(magic_numbers::SRE_FREE);
                 // now we need to move the parameter position back because we popped the value
@@ -456,14 +695,90 @@ std::stringstream compiler::sincall(const function_symbol& s, std::vector<const
                 sincall_ss << "\t" << "mov " << register_usage::get_register_name(param.get_register(), param.get_data_type()) << ", " << reg_name << std::endl;
             }
 
+            // the slot for a borrowed parameter holds the reference the caller must release, whether or not it is passed in a register
+            if (borrowed && (copy_constructed || arg_p.second)) {
+                if (!copy_constructed && param.get_register() != NO_REGISTER) {
+                    sincall_ss << "\t" << "mov [rsp + " << param_offset << "], rax" << std::endl;
+                }
+                to_release.push_back(param_offset);
+            }
+
             param.set_initialized();
         }
         // todo: default values
 
+        // load the vectors passed in registers
+        for (auto param: vector_args) {
+            std::string vector_reg = register_usage::get_register_name(param->get_register());
+            if (param->get_data_type().get_width() == 32) {
+                vector_reg[0] = 'y';
+            }
+
+            size_t param_offset = -param->get_offset() - general_utilities::BASE_PARAMETER_OFFSET;
+            sincall_ss << "\t" << vector_move << " " << vector_reg << ", [rsp + " << param_offset << "]" << std::endl;
+            this->reg_stack.peek().set(param->get_register());
+        }
+
+        // and the tuples and structs
+        for (auto i: tuple_args) {
+            const symbol *param = formal_parameters[i].get();
+            std::vector<eightbyte> parts;
+            get_eightbytes(param->get_data_type(), parts, &this->structs);
+            std::vector<reg> regs = s.get_tuple_registers(i);
+
+            size_t param_offset = -param->get_offset() - general_utilities::BASE_PARAMETER_OFFSET;
+            std::string address = "[rsp + " + std::to_string(param_offset) + "]";
+            for (size_t j = 0; j < parts.size(); j++) {
+                sincall_ss << move_eightbyte(parts[j], regs[j], address, true);
+                this->reg_stack.peek().set(regs[j]);
+            }
+        }
+
         // call the function
-        sincall_ss << function_util::call_sincall_subroutine(s.get_name());
+        // if it is a SIN function defined in this file, we know how it returns and can use the lighter call sequence
+        bool internal = s.is_defined() && !s.get_data_type().get_qualities().is_extern();
+        sincall_ss << function_util::call_sincall_subroutine(s.get_name(), internal);
 
         // the return value is now in RAX or XMM0, depending on the data type
+        // a small tuple or struct is stored in the space above the parameters instead, and its address is returned in RAX like that of any other
+        if (!returned_parts.empty()) {
+            size_t return_offset = total_offset - s.get_data_type().get_width();
+            std::string address = "[rsp + " + std::to_string(return_offset) + "]";
+            std::vector<reg> regs = get_return_registers(returned_parts);
+            for (size_t i = 0; i < returned_parts.size(); i++) {
+                sincall_ss << move_eightbyte(returned_parts[i], regs[i], address, false);
+            }
+            sincall_ss << "\t" << "lea rax, " << address << std::endl;
+        }
+
+        // release anything we created to lend to the callee, preserving the return value
+        if (!to_release.empty()) {
+            bool float_return = s.get_data_type().get_primary() == FLOAT;
+            size_t vector_width = s.get_data_type().get_primary() == VECTOR ? s.get_data_type().get_width() : 0;
+            if (vector_width) {
+                // vectors are kept on the stack instead
+                std::string vector_reg = vector_width == 32 ? "ymm0" : "xmm0";
+                sincall_ss << "\t" << "sub rsp, " << vector_width << std::endl;
+                sincall_ss << "\t" << vector_move << " [rsp], " << vector_reg << std::endl;
+            }
+            else {
+                sincall_ss << "\t" << (float_return ? "movq r13, xmm0" : "mov r13, rax") << std::endl;
+            }
+
+            for (auto offset: to_release) {
+                sincall_ss << "\t" << "mov rdi, [rsp + " << offset + vector_width << "]" << std::endl;
+                sincall_ss << function_util::call_sre_function(magic_numbers::SRE_FREE);
+            }
+
+            if (vector_width) {
+                std::string vector_reg = vector_width == 32 ? "ymm0" : "xmm0";
+                sincall_ss << "\t" << vector_move << " " << vector_reg << ", [rsp]" << std::endl;
+                sincall_ss << "\t" << "add rsp, " << vector_width << std::endl;
+            }
+            else {
+                sincall_ss << "\t" << (float_return ? "movq xmm0, r13" : "mov rax, r13") << std::endl;
+            }
+        }
 
         // if we had to adjust rsp, move it back
         if (total_offset != 0) {
@@ -486,16 +801,168 @@ std::stringstream compiler::sincall(const function_symbol& s, std::vector<const
     return sincall_ss;
 }
 
-std::stringstream compiler::system_v_call(const function_symbol& s, std::vector<Expression*> args, unsigned int line)
+std::stringstream compiler::system_v_call(const function_symbol& s, std::vector<const Expression*> args, unsigned int line)
 {
+    /*
+
+    system_v_call
+    Generates a call to a function using the System V AMD64 ABI
+
+    Every argument is evaluated (left to right) and pushed to the stack before any are passed, as the evaluation of one argument may otherwise clobber the registers of another. Once all are evaluated:
+        - the stack is aligned on a 16-byte boundary (accounting for arguments passed in memory)
+        - arguments passed in memory are pushed right to left, each in its own eightbyte
+        - arguments passed in registers are loaded (the registers were determined by the function symbol)
+        - AL is set to the number of vector registers used, as is required for variadic functions
+    R12 holds the location of the evaluated arguments over the call, as it is preserved by the callee.
+    Any temporary references used for arguments are freed after the call returns.
+
+    @param  s   The symbol for the function
+    @param  args    The function's arguments
+    @param  line    The line number where the call occurs
+    @return A stringstream containing the generated code
+    @throws Throws an exception if the function signature does not match the arguments supplied
+
+    */
+
     std::stringstream system_v_call_ss;
 
-    // todo: System V ABI call
+    // preserve our registers -- in this convention, only RBX, RBP, and R12 - R15 are preserved by the callee
+    bool pushed = false;
+    if (!this->reg_stack.empty()) {
+        pushed = true;
+        system_v_call_ss << push_used_registers(this->reg_stack.peek(), true).str();
+    }
+
+    auto &formal_parameters = s.get_formal_parameters();
+    if (args.size() != formal_parameters.size()) {
+        throw FunctionSignatureException(line);
+    }
+
+    // evaluate each argument, pushing the values (and the temporary references we need to free afterwards) in turn
+    std::vector<bool> slot_is_temporary;
+    std::vector<size_t> argument_slots;
+    bool has_temporaries = false;
+    for (size_t i = 0; i < args.size(); i++) {
+        const Expression *arg = args.at(i);
+        symbol &param = *formal_parameters[i];
+
+        DataType arg_type = expression_util::get_expression_data_type(*arg, this->symbols, this->structs, line);
+        if (!arg_type.is_compatible(param.get_data_type())) {
+            throw FunctionSignatureException(line);
+        }
+        else if (param.get_data_type().get_primary() == VECTOR) {
+            throw CompilerException(
+                "Vectors may not be passed to functions using the System V calling convention",
+                compiler_errors::UNSUPPORTED_FEATURE,
+                line
+            );
+        }
+        else if (!can_pass_in_register(param.get_data_type())) {
+            throw CompilerException(
+                "Aggregates may not be passed by value to functions using the System V calling convention (pass a pointer instead)",
+                compiler_errors::UNSUPPORTED_FEATURE,
+                line
+            );
+        }
+
+        auto arg_p = this->evaluate_expression(*arg, line, &arg_type);
+        system_v_call_ss << arg_p.first;
+        if (arg_p.second) {
+            slot_is_temporary.push_back(true);
+            has_temporaries = true;
+        }
+
+        if (param.get_data_type().get_primary() == FLOAT) {
+            system_v_call_ss << "\t" << "movq rax, xmm0" << std::endl;
+        }
+        else if (param.get_data_type().get_primary() == STRING || param.get_data_type().get_primary() == ARRAY) {
+            // C expects the address of the first element, not of the length doubleword
+            system_v_call_ss << "\t" << "add rax, " << sin_widths::INT_WIDTH << std::endl;
+        }
+        else if (param.get_data_type().get_width() < sin_widths::INT_WIDTH) {
+            // the ABI expects narrow integers to be extended to 32 bits by the caller
+            std::string ext = param.get_data_type().get_qualities().is_signed() ? "movsx" : "movzx";
+            system_v_call_ss << "\t" << ext << " eax, " << get_rax_name_variant(param.get_data_type(), line) << std::endl;
+        }
+        system_v_call_ss << "\t" << "push rax" << std::endl;
+
+        argument_slots.push_back(slot_is_temporary.size());
+        slot_is_temporary.push_back(false);
+    }
+
+    // the location of each evaluated argument relative to R12
+    size_t slot_count = slot_is_temporary.size();
+    auto slot_location = [slot_count](size_t slot) {
+        return std::to_string((slot_count - 1 - slot) * sin_widths::PTR_WIDTH);
+    };
+
+    size_t memory_arguments = 0;
+    for (auto param: formal_parameters) {
+        if (param->get_register() == NO_REGISTER) {
+            memory_arguments += 1;
+        }
+    }
+
+    // align the stack so that it is on a 16-byte boundary once the memory arguments have been pushed
+    system_v_call_ss << "\t" << "mov r12, rsp" << std::endl;
+    system_v_call_ss << "\t" << "and rsp, -0x10" << std::endl;
+    if (memory_arguments % 2) {
+        system_v_call_ss << "\t" << "sub rsp, 8" << std::endl;
+    }
+
+    // push the memory arguments from right to left
+    for (size_t i = formal_parameters.size(); i > 0; i--) {
+        if (formal_parameters[i - 1]->get_register() == NO_REGISTER) {
+            system_v_call_ss << "\t" << "push qword [r12 + " << slot_location(argument_slots[i - 1]) << "]" << std::endl;
+        }
+    }
+
+    // load the register arguments
+    size_t vector_registers = 0;
+    for (size_t i = 0; i < formal_parameters.size(); i++) {
+        symbol &param = *formal_parameters[i];
+        if (param.get_register() == NO_REGISTER) {
+            continue;
+        }
+
+        std::string location = "[r12 + " + slot_location(argument_slots[i]) + "]";
+        if (param.get_data_type().get_primary() == FLOAT) {
+            std::string inst = (param.get_data_type().get_width() == sin_widths::DOUBLE_WIDTH) ? "movsd" : "movss";
+            system_v_call_ss << "\t" << inst << " " << register_usage::get_register_name(param.get_register()) << ", " << location << std::endl;
+            vector_registers += 1;
+        }
+        else {
+            system_v_call_ss << "\t" << "mov " << register_usage::get_register_name(param.get_register()) << ", " << location << std::endl;
+        }
+    }
+
+    system_v_call_ss << "\t" << "mov eax, " << vector_registers << std::endl;
+    system_v_call_ss << "\t" << "call " << s.get_name() << std::endl;
+    system_v_call_ss << "\t" << "mov rsp, r12" << std::endl;
+
+    // free any temporary references, preserving the return value
+    if (has_temporaries) {
+        bool returns_float = s.get_data_type().get_primary() == FLOAT;
+        system_v_call_ss << "\t" << (returns_float ? "movq r13, xmm0" : "mov r13, rax") << std::endl;
+        for (size_t i = 0; i < slot_count; i++) {
+            if (slot_is_temporary[i]) {
+                system_v_call_ss << "\t" << "mov rdi, [rsp + " << slot_location(i) << "]" << std::endl;
+                system_v_call_ss << function_util::call_sre_function(magic_numbers::SRE_FREE);
+            }
+        }
+        system_v_call_ss << "\t" << (returns_float ? "movq xmm0, r13" : "mov rax, r13") << std::endl;
+    }
+
+    system_v_call_ss << "\t" << "add rsp, " << slot_count * sin_widths::PTR_WIDTH << std::endl;
+
+    if (pushed) {
+        system_v_call_ss << pop_used_registers(this->reg_stack.peek(), true).str();
+    }
 
     return system_v_call_ss;
 }
 
-std::stringstream compiler::win64_call(const function_symbol& s, std::vector<Expression*> args, unsigned int line)
+std::stringstream compiler::win64_call(const function_symbol& s, std::vector<const Expression*> args, unsigned int line)
 {
     std::stringstream win64_call_ss;
 
@@ -542,32 +1009,188 @@ std::stringstream compiler::handle_return(const ReturnStatement &ret, function_s
 
         // types are compatible; how the value gets returned (and how the callee gets cleaned up) depends on the function's calling convention
         if (signature.get_calling_convention() == SINCALL) {
-            ret_ss << this->sincall_return(ret, return_type).str() << std::endl;
+            // 'return @f(...)' may be able to hand this frame to 'f' rather than calling it
+            const function_symbol *callee = (this->_opt_level > 0) ? this->get_tail_callee(ret, signature) : nullptr;
+            if (callee) {
+                auto &call = static_cast<const Procedure&>(ret.get_return_exp());
+                std::string callee_name = static_cast<const Identifier&>(call.get_func_name()).getValue();
+                if (callee->get_name() == signature.get_name()) {
+                    compiler_note("Self-recursive tail call to '" + callee_name + "' was turned into a loop", ret.get_line_number());
+                }
+                else {
+                    compiler_note("Tail call to '" + callee_name + "' reuses the caller's frame", ret.get_line_number());
+                }
+                ret_ss << this->sincall_tail_call(call, *callee, ret.get_line_number()).str() << std::endl;
+            }
+            else {
+                std::vector<eightbyte> parts;
+                if (get_eightbytes(signature.get_data_type(), parts, &this->structs)) {
+                    ret_ss << this->sincall_return_tuple(ret, signature.get_data_type()).str() << std::endl;
+                }
+                else {
+                    ret_ss << this->sincall_return(ret, return_type).str() << std::endl;
+                }
+
+                ret_ss << "\t" << "mov rsp, rbp" << std::endl;
+                
+                // adjust the offset by one pointer width, as rsp needs to be where it was when we pushed the function return value
+                ret_ss << "\t" << "sub rsp, " << sin_widths::PTR_WIDTH << std::endl;
+                
+                // now that the calling convention's return responsibilities have been dealt with, we can return
+                ret_ss << "\t" << "ret" << std::endl;
+            }
+            this->max_offset -= 8;
         }
-        /*else if (signature.get_calling_convention() == SYSTEM_V) {
-            // todo: System V
+        else if (signature.get_calling_convention() == SYSTEM_V) {
+            ret_ss << this->system_v_return(ret, return_type).str() << std::endl;
         }
-        else if (signature.get_calling_convention() == WIN_64) {
+        /*else if (signature.get_calling_convention() == WIN_64) {
             // todo: Windows 64
         }*/
         else {
-            throw CompilerException("Calling conventions other than sincall are currently not supported", 0, ret.get_line_number());
+            throw CompilerException("Calling conventions other than sincall and System V are currently not supported", 0, ret.get_line_number());
         }
     } else {
         throw ReturnMismatchException(ret.get_line_number());
     }
 
-    ret_ss << "\t" << "mov rsp, rbp" << std::endl;
-    
-    // adjust the offset by one pointer width, as rsp needs to be where it was when we pushed the function return value
-    ret_ss << "\t" << "sub rsp, " << sin_widths::PTR_WIDTH << std::endl;
-    
-    // now that the calling convention's return responsibilities have been dealt with, we can return
-    ret_ss << "\t" << "ret" << std::endl;
-    this->max_offset -= 8;
     return ret_ss;
 }
 
+const function_symbol *compiler::get_tail_callee(const ReturnStatement &ret, const function_symbol &signature) {
+    /*
+
+    get_tail_callee
+    Determines whether a return statement is a tail call that may reuse the frame of the function containing it
+
+    A SINCALL function's frame (and the space for its parameters) is set up and torn down by its caller, so a call in tail position may reuse it if:
+        - the callee is a SINCALL function defined in this file (and isn't a method);
+        - its parameters and return value are integers, booleans, or characters that don't need to be freed or copy-constructed;
+        - its parameters fit within the space set aside for the caller's; and
+        - the caller has nothing left to free -- any pending decrements would have to happen after the call returns, so the call isn't really in tail position
+
+    @param  ret The return statement
+    @param  signature   The function containing the statement
+    @return The function that is called, or nullptr if the frame can't be reused
+
+    */
+
+    const Expression &returned = ret.get_return_exp();
+    if (returned.get_expression_type() != CALL_EXP) {
+        return nullptr;
+    }
+
+    auto &call = static_cast<const Procedure&>(returned);
+    if (call.get_func_name().get_expression_type() != IDENTIFIER) {
+        return nullptr;
+    }
+
+    if (!this->symbols.get_symbols_to_free(this->current_scope_name, this->current_scope_level, true).empty()) {
+        return nullptr;
+    }
+
+    symbol &sym = expression_util::get_function_symbol(call.get_func_name(), this->structs, this->symbols, ret.get_line_number());
+    if (sym.get_symbol_type() != FUNCTION_SYMBOL) {
+        return nullptr;
+    }
+
+    auto &callee = static_cast<const function_symbol&>(sym);
+    if (
+        callee.get_calling_convention() != SINCALL ||
+        callee.requires_this() ||
+        !callee.is_defined() ||
+        callee.get_data_type().get_qualities().is_extern()
+    ) {
+        return nullptr;
+    }
+
+    auto is_plain = [](const DataType &t) {
+        Type p = t.get_primary();
+        return (p == INT || p == BOOL || p == CHAR) && !t.must_free() && !t.get_qualities().is_dynamic() && !t.get_qualities().is_static();
+    };
+
+    if (!is_plain(callee.get_data_type()) || !callee.get_data_type().is_compatible(signature.get_data_type())) {
+        return nullptr;
+    }
+
+    auto &params = callee.get_formal_parameters();
+    auto args = call.get_args().get_list();
+    if (args.size() != params.size()) {
+        return nullptr;
+    }
+
+    size_t callee_width = 0;
+    for (size_t i = 0; i < params.size(); i++) {
+        DataType arg_type = expression_util::get_expression_data_type(*args[i], this->symbols, this->structs, ret.get_line_number());
+        if (!is_plain(params[i]->get_data_type()) || !arg_type.is_compatible(params[i]->get_data_type())) {
+            return nullptr;
+        }
+        callee_width += params[i]->get_data_type().get_width();
+    }
+
+    size_t caller_width = 0;
+    for (auto p: signature.get_formal_parameters()) {
+        caller_width += p->get_data_type().get_width();
+    }
+
+    return (callee_width <= caller_width) ? &callee : nullptr;
+}
+
+std::stringstream compiler::sincall_tail_call(const Procedure &call, const function_symbol &callee, unsigned int line) {
+    /*
+
+    sincall_tail_call
+    Generates a tail call that reuses the current frame
+
+    Instead of setting up a new frame, the arguments are written to where the callee expects its parameters -- its argument registers, or the parameter space above RBP -- and the stack pointer is reset to the return address before jumping to the callee, which then returns directly to our caller.
+    Arguments may refer to the parameters they replace, so all of them are evaluated (and saved on the stack) before any are written.
+    A self-recursive tail call becomes a jump back to the top of the function -- i.e., a loop.
+
+    See get_tail_callee for the conditions under which this may be used
+
+    */
+
+    std::stringstream tail_ss;
+
+    auto &params = callee.get_formal_parameters();
+    auto args = call.get_args().get_list();
+
+    for (auto arg: args) {
+        DataType arg_type = expression_util::get_expression_data_type(*arg, this->symbols, this->structs, line);
+        tail_ss << this->evaluate_expression(*arg, line, &arg_type).first;
+        tail_ss << "\t" << "push rax" << std::endl;
+    }
+
+    // the symbol's current register may differ from where it is passed, so use the registers assigned in the signature
+    // only integral parameters are eligible, so only the integer argument registers need to be checked
+    const reg integer_registers[] = { RSI, RDI, RCX, RDX, R8, R9 };
+    register_usage entry_regs = callee.get_arg_regs();
+    for (size_t i = args.size(); i > 0; i--) {
+        symbol &param = *params[i - 1];
+        reg r = NO_REGISTER;
+        for (auto candidate: integer_registers) {
+            if (entry_regs.get_contained_symbol(candidate) == &param) {
+                r = candidate;
+            }
+        }
+
+        std::string reg_name = get_rax_name_variant(param.get_data_type(), line);
+        tail_ss << "\t" << "pop rax" << std::endl;
+        if (r == NO_REGISTER) {
+            tail_ss << "\t" << "mov [rbp + " << -param.get_offset() << "], " << reg_name << std::endl;
+        }
+        else {
+            tail_ss << "\t" << "mov " << register_usage::get_register_name(r, param.get_data_type()) << ", " << reg_name << std::endl;
+        }
+    }
+
+    tail_ss << "\t" << "mov rsp, rbp" << std::endl;
+    tail_ss << "\t" << "sub rsp, " << sin_widths::PTR_WIDTH << std::endl;
+    tail_ss << "\t" << "jmp " << callee.get_name() << std::endl;
+
+    return tail_ss;
+}
+
 std::stringstream compiler::sincall_return(const ReturnStatement &ret, DataType return_type) {
     /*
 
@@ -583,6 +1206,25 @@ std::stringstream compiler::sincall_return(const ReturnStatement &ret, DataType
 
 	std::stringstream sincall_ss;
 
+    // vectors are returned in XMM0 (or YMM0); keep them on the stack while everything is freed
+    if (return_type.get_primary() == VECTOR) {
+        bool wide = return_type.get_width() == 32;
+        std::string vector_reg = wide ? "ymm0" : "xmm0";
+        std::string vector_move = wide ? "vmovups" : "movups";
+
+        sincall_ss << this->evaluate_vector_expression(ret.get_return_exp(), return_type, ret.get_line_number());
+        std::string free_code = decrement_rc(this->reg_stack.peek(), this->symbols, this->structs, this->current_scope_name, this->current_scope_level, true);
+        if (!free_code.empty()) {
+            sincall_ss << "\t" << "sub rsp, " << return_type.get_width() << std::endl;
+            sincall_ss << "\t" << vector_move << " [rsp], " << vector_reg << std::endl;
+            sincall_ss << free_code;
+            sincall_ss << "\t" << vector_move << " " << vector_reg << ", [rsp]" << std::endl;
+            sincall_ss << "\t" << "add rsp, " << return_type.get_width() << std::endl;
+        }
+
+        return sincall_ss;
+    }
+
     auto ret_p = this->evaluate_expression(ret.get_return_exp(), ret.get_line_number());
 
 	sincall_ss << ret_p.first;
@@ -596,14 +1238,37 @@ std::stringstream compiler::sincall_return(const ReturnStatement &ret, DataType
         this->structs,
         ret.get_line_number()
     );
-    if (t.is_reference_type() || t.get_primary() == PTR) {
+    // if we are returning a local that would be freed here, the increment and decrement cancel out; its reference is simply handed to the caller
+    // this only applies to types evaluated to the reference itself (dynamic primitives are evaluated to their values)
+    std::string transferred = "";
+    if (
+        this->_opt_level > 0 &&
+        ret.get_return_exp().get_expression_type() == IDENTIFIER &&
+        (
+            t.get_primary() == STRING ||
+            t.get_primary() == PTR ||
+            (t.get_qualities().is_dynamic() && (t.get_primary() == ARRAY || t.get_primary() == STRUCT || t.get_primary() == TUPLE))
+        )
+    ) {
+        auto &id = static_cast<const Identifier&>(ret.get_return_exp());
+        symbol *returned = this->lookup(id.getValue(), ret.get_line_number());
+        for (auto &s: this->symbols.get_symbols_to_free(this->current_scope_name, this->current_scope_level, true)) {
+            if (s.get_name() == returned->get_name()) {
+                transferred = s.get_name();
+            }
+        }
+    }
+
+    // likewise, a temporary (e.g., the result of a concatenation) already holds a reference that nothing else will release
+    bool temporary = this->_opt_level > 0 && ret_p.second > 0;
+    if ((t.is_reference_type() || t.get_primary() == PTR) && transferred.empty() && !temporary) {
         sincall_ss << "\t" << "mov rdi, rax" << std::endl;
         sincall_ss << function_util::call_sre_function(magic_numbers::SRE_ADD_REF);
     }
 
     // decrement the rc of all pointers, references, and dynamic memory
     try {
-        sincall_ss << decrement_rc(this->reg_stack.peek(), this->symbols, this->structs, this->current_scope_name, this->current_scope_level, true);
+        sincall_ss << decrement_rc(this->reg_stack.peek(), this->symbols, this->structs, this->current_scope_name, this->current_scope_level, true, transferred);
     }
     catch (CompilerException &e) {
         e.set_line(ret.get_line_number());  // it would be unusual for this to get caught, but to be safe...
@@ -614,3 +1279,77 @@ std::stringstream compiler::sincall_return(const ReturnStatement &ret, DataType
 
     return sincall_ss;
 }
+
+std::stringstream compiler::sincall_return_tuple(const ReturnStatement &ret, const DataType &return_type) {
+    /*
+
+    sincall_return_tuple
+    Handles a return statement for a SINCALL function that returns a small tuple or struct
+
+    Tuples and structs no wider than 16 bytes whose members are all primitives are returned in registers rather than by address: each eightbyte (see get_eightbytes) is returned in RAX and then RDX if it holds integers, or XMM0 and then XMM1 if it holds only floats. The caller stores them into space it sets aside above the parameters (see compiler::sincall).
+    The value is loaded before anything is freed, as it may lie below the stack pointer (e.g., if it was returned by another call); the registers are kept on the stack while the frees happen.
+
+    */
+
+    std::stringstream sincall_ss;
+
+    std::vector<eightbyte> parts;
+    get_eightbytes(return_type, parts, &this->structs);
+    std::vector<reg> regs = get_return_registers(parts);
+
+    auto ret_p = this->evaluate_expression(ret.get_return_exp(), ret.get_line_number(), &return_type);
+    sincall_ss << ret_p.first;
+
+    // RAX holds the tuple's address, so it is loaded last
+    for (size_t i = 0; i < parts.size(); i++) {
+        if (regs[i] != RAX) {
+            sincall_ss << move_eightbyte(parts[i], regs[i], "[rax]", true);
+        }
+    }
+    for (size_t i = 0; i < parts.size(); i++) {
+        if (regs[i] == RAX) {
+            sincall_ss << move_eightbyte(parts[i], regs[i], "[rax]", true);
+        }
+    }
+
+    std::string free_code = decrement_rc(this->reg_stack.peek(), this->symbols, this->structs, this->current_scope_name, this->current_scope_level, true);
+    if (!free_code.empty()) {
+        sincall_ss << "\t" << "sub rsp, 16" << std::endl;
+        for (size_t i = 0; i < parts.size(); i++) {
+            sincall_ss << move_eightbyte(parts[i], regs[i], "[rsp]", false);
+        }
+        sincall_ss << free_code;
+        for (size_t i = 0; i < parts.size(); i++) {
+            sincall_ss << move_eightbyte(parts[i], regs[i], "[rsp]", true);
+        }
+        sincall_ss << "\t" << "add rsp, 16" << std::endl;
+    }
+
+    return sincall_ss;
+}
+
+std::stringstream compiler::system_v_return(const ReturnStatement &ret, DataType return_type) {
+    /*
+
+    system_v_return
+    Handles a return statement for a function using the System V calling convention
+
+    The returned value is handled exactly as it is in SINCALL (in RAX or XMM0); the difference is that the callee must tear down its own frame and restore the registers the ABI requires it to preserve
+
+    */
+
+    std::stringstream system_v_ss;
+
+    system_v_ss << this->sincall_return(ret, return_type).str();
+
+    system_v_ss << "\t" << "mov rsp, rbp" << std::endl;
+    system_v_ss << "\t" << "pop r15" << std::endl;
+    system_v_ss << "\t" << "pop r14" << std::endl;
+    system_v_ss << "\t" << "pop r13" << std::endl;
+    system_v_ss << "\t" << "pop r12" << std::endl;
+    system_v_ss << "\t" << "pop rbx" << std::endl;
+    system_v_ss << "\t" << "pop rbp" << std::endl;
+    system_v_ss << "\t" << "ret" << std::endl;
+
+    return system_v_ss;
+}
@@ -11,6 +11,7 @@ Note that SIN does *not* support the arrow operator as syntactic sugar; you must
 
 #include "compiler.h"
 #include "compile_util/function_util.h"
+#include "compile_util/division_util.h"
 
 std::stringstream compiler::evaluate_unary(const Unary &to_evaluate, unsigned int line, const DataType *type_hint) {
 	/*
@@ -32,6 +33,16 @@ std::stringstream compiler::evaluate_unary(const Unary &to_evaluate, unsigned in
 	// We need to know the data type in order to evaluate the expression properly
 	DataType unary_type = expression_util::get_expression_data_type(to_evaluate.get_operand(), this->symbols, this->structs, line);
 
+	// vector operations (and dereferenced vectors) are computed in XMM0
+	if (
+		(unary_type.get_primary() == VECTOR && to_evaluate.get_operator() != ADDRESS) ||
+		(to_evaluate.get_operator() == DEREFERENCE && unary_type.get_primary() == PTR && unary_type.get_subtype().get_primary() == VECTOR)
+	) {
+		DataType vector_type = unary_type.get_primary() == VECTOR ? unary_type : unary_type.get_subtype();
+		eval_ss << this->evaluate_vector_expression(to_evaluate, vector_type, line);
+		return eval_ss;
+	}
+
 	// first, evaluate the expression we are modifying *unless* it is an ADDRESS operation
 	if (to_evaluate.get_operator() != ADDRESS) {
 		auto addr_p = this->evaluate_expression(to_evaluate.get_operand(), line, type_hint);
@@ -105,10 +116,9 @@ std::stringstream compiler::evaluate_unary(const Unary &to_evaluate, unsigned in
 		// expression must be a boolean
 
 		if (unary_type.get_primary() == BOOL) {
-			// XOR against a bitmask of 0xFF, as a boolean checks for zero or non-zero, not necessarily 1 or 0
-			// a boolean will be in al
-			eval_ss << "\t" << "mov ah, 0xFF" << std::endl;
-			eval_ss << "\t" << "xor al, ah" << std::endl;
+			// a boolean will be in al; any non-zero value is true, so compare against zero rather than flipping bits
+			eval_ss << "\t" << "cmp al, 0" << std::endl;
+			eval_ss << "\t" << "sete al" << std::endl;
 		}
 		else {
 			throw UnaryTypeNotSupportedError(line);
@@ -158,6 +168,396 @@ std::stringstream compiler::evaluate_unary(const Unary &to_evaluate, unsigned in
 	return eval_ss;
 }
 
+void compiler::check_binary_operands(const DataType &left_type, const DataType &right_type, unsigned int line) {
+	/*
+
+	check_binary_operands
+	Issues warnings about the operand types of a binary expression (precision, signedness, and width mismatches)
+
+	@param	left_type	The type of the left operand
+	@param	right_type	The type of the right operand
+	@param	line	The line number where the expression occurs
+
+	*/
+
+	// check for half-precision type once here instead of repeating this call multiple times in source later
+	if (left_type.get_primary() == FLOAT) {
+		if (
+			(left_type.get_width() == sin_widths::HALF_WIDTH) ||
+			(right_type.get_primary() == FLOAT && right_type.get_width() == sin_widths::HALF_WIDTH)
+		) {
+			half_precision_not_supported_warning(line);
+		}
+	}
+
+	// issue a warning for signed/unsigned mismatch if applicable
+	if (
+		(left_type.get_primary() == INT) &&
+		(left_type.get_qualities().is_signed() != right_type.get_qualities().is_signed())
+	) {
+		this->_warn("Signed/unsigned mismatch", compiler_errors::SIGNED_UNSIGNED_MISMATCH, line);
+	}
+	
+	// todo: generalize check for width mismatch warning
+	// also issue a warning if the types are different widths
+	if (
+		(left_type.get_width() != right_type.get_width()) &&
+		!(left_type.get_primary() == STRING && right_type.get_primary() == CHAR)
+	) {
+		this->_warn(
+			"Width mismatch (left type is " +
+				std::to_string(left_type.get_width()) +
+				" bytes wide, right type is " + 
+				std::to_string(right_type.get_width()) + ")",
+			compiler_errors::WIDTH_MISMATCH,
+			line
+		);
+	}
+}
+
+std::stringstream compiler::evaluate_logical(const Binary &to_evaluate, unsigned int line) {
+	/*
+
+	evaluate_logical
+	Generates short-circuit code for the logical 'and' and 'or' operators
+
+	The left operand is always evaluated first. If it already decides the result (false for 'and', true for 'or'), the right operand is skipped entirely -- its side effects included -- and the left operand's value in AL is the result.
+	When used as a condition in a control flow statement, these operators are lowered by evaluate_condition instead.
+
+	@param	to_evaluate	The logical expression
+	@param	line	The line number where the expression occurs
+	@return	A stringstream containing the generated code
+
+	*/
+
+	std::stringstream eval_ss;
+	bool is_and = to_evaluate.get_operator() == AND;
+
+	DataType left_type = expression_util::get_expression_data_type(to_evaluate.get_left(), this->symbols, this->structs, line);
+	DataType right_type = expression_util::get_expression_data_type(to_evaluate.get_right(), this->symbols, this->structs, line, &left_type);
+	if (!left_type.is_compatible(right_type)) {
+		throw TypeException(line);
+	}
+	else if (left_type.get_primary() != BOOL) {
+		throw UndefinedOperatorError(is_and ? "logical-and" : "logical-or", line);
+	}
+
+	std::string skip_label = magic_numbers::CONDITION_SKIP_LABEL + std::to_string(this->condition_num);
+	this->condition_num += 1;
+
+	// evaluate the left-hand side; if it decides the result, skip the right-hand side
+	auto lhs_pair = this->evaluate_expression(to_evaluate.get_left(), line);
+	eval_ss << lhs_pair.first;
+	if (lhs_pair.second) {
+		eval_ss << release_temporary(this->reg_stack.peek(), left_type);
+	}
+	eval_ss << "\t" << "test al, al" << std::endl;
+	eval_ss << "\t" << (is_and ? "jz " : "jnz ") << skip_label << std::endl;
+
+	// otherwise, the result is that of the right-hand side
+	auto rhs_pair = this->evaluate_expression(to_evaluate.get_right(), line);
+	eval_ss << rhs_pair.first;
+	if (rhs_pair.second) {
+		eval_ss << release_temporary(this->reg_stack.peek(), right_type);
+	}
+	eval_ss << skip_label << ":" << std::endl;
+
+	return eval_ss;
+}
+
+std::string compiler::evaluate_fp_contraction(const Binary &to_evaluate, unsigned int line) {
+	/*
+
+	evaluate_fp_contraction
+	Generates code for a floating-point multiply-add or multiply-subtract, if the expression is one we can contract
+
+	The expression 'a * b + c' (or 'c + a * b', 'a * b - c', or 'c - a * b') is computed with a single FMA3 instruction when the target supports it, or with a separate multiply and add otherwise.
+	Either way, 'a' is loaded into XMM0, 'b' into XMM1, and 'c' into XMM2 without going through the stack; as such, at most one of them may be anything other than a literal, a name, or an element of an array (that one is evaluated first).
+	All of the operands must have the same precision, as contracting a product that would have been rounded to single precision before being added to a double would change its value.
+
+	@param	to_evaluate	The binary expression
+	@param	line	The line number where the expression occurs
+	@return	The generated code, leaving the result in XMM0; empty if the expression can't be contracted
+
+	*/
+
+	exp_operator op = to_evaluate.get_operator();
+	if (op != PLUS && op != MINUS) {
+		return "";
+	}
+
+	// find the product; for subtraction, 'c - a * b' negates it
+	const Binary *product = nullptr;
+	const Expression *addend = nullptr;
+	bool negate_product = false;
+	if (to_evaluate.get_left().get_expression_type() == BINARY && static_cast<const Binary&>(to_evaluate.get_left()).get_operator() == MULT) {
+		product = static_cast<const Binary*>(&to_evaluate.get_left());
+		addend = &to_evaluate.get_right();
+	}
+	else if (to_evaluate.get_right().get_expression_type() == BINARY && static_cast<const Binary&>(to_evaluate.get_right()).get_operator() == MULT) {
+		product = static_cast<const Binary*>(&to_evaluate.get_right());
+		addend = &to_evaluate.get_left();
+		negate_product = op == MINUS;
+	}
+	else {
+		return "";
+	}
+
+	// get the operands in the order of their registers
+	const Expression *operands[] = { &product->get_left(), &product->get_right(), addend };
+
+	// every operand must be a floating-point value of the same width; literals are written at whatever width the others have
+	DataType fp_type;
+	for (auto operand: operands) {
+		DataType t = expression_util::get_expression_data_type(*operand, this->symbols, this->structs, line);
+		if (t.get_primary() != FLOAT) {
+			return "";
+		}
+		else if (operand->get_expression_type() == LITERAL) {
+			continue;
+		}
+		else if (fp_type.get_primary() == FLOAT && fp_type.get_width() != t.get_width()) {
+			return "";
+		}
+		fp_type = t;
+	}
+
+	if (fp_type.get_primary() != FLOAT) {
+		fp_type = expression_util::get_expression_data_type(*operands[0], this->symbols, this->structs, line);
+	}
+	if (fp_type.get_width() != sin_widths::FLOAT_WIDTH && fp_type.get_width() != sin_widths::DOUBLE_WIDTH) {
+		return "";
+	}
+
+	// only literals, names, and array elements can be loaded without disturbing the other registers
+	auto is_simple = [this, line](const Expression &e) {
+		if (e.get_expression_type() == LITERAL || e.get_expression_type() == IDENTIFIER) {
+			return true;
+		}
+		else if (e.get_expression_type() == INDEXED) {
+			auto &idx = static_cast<const Indexed&>(e);
+			exp_type index = idx.get_index_value().get_expression_type();
+			return idx.get_to_index().get_expression_type() == IDENTIFIER && (index == LITERAL || index == IDENTIFIER) &&
+				expression_util::get_expression_data_type(idx.get_to_index(), this->symbols, this->structs, line).get_primary() == ARRAY;
+		}
+		return false;
+	};
+
+	int complex = -1;
+	for (int i = 0; i < 3; i++) {
+		if (!is_simple(*operands[i])) {
+			if (complex >= 0) {
+				return "";
+			}
+			complex = i;
+		}
+	}
+
+	// the complex operand goes first; parameters held in XMM registers must be read before anything overwrites them
+	std::vector<int> order;
+	if (complex >= 0) {
+		order.push_back(complex);
+	}
+	for (int i = 0; i < 3; i++) {
+		if (i != complex) {
+			order.push_back(i);
+		}
+	}
+
+	std::set<reg> written;
+	for (int i: order) {
+		if (operands[i]->get_expression_type() == IDENTIFIER) {
+			reg r = this->lookup(static_cast<const Identifier&>(*operands[i]).getValue(), line)->get_register();
+			if (r != NO_REGISTER && written.count(r)) {
+				return "";
+			}
+		}
+
+		if (i == complex) {
+			written.insert({ XMM0, XMM1, XMM2 });
+		}
+		else {
+			written.insert(static_cast<reg>(XMM0 + i));
+		}
+	}
+
+	std::stringstream fma_ss;
+	for (int i: order) {
+		fma_ss << this->evaluate_vector_scalar(*operands[i], fp_type, line, i);
+	}
+
+	std::string suffix = fp_type.get_width() == sin_widths::DOUBLE_WIDTH ? "sd" : "ss";
+	if (this->_cpu >= X86_64_V3) {
+		std::string inst;
+		if (negate_product) {
+			inst = "vfnmadd213";	// -(xmm0 * xmm1) + xmm2
+		}
+		else if (op == MINUS) {
+			inst = "vfmsub213";	// xmm0 * xmm1 - xmm2
+		}
+		else {
+			inst = "vfmadd213";	// xmm0 * xmm1 + xmm2
+		}
+		fma_ss << "\t" << inst << suffix << " xmm0, xmm1, xmm2" << std::endl;
+	}
+	else {
+		fma_ss << "\t" << "mul" << suffix << " xmm0, xmm1" << std::endl;
+		if (negate_product) {
+			fma_ss << "\t" << "sub" << suffix << " xmm2, xmm0" << std::endl;
+			fma_ss << "\t" << "movaps xmm0, xmm2" << std::endl;
+		}
+		else {
+			fma_ss << "\t" << (op == MINUS ? "sub" : "add") << suffix << " xmm0, xmm2" << std::endl;
+		}
+	}
+
+	return fma_ss.str();
+}
+
+void compiler::get_concatenation_operands(const Expression &e, std::vector<const Expression*> &operands, unsigned int line) {
+	/*
+
+	get_concatenation_operands
+	Flattens a chain of string concatenations, e.g. 'a + (b + c) + d', into its operands (in the order they are evaluated)
+
+	*/
+
+	if (e.get_expression_type() == BINARY && static_cast<const Binary&>(e).get_operator() == PLUS) {
+		auto &b = static_cast<const Binary&>(e);
+		DataType left_type = expression_util::get_expression_data_type(b.get_left(), this->symbols, this->structs, line);
+		if (left_type.get_primary() == STRING) {
+			this->get_concatenation_operands(b.get_left(), operands, line);
+			this->get_concatenation_operands(b.get_right(), operands, line);
+			return;
+		}
+	}
+
+	operands.push_back(&e);
+}
+
+std::pair<std::string, size_t> compiler::evaluate_string_concatenation(const Binary &to_evaluate, unsigned int line) {
+	/*
+
+	evaluate_string_concatenation
+	Generates code for a chain of string concatenations with a single allocation
+
+	Concatenating one string at a time allocates an intermediate string for every '+' in the chain. Instead, every operand is evaluated and pushed, then:
+		1. their lengths are summed (a 'char' operand counts for one);
+		2. the result is allocated once, with sinl_string_alloc;
+		3. each operand is copied into it; and
+		4. the temporaries created by the operands (e.g., strings returned by functions) are freed.
+	As with a single concatenation, the result is left in RAX and pushed so that it can be freed once it has been used.
+
+	Concatenations of two names or literals are left to sinl_string_concat, as they only allocate once anyway.
+
+	@param	to_evaluate	The outermost concatenation in the chain
+	@param	line	The line number where the expression occurs
+	@return	The generated code and its number of temporaries (always 1); the code is empty if the chain should be evaluated normally
+
+	*/
+
+	std::vector<const Expression*> operands;
+	this->get_concatenation_operands(to_evaluate, operands, line);
+
+	// every operand must be a string or a char
+	std::vector<bool> is_char;
+	bool simple = operands.size() < 3;
+	for (auto operand: operands) {
+		DataType t = expression_util::get_expression_data_type(*operand, this->symbols, this->structs, line);
+		if (t.get_primary() != STRING && t.get_primary() != CHAR) {
+			return std::make_pair<>("", 0);
+		}
+		is_char.push_back(t.get_primary() == CHAR);
+		simple = simple && (operand->get_expression_type() == IDENTIFIER || operand->get_expression_type() == LITERAL);
+	}
+
+	if (simple) {
+		return std::make_pair<>("", 0);
+	}
+
+	std::stringstream concat_ss;
+	concat_ss << push_used_registers(this->reg_stack.peek(), true).str();
+
+	// evaluate the operands; each leaves its temporaries on the stack, and we push its value after them
+	// 'slots' tracks what each quadword on the stack holds (in the order they were pushed)
+	std::vector<int> slots;	// the index of the operand whose value is in the slot, or -1 for a temporary
+	for (size_t i = 0; i < operands.size(); i++) {
+		auto operand_p = this->evaluate_expression(*operands[i], line);
+		concat_ss << operand_p.first;
+		for (size_t j = 0; j < operand_p.second; j++) {
+			slots.push_back(-1);
+		}
+
+		concat_ss << "\t" << "push rax" << std::endl;
+		slots.push_back(i);
+	}
+
+	auto slot_location = [&slots](size_t slot) {
+		size_t offset = (slots.size() - 1 - slot) * sin_widths::PTR_WIDTH;
+		return offset ? "[rsp + " + std::to_string(offset) + "]" : std::string("[rsp]");
+	};
+
+	// sum the lengths
+	size_t chars = 0;
+	concat_ss << "\t" << "xor esi, esi" << std::endl;
+	for (size_t slot = 0; slot < slots.size(); slot++) {
+		if (slots[slot] < 0) {
+			continue;
+		}
+		else if (is_char[slots[slot]]) {
+			chars += 1;
+		}
+		else {
+			concat_ss << "\t" << "mov rax, " << slot_location(slot) << std::endl;
+			concat_ss << "\t" << "add esi, [rax]" << std::endl;
+		}
+	}
+	if (chars) {
+		concat_ss << "\t" << "add esi, " << chars << std::endl;
+	}
+
+	// allocate the result, keeping its length on the stack
+	concat_ss << "\t" << "push rsi" << std::endl;
+	concat_ss << function_util::call_sincall_subroutine("sinl_string_alloc");
+	concat_ss << "\t" << "pop rcx" << std::endl;
+	concat_ss << "\t" << "mov [rax], ecx" << std::endl;
+	concat_ss << "\t" << "mov r13, rax" << std::endl;
+
+	// copy each operand after the length
+	concat_ss << "\t" << "lea rdi, [rax + " << sin_widths::INT_WIDTH << "]" << std::endl;
+	for (size_t slot = 0; slot < slots.size(); slot++) {
+		if (slots[slot] < 0) {
+			continue;
+		}
+		else if (is_char[slots[slot]]) {
+			concat_ss << "\t" << "mov al, " << slot_location(slot) << std::endl;
+			concat_ss << "\t" << "stosb" << std::endl;
+		}
+		else {
+			concat_ss << "\t" << "mov rsi, " << slot_location(slot) << std::endl;
+			concat_ss << "\t" << "mov ecx, [rsi]" << std::endl;
+			concat_ss << "\t" << "add rsi, " << sin_widths::INT_WIDTH << std::endl;
+			concat_ss << "\t" << "rep movsb" << std::endl;
+		}
+	}
+	concat_ss << "\t" << "mov byte [rdi], 0" << std::endl;
+
+	// free the temporaries
+	for (size_t slot = 0; slot < slots.size(); slot++) {
+		if (slots[slot] < 0) {
+			concat_ss << "\t" << "mov rdi, " << slot_location(slot) << std::endl;
+			concat_ss << function_util::call_sre_function(magic_numbers::SRE_FREE);
+		}
+	}
+
+	concat_ss << "\t" << "add rsp, " << slots.size() * sin_widths::PTR_WIDTH << std::endl;
+	concat_ss << pop_used_registers(this->reg_stack.peek(), true).str();
+	concat_ss << "\t" << "mov rax, r13" << std::endl;
+	concat_ss << "\t" << "push rax" << std::endl;
+
+	return std::make_pair<>(concat_ss.str(), 1);
+}
+
 std::pair<std::string, size_t> compiler::evaluate_binary(const Binary &to_evaluate, unsigned int line, const DataType *type_hint) {
 	/*
 
@@ -201,7 +601,16 @@ std::pair<std::string, size_t> compiler::evaluate_binary(const Binary &to_evalua
 
 	// act based on the operator
 	if (to_evaluate.get_operator() == DOT) {
-		eval_ss << expression_util::evaluate_member_selection(to_evaluate, this->symbols, this->structs, RAX, line).str();
+		// vector members are loaded into XMM0 rather than RAX
+		DataType member_type = expression_util::get_expression_data_type(to_evaluate, this->symbols, this->structs, line);
+		if (member_type.get_primary() == VECTOR) {
+			eval_ss << this->evaluate_vector_expression(to_evaluate, member_type, line);
+		}
+		else {
+			eval_ss << expression_util::evaluate_member_selection(to_evaluate, this->symbols, this->structs, RAX, line).str();
+		}
+	} else if (to_evaluate.get_operator() == AND || to_evaluate.get_operator() == OR) {
+		eval_ss << this->evaluate_logical(to_evaluate, line).str();
 	} else {
 		// get the left and right branches
 
@@ -219,42 +628,55 @@ std::pair<std::string, size_t> compiler::evaluate_binary(const Binary &to_evalua
             &left_type
 		);
 
+		// operations on vectors are packed (see compile/vector_expressions.cpp)
+		if (left_type.get_primary() == VECTOR || right_type.get_primary() == VECTOR) {
+			DataType result_type = expression_util::get_vector_result_type(to_evaluate.get_operator(), left_type, right_type, line);
+			eval_ss << this->evaluate_vector_expression(to_evaluate, result_type, line);
+			return std::make_pair<>(eval_ss.str(), count);
+		}
+
 		Type primary = left_type.get_primary();
 		size_t data_width = left_type.get_width();
 		bool is_signed = left_type.get_qualities().is_signed() || right_type.get_qualities().is_signed();
 
-		// check for half-precision type once here instead of repeating this call multiple times in source later
-		if (primary == FLOAT) {
-			if (
-				(left_type.get_width() == sin_widths::HALF_WIDTH) ||
-				(right_type.get_primary() == FLOAT && right_type.get_width() == sin_widths::HALF_WIDTH)
-			) {
-				half_precision_not_supported_warning(line);
+		// issue any warnings about the operand types
+		this->check_binary_operands(left_type, right_type, line);
+
+		// chains of concatenations are built with a single allocation
+		if (primary == STRING && to_evaluate.get_operator() == PLUS && left_type.is_compatible(right_type)) {
+			auto concat_p = this->evaluate_string_concatenation(to_evaluate, line);
+			if (!concat_p.first.empty()) {
+				return concat_p;
 			}
 		}
 
-		// issue a warning for signed/unsigned mismatch if applicable
-		if (
-			(primary == INT) &&
-			(left_type.get_qualities().is_signed() != right_type.get_qualities().is_signed())
-		) {
-			this->_warn("Signed/unsigned mismatch", compiler_errors::SIGNED_UNSIGNED_MISMATCH, line);
+		// with --fp-contract=fast, multiply-adds are fused (or at least kept in registers)
+		if (this->_fp_contract && primary == FLOAT) {
+			std::string contracted = this->evaluate_fp_contraction(to_evaluate, line);
+			if (!contracted.empty()) {
+				return std::make_pair<>(contracted, count);
+			}
 		}
-		
-		// todo: generalize check for width mismatch warning
-		// also issue a warning if the types are different widths
+
+		// integer division and modulo by a constant are done with a multiplication instead; the divisor never needs to be evaluated
+		int64_t divisor;
 		if (
-			(left_type.get_width() != right_type.get_width()) &&
-			!(primary == STRING && right_type.get_primary() == CHAR)
+			primary == INT &&
+			(to_evaluate.get_operator() == DIV || to_evaluate.get_operator() == MODULO) &&
+			left_type.is_compatible(right_type) &&
+			division_util::get_constant_divisor(to_evaluate.get_right(), left_type, is_signed, divisor)
 		) {
-			this->_warn(
-                "Width mismatch (left type is " +
-                    std::to_string(left_type.get_width()) +
-                    " bytes wide, right type is " + 
-                    std::to_string(right_type.get_width()) + ")",
-                compiler_errors::WIDTH_MISMATCH,
-                line
-            );
+			auto lhs_pair = this->evaluate_expression(to_evaluate.get_left(), line, type_hint);
+			eval_ss << lhs_pair.first;
+			eval_ss << division_util::divide_by_constant(
+				divisor,
+				left_type,
+				is_signed,
+				to_evaluate.get_operator() == MODULO,
+				this->reg_stack.peek()
+			);
+
+			return std::make_pair<>(eval_ss.str(), lhs_pair.second);
 		}
 
 		// ensure the types are compatible before proceeding with evaluation
@@ -449,7 +871,7 @@ std::pair<std::string, size_t> compiler::evaluate_binary(const Binary &to_evalua
 				if (primary == INT) {
 					// how we handle integer division depends on whether we are using signed or unsigned integers
 					auto rbx_name = register_usage::get_register_name(RBX, left_type);
-					eval_ss << "\t" << "mov " << register_usage::get_register_name(RDX, left_type) << ", 0" << std::endl;
+					eval_ss << division_util::extend_dividend(left_type, is_signed);
 					if (is_signed) {
 						// use idiv
 						eval_ss << "\t" << "idiv " << rbx_name << std::endl;
@@ -476,10 +898,10 @@ std::pair<std::string, size_t> compiler::evaluate_binary(const Binary &to_evalua
 			{
 				// modulo only allowed for int and float
 				if (primary == INT) {
-					// for modulo, we need to determine what should happen if we are using signed numbers
+					// signed modulo uses idiv, so the remainder has the sign of the dividend
 					auto rdx_name = register_usage::get_register_name(RDX, left_type);
-					eval_ss << "\t" << "mov " << rdx_name << ", 0" << std::endl;
-					eval_ss << "\t" << "div " << register_usage::get_register_name(RBX, left_type) << std::endl;
+					eval_ss << division_util::extend_dividend(left_type, is_signed);
+					eval_ss << "\t" << (is_signed ? "idiv " : "div ") << register_usage::get_register_name(RBX, left_type) << std::endl;
 					eval_ss << "\t" << "mov " << register_usage::get_register_name(RAX, left_type) << ", " << rdx_name << std::endl;
 				}
 				else if (primary == FLOAT) {
@@ -581,29 +1003,9 @@ std::pair<std::string, size_t> compiler::evaluate_binary(const Binary &to_evalua
 			Logical operators
 
 			These may only operate on boolean types
-			They generate identical code to their bitwise counterparts but different errors
+			'and' and 'or' are short-circuited and so are handled by evaluate_logical; 'xor' always depends on both operands
 
 			*/
-			else if (to_evaluate.get_operator() == exp_operator::AND)
-			{
-				// logical and
-				if (primary == BOOL) {
-					eval_ss << "\t" << "and al, bl" << std::endl;
-				}
-				else {
-					throw UndefinedOperatorError("logical-and", line);
-				}
-			}
-			else if (to_evaluate.get_operator() == exp_operator::OR)
-			{
-				// logical or
-				if (primary == BOOL) {
-					eval_ss << "\t" << "or al, bl" << std::endl;
-				}
-				else {
-					throw UndefinedOperatorError("logical-or", line);
-				}
-			}
 			else if (to_evaluate.get_operator() == exp_operator::XOR)
 			{
 				// logical xor
@@ -668,51 +1070,44 @@ std::pair<std::string, size_t> compiler::evaluate_binary(const Binary &to_evalua
 						eval_ss << "ucomiss";
 					}
 
-					// write the comparison
-					eval_ss << " xmm0, xmm1" << std::endl;
+					/*
+
+					ucomiss/ucomisd set the flags like an unsigned comparison would, but an unordered result (either operand is NaN) sets ZF, PF, and CF at once
+					Comparisons that must be false for NaN therefore use 'above' (with the operands swapped for < and <=), and equality checks PF as well
+
+					*/
+
+					exp_operator op = to_evaluate.get_operator();
+					bool swap = op == LESS || op == LESS_OR_EQUAL;
+					eval_ss << (swap ? " xmm1, xmm0" : " xmm0, xmm1") << std::endl;
+
+					if (op == EQUAL) {
+						eval_ss << "\t" << "sete al" << std::endl;
+						eval_ss << "\t" << "setnp bl" << std::endl;
+						eval_ss << "\t" << "and al, bl" << std::endl;
+					}
+					else if (op == NOT_EQUAL) {
+						eval_ss << "\t" << "setne al" << std::endl;
+						eval_ss << "\t" << "setp bl" << std::endl;
+						eval_ss << "\t" << "or al, bl" << std::endl;
+					}
+					else {
+						exp_operator above = (op == LESS || op == GREATER) ? GREATER : GREATER_OR_EQUAL;
+						eval_ss << "\t" << "set" << get_condition_code(above, true, line) << " al" << std::endl;
+					}
 				}
 				else {
 					// if we have two unsigned variables, use unsigned comparison
 					requires_unsigned = left_type.get_qualities().is_unsigned() && right_type.get_qualities().is_unsigned();
 					
-					// write the comparison
-					eval_ss << "\t" << "cmp rax, rbx" << std::endl;
+					// write the comparison, using the operand width so that signed comparisons of narrower types are correct
+					eval_ss << "\t" << "cmp " << register_usage::get_register_name(RAX, left_type) << ", " << register_usage::get_register_name(RBX, left_type) << std::endl;
 				}
 				
-				// a variable to hold our instruction mnemonic
-				std::string instruction = "";
-
-				// todo: we could write a simple utility function to get a string for the equality based on an operator (e.g., turning EQUAL into 'e' or LESS OR EQUAL to 'le'), assuming we need to use it more than once
-				// todo: use seta/setb/setna/setnb/setae/setbe for unsigned comparisons (both operands unsigned)
-				
-				// now, switch to determine which branching instruction we need
-				switch (to_evaluate.get_operator()) {
-				case exp_operator::EQUAL:
-					instruction = "sete";
-					break;
-				case exp_operator::NOT_EQUAL:
-					instruction = "setne";
-					break;
-				case exp_operator::GREATER:
-					instruction = "setg";
-					break;
-				case exp_operator::LESS:
-					instruction = "setl";
-					break;
-				case exp_operator::GREATER_OR_EQUAL:
-					instruction = "setge";
-					break;
-				case exp_operator::LESS_OR_EQUAL:
-					instruction = "setle";
-					break;
-				default:
-					// if the parser didn't catch a 'no operator', throw the exception here -- we have no more valid operators
-					throw CompilerException("Undefined operator", compiler_errors::UNDEFINED_ERROR, line);
-					break;
+				// finally, set al based on eflags (floats have done so already)
+				if (left_type.get_primary() != FLOAT) {
+					eval_ss << "\t" << "set" << get_condition_code(to_evaluate.get_operator(), requires_unsigned, line) << " al" << std::endl;
 				}
-
-				// finally, set al based on eflags
-				eval_ss << "\t" << instruction << " al" << std::endl;
 			}
 		}
 		else {
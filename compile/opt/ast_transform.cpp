@@ -0,0 +1,311 @@
+/*
+
+SIN Toolchain (x86 target)
+opt/ast_transform.cpp
+Copyright 2021 Riley Lannon
+
+Implementation of the default (copying) AST transform
+
+*/
+
+#include "ast_transform.h"
+#include "../../util/Exceptions.h"
+
+bool ast_transform::run(StatementBlock &ast) {
+	this->changed = false;
+	ast = this->transform_block(ast);
+	return this->changed;
+}
+
+StatementBlock ast_transform::transform_block(const StatementBlock &block) {
+	StatementBlock transformed;
+	transformed.has_return = block.has_return;
+
+	for (auto s: block.statements_list) {
+		std::unique_ptr<Statement> t = this->transform_statement(*s);
+		if (t) {
+			transformed.statements_list.push_back(std::move(t));
+		}
+	}
+
+	return transformed;
+}
+
+std::unique_ptr<Statement> ast_transform::transform_branch(const Statement *branch) {
+	/*
+
+	transform_branch
+	Rebuilds the branch of an if/else statement or loop
+
+	Branches may be empty (a missing 'else'), but an existing branch is never removed entirely; if the transform would remove it, it is replaced with an empty scope block
+
+	*/
+
+	if (!branch) {
+		return nullptr;
+	}
+
+	std::unique_ptr<Statement> t = this->transform_statement(*branch);
+	if (!t) {
+		t = std::make_unique<ScopedBlock>(StatementBlock());
+		t->set_line_number(branch->get_line_number());
+	}
+
+	return t;
+}
+
+std::vector<std::unique_ptr<Statement>> ast_transform::transform_parameters(const std::vector<const Statement*> &params) {
+	std::vector<std::unique_ptr<Statement>> transformed;
+	for (auto p: params) {
+		transformed.push_back(this->transform_statement(*p));
+	}
+	return transformed;
+}
+
+std::unique_ptr<Statement> ast_transform::transform_statement(const Statement &s) {
+	std::unique_ptr<Statement> t;
+
+	switch (s.get_statement_type()) {
+		case INCLUDE:
+		{
+			auto &inc = static_cast<const Include&>(s);
+			t = std::make_unique<Include>(inc.get_filename());
+			break;
+		}
+		case DECLARATION:
+		{
+			auto &decl = static_cast<const Declaration&>(s);
+			auto params = this->transform_parameters(decl.get_formal_parameters());
+			t = std::make_unique<Declaration>(
+				decl.get_type_information(),
+				decl.get_name(),
+				decl.get_initial_value() ? decl.get_initial_value()->clone() : nullptr,
+				decl.is_function(),
+				decl.is_struct(),
+				params,
+				decl.get_calling_convention()
+			);
+			break;
+		}
+		case ALLOCATION:
+		{
+			auto &alloc = static_cast<const Allocation&>(s);
+			t = std::make_unique<Allocation>(
+				alloc.get_type_information(),
+				alloc.get_name(),
+				alloc.was_initialized(),
+				alloc.get_initial_value() ? this->transform_expression(*alloc.get_initial_value()) : nullptr
+			);
+			break;
+		}
+		case ASSIGNMENT:
+		{
+			auto &assign = static_cast<const Assignment&>(s);
+			t = std::make_unique<Assignment>(
+				this->transform_expression(assign.get_lvalue()),
+				this->transform_expression(assign.get_rvalue())
+			);
+			break;
+		}
+		case COMPOUND_ASSIGNMENT:
+		{
+			// the rvalue of a compound assignment is the full binary expression (e.g., 'a += b' has the rvalue 'a + b')
+			auto &assign = static_cast<const CompoundAssignment&>(s);
+			auto &rvalue = static_cast<const Binary&>(assign.get_rvalue());
+			t = std::make_unique<CompoundAssignment>(
+				this->transform_expression(assign.get_lvalue()),
+				this->transform_expression(rvalue.get_right()),
+				rvalue.get_operator()
+			);
+			break;
+		}
+		case MOVEMENT:
+		{
+			auto &move = static_cast<const Movement&>(s);
+			t = std::make_unique<Movement>(
+				this->transform_expression(move.get_lvalue()),
+				this->transform_expression(move.get_rvalue())
+			);
+			break;
+		}
+		case RETURN_STATEMENT:
+		{
+			auto &ret = static_cast<const ReturnStatement&>(s);
+			t = std::make_unique<ReturnStatement>(this->transform_expression(ret.get_return_exp()));
+			break;
+		}
+		case IF_THEN_ELSE:
+		{
+			auto &ite = static_cast<const IfThenElse&>(s);
+			t = std::make_unique<IfThenElse>(
+				this->transform_expression(ite.get_condition()),
+				this->transform_branch(ite.get_if_branch()),
+				this->transform_branch(ite.get_else_branch())
+			);
+			break;
+		}
+		case WHILE_LOOP:
+		{
+			auto &loop = static_cast<const WhileLoop&>(s);
+			t = std::make_unique<WhileLoop>(
+				this->transform_expression(loop.get_condition()),
+				this->transform_branch(loop.get_branch())
+			);
+			break;
+		}
+		case FUNCTION_DEFINITION:
+		{
+			auto &def = static_cast<const FunctionDefinition&>(s);
+			auto params = this->transform_parameters(def.get_formal_parameters());
+			t = std::make_unique<FunctionDefinition>(
+				def.get_name(),
+				def.get_type_information(),
+				params,
+				std::make_unique<StatementBlock>(this->transform_block(def.get_procedure())),
+				def.get_calling_convention()
+			);
+			break;
+		}
+		case STRUCT_DEFINITION:
+		{
+			// struct members are left as they are
+			auto &def = static_cast<const StructDefinition&>(s);
+			t = std::make_unique<StructDefinition>(
+				def.get_name(),
+				std::make_unique<StatementBlock>(def.get_procedure())
+			);
+			break;
+		}
+		case CALL:
+		{
+			auto &call = static_cast<const Call&>(s);
+			auto proc = this->transform_procedure(call);
+			CallExpression call_exp(proc.get());
+			t = std::make_unique<Call>(call_exp);
+			break;
+		}
+		case INLINE_ASM:
+		{
+			auto &asm_stmt = static_cast<const InlineAssembly&>(s);
+			t = std::make_unique<InlineAssembly>(asm_stmt.get_asm_code());
+			break;
+		}
+		case FREE_MEMORY:
+		{
+			auto &free_stmt = static_cast<const FreeMemory&>(s);
+			t = std::make_unique<FreeMemory>(this->transform_expression(free_stmt.get_freed_memory()));
+			break;
+		}
+		case SCOPE_BLOCK:
+		{
+			auto &block = static_cast<const ScopedBlock&>(s);
+			t = std::make_unique<ScopedBlock>(this->transform_block(block.get_statements()));
+			break;
+		}
+		default:
+			throw CompilerException("This statement type is not currently supported", compiler_errors::ILLEGAL_OPERATION_ERROR, s.get_line_number());
+			break;
+	}
+
+	t->set_line_number(s.get_line_number());
+	return t;
+}
+
+std::unique_ptr<ListExpression> ast_transform::transform_list(const ListExpression &list) {
+	std::vector<std::unique_ptr<Expression>> members;
+	for (auto member: list.get_list()) {
+		members.push_back(this->transform_expression(*member));
+	}
+
+	return std::make_unique<ListExpression>(members, list.get_list_type());
+}
+
+std::unique_ptr<Procedure> ast_transform::transform_procedure(const Procedure &proc) {
+	return std::make_unique<Procedure>(
+		this->transform_expression(proc.get_func_name()),
+		this->transform_list(proc.get_args())
+	);
+}
+
+std::unique_ptr<Expression> ast_transform::transform_expression(const Expression &e) {
+	std::unique_ptr<Expression> t;
+
+	switch (e.get_expression_type()) {
+		case LIST:
+			t = this->transform_list(static_cast<const ListExpression&>(e));
+			break;
+		case INDEXED:
+		{
+			auto &idx = static_cast<const Indexed&>(e);
+			auto indexed = std::make_unique<Indexed>(
+				this->transform_expression(idx.get_to_index()),
+				this->transform_expression(idx.get_index_value())
+			);
+			if (!idx.is_bounds_checked()) {
+				indexed->remove_bounds_check();
+			}
+			t = std::move(indexed);
+			break;
+		}
+		case BINARY:
+		{
+			auto &b = static_cast<const Binary&>(e);
+			t = std::make_unique<Binary>(
+				this->transform_expression(b.get_left()),
+				this->transform_expression(b.get_right()),
+				b.get_operator()
+			);
+			break;
+		}
+		case UNARY:
+		{
+			auto &u = static_cast<const Unary&>(e);
+			t = std::make_unique<Unary>(this->transform_expression(u.get_operand()), u.get_operator());
+			break;
+		}
+		case CALL_EXP:
+		{
+			auto proc = this->transform_procedure(static_cast<const Procedure&>(e));
+			t = std::make_unique<CallExpression>(proc.get());
+			break;
+		}
+		case PROC_EXP:
+			t = this->transform_procedure(static_cast<const Procedure&>(e));
+			break;
+		case CAST:
+		{
+			auto &c = static_cast<const Cast&>(e);
+			t = std::make_unique<Cast>(this->transform_expression(c.get_exp()), c.get_new_type());
+			break;
+		}
+		case ATTRIBUTE:
+		{
+			auto &attr = static_cast<const AttributeSelection&>(e);
+			return std::make_unique<AttributeSelection>(
+				this->transform_expression(attr.get_selected()),
+				attr.get_attribute(),
+				attr.get_data_type()
+			);
+			break;
+		}
+		default:
+			// literals, identifiers, keywords, etc. have no subexpressions
+			t = e.clone();
+			break;
+	}
+
+	// whether an expression is a compile-time constant is determined by the parser, so it must be carried over
+	if (e.is_const()) {
+		t->set_const();
+	}
+
+	return t;
+}
+
+ast_transform::ast_transform()
+	: changed(false)
+{
+}
+
+ast_transform::~ast_transform() {
+}
@@ -0,0 +1,43 @@
+/*
+
+SIN Toolchain (x86 target)
+opt/ast_transform.h
+Copyright 2021 Riley Lannon
+
+A base class for passes that rewrite the AST
+
+The parser's AST nodes are immutable once created, so a transform rebuilds the tree as it walks it. By default, every node is copied as-is; a pass overrides the hooks for the nodes it is interested in and calls the base implementation for everything else.
+
+*/
+
+#pragma once
+
+#include <memory>
+
+#include "pass_manager.h"
+#include "../../parser/Statement.h"
+
+class ast_transform: public optimization_pass {
+protected:
+	bool changed;	// set by a pass whenever it modifies the tree
+
+	// rebuild a block; statements whose transform returns nullptr are removed
+	virtual StatementBlock transform_block(const StatementBlock &block);
+
+	// rebuild a single statement (nullptr removes it)
+	virtual std::unique_ptr<Statement> transform_statement(const Statement &s);
+
+	// rebuild an expression
+	virtual std::unique_ptr<Expression> transform_expression(const Expression &e);
+
+	// convenience functions for the rebuilding of specific node types
+	std::unique_ptr<ListExpression> transform_list(const ListExpression &list);
+	std::unique_ptr<Procedure> transform_procedure(const Procedure &proc);
+	std::unique_ptr<Statement> transform_branch(const Statement *branch);
+	std::vector<std::unique_ptr<Statement>> transform_parameters(const std::vector<const Statement*> &params);
+public:
+	bool run(StatementBlock &ast) override;
+
+	ast_transform();
+	virtual ~ast_transform();
+};
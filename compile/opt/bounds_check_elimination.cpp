@@ -0,0 +1,626 @@
+/*
+
+SIN Toolchain (x86 target)
+opt/bounds_check_elimination.cpp
+Copyright 2021 Riley Lannon
+
+Implementation of the bounds check elimination pass
+
+*/
+
+#include <iostream>
+#include <limits>
+#include <algorithm>
+
+#include "bounds_check_elimination.h"
+#include "../../util/Exceptions.h"
+
+bool bounds_check_elimination::bound_fact::operator==(const bound_fact &right) const {
+	return this->kind == right.kind && this->index == right.index && this->array == right.array && this->bound == right.bound;
+}
+
+bounds_check_elimination::effects::effects()
+	: has_call(false)
+	, has_indirect_store(false)
+	, opaque(false)
+{
+}
+
+std::string bounds_check_elimination::get_name() const {
+	return "bounds-check-elimination";
+}
+
+bool bounds_check_elimination::get_int_literal(const Expression &e, long long &value) {
+	/*
+
+	get_int_literal
+	Gets the value of an integer literal
+
+	Integer literals are never negative (negation is a unary operator), and are always written in base 10
+
+	*/
+
+	if (e.get_expression_type() != LITERAL) {
+		return false;
+	}
+
+	auto &literal = static_cast<const Literal&>(e);
+	if (literal.get_data_type().get_primary() != INT) {
+		return false;
+	}
+
+	try {
+		value = std::stoll(literal.get_value(), nullptr, 10);
+	}
+	catch (std::exception &e) {
+		return false;
+	}
+
+	return value >= 0 && value <= (long long)std::numeric_limits<int32_t>::max();
+}
+
+bool bounds_check_elimination::keeps_non_negative(const std::string &name, const Expression &rvalue) {
+	// a non-negative literal, or the name plus a non-negative literal (the rvalue of 'let i += 1')
+	long long value;
+	if (get_int_literal(rvalue, value)) {
+		return true;
+	}
+	else if (rvalue.get_expression_type() == BINARY) {
+		auto &b = static_cast<const Binary&>(rvalue);
+		return b.get_operator() == PLUS && b.get_left().get_expression_type() == IDENTIFIER &&
+			static_cast<const Identifier&>(b.get_left()).getValue() == name && get_int_literal(b.get_right(), value);
+	}
+
+	return false;
+}
+
+bool bounds_check_elimination::get_name_type(const std::string &name, DataType &t) const {
+	if (this->locals.is_local(name)) {
+		return this->locals.get_local_type(name, t);
+	}
+
+	auto it = this->global_types.find(name);
+	if (it != this->global_types.end()) {
+		t = it->second;
+		return true;
+	}
+
+	return false;
+}
+
+bool bounds_check_elimination::get_fixed_length(const std::string &array, long long &length) const {
+	/*
+
+	get_fixed_length
+	Gets the length of an array whose length is known at compile time
+
+	Parameters are excluded, as are dynamic arrays (which may be reassigned to arrays of another length)
+
+	*/
+
+	DataType t;
+	if (this->locals.is_param(array) || !this->get_name_type(array, t) || t.get_primary() != ARRAY || t.get_qualities().is_dynamic()) {
+		return false;
+	}
+
+	const Expression *length_exp = t.get_array_length_expression();
+	return length_exp && get_int_literal(*length_exp, length);
+}
+
+bool bounds_check_elimination::has_fact(const bound_fact &f) const {
+	return std::find(this->facts.begin(), this->facts.end(), f) != this->facts.end();
+}
+
+void bounds_check_elimination::add_fact(const bound_fact &f) {
+	if (!this->has_fact(f)) {
+		this->facts.push_back(f);
+	}
+}
+
+bool bounds_check_elimination::is_within_bounds(const Indexed &idx) const {
+	/*
+
+	is_within_bounds
+	Determines whether the index of an indexed expression is always within [0, len)
+
+	*/
+
+	if (idx.get_to_index().get_expression_type() != IDENTIFIER) {
+		return false;
+	}
+
+	std::string array = static_cast<const Identifier&>(idx.get_to_index()).getValue();
+	DataType array_type;
+	if (!this->get_name_type(array, array_type) || (array_type.get_primary() != ARRAY && array_type.get_primary() != STRING)) {
+		return false;
+	}
+
+	long long length = 0;
+	bool fixed = this->get_fixed_length(array, length);
+
+	// a literal index can be checked right here
+	long long value;
+	if (get_int_literal(idx.get_index_value(), value)) {
+		return fixed && value < length;
+	}
+	else if (idx.get_index_value().get_expression_type() != IDENTIFIER) {
+		return false;
+	}
+
+	std::string index = static_cast<const Identifier&>(idx.get_index_value()).getValue();
+	DataType index_type;
+	if (!this->get_name_type(index, index_type) || index_type.get_primary() != INT) {
+		return false;
+	}
+
+	// unless the index was declared 'unsigned', it must be known not to be negative
+	bool is_unsigned = index_type.get_qualities().has_sign_quality() && index_type.get_qualities().is_unsigned();
+	if (!is_unsigned && !this->has_fact(bound_fact{ bound_fact::NON_NEGATIVE, index, "", 0 })) {
+		return false;
+	}
+
+	if (this->has_fact(bound_fact{ bound_fact::BELOW_LENGTH, index, array, 0 })) {
+		return true;
+	}
+
+	for (auto &f: this->facts) {
+		if (fixed && f.kind == bound_fact::BELOW_CONSTANT && f.index == index && f.bound <= length) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void bounds_check_elimination::add_condition_facts(const Expression &condition) {
+	/*
+
+	add_condition_facts
+	Adds the facts that hold whenever a condition is true
+
+	*/
+
+	if (condition.get_expression_type() != BINARY) {
+		return;
+	}
+
+	auto &b = static_cast<const Binary&>(condition);
+	exp_operator op = b.get_operator();
+	if (op == AND) {
+		this->add_condition_facts(b.get_left());
+		this->add_condition_facts(b.get_right());
+		return;
+	}
+
+	// put the name on the left, so that 'a:len > i' is handled as 'i < a:len'
+	const Expression *name = &b.get_left();
+	const Expression *other = &b.get_right();
+	if (name->get_expression_type() != IDENTIFIER) {
+		std::swap(name, other);
+		switch (op) {
+			case LESS: op = GREATER; break;
+			case GREATER: op = LESS; break;
+			case LESS_OR_EQUAL: op = GREATER_OR_EQUAL; break;
+			case GREATER_OR_EQUAL: op = LESS_OR_EQUAL; break;
+			default: break;
+		}
+
+		if (name->get_expression_type() != IDENTIFIER) {
+			return;
+		}
+	}
+
+	std::string index = static_cast<const Identifier&>(*name).getValue();
+	long long value;
+	if (op == LESS || op == LESS_OR_EQUAL) {
+		if (op == LESS && other->get_expression_type() == ATTRIBUTE) {
+			auto &attr = static_cast<const AttributeSelection&>(*other);
+			if (attr.get_attribute() == LENGTH && attr.get_selected().get_expression_type() == IDENTIFIER) {
+				this->add_fact(bound_fact{ bound_fact::BELOW_LENGTH, index, static_cast<const Identifier&>(attr.get_selected()).getValue(), 0 });
+			}
+		}
+		else if (get_int_literal(*other, value)) {
+			this->add_fact(bound_fact{ bound_fact::BELOW_CONSTANT, index, "", op == LESS ? value : value + 1 });
+		}
+	}
+	else if ((op == GREATER_OR_EQUAL || op == GREATER) && get_int_literal(*other, value)) {
+		this->add_fact(bound_fact{ bound_fact::NON_NEGATIVE, index, "", 0 });
+	}
+}
+
+void bounds_check_elimination::add_write_facts(const Statement &s) {
+	// assigning a non-negative literal makes a name non-negative
+	if (s.get_statement_type() == ALLOCATION) {
+		auto &alloc = static_cast<const Allocation&>(s);
+		long long value;
+		if (alloc.get_initial_value() && get_int_literal(*alloc.get_initial_value(), value)) {
+			this->add_fact(bound_fact{ bound_fact::NON_NEGATIVE, alloc.get_name(), "", 0 });
+		}
+	}
+	else if (s.get_statement_type() == ASSIGNMENT) {
+		auto &assign = static_cast<const Assignment&>(s);
+		long long value;
+		if (assign.get_lvalue().get_expression_type() == IDENTIFIER && get_int_literal(assign.get_rvalue(), value)) {
+			this->add_fact(bound_fact{ bound_fact::NON_NEGATIVE, static_cast<const Identifier&>(assign.get_lvalue()).getValue(), "", 0 });
+		}
+	}
+}
+
+void bounds_check_elimination::write_lvalue(const Expression &lvalue, bool keeps_non_negative, effects &fx) const {
+	switch (lvalue.get_expression_type()) {
+		case IDENTIFIER:
+		{
+			// assigning to a reference writes to whatever it refers to
+			std::string name = static_cast<const Identifier&>(lvalue).getValue();
+			auto it = fx.written.find(name);
+			if (it == fx.written.end()) {
+				fx.written[name] = keeps_non_negative;
+			}
+			else {
+				it->second = it->second && keeps_non_negative;
+			}
+
+			DataType t;
+			if (!this->get_name_type(name, t) || t.get_primary() == REFERENCE) {
+				fx.has_indirect_store = true;
+			}
+			break;
+		}
+		case INDEXED:
+			// writing an element doesn't change the length of the array
+			break;
+		case BINARY:
+		{
+			auto &b = static_cast<const Binary&>(lvalue);
+			if (b.get_operator() == DOT) {
+				this->write_lvalue(b.get_left(), false, fx);
+			}
+			else {
+				fx.has_indirect_store = true;
+			}
+			break;
+		}
+		default:
+			fx.has_indirect_store = true;
+			break;
+	}
+}
+
+void bounds_check_elimination::collect_effects(const Statement &s, effects &fx) const {
+	/*
+
+	collect_effects
+	Records everything a statement may modify
+
+	*/
+
+	switch (s.get_statement_type()) {
+		case ALLOCATION:
+		{
+			auto &alloc = static_cast<const Allocation&>(s);
+			fx.written[alloc.get_name()] = false;
+			if (alloc.get_initial_value()) {
+				this->collect_effects(*alloc.get_initial_value(), fx);
+			}
+			break;
+		}
+		case ASSIGNMENT:
+		case COMPOUND_ASSIGNMENT:
+		{
+			auto &assign = static_cast<const Assignment&>(s);
+			bool keeps = assign.get_lvalue().get_expression_type() == IDENTIFIER &&
+				keeps_non_negative(static_cast<const Identifier&>(assign.get_lvalue()).getValue(), assign.get_rvalue());
+
+			// of the compound assignments, only 'let i += c' keeps a name non-negative
+			if (s.get_statement_type() == COMPOUND_ASSIGNMENT && static_cast<const CompoundAssignment&>(s).get_operator() != PLUS) {
+				keeps = false;
+			}
+			this->write_lvalue(assign.get_lvalue(), keeps, fx);
+			this->collect_effects(assign.get_lvalue(), fx);
+			this->collect_effects(assign.get_rvalue(), fx);
+			break;
+		}
+		case MOVEMENT:
+		{
+			auto &move = static_cast<const Movement&>(s);
+			this->write_lvalue(move.get_lvalue(), false, fx);
+			this->write_lvalue(move.get_rvalue(), false, fx);
+			this->collect_effects(move.get_lvalue(), fx);
+			this->collect_effects(move.get_rvalue(), fx);
+			break;
+		}
+		case RETURN_STATEMENT:
+			this->collect_effects(static_cast<const ReturnStatement&>(s).get_return_exp(), fx);
+			break;
+		case IF_THEN_ELSE:
+		{
+			auto &ite = static_cast<const IfThenElse&>(s);
+			this->collect_effects(ite.get_condition(), fx);
+			if (ite.get_if_branch()) this->collect_effects(*ite.get_if_branch(), fx);
+			if (ite.get_else_branch()) this->collect_effects(*ite.get_else_branch(), fx);
+			break;
+		}
+		case WHILE_LOOP:
+		{
+			auto &loop = static_cast<const WhileLoop&>(s);
+			this->collect_effects(loop.get_condition(), fx);
+			if (loop.get_branch()) this->collect_effects(*loop.get_branch(), fx);
+			break;
+		}
+		case CALL:
+			this->collect_effects(static_cast<const Expression&>(static_cast<const Call&>(s)), fx);
+			break;
+		case FREE_MEMORY:
+		{
+			auto &free_stmt = static_cast<const FreeMemory&>(s);
+			this->write_lvalue(free_stmt.get_freed_memory(), false, fx);
+			this->collect_effects(free_stmt.get_freed_memory(), fx);
+			break;
+		}
+		case SCOPE_BLOCK:
+			for (auto stmt: static_cast<const ScopedBlock&>(s).get_statements().statements_list) {
+				this->collect_effects(*stmt, fx);
+			}
+			break;
+		default:
+			// inline assembly may do anything at all
+			fx.has_call = true;
+			fx.has_indirect_store = true;
+			fx.opaque = true;
+			break;
+	}
+}
+
+void bounds_check_elimination::collect_effects(const Expression &e, effects &fx) const {
+	switch (e.get_expression_type()) {
+		case LIST:
+			for (auto member: static_cast<const ListExpression&>(e).get_list()) {
+				this->collect_effects(*member, fx);
+			}
+			break;
+		case INDEXED:
+		{
+			auto &idx = static_cast<const Indexed&>(e);
+			this->collect_effects(idx.get_to_index(), fx);
+			this->collect_effects(idx.get_index_value(), fx);
+			break;
+		}
+		case BINARY:
+		{
+			auto &b = static_cast<const Binary&>(e);
+			this->collect_effects(b.get_left(), fx);
+			this->collect_effects(b.get_right(), fx);
+			break;
+		}
+		case UNARY:
+			this->collect_effects(static_cast<const Unary&>(e).get_operand(), fx);
+			break;
+		case CALL_EXP:
+		case PROC_EXP:
+		{
+			auto &proc = static_cast<const Procedure&>(e);
+			fx.has_call = true;
+			this->collect_effects(proc.get_func_name(), fx);
+			for (auto arg: proc.get_args().get_list()) {
+				this->collect_effects(*arg, fx);
+			}
+			break;
+		}
+		case CAST:
+			this->collect_effects(static_cast<const Cast&>(e).get_exp(), fx);
+			break;
+		case ATTRIBUTE:
+			this->collect_effects(static_cast<const AttributeSelection&>(e).get_selected(), fx);
+			break;
+		default:
+			break;
+	}
+}
+
+void bounds_check_elimination::kill_facts(const std::string &name, bool keep_non_negative) {
+	this->facts.erase(
+		std::remove_if(this->facts.begin(), this->facts.end(), [&](const bound_fact &f) {
+			if (f.kind == bound_fact::NON_NEGATIVE && keep_non_negative) {
+				return false;
+			}
+			return f.index == name || f.array == name;
+		}),
+		this->facts.end()
+	);
+}
+
+void bounds_check_elimination::apply_effects(const effects &fx) {
+	/*
+
+	apply_effects
+	Removes every fact that may no longer hold once the given effects have happened
+
+	*/
+
+	if (fx.opaque) {
+		this->facts.clear();
+		return;
+	}
+
+	for (auto &w: fx.written) {
+		this->kill_facts(w.first, w.second);
+	}
+
+	if (fx.has_call || fx.has_indirect_store) {
+		// calls and indirect stores may modify globals, as well as any local whose address has escaped
+		auto may_be_modified = [&](const std::string &name) {
+			if (name.empty()) {
+				return false;
+			}
+			return !this->locals.is_local(name) || this->locals.is_address_taken(name);
+		};
+
+		this->facts.erase(
+			std::remove_if(this->facts.begin(), this->facts.end(), [&](const bound_fact &f) {
+				return may_be_modified(f.index) || may_be_modified(f.array);
+			}),
+			this->facts.end()
+		);
+	}
+}
+
+std::unique_ptr<Expression> bounds_check_elimination::transform_expression(const Expression &e) {
+	if (this->current_function.empty()) {
+		return ast_transform::transform_expression(e);
+	}
+
+	if (e.get_expression_type() == INDEXED) {
+		auto &idx = static_cast<const Indexed&>(e);
+		std::unique_ptr<Expression> t = ast_transform::transform_expression(e);
+
+		auto &count = this->counts.back().second;
+		if (!idx.is_bounds_checked()) {
+			count.first += 1;
+		}
+		else if (this->is_within_bounds(idx)) {
+			static_cast<Indexed&>(*t).remove_bounds_check();
+			count.first += 1;
+			this->changed = true;
+		}
+		else {
+			count.second += 1;
+		}
+
+		return t;
+	}
+	else if (e.get_expression_type() == BINARY && static_cast<const Binary&>(e).get_operator() == AND) {
+		// the right operand is only evaluated when the left is true
+		auto &b = static_cast<const Binary&>(e);
+		std::unique_ptr<Expression> left = this->transform_expression(b.get_left());
+
+		std::vector<bound_fact> saved = this->facts;
+		this->add_condition_facts(b.get_left());
+		std::unique_ptr<Expression> right = this->transform_expression(b.get_right());
+		this->facts = saved;
+
+		std::unique_ptr<Expression> t = std::make_unique<Binary>(std::move(left), std::move(right), AND);
+		if (e.is_const()) {
+			t->set_const();
+		}
+		return t;
+	}
+
+	return ast_transform::transform_expression(e);
+}
+
+std::unique_ptr<Statement> bounds_check_elimination::transform_statement(const Statement &s) {
+	if (s.get_statement_type() == FUNCTION_DEFINITION) {
+		auto &def = static_cast<const FunctionDefinition&>(s);
+
+		this->current_function = def.get_name();
+		this->locals.analyze(def);
+		this->facts.clear();
+		this->counts.push_back(std::make_pair(def.get_name(), std::make_pair(0u, 0u)));
+
+		std::unique_ptr<Statement> t = ast_transform::transform_statement(s);
+		this->current_function = "";
+		this->facts.clear();
+		return t;
+	}
+	else if (this->current_function.empty()) {
+		return ast_transform::transform_statement(s);
+	}
+
+	switch (s.get_statement_type()) {
+		case IF_THEN_ELSE:
+		{
+			// after the statement, only the facts that hold at the end of both branches remain
+			auto &ite = static_cast<const IfThenElse&>(s);
+			effects fx;
+			this->collect_effects(ite.get_condition(), fx);
+			this->apply_effects(fx);
+			std::unique_ptr<Expression> condition = this->transform_expression(ite.get_condition());
+
+			std::vector<bound_fact> saved = this->facts;
+			this->add_condition_facts(ite.get_condition());
+			std::unique_ptr<Statement> if_branch = this->transform_branch(ite.get_if_branch());
+			std::vector<bound_fact> if_facts = this->facts;
+
+			this->facts = saved;
+			std::unique_ptr<Statement> else_branch = this->transform_branch(ite.get_else_branch());
+
+			this->facts.erase(
+				std::remove_if(this->facts.begin(), this->facts.end(), [&](const bound_fact &f) {
+					return std::find(if_facts.begin(), if_facts.end(), f) == if_facts.end();
+				}),
+				this->facts.end()
+			);
+
+			std::unique_ptr<Statement> t = std::make_unique<IfThenElse>(std::move(condition), std::move(if_branch), std::move(else_branch));
+			t->set_line_number(s.get_line_number());
+			return t;
+		}
+		case WHILE_LOOP:
+		{
+			// only facts the loop can't invalidate hold at the top of every iteration
+			auto &loop = static_cast<const WhileLoop&>(s);
+			effects fx;
+			this->collect_effects(s, fx);
+			this->apply_effects(fx);
+
+			std::unique_ptr<Expression> condition = this->transform_expression(loop.get_condition());
+
+			std::vector<bound_fact> saved = this->facts;
+			this->add_condition_facts(loop.get_condition());
+			std::unique_ptr<Statement> branch = this->transform_branch(loop.get_branch());
+			this->facts = saved;
+
+			std::unique_ptr<Statement> t = std::make_unique<WhileLoop>(std::move(condition), std::move(branch));
+			t->set_line_number(s.get_line_number());
+			return t;
+		}
+		case SCOPE_BLOCK:
+			return ast_transform::transform_statement(s);
+		default:
+		{
+			// a call made by the statement may happen before any of its accesses, so its effects are applied first
+			effects fx;
+			this->collect_effects(s, fx);
+			if (fx.has_call || fx.has_indirect_store) {
+				this->apply_effects(fx);
+			}
+
+			std::unique_ptr<Statement> t = ast_transform::transform_statement(s);
+			this->apply_effects(fx);
+			this->add_write_facts(s);
+			return t;
+		}
+	}
+}
+
+bool bounds_check_elimination::run(StatementBlock &ast) {
+	/*
+
+	run
+	Collects the types of globals before transforming the program
+
+	*/
+
+	this->global_types.clear();
+	this->counts.clear();
+
+	for (auto s: ast.statements_list) {
+		if (s->get_statement_type() == ALLOCATION) {
+			auto &alloc = static_cast<const Allocation&>(*s);
+			this->global_types.emplace(alloc.get_name(), alloc.get_type_information());
+		}
+	}
+
+	this->current_function = "";
+	return ast_transform::run(ast);
+}
+
+void bounds_check_elimination::report() const {
+	for (auto &c: this->counts) {
+		unsigned int removed = c.second.first;
+		unsigned int kept = c.second.second;
+		if (removed + kept > 0) {
+			std::cout << "\t" << this->get_name() << ": '" << c.first << "' removed " << removed << " of " << (removed + kept) << " bounds check(s), kept " << kept << std::endl;
+		}
+	}
+}
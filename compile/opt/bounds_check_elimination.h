@@ -0,0 +1,92 @@
+/*
+
+SIN Toolchain (x86 target)
+opt/bounds_check_elimination.h
+Copyright 2021 Riley Lannon
+
+A pass to remove array bounds checks that can never fail
+
+*/
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+#include "ast_transform.h"
+#include "function_info.h"
+
+class bounds_check_elimination: public ast_transform {
+	/*
+
+	bounds_check_elimination
+	Proves indices to be within [0, len) and removes their runtime checks
+
+	Every indexed access normally compares its index against the length of the array (or string) and calls SINL_RTE_OUT_OF_BOUNDS if it is too large. This pass walks each function in order, keeping a set of facts about its integer variables:
+		* 'i' is non-negative -- if it is unsigned, was last assigned a non-negative literal, or was tested with 'i >= 0'; increments by a non-negative literal keep it so, which covers induction variables counting up from zero
+		* 'i' is less than 'a:len' -- from a loop or 'if' guard such as 'i < a:len', or the left side of an 'and'
+		* 'i' is less than a constant -- from a guard such as 'i < 10'
+	A fact is removed as soon as anything it depends on may be modified; before a loop, the facts are removed for anything the loop modifies, so the facts at the top of the body hold on every iteration.
+
+	An access 'a[i]' is within bounds if 'i' is non-negative and either less than 'a:len' or less than a constant that is no more than the length of 'a', when 'a' is a local or global 'array<N, T>' with a literal length. A literal index into such an array is checked directly.
+
+	*/
+
+	struct bound_fact {
+		enum fact_kind {
+			NON_NEGATIVE,
+			BELOW_LENGTH,
+			BELOW_CONSTANT
+		} kind;
+
+		std::string index;
+		std::string array;	// for BELOW_LENGTH
+		long long bound;	// for BELOW_CONSTANT
+
+		bool operator==(const bound_fact &right) const;
+	};
+
+	struct effects {
+		std::unordered_map<std::string, bool> written;	// name -> whether every write leaves it non-negative
+		bool has_call;
+		bool has_indirect_store;
+		bool opaque;	// inline assembly
+
+		effects();
+	};
+
+	std::vector<bound_fact> facts;
+
+	std::unordered_map<std::string, DataType> global_types;
+	std::string current_function;
+	function_info locals;
+
+	// the number of checks removed and kept in each function, for the report
+	std::vector<std::pair<std::string, std::pair<unsigned int, unsigned int>>> counts;
+
+	static bool get_int_literal(const Expression &e, long long &value);
+	static bool keeps_non_negative(const std::string &name, const Expression &rvalue);
+
+	bool get_name_type(const std::string &name, DataType &t) const;
+	bool get_fixed_length(const std::string &array, long long &length) const;
+	bool has_fact(const bound_fact &f) const;
+	bool is_within_bounds(const Indexed &idx) const;
+
+	void add_fact(const bound_fact &f);
+	void add_condition_facts(const Expression &condition);
+	void add_write_facts(const Statement &s);
+
+	void collect_effects(const Statement &s, effects &fx) const;
+	void collect_effects(const Expression &e, effects &fx) const;
+	void write_lvalue(const Expression &lvalue, bool keeps_non_negative, effects &fx) const;
+	void apply_effects(const effects &fx);
+	void kill_facts(const std::string &name, bool keep_non_negative);
+protected:
+	std::unique_ptr<Statement> transform_statement(const Statement &s) override;
+	std::unique_ptr<Expression> transform_expression(const Expression &e) override;
+public:
+	std::string get_name() const override;
+	bool run(StatementBlock &ast) override;
+	void report() const override;
+};
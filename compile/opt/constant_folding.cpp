@@ -0,0 +1,340 @@
+/*
+
+SIN Toolchain (x86 target)
+opt/constant_folding.cpp
+Copyright 2021 Riley Lannon
+
+Implementation of the constant folding pass
+
+*/
+
+#include <iostream>
+#include <limits>
+
+#include "constant_folding.h"
+#include "../../util/data_widths.h"
+#include "../../util/Exceptions.h"
+
+std::string constant_folding::get_name() const {
+	return "constant-folding";
+}
+
+bool constant_folding::get_int_value(const Expression &e, uint64_t &value) {
+	/*
+
+	get_int_value
+	Gets the value of an integer literal, if it may be folded
+
+	Only plain 'int' literals are considered; integer literals are always written in base 10
+
+	*/
+
+	if (e.get_expression_type() != LITERAL) {
+		return false;
+	}
+
+	auto &literal = static_cast<const Literal&>(e);
+	if (literal.get_data_type().get_primary() != INT || literal.get_data_type().get_width() != sin_widths::INT_WIDTH) {
+		return false;
+	}
+
+	try {
+		value = std::stoull(literal.get_value(), nullptr, 10);
+	}
+	catch (std::exception &e) {
+		return false;
+	}
+
+	return value <= (uint64_t)std::numeric_limits<int32_t>::max();
+}
+
+bool constant_folding::get_bool_value(const Expression &e, bool &value) {
+	if (e.get_expression_type() != LITERAL) {
+		return false;
+	}
+
+	auto &literal = static_cast<const Literal&>(e);
+	if (literal.get_data_type().get_primary() != BOOL) {
+		return false;
+	}
+	else if (literal.get_value() == "true") {
+		value = true;
+	}
+	else if (literal.get_value() == "false") {
+		value = false;
+	}
+	else {
+		return false;
+	}
+
+	return true;
+}
+
+std::unique_ptr<Expression> constant_folding::fold_binary(const Binary &b) {
+	/*
+
+	fold_binary
+	Attempts to fold a binary expression whose operands have already been folded
+
+	@param	b	The expression to fold
+	@return	The resulting literal, or nullptr if it could not be folded
+
+	*/
+
+	exp_operator op = b.get_operator();
+	uint64_t left, right;
+	bool left_b, right_b;
+
+	if (get_int_value(b.get_left(), left) && get_int_value(b.get_right(), right)) {
+		uint64_t result;
+
+		// both operands are in [0, INT32_MAX], so no operation here can overflow 64 bits
+		switch (op) {
+			case PLUS:
+				result = left + right;
+				break;
+			case MINUS:
+				if (right > left) return nullptr;
+				result = left - right;
+				break;
+			case MULT:
+				result = left * right;
+				break;
+			case DIV:
+				if (right == 0) return nullptr;
+				result = left / right;
+				break;
+			case MODULO:
+				if (right == 0) return nullptr;
+				result = left % right;
+				break;
+			case BIT_AND:
+				result = left & right;
+				break;
+			case BIT_OR:
+				result = left | right;
+				break;
+			case BIT_XOR:
+				result = left ^ right;
+				break;
+			case LEFT_SHIFT:
+				if (right >= 32) return nullptr;
+				result = left << right;
+				break;
+			case RIGHT_SHIFT:
+				if (right >= 32) return nullptr;
+				result = left >> right;
+				break;
+			case EQUAL:
+				return std::make_unique<Literal>(BOOL, (left == right) ? "true" : "false");
+			case NOT_EQUAL:
+				return std::make_unique<Literal>(BOOL, (left != right) ? "true" : "false");
+			case GREATER:
+				return std::make_unique<Literal>(BOOL, (left > right) ? "true" : "false");
+			case LESS:
+				return std::make_unique<Literal>(BOOL, (left < right) ? "true" : "false");
+			case GREATER_OR_EQUAL:
+				return std::make_unique<Literal>(BOOL, (left >= right) ? "true" : "false");
+			case LESS_OR_EQUAL:
+				return std::make_unique<Literal>(BOOL, (left <= right) ? "true" : "false");
+			default:
+				return nullptr;
+		}
+
+		// results that don't fit in a signed int would depend on the signedness of the expression
+		if (result > (uint64_t)std::numeric_limits<int32_t>::max()) {
+			return nullptr;
+		}
+
+		auto &left_literal = static_cast<const Literal&>(b.get_left());
+		return std::make_unique<Literal>(left_literal.get_data_type(), std::to_string(result));
+	}
+	else if (get_bool_value(b.get_left(), left_b) && get_bool_value(b.get_right(), right_b)) {
+		bool result;
+
+		switch (op) {
+			case AND:
+				result = left_b && right_b;
+				break;
+			case OR:
+				result = left_b || right_b;
+				break;
+			case XOR:
+			case NOT_EQUAL:
+				result = left_b != right_b;
+				break;
+			case EQUAL:
+				result = left_b == right_b;
+				break;
+			default:
+				return nullptr;
+		}
+
+		return std::make_unique<Literal>(BOOL, result ? "true" : "false");
+	}
+
+	return nullptr;
+}
+
+std::unique_ptr<Expression> constant_folding::fold_unary(const Unary &u) {
+	bool value;
+	uint64_t int_value;
+
+	if (u.get_operator() == NOT && get_bool_value(u.get_operand(), value)) {
+		return std::make_unique<Literal>(BOOL, value ? "false" : "true");
+	}
+	else if (u.get_operator() == UNARY_PLUS && get_int_value(u.get_operand(), int_value)) {
+		return u.get_operand().clone();
+	}
+
+	return nullptr;
+}
+
+std::unique_ptr<Expression> constant_folding::fold_call(const Procedure &call) {
+	/*
+
+	fold_call
+	Attempts to evaluate a call whose arguments have already been folded
+
+	@param	call	The call to fold
+	@return	The literal result of the call, or nullptr if it could not be evaluated
+
+	*/
+
+	if (call.get_func_name().get_expression_type() != IDENTIFIER) {
+		return nullptr;
+	}
+
+	// the arguments must be known, and they form the key for the call's result
+	std::string key = static_cast<const Identifier&>(call.get_func_name()).getValue() + "(";
+	for (size_t i = 0; i < call.get_num_args(); i++) {
+		const Expression *arg = &call.get_arg(i);
+		if (arg->get_expression_type() == IDENTIFIER) {
+			auto it = this->global_constants.find(static_cast<const Identifier&>(*arg).getValue());
+			if (it == this->global_constants.end()) {
+				return nullptr;
+			}
+			arg = it->second.get();
+		}
+
+		if (arg->get_expression_type() != LITERAL) {
+			return nullptr;
+		}
+
+		auto &literal = static_cast<const Literal&>(*arg);
+		key += literal.get_value() + ":" + std::to_string(literal.get_data_type().get_primary()) + ":" +
+			std::to_string(literal.get_data_type().get_width()) + ":" + std::to_string(literal.get_data_type().get_qualities().is_signed()) + ",";
+	}
+	key += ")";
+
+	auto cached = this->call_results.find(key);
+	if (cached == this->call_results.end()) {
+		std::unique_ptr<Literal> result = this->interp.evaluate(call, [this](const std::string &name) -> std::unique_ptr<Literal> {
+			auto it = this->global_constants.find(name);
+			if (it == this->global_constants.end()) {
+				return nullptr;
+			}
+			return std::make_unique<Literal>(it->second->get_data_type(), it->second->get_value());
+		});
+		cached = this->call_results.insert(std::make_pair(key, std::move(result))).first;
+	}
+
+	if (!cached->second) {
+		return nullptr;
+	}
+
+	this->folded_calls.push_back(std::make_pair(static_cast<const Identifier&>(call.get_func_name()).getValue(), this->current_line));
+	return std::make_unique<Literal>(cached->second->get_data_type(), cached->second->get_value());
+}
+
+std::unique_ptr<Statement> constant_folding::transform_statement(const Statement &s) {
+	unsigned int previous_line = this->current_line;
+	bool top_level = this->at_top_level;
+
+	this->current_line = s.get_line_number();
+	if (s.get_statement_type() == FUNCTION_DEFINITION || s.get_statement_type() == STRUCT_DEFINITION) {
+		this->at_top_level = false;
+	}
+
+	std::unique_ptr<Statement> t = ast_transform::transform_statement(s);
+
+	this->current_line = previous_line;
+	this->at_top_level = top_level;
+
+	// a global constant whose initializer folded to a literal may be used by the calls that follow it
+	if (top_level && t && t->get_statement_type() == ALLOCATION) {
+		auto &alloc = static_cast<const Allocation&>(*t);
+		const Expression *init = alloc.get_initial_value();
+		if (alloc.get_type_information().get_qualities().is_const() && init && init->get_expression_type() == LITERAL) {
+			auto &literal = static_cast<const Literal&>(*init);
+			this->global_constants[alloc.get_name()] = std::make_unique<Literal>(literal.get_data_type(), literal.get_value());
+		}
+	}
+
+	return t;
+}
+
+std::unique_ptr<Expression> constant_folding::transform_expression(const Expression &e) {
+	// fold the subexpressions first
+	std::unique_ptr<Expression> t = ast_transform::transform_expression(e);
+	std::unique_ptr<Expression> folded;
+
+	if (t->get_expression_type() == BINARY) {
+		folded = this->fold_binary(static_cast<const Binary&>(*t));
+	}
+	else if (t->get_expression_type() == UNARY) {
+		folded = this->fold_unary(static_cast<const Unary&>(*t));
+	}
+	else if (t->get_expression_type() == CALL_EXP) {
+		folded = this->fold_call(static_cast<const Procedure&>(*t));
+	}
+
+	if (folded) {
+		folded->set_const();
+		this->changed = true;
+		return folded;
+	}
+
+	return t;
+}
+
+bool constant_folding::run(StatementBlock &ast) {
+	/*
+
+	run
+	Makes the program's functions available to the interpreter before transforming it
+
+	The interpreter refers to the definitions in the original tree, which remains valid until the transformed tree replaces it
+
+	*/
+
+	this->interp.clear_functions();
+	for (auto s: ast.statements_list) {
+		if (s->get_statement_type() == FUNCTION_DEFINITION) {
+			this->interp.add_function(static_cast<const FunctionDefinition&>(*s));
+		}
+	}
+
+	this->global_constants.clear();
+	this->at_top_level = true;
+	bool changed = ast_transform::run(ast);
+	this->interp.clear_functions();
+
+	return changed;
+}
+
+void constant_folding::report() const {
+	for (auto &c: this->folded_calls) {
+		compiler_note("Call to '" + c.first + "' was evaluated at compile time", c.second);
+	}
+
+	if (!this->folded_calls.empty()) {
+		std::cout << "\t" << this->get_name() << ": evaluated " << this->folded_calls.size() << " call(s) at compile time" << std::endl;
+	}
+}
+
+constant_folding::constant_folding()
+	: at_top_level(true)
+	, current_line(0)
+{
+}
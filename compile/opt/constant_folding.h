@@ -0,0 +1,56 @@
+/*
+
+SIN Toolchain (x86 target)
+opt/constant_folding.h
+Copyright 2021 Riley Lannon
+
+A pass to fold operations on literal values
+
+*/
+
+#pragma once
+
+#include <cinttypes>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+#include "ast_transform.h"
+#include "../compile_util/interpreter.h"
+
+class constant_folding: public ast_transform {
+	/*
+
+	constant_folding
+	Replaces expressions whose operands are all literals with the literal result
+
+	Only results which are identical under both signed and unsigned interpretation are folded, so the pass never has to decide the signedness of an expression; anything else is left for the code generator.
+
+	Calls to functions defined in the file whose arguments are all literals (or global constants) are executed by the interpreter; if the function is pure and finishes within the interpreter's limits, the call is replaced by its result. The results of calls -- including those that couldn't be evaluated -- are remembered between runs, as a function's behavior doesn't change when other passes rewrite it.
+
+	*/
+
+	interpreter interp;
+	std::unordered_map<std::string, std::unique_ptr<Literal>> global_constants;	// global constants whose initializers have been folded
+	std::unordered_map<std::string, std::unique_ptr<Literal>> call_results;	// keyed by the function name and argument values; nullptr if the call can't be evaluated
+
+	bool at_top_level;
+	unsigned int current_line;
+	std::vector<std::pair<std::string, unsigned int>> folded_calls;
+
+	static bool get_int_value(const Expression &e, uint64_t &value);
+	static bool get_bool_value(const Expression &e, bool &value);
+
+	std::unique_ptr<Expression> fold_binary(const Binary &b);
+	std::unique_ptr<Expression> fold_unary(const Unary &u);
+	std::unique_ptr<Expression> fold_call(const Procedure &call);
+protected:
+	std::unique_ptr<Statement> transform_statement(const Statement &s) override;
+	std::unique_ptr<Expression> transform_expression(const Expression &e) override;
+public:
+	std::string get_name() const override;
+	bool run(StatementBlock &ast) override;
+	void report() const override;
+
+	constant_folding();
+};
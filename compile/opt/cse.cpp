@@ -0,0 +1,822 @@
+/*
+
+SIN Toolchain (x86 target)
+opt/cse.cpp
+Copyright 2021 Riley Lannon
+
+Implementation of the common subexpression elimination pass
+
+*/
+
+#include <iostream>
+
+#include "cse.h"
+#include "../../util/Exceptions.h"
+
+std::string cse::get_name() const {
+	return "cse";
+}
+
+bool cse::contains_call(const Expression &e) {
+	switch (e.get_expression_type()) {
+		case CALL_EXP:
+		case PROC_EXP:
+			return true;
+		case LIST:
+			for (auto member: static_cast<const ListExpression&>(e).get_list()) {
+				if (contains_call(*member)) {
+					return true;
+				}
+			}
+			return false;
+		case INDEXED:
+		{
+			auto &idx = static_cast<const Indexed&>(e);
+			return contains_call(idx.get_to_index()) || contains_call(idx.get_index_value());
+		}
+		case BINARY:
+		{
+			auto &b = static_cast<const Binary&>(e);
+			return contains_call(b.get_left()) || contains_call(b.get_right());
+		}
+		case UNARY:
+			return contains_call(static_cast<const Unary&>(e).get_operand());
+		case CAST:
+			return contains_call(static_cast<const Cast&>(e).get_exp());
+		case ATTRIBUTE:
+			return contains_call(static_cast<const AttributeSelection&>(e).get_selected());
+		default:
+			return false;
+	}
+}
+
+bool cse::is_lvalue(const Expression &e) {
+	// an argument that names an object may be bound to a reference parameter, so it can't become a temporary
+	exp_type type = e.get_expression_type();
+	return type == IDENTIFIER || type == INDEXED || (type == BINARY && static_cast<const Binary&>(e).get_operator() == DOT);
+}
+
+void cse::collect_names(const Expression &e, std::vector<std::string> &names) {
+	switch (e.get_expression_type()) {
+		case IDENTIFIER:
+			names.push_back(static_cast<const Identifier&>(e).getValue());
+			break;
+		case INDEXED:
+		{
+			auto &idx = static_cast<const Indexed&>(e);
+			collect_names(idx.get_to_index(), names);
+			collect_names(idx.get_index_value(), names);
+			break;
+		}
+		case ATTRIBUTE:
+			collect_names(static_cast<const AttributeSelection&>(e).get_selected(), names);
+			break;
+		case BINARY:
+		{
+			// the right side of a member selection is a member, not a name
+			auto &b = static_cast<const Binary&>(e);
+			collect_names(b.get_left(), names);
+			if (b.get_operator() != DOT) {
+				collect_names(b.get_right(), names);
+			}
+			break;
+		}
+		case UNARY:
+			collect_names(static_cast<const Unary&>(e).get_operand(), names);
+			break;
+		default:
+			break;
+	}
+}
+
+bool cse::is_pure(const Expression &e) const {
+	/*
+
+	is_pure
+	Determines whether an expression computes a value only from the names it contains, without faulting (other than in a bounds check) or side effects
+
+	*/
+
+	switch (e.get_expression_type()) {
+		case LITERAL:
+			return true;
+		case IDENTIFIER:
+		{
+			// a reference may refer to anything
+			DataType t;
+			return this->program.get_name_type(this->locals, static_cast<const Identifier&>(e).getValue(), t) && t.get_primary() != REFERENCE;
+		}
+		case INDEXED:
+		{
+			// the array must be a name or a member, not a value computed from one
+			auto &idx = static_cast<const Indexed&>(e);
+			exp_type array = idx.get_to_index().get_expression_type();
+			return (array == IDENTIFIER || (array == BINARY && static_cast<const Binary&>(idx.get_to_index()).get_operator() == DOT)) &&
+				this->is_pure(idx.get_to_index()) && this->is_pure(idx.get_index_value());
+		}
+		case ATTRIBUTE:
+		{
+			auto &attr = static_cast<const AttributeSelection&>(e);
+			return attr.get_attribute() == LENGTH && attr.get_selected().get_expression_type() == IDENTIFIER && this->is_pure(attr.get_selected());
+		}
+		case BINARY:
+		{
+			auto &b = static_cast<const Binary&>(e);
+			switch (b.get_operator()) {
+				case DOT:
+				{
+					exp_type left = b.get_left().get_expression_type();
+					return b.get_right().get_expression_type() == IDENTIFIER &&
+						(left == IDENTIFIER || (left == BINARY && static_cast<const Binary&>(b.get_left()).get_operator() == DOT)) &&
+						this->is_pure(b.get_left());
+				}
+				case PLUS:
+				case MINUS:
+				case MULT:
+				case BIT_AND:
+				case BIT_OR:
+				case BIT_XOR:
+				case LEFT_SHIFT:
+				case RIGHT_SHIFT:
+				{
+					// operands of different widths are extended by the generated code, which a temporary of either type wouldn't reproduce
+					DataType left, right;
+					return this->is_pure(b.get_left()) && this->is_pure(b.get_right()) &&
+						this->program.get_type(this->locals, b.get_left(), left) && this->program.get_type(this->locals, b.get_right(), right) &&
+						left.get_primary() == right.get_primary() && left.get_width() == right.get_width();
+				}
+				default:
+					// division may fault, and the remaining operators aren't worth a temporary
+					return false;
+			}
+		}
+		case UNARY:
+		{
+			auto &u = static_cast<const Unary&>(e);
+			return (u.get_operator() == UNARY_MINUS || u.get_operator() == BIT_NOT) && this->is_pure(u.get_operand());
+		}
+		default:
+			return false;
+	}
+}
+
+bool cse::assigns_vector(const Assignment &a) const {
+	// an array element assigned to a vector is loaded along with those following it (see compiler::assign_vector)
+	DataType t;
+	return this->program.get_type(this->locals, a.get_lvalue(), t) && t.get_primary() == VECTOR;
+}
+
+bool cse::is_candidate(const Expression &e) const {
+	// a computation (not a plain load) on primitives, from at least one name, that isn't already a compile-time constant
+	exp_type type = e.get_expression_type();
+	if ((type != INDEXED && type != ATTRIBUTE && type != BINARY && type != UNARY) || e.is_const() || !this->is_pure(e)) {
+		return false;
+	}
+
+	std::vector<std::string> names;
+	collect_names(e, names);
+
+	DataType t;
+	if (names.empty() || !this->program.get_type(this->locals, e, t)) {
+		return false;
+	}
+
+	Type p = t.get_primary();
+	return p == INT || p == FLOAT || p == BOOL || p == CHAR;
+}
+
+void cse::count_candidates(const Expression &e, bool unconditional, std::unordered_map<std::string, unsigned int> &counts, std::unordered_map<std::string, const Expression*> &found) const {
+	/*
+
+	count_candidates
+	Counts the occurrences of each candidate computation in an expression (including those nested within other candidates)
+
+	@param	unconditional	If true, only occurrences that are always evaluated with the expression are counted
+
+	*/
+
+	if (this->is_candidate(e)) {
+		std::string key = program_info::expression_key(e);
+		if (!key.empty()) {
+			counts[key] += 1;
+			found.emplace(key, &e);
+		}
+	}
+
+	switch (e.get_expression_type()) {
+		case LIST:
+			for (auto member: static_cast<const ListExpression&>(e).get_list()) {
+				this->count_candidates(*member, unconditional, counts, found);
+			}
+			break;
+		case INDEXED:
+		{
+			auto &idx = static_cast<const Indexed&>(e);
+			this->count_candidates(idx.get_to_index(), unconditional, counts, found);
+			this->count_candidates(idx.get_index_value(), unconditional, counts, found);
+			break;
+		}
+		case BINARY:
+		{
+			auto &b = static_cast<const Binary&>(e);
+			this->count_candidates(b.get_left(), unconditional, counts, found);
+			if (!unconditional || (b.get_operator() != AND && b.get_operator() != OR)) {
+				this->count_candidates(b.get_right(), unconditional, counts, found);
+			}
+			break;
+		}
+		case UNARY:
+		{
+			auto &u = static_cast<const Unary&>(e);
+			if (u.get_operator() != ADDRESS) {
+				this->count_candidates(u.get_operand(), unconditional, counts, found);
+			}
+			break;
+		}
+		case CALL_EXP:
+		case PROC_EXP:
+			for (auto arg: static_cast<const Procedure&>(e).get_args().get_list()) {
+				if (!is_lvalue(*arg)) {
+					this->count_candidates(*arg, unconditional, counts, found);
+				}
+			}
+			break;
+		case CAST:
+			this->count_candidates(static_cast<const Cast&>(e).get_exp(), unconditional, counts, found);
+			break;
+		case ATTRIBUTE:
+			this->count_candidates(static_cast<const AttributeSelection&>(e).get_selected(), unconditional, counts, found);
+			break;
+		default:
+			break;
+	}
+}
+
+void cse::count_candidates(const Statement &s, std::unordered_map<std::string, unsigned int> &counts, std::unordered_map<std::string, const Expression*> &found) const {
+	// counts every occurrence in a statement that the transform could rewrite
+	switch (s.get_statement_type()) {
+		case ALLOCATION:
+		{
+			auto &alloc = static_cast<const Allocation&>(s);
+			Type p = alloc.get_type_information().get_primary();
+			if (alloc.get_initial_value() && p != REFERENCE && p != VECTOR) {
+				this->count_candidates(*alloc.get_initial_value(), false, counts, found);
+			}
+			break;
+		}
+		case ASSIGNMENT:
+			if (!this->assigns_vector(static_cast<const Assignment&>(s))) {
+				this->count_candidates(static_cast<const Assignment&>(s).get_rvalue(), false, counts, found);
+			}
+			break;
+		case COMPOUND_ASSIGNMENT:
+			this->count_candidates(static_cast<const Binary&>(static_cast<const Assignment&>(s).get_rvalue()).get_right(), false, counts, found);
+			break;
+		case RETURN_STATEMENT:
+			if (!this->returns_reference) {
+				this->count_candidates(static_cast<const ReturnStatement&>(s).get_return_exp(), false, counts, found);
+			}
+			break;
+		case CALL:
+			this->count_candidates(static_cast<const Expression&>(static_cast<const Call&>(s)), false, counts, found);
+			break;
+		case IF_THEN_ELSE:
+		{
+			auto &ite = static_cast<const IfThenElse&>(s);
+			this->count_candidates(ite.get_condition(), false, counts, found);
+			if (ite.get_if_branch()) this->count_candidates(*ite.get_if_branch(), counts, found);
+			if (ite.get_else_branch()) this->count_candidates(*ite.get_else_branch(), counts, found);
+			break;
+		}
+		case WHILE_LOOP:
+		{
+			auto &loop = static_cast<const WhileLoop&>(s);
+			this->count_candidates(loop.get_condition(), false, counts, found);
+			if (loop.get_branch()) this->count_candidates(*loop.get_branch(), counts, found);
+			break;
+		}
+		case SCOPE_BLOCK:
+			for (auto stmt: static_cast<const ScopedBlock&>(s).get_statements().statements_list) {
+				this->count_candidates(*stmt, counts, found);
+			}
+			break;
+		default:
+			break;
+	}
+}
+
+bool cse::get_straight_line_expressions(const Statement &s, std::vector<const Expression*> &exps) const {
+	/*
+
+	get_straight_line_expressions
+	Gets the expressions a statement evaluates before it has any effect, i.e., those whose computations may be moved into temporaries allocated before it
+
+	Returns false if temporaries can't be allocated for the statement
+
+	*/
+
+	switch (s.get_statement_type()) {
+		case ALLOCATION:
+		{
+			// static initializers are evaluated elsewhere, and our own temporaries are left alone so that a second run doesn't stack them
+			// an element assigned to a vector is loaded along with those following it, so it can't be replaced with a temporary
+			auto &alloc = static_cast<const Allocation&>(s);
+			const DataType &t = alloc.get_type_information();
+			if (t.get_primary() == REFERENCE || t.get_primary() == VECTOR || t.get_qualities().is_static() || alloc.get_name().compare(0, 5, "__cse") == 0) {
+				return false;
+			}
+			if (alloc.get_initial_value()) {
+				exps.push_back(alloc.get_initial_value());
+			}
+			break;
+		}
+		case ASSIGNMENT:
+			if (this->assigns_vector(static_cast<const Assignment&>(s))) {
+				return false;
+			}
+			exps.push_back(&static_cast<const Assignment&>(s).get_rvalue());
+			break;
+		case COMPOUND_ASSIGNMENT:
+			exps.push_back(&static_cast<const Binary&>(static_cast<const Assignment&>(s).get_rvalue()).get_right());
+			break;
+		case RETURN_STATEMENT:
+			if (this->returns_reference) {
+				return false;
+			}
+			exps.push_back(&static_cast<const ReturnStatement&>(s).get_return_exp());
+			break;
+		case CALL:
+			exps.push_back(&static_cast<const Expression&>(static_cast<const Call&>(s)));
+			break;
+		case IF_THEN_ELSE:
+			exps.push_back(&static_cast<const IfThenElse&>(s).get_condition());
+			break;
+		default:
+			return false;
+	}
+
+	// a call's arguments are evaluated before it, but anything evaluated after a call may observe its effects
+	for (auto e: exps) {
+		if (e->get_expression_type() == CALL_EXP) {
+			for (auto arg: static_cast<const Procedure&>(*e).get_args().get_list()) {
+				if (contains_call(*arg)) {
+					return false;
+				}
+			}
+		}
+		else if (contains_call(*e)) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool cse::is_killed(const Expression &e, const program_info::effects &fx) const {
+	std::vector<std::string> names;
+	collect_names(e, names);
+	for (auto &name: names) {
+		if (this->program.may_modify(this->locals, fx, name)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+void cse::kill(const program_info::effects &fx) {
+	for (auto it = this->available.begin(); it != this->available.end(); ) {
+		bool killed = false;
+		for (auto &name: it->second.names) {
+			if (this->program.may_modify(this->locals, fx, name)) {
+				killed = true;
+				break;
+			}
+		}
+
+		if (killed) {
+			it = this->available.erase(it);
+		}
+		else {
+			++it;
+		}
+	}
+}
+
+void cse::plan(const StatementBlock &block, size_t index) {
+	/*
+
+	plan
+	Determines which computations in a statement should be stored in temporaries
+
+	A computation gets a temporary if it occurs more than once before its value may change -- later in the same statement, or in the statements that follow it in the block
+
+	*/
+
+	this->wanted.clear();
+
+	const Statement &s = *block.statements_list[index];
+	std::vector<const Expression*> exps;
+	if (!this->get_straight_line_expressions(s, exps)) {
+		return;
+	}
+
+	std::unordered_map<std::string, unsigned int> counts;
+	std::unordered_map<std::string, const Expression*> found;
+	for (auto e: exps) {
+		this->count_candidates(*e, true, counts, found);
+	}
+
+	// occurrences in the statement's branches may use a temporary if the statement doesn't modify its names first
+	program_info::effects own;
+	this->program.collect_effects(this->locals, s, own);
+
+	std::unordered_map<std::string, unsigned int> all_counts;
+	std::unordered_map<std::string, const Expression*> all_found;
+	this->count_candidates(s, all_counts, all_found);
+
+	std::vector<std::string> open;
+	for (auto &c: counts) {
+		if (this->available.count(c.first)) {
+			continue;
+		}
+
+		bool killed = this->is_killed(*found[c.first], own);
+		unsigned int total = killed ? c.second : all_counts[c.first];
+		if (total > 1) {
+			this->wanted.insert(c.first);
+		}
+		else if (!killed) {
+			open.push_back(c.first);
+		}
+	}
+
+	for (size_t i = index + 1; i < block.statements_list.size() && !open.empty(); i++) {
+		const Statement &next = *block.statements_list[i];
+
+		program_info::effects fx;
+		this->program.collect_effects(this->locals, next, fx);
+
+		std::unordered_map<std::string, unsigned int> next_counts;
+		std::unordered_map<std::string, const Expression*> next_found;
+		this->count_candidates(next, next_counts, next_found);
+
+		// if the statement modifies a name, only what it evaluates first sees the old value
+		std::unordered_map<std::string, unsigned int> first_counts;
+		std::unordered_map<std::string, const Expression*> first_found;
+		std::vector<const Expression*> first;
+		if (this->get_straight_line_expressions(next, first)) {
+			for (auto e: first) {
+				this->count_candidates(*e, true, first_counts, first_found);
+			}
+		}
+
+		std::vector<std::string> still_open;
+		for (auto &key: open) {
+			if (this->is_killed(*found[key], fx)) {
+				if (first_counts.count(key)) {
+					this->wanted.insert(key);
+				}
+			}
+			else if (next_counts.count(key)) {
+				this->wanted.insert(key);
+			}
+			else {
+				still_open.push_back(key);
+			}
+		}
+		open = still_open;
+	}
+}
+
+std::unique_ptr<Procedure> cse::transform_call(const Procedure &proc) {
+	// the name (which may include the object of a method call) and arguments that name objects are left as they are
+	this->frozen += 1;
+	std::unique_ptr<Expression> name = this->transform_expression(proc.get_func_name());
+	this->frozen -= 1;
+
+	std::vector<std::unique_ptr<Expression>> args;
+	for (auto arg: proc.get_args().get_list()) {
+		if (is_lvalue(*arg)) {
+			this->frozen += 1;
+			args.push_back(this->transform_expression(*arg));
+			this->frozen -= 1;
+		}
+		else {
+			args.push_back(this->transform_expression(*arg));
+		}
+	}
+
+	return std::make_unique<Procedure>(std::move(name), std::make_unique<ListExpression>(args, proc.get_args().get_list_type()));
+}
+
+std::unique_ptr<Expression> cse::transform_expression(const Expression &e) {
+	if (this->frozen > 0 || (e.get_expression_type() == UNARY && static_cast<const Unary&>(e).get_operator() == ADDRESS)) {
+		// the address of an element or member must not become the address of a temporary
+		std::unique_ptr<Expression> t = e.clone();
+		if (e.is_const()) {
+			t->set_const();
+		}
+		return t;
+	}
+
+	if (!this->current_function.empty() && this->is_candidate(e)) {
+		std::string key = program_info::expression_key(e);
+		auto it = this->available.find(key);
+		if (!key.empty() && it != this->available.end()) {
+			this->changed = true;
+			this->reused_count += 1;
+			this->function_reused += 1;
+			return std::make_unique<Identifier>(it->second.temp);
+		}
+		else if (!key.empty() && this->conditional == 0 && this->wanted.count(key)) {
+			std::string name = "__cse" + std::to_string(++this->temp_count);
+
+			DataType t;
+			this->program.get_type(this->locals, e, t);
+			t.remove_quality(CONSTANT);
+			t.remove_quality(FINAL);
+			t.remove_quality(STATIC);
+			t.remove_quality(DYNAMIC);
+			t.remove_quality(EXTERN);
+
+			// the temporary's own initializer may reuse values, too
+			std::unique_ptr<Statement> temp = std::make_unique<Allocation>(t, name, true, ast_transform::transform_expression(e));
+			temp->set_line_number(this->line);
+			this->pending.push_back(std::move(temp));
+
+			value v;
+			v.temp = name;
+			v.depth = this->depth;
+			collect_names(e, v.names);
+			this->available[key] = v;
+
+			this->changed = true;
+			return std::make_unique<Identifier>(name);
+		}
+	}
+
+	switch (e.get_expression_type()) {
+		case BINARY:
+		{
+			// the right operand of 'and' and 'or' isn't always evaluated
+			auto &b = static_cast<const Binary&>(e);
+			if (b.get_operator() != AND && b.get_operator() != OR) {
+				break;
+			}
+
+			std::unique_ptr<Expression> left = this->transform_expression(b.get_left());
+			this->conditional += 1;
+			std::unique_ptr<Expression> right = this->transform_expression(b.get_right());
+			this->conditional -= 1;
+
+			std::unique_ptr<Expression> t = std::make_unique<Binary>(std::move(left), std::move(right), b.get_operator());
+			if (e.is_const()) {
+				t->set_const();
+			}
+			return t;
+		}
+		case CALL_EXP:
+		{
+			auto proc = this->transform_call(static_cast<const Procedure&>(e));
+			std::unique_ptr<Expression> t = std::make_unique<CallExpression>(proc.get());
+			if (e.is_const()) {
+				t->set_const();
+			}
+			return t;
+		}
+		case PROC_EXP:
+		{
+			std::unique_ptr<Expression> t = this->transform_call(static_cast<const Procedure&>(e));
+			if (e.is_const()) {
+				t->set_const();
+			}
+			return t;
+		}
+		default:
+			break;
+	}
+
+	return ast_transform::transform_expression(e);
+}
+
+std::unique_ptr<Statement> cse::transform_statement(const Statement &s) {
+	if (s.get_statement_type() == FUNCTION_DEFINITION) {
+		auto &def = static_cast<const FunctionDefinition&>(s);
+
+		this->current_function = def.get_name();
+		this->returns_reference = def.get_type_information().get_primary() == REFERENCE;
+		this->locals.analyze(def);
+		this->available.clear();
+		this->function_reused = 0;
+
+		std::unique_ptr<Statement> t = ast_transform::transform_statement(s);
+		if (this->function_reused > 0) {
+			this->reused.push_back(std::make_pair(
+				"Reused " + std::to_string(this->function_reused) + " previously computed value(s) in '" + this->current_function + "'",
+				s.get_line_number()
+			));
+		}
+
+		this->current_function = "";
+		this->available.clear();
+		return t;
+	}
+	else if (this->current_function.empty()) {
+		return ast_transform::transform_statement(s);
+	}
+
+	std::unique_ptr<Statement> t;
+	switch (s.get_statement_type()) {
+		case ALLOCATION:
+		{
+			// references, statics, and our own temporaries are copied as they are
+			std::vector<const Expression*> exps;
+			bool freeze = !this->get_straight_line_expressions(s, exps);
+			this->frozen += freeze;
+			t = ast_transform::transform_statement(s);
+			this->frozen -= freeze;
+			return t;
+		}
+		case ASSIGNMENT:
+		{
+			auto &assign = static_cast<const Assignment&>(s);
+			bool freeze = this->assigns_vector(assign);
+			this->frozen += 1;
+			std::unique_ptr<Expression> lvalue = this->transform_expression(assign.get_lvalue());
+			this->frozen -= 1;
+			this->frozen += freeze;
+			std::unique_ptr<Expression> rvalue = this->transform_expression(assign.get_rvalue());
+			this->frozen -= freeze;
+			t = std::make_unique<Assignment>(std::move(lvalue), std::move(rvalue));
+			break;
+		}
+		case COMPOUND_ASSIGNMENT:
+		{
+			auto &assign = static_cast<const CompoundAssignment&>(s);
+			auto &rvalue = static_cast<const Binary&>(assign.get_rvalue());
+			this->frozen += 1;
+			std::unique_ptr<Expression> lvalue = this->transform_expression(assign.get_lvalue());
+			this->frozen -= 1;
+			t = std::make_unique<CompoundAssignment>(std::move(lvalue), this->transform_expression(rvalue.get_right()), rvalue.get_operator());
+			break;
+		}
+		case RETURN_STATEMENT:
+		case MOVEMENT:
+		case FREE_MEMORY:
+		{
+			// these name objects rather than compute values (as does the return value of a function returning a reference)
+			bool freeze = s.get_statement_type() != RETURN_STATEMENT || this->returns_reference;
+			this->frozen += freeze;
+			t = ast_transform::transform_statement(s);
+			this->frozen -= freeze;
+			return t;
+		}
+		case CALL:
+		{
+			auto proc = this->transform_call(static_cast<const Call&>(s));
+			CallExpression call_exp(proc.get());
+			t = std::make_unique<Call>(call_exp);
+			break;
+		}
+		case IF_THEN_ELSE:
+		{
+			// each branch starts with the values available before the 'if'
+			auto &ite = static_cast<const IfThenElse&>(s);
+			std::unique_ptr<Expression> condition = this->transform_expression(ite.get_condition());
+
+			auto before = this->available;
+			this->conditional += 1;
+			std::unique_ptr<Statement> if_branch = this->transform_branch(ite.get_if_branch());
+			this->available = before;
+			std::unique_ptr<Statement> else_branch = this->transform_branch(ite.get_else_branch());
+			this->available = before;
+			this->conditional -= 1;
+
+			t = std::make_unique<IfThenElse>(std::move(condition), std::move(if_branch), std::move(else_branch));
+			break;
+		}
+		case WHILE_LOOP:
+		{
+			// only values the loop never modifies are available in it
+			auto &loop = static_cast<const WhileLoop&>(s);
+			program_info::effects fx;
+			this->program.collect_effects(this->locals, s, fx);
+			this->kill(fx);
+
+			auto before = this->available;
+			this->conditional += 1;
+			std::unique_ptr<Expression> condition = this->transform_expression(loop.get_condition());
+			std::unique_ptr<Statement> branch = this->transform_branch(loop.get_branch());
+			this->conditional -= 1;
+			this->available = before;
+
+			t = std::make_unique<WhileLoop>(std::move(condition), std::move(branch));
+			break;
+		}
+		default:
+			return ast_transform::transform_statement(s);
+	}
+
+	t->set_line_number(s.get_line_number());
+	return t;
+}
+
+StatementBlock cse::transform_block(const StatementBlock &block) {
+	/*
+
+	transform_block
+	Walks a block in order, allocating temporaries before the statements that need them and removing values as they become unavailable
+
+	*/
+
+	if (this->current_function.empty()) {
+		return ast_transform::transform_block(block);
+	}
+
+	// a nested block gets its own temporaries
+	std::unordered_set<std::string> outer_wanted = std::move(this->wanted);
+	std::vector<std::unique_ptr<Statement>> outer_pending = std::move(this->pending);
+	unsigned int outer_conditional = this->conditional;
+	unsigned int outer_line = this->line;
+	this->wanted.clear();
+	this->pending.clear();
+	this->conditional = 0;
+	this->depth += 1;
+
+	StatementBlock transformed;
+	transformed.has_return = block.has_return;
+
+	for (size_t i = 0; i < block.statements_list.size(); i++) {
+		const Statement &s = *block.statements_list[i];
+		this->plan(block, i);
+		this->line = s.get_line_number();
+
+		std::unique_ptr<Statement> t = this->transform_statement(s);
+		for (auto &temp: this->pending) {
+			transformed.statements_list.push_back(std::move(temp));
+		}
+		this->pending.clear();
+		if (t) {
+			transformed.statements_list.push_back(std::move(t));
+		}
+
+		program_info::effects fx;
+		this->program.collect_effects(this->locals, s, fx);
+		this->kill(fx);
+	}
+
+	// the temporaries go out of scope with the block
+	for (auto it = this->available.begin(); it != this->available.end(); ) {
+		if (it->second.depth >= this->depth) {
+			it = this->available.erase(it);
+		}
+		else {
+			++it;
+		}
+	}
+
+	this->depth -= 1;
+	this->wanted = std::move(outer_wanted);
+	this->pending = std::move(outer_pending);
+	this->conditional = outer_conditional;
+	this->line = outer_line;
+
+	return transformed;
+}
+
+bool cse::run(StatementBlock &ast) {
+	/*
+
+	run
+	Collects the types of globals and struct members before transforming the program
+
+	*/
+
+	this->program.analyze(ast);
+	this->current_function = "";
+	this->available.clear();
+	this->depth = 0;
+	return ast_transform::run(ast);
+}
+
+void cse::report() const {
+	for (auto &r: this->reused) {
+		compiler_note(r.first, r.second);
+	}
+
+	if (this->reused_count > 0) {
+		std::cout << "\t" << this->get_name() << ": reused " << this->reused_count << " value(s) from " << this->temp_count << " temporaries" << std::endl;
+	}
+}
+
+cse::cse()
+	: returns_reference(false)
+	, depth(0)
+	, conditional(0)
+	, frozen(0)
+	, line(0)
+	, temp_count(0)
+	, reused_count(0)
+	, function_reused(0)
+{
+}
@@ -0,0 +1,91 @@
+/*
+
+SIN Toolchain (x86 target)
+opt/cse.h
+Copyright 2021 Riley Lannon
+
+A pass to reuse values that have already been computed in straight-line code
+
+*/
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "ast_transform.h"
+#include "function_info.h"
+#include "program_info.h"
+
+class cse: public ast_transform {
+	/*
+
+	cse
+	Common subexpression elimination, by value numbering
+
+	Every occurrence of an expression like 'a[i]', 's:len', or 'p.x' is normally evaluated from scratch, even when the same value was just computed in the same statement or the one before it. This pass walks each function in order, keeping a table of the values that are available -- computations whose result is held in a temporary -- along with the names each was computed from. When a computation will be evaluated more than once, its first evaluation is stored in a temporary immediately before the statement containing it:
+		alloc T __cseN: <expression>;
+	and every occurrence refers to the temporary instead for as long as the value is available.
+
+	A value is no longer available once a statement may modify one of its names: an assignment, movement, allocation, or 'free' of the name itself (or of one of its elements or members), or, for globals and names whose address is taken, any call or store through a pointer or reference; inline assembly makes every value unavailable. The branches of an 'if' start with the values available before it, and the body of a loop with the values the loop never modifies. A temporary is scoped to the block it is allocated in.
+
+	Only computations that can't fault or have side effects (other than their bounds checks) are reused: element accesses, lengths, struct member selection, and arithmetic other than division, on primitive types. A temporary is only introduced for an occurrence that is evaluated whenever its statement is -- not in the right operand of 'and' or 'or', nor in a branch or loop -- and never in a statement containing calls whose results it might depend on, so evaluating it before the statement can't change its value.
+
+	*/
+
+	struct value {
+		std::string temp;
+		std::vector<std::string> names;	// the names it was computed from
+		unsigned int depth;	// the nesting depth of the block that allocates the temporary
+	};
+
+	program_info program;
+
+	// the function being transformed
+	std::string current_function;
+	bool returns_reference;
+	function_info locals;
+
+	std::unordered_map<std::string, value> available;	// expression key -> value
+	std::unordered_set<std::string> wanted;	// keys that get a temporary at their first unconditional occurrence in the current statement
+	std::vector<std::unique_ptr<Statement>> pending;	// temporaries to allocate before the current statement
+	unsigned int depth;
+	unsigned int conditional;	// non-zero in expressions that aren't evaluated whenever their statement is
+	unsigned int frozen;	// non-zero in expressions that must not be rewritten (e.g., lvalues)
+	unsigned int line;
+
+	unsigned int temp_count;
+	unsigned int reused_count;
+	unsigned int function_reused;
+	std::vector<std::pair<std::string, unsigned int>> reused;
+
+	static bool contains_call(const Expression &e);
+	static bool is_lvalue(const Expression &e);
+	static void collect_names(const Expression &e, std::vector<std::string> &names);
+
+	bool is_pure(const Expression &e) const;
+	bool assigns_vector(const Assignment &a) const;
+	bool is_candidate(const Expression &e) const;
+
+	void count_candidates(const Expression &e, bool unconditional, std::unordered_map<std::string, unsigned int> &counts, std::unordered_map<std::string, const Expression*> &found) const;
+	void count_candidates(const Statement &s, std::unordered_map<std::string, unsigned int> &counts, std::unordered_map<std::string, const Expression*> &found) const;
+	bool get_straight_line_expressions(const Statement &s, std::vector<const Expression*> &exps) const;
+
+	bool is_killed(const Expression &e, const program_info::effects &fx) const;
+	void kill(const program_info::effects &fx);
+	void plan(const StatementBlock &block, size_t index);
+
+	std::unique_ptr<Procedure> transform_call(const Procedure &proc);
+protected:
+	StatementBlock transform_block(const StatementBlock &block) override;
+	std::unique_ptr<Statement> transform_statement(const Statement &s) override;
+	std::unique_ptr<Expression> transform_expression(const Expression &e) override;
+public:
+	std::string get_name() const override;
+	bool run(StatementBlock &ast) override;
+	void report() const override;
+
+	cse();
+};
@@ -0,0 +1,318 @@
+/*
+
+SIN Toolchain (x86 target)
+opt/dead_code_elimination.cpp
+Copyright 2021 Riley Lannon
+
+Implementation of the dead code elimination pass
+
+*/
+
+#include <iostream>
+#include <queue>
+
+#include "dead_code_elimination.h"
+#include "../../util/Exceptions.h"
+
+std::string dead_code_elimination::get_name() const {
+	return "dead-code-elimination";
+}
+
+bool dead_code_elimination::get_condition_value(const Expression &condition, bool &value) {
+	/*
+
+	get_condition_value
+	Gets the value of a condition if it is known at compile time
+
+	Conditions built from literals will already have been reduced to a single literal by constant folding
+
+	*/
+
+	if (condition.get_expression_type() != LITERAL) {
+		return false;
+	}
+
+	auto &literal = static_cast<const Literal&>(condition);
+	if (literal.get_data_type().get_primary() != BOOL) {
+		return false;
+	}
+	else if (literal.get_value() == "true") {
+		value = true;
+	}
+	else if (literal.get_value() == "false") {
+		value = false;
+	}
+	else {
+		return false;
+	}
+
+	return true;
+}
+
+bool dead_code_elimination::always_returns(const Statement &s) {
+	/*
+
+	always_returns
+	Determines whether every path through a statement ends in a return
+
+	Unlike general_utilities::returns, this never assumes a block returns; it is used to decide which code is unreachable, so it must only be true when control can't fall through.
+
+	*/
+
+	switch (s.get_statement_type()) {
+		case RETURN_STATEMENT:
+			return true;
+		case SCOPE_BLOCK:
+		{
+			auto &block = static_cast<const ScopedBlock&>(s).get_statements();
+			for (auto stmt: block.statements_list) {
+				if (always_returns(*stmt)) {
+					return true;
+				}
+			}
+			return false;
+		}
+		case IF_THEN_ELSE:
+		{
+			auto &ite = static_cast<const IfThenElse&>(s);
+			return ite.get_if_branch() && ite.get_else_branch() &&
+				always_returns(*ite.get_if_branch()) && always_returns(*ite.get_else_branch());
+		}
+		default:
+			return false;
+	}
+}
+
+unsigned int dead_code_elimination::count_statements(const Statement &s) {
+	// counts a statement along with everything nested inside it
+	switch (s.get_statement_type()) {
+		case SCOPE_BLOCK:
+			return 1 + count_statements(static_cast<const ScopedBlock&>(s).get_statements());
+		case IF_THEN_ELSE:
+		{
+			auto &ite = static_cast<const IfThenElse&>(s);
+			unsigned int count = 1;
+			if (ite.get_if_branch()) count += count_statements(*ite.get_if_branch());
+			if (ite.get_else_branch()) count += count_statements(*ite.get_else_branch());
+			return count;
+		}
+		case WHILE_LOOP:
+		{
+			auto &loop = static_cast<const WhileLoop&>(s);
+			return 1 + (loop.get_branch() ? count_statements(*loop.get_branch()) : 0);
+		}
+		case FUNCTION_DEFINITION:
+			return 1 + count_statements(static_cast<const FunctionDefinition&>(s).get_procedure());
+		default:
+			return 1;
+	}
+}
+
+unsigned int dead_code_elimination::count_statements(const StatementBlock &block) {
+	unsigned int count = 0;
+	for (auto s: block.statements_list) {
+		count += count_statements(*s);
+	}
+	return count;
+}
+
+StatementBlock dead_code_elimination::transform_block(const StatementBlock &block) {
+	/*
+
+	transform_block
+	Rebuilds a block, dropping everything after a statement that always returns
+
+	*/
+
+	StatementBlock transformed;
+	transformed.has_return = block.has_return;
+	bool reachable = true;
+
+	for (auto s: block.statements_list) {
+		if (!reachable) {
+			this->removed_statements += count_statements(*s);
+			this->changed = true;
+			continue;
+		}
+
+		std::unique_ptr<Statement> t = this->transform_statement(*s);
+		if (t) {
+			reachable = !always_returns(*t);
+			transformed.statements_list.push_back(std::move(t));
+		}
+	}
+
+	return transformed;
+}
+
+std::unique_ptr<Statement> dead_code_elimination::transform_statement(const Statement &s) {
+	switch (s.get_statement_type()) {
+		case IF_THEN_ELSE:
+		{
+			auto &ite = static_cast<const IfThenElse&>(s);
+			bool value;
+			if (get_condition_value(ite.get_condition(), value)) {
+				const Statement *taken = value ? ite.get_if_branch() : ite.get_else_branch();
+				const Statement *untaken = value ? ite.get_else_branch() : ite.get_if_branch();
+
+				this->removed_statements += 1 + (untaken ? count_statements(*untaken) : 0);
+				this->changed = true;
+
+				// branches are compiled in the scope of the 'if' itself, so the taken branch may simply replace it
+				return taken ? this->transform_statement(*taken) : nullptr;
+			}
+			break;
+		}
+		case WHILE_LOOP:
+		{
+			auto &loop = static_cast<const WhileLoop&>(s);
+			bool value;
+			if (get_condition_value(loop.get_condition(), value) && !value) {
+				this->removed_statements += count_statements(s);
+				this->changed = true;
+				return nullptr;
+			}
+			break;
+		}
+		case FUNCTION_DEFINITION:
+		{
+			auto &def = static_cast<const FunctionDefinition&>(s);
+			std::string previous_function = this->current_function;
+			this->current_function = def.get_name();
+			this->references[def.get_name()];	// ensure every function has an entry, even if it references nothing
+
+			std::unique_ptr<Statement> t = ast_transform::transform_statement(s);
+
+			this->current_function = previous_function;
+			return t;
+		}
+		case STRUCT_DEFINITION:
+		{
+			/*
+
+			Struct definitions are copied as they are, but their methods may be called from anywhere, so anything they reference must be kept.
+			Walk the members for their references only, discarding the result
+
+			*/
+
+			auto &def = static_cast<const StructDefinition&>(s);
+			std::string previous_function = this->current_function;
+			bool previous_changed = this->changed;
+			unsigned int previous_removed = this->removed_statements;
+
+			this->current_function = "";
+			this->transform_block(def.get_procedure());
+
+			this->current_function = previous_function;
+			this->changed = previous_changed;
+			this->removed_statements = previous_removed;
+			break;
+		}
+		default:
+			break;
+	}
+
+	return ast_transform::transform_statement(s);
+}
+
+std::unique_ptr<Expression> dead_code_elimination::transform_expression(const Expression &e) {
+	if (e.get_expression_type() == IDENTIFIER) {
+		auto &id = static_cast<const Identifier&>(e);
+		this->references[this->current_function].insert(id.getValue());
+	}
+
+	return ast_transform::transform_expression(e);
+}
+
+void dead_code_elimination::remove_unreachable_functions(StatementBlock &ast) {
+	/*
+
+	remove_unreachable_functions
+	Removes top-level function definitions that can't be reached from the program's roots
+
+	The roots are 'main', 'extern' functions, functions declared with 'decl' (which are exported when defined), and anything referenced outside of a function
+
+	*/
+
+	if (!this->references.count("main")) {
+		return;
+	}
+
+	std::unordered_set<std::string> reachable;
+	std::queue<std::string> to_visit;
+	auto visit = [&](const std::string &name) {
+		if (reachable.insert(name).second) {
+			to_visit.push(name);
+		}
+	};
+
+	visit("main");
+	for (auto &name: this->references[""]) {
+		visit(name);
+	}
+	for (auto s: ast.statements_list) {
+		if (s->get_statement_type() == FUNCTION_DEFINITION) {
+			auto &def = static_cast<const FunctionDefinition&>(*s);
+			if (def.get_type_information().get_qualities().is_extern()) {
+				visit(def.get_name());
+			}
+		}
+		else if (s->get_statement_type() == DECLARATION) {
+			visit(static_cast<const Declaration&>(*s).get_name());
+		}
+	}
+
+	while (!to_visit.empty()) {
+		std::string name = to_visit.front();
+		to_visit.pop();
+
+		auto it = this->references.find(name);
+		if (it != this->references.end()) {
+			for (auto &referenced: it->second) {
+				visit(referenced);
+			}
+		}
+	}
+
+	auto it = ast.statements_list.begin();
+	while (it != ast.statements_list.end()) {
+		if ((*it)->get_statement_type() == FUNCTION_DEFINITION) {
+			auto &def = static_cast<const FunctionDefinition&>(**it);
+			if (!reachable.count(def.get_name())) {
+				this->removed_functions.push_back(std::make_pair(def.get_name(), def.get_line_number()));
+				this->removed_statements += count_statements(def);
+				this->changed = true;
+				it = ast.statements_list.erase(it);
+				continue;
+			}
+		}
+
+		it++;
+	}
+}
+
+bool dead_code_elimination::run(StatementBlock &ast) {
+	this->current_function = "";
+	this->references.clear();
+
+	ast_transform::run(ast);
+	this->remove_unreachable_functions(ast);
+
+	return this->changed;
+}
+
+void dead_code_elimination::report() const {
+	for (auto &f: this->removed_functions) {
+		compiler_note("Function '" + f.first + "' is unreachable and will not be emitted", f.second);
+	}
+
+	if (this->removed_statements > 0) {
+		std::cout << "\t" << this->get_name() << ": removed " << this->removed_statements << " statement(s), including "
+			<< this->removed_functions.size() << " unreachable function(s)" << std::endl;
+	}
+}
+
+dead_code_elimination::dead_code_elimination()
+	: removed_statements(0)
+{
+}
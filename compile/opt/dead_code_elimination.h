@@ -0,0 +1,59 @@
+/*
+
+SIN Toolchain (x86 target)
+opt/dead_code_elimination.h
+Copyright 2021 Riley Lannon
+
+A pass to remove code that can never be executed
+
+*/
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "ast_transform.h"
+
+class dead_code_elimination: public ast_transform {
+	/*
+
+	dead_code_elimination
+	Removes unreachable statements and functions from the program
+
+	The following are removed:
+		* the untaken branch of an 'if' whose condition is a literal (after constant folding), and any 'while' loop whose condition is 'false'
+		* statements in a block that follow a statement which returns on every path
+		* function definitions that cannot be reached from 'main', from 'extern' functions, or from functions that are declared in the file (and may therefore be called from elsewhere)
+
+	Functions are only removed from files that define 'main'; a file without one is treated as a library, and all of its functions are kept.
+	References are tracked by name, so any use of a function's name (not only a call) keeps it alive.
+
+	*/
+
+	std::string current_function;	// the function whose body is being transformed; empty at the top level
+	std::unordered_map<std::string, std::unordered_set<std::string>> references;	// the names referenced in each function
+
+	// totals over every run of the pass, for the report
+	unsigned int removed_statements;
+	std::vector<std::pair<std::string, unsigned int>> removed_functions;
+
+	static bool get_condition_value(const Expression &condition, bool &value);
+	static bool always_returns(const Statement &s);
+	static unsigned int count_statements(const Statement &s);
+	static unsigned int count_statements(const StatementBlock &block);
+
+	void remove_unreachable_functions(StatementBlock &ast);
+protected:
+	StatementBlock transform_block(const StatementBlock &block) override;
+	std::unique_ptr<Statement> transform_statement(const Statement &s) override;
+	std::unique_ptr<Expression> transform_expression(const Expression &e) override;
+public:
+	std::string get_name() const override;
+	bool run(StatementBlock &ast) override;
+	void report() const override;
+
+	dead_code_elimination();
+};
@@ -0,0 +1,253 @@
+/*
+
+SIN Toolchain (x86 target)
+opt/escape_analysis.cpp
+Copyright 2021 Riley Lannon
+
+Implementation of the escape analysis pass
+
+*/
+
+#include "escape_analysis.h"
+#include "../../util/Exceptions.h"
+
+std::string escape_analysis::get_name() const {
+	return "escape-analysis";
+}
+
+bool escape_analysis::is_demotable(const DataType &t) {
+	/*
+
+	is_demotable
+	Determines whether a type may be moved from dynamic to automatic memory
+
+	The type must be dynamic and have a width that is known at compile time. Types with other storage qualities are left alone so that the compiler reports the conflict.
+
+	*/
+
+	auto is_primitive = [](const DataType &p) {
+		return (p.get_primary() == INT || p.get_primary() == FLOAT || p.get_primary() == BOOL || p.get_primary() == CHAR) &&
+			!p.get_qualities().is_dynamic();
+	};
+
+	if (!t.get_qualities().is_dynamic() || t.get_qualities().is_const() || t.get_qualities().is_static()) {
+		return false;
+	}
+
+	if (t.get_primary() == ARRAY) {
+		return t.has_subtype() && is_primitive(t.get_subtype()) &&
+			t.get_array_length_expression() && t.get_array_length_expression()->get_expression_type() == LITERAL;
+	}
+	else {
+		return t.get_primary() == INT || t.get_primary() == FLOAT || t.get_primary() == BOOL || t.get_primary() == CHAR;
+	}
+}
+
+void escape_analysis::analyze_block(const StatementBlock &block) {
+	for (auto s: block.statements_list) {
+		this->analyze_statement(*s);
+	}
+}
+
+void escape_analysis::analyze_statement(const Statement &s) {
+	/*
+
+	analyze_statement
+	Records the allocations in a statement and any names that escape through it
+
+	*/
+
+	switch (s.get_statement_type()) {
+		case ALLOCATION:
+		{
+			auto &alloc = static_cast<const Allocation&>(s);
+			this->allocated[alloc.get_name()] += 1;
+
+			// initializing a pointer or a reference keeps a reference to the initial value; anything else is a copy
+			if (alloc.get_initial_value()) {
+				Type primary = alloc.get_type_information().get_primary();
+				this->analyze_expression(*alloc.get_initial_value(), primary == PTR || primary == REFERENCE);
+			}
+			break;
+		}
+		case ASSIGNMENT:
+		case COMPOUND_ASSIGNMENT:
+		{
+			auto &assign = static_cast<const Assignment&>(s);
+			this->analyze_expression(assign.get_lvalue(), false);
+			this->analyze_expression(assign.get_rvalue(), false);
+			break;
+		}
+		case MOVEMENT:
+		{
+			auto &move = static_cast<const Movement&>(s);
+			this->analyze_expression(move.get_lvalue(), true);
+			this->analyze_expression(move.get_rvalue(), true);
+			break;
+		}
+		case RETURN_STATEMENT:
+			this->analyze_expression(static_cast<const ReturnStatement&>(s).get_return_exp(), true);
+			break;
+		case IF_THEN_ELSE:
+		{
+			auto &ite = static_cast<const IfThenElse&>(s);
+			this->analyze_expression(ite.get_condition(), false);
+			if (ite.get_if_branch()) this->analyze_statement(*ite.get_if_branch());
+			if (ite.get_else_branch()) this->analyze_statement(*ite.get_else_branch());
+			break;
+		}
+		case WHILE_LOOP:
+		{
+			auto &loop = static_cast<const WhileLoop&>(s);
+			this->analyze_expression(loop.get_condition(), false);
+			if (loop.get_branch()) this->analyze_statement(*loop.get_branch());
+			break;
+		}
+		case CALL:
+			this->analyze_expression(static_cast<const Call&>(s), false);
+			break;
+		case FREE_MEMORY:
+			this->analyze_expression(static_cast<const FreeMemory&>(s).get_freed_memory(), true);
+			break;
+		case INLINE_ASM:
+			// we can't know what the assembly does with our variables
+			this->has_inline_asm = true;
+			break;
+		case SCOPE_BLOCK:
+			this->analyze_block(static_cast<const ScopedBlock&>(s).get_statements());
+			break;
+		default:
+			break;
+	}
+}
+
+void escape_analysis::analyze_expression(const Expression &e, bool escapes) {
+	/*
+
+	analyze_expression
+	Walks an expression, marking names that escape
+
+	@param	e	The expression to analyze
+	@param	escapes	Whether a reference to the value of 'e' may be kept
+
+	*/
+
+	switch (e.get_expression_type()) {
+		case IDENTIFIER:
+			if (escapes) {
+				this->escaped.insert(static_cast<const Identifier&>(e).getValue());
+			}
+			break;
+		case LIST:
+			for (auto member: static_cast<const ListExpression&>(e).get_list()) {
+				this->analyze_expression(*member, true);
+			}
+			break;
+		case INDEXED:
+		{
+			// a reference to an element is a reference into the indexed object
+			auto &idx = static_cast<const Indexed&>(e);
+			this->analyze_expression(idx.get_to_index(), escapes);
+			this->analyze_expression(idx.get_index_value(), false);
+			break;
+		}
+		case BINARY:
+		{
+			auto &b = static_cast<const Binary&>(e);
+			this->analyze_expression(b.get_left(), false);
+			this->analyze_expression(b.get_right(), false);
+			break;
+		}
+		case UNARY:
+		{
+			auto &u = static_cast<const Unary&>(e);
+			this->analyze_expression(u.get_operand(), u.get_operator() == ADDRESS);
+			break;
+		}
+		case CALL_EXP:
+		case PROC_EXP:
+		{
+			auto &proc = static_cast<const Procedure&>(e);
+			this->analyze_expression(proc.get_func_name(), false);
+			for (auto arg: proc.get_args().get_list()) {
+				this->analyze_expression(*arg, true);
+			}
+			break;
+		}
+		case CAST:
+			this->analyze_expression(static_cast<const Cast&>(e).get_exp(), escapes);
+			break;
+		case ATTRIBUTE:
+			this->analyze_expression(static_cast<const AttributeSelection&>(e).get_selected(), false);
+			break;
+		default:
+			break;
+	}
+}
+
+std::unique_ptr<Statement> escape_analysis::transform_statement(const Statement &s) {
+	if (s.get_statement_type() == FUNCTION_DEFINITION) {
+		auto &def = static_cast<const FunctionDefinition&>(s);
+
+		this->allocated.clear();
+		this->escaped.clear();
+		this->has_inline_asm = false;
+
+		// parameters are allocated by the caller, so they are never demoted
+		for (auto param: def.get_formal_parameters()) {
+			this->analyze_statement(*param);
+			if (param->get_statement_type() == ALLOCATION) {
+				this->escaped.insert(static_cast<const Allocation*>(param)->get_name());
+			}
+		}
+		this->analyze_block(def.get_procedure());
+
+		// every name allocated exactly once, in the body, with a demotable type, that never escapes
+		this->to_demote.clear();
+		if (!this->has_inline_asm) {
+			for (auto &p: this->allocated) {
+				if (p.second == 1 && !this->escaped.count(p.first)) {
+					this->to_demote.insert(p.first);
+				}
+			}
+		}
+
+		this->current_function = def.get_name();
+		std::unique_ptr<Statement> t = ast_transform::transform_statement(s);
+		this->to_demote.clear();
+
+		return t;
+	}
+	else if (s.get_statement_type() == ALLOCATION) {
+		auto &alloc = static_cast<const Allocation&>(s);
+		if (this->to_demote.count(alloc.get_name()) && is_demotable(alloc.get_type_information())) {
+			DataType demoted_type = alloc.get_type_information();
+			demoted_type.remove_quality(DYNAMIC);
+
+			std::unique_ptr<Statement> t = std::make_unique<Allocation>(
+				demoted_type,
+				alloc.get_name(),
+				alloc.was_initialized(),
+				alloc.get_initial_value() ? this->transform_expression(*alloc.get_initial_value()) : nullptr
+			);
+			t->set_line_number(s.get_line_number());
+
+			this->demoted.push_back(std::make_pair(this->current_function + "::" + alloc.get_name(), s.get_line_number()));
+			this->changed = true;
+			return t;
+		}
+	}
+
+	return ast_transform::transform_statement(s);
+}
+
+void escape_analysis::report() const {
+	for (auto &d: this->demoted) {
+		compiler_note("Dynamic allocation of '" + d.first + "' does not escape its function and was given automatic storage", d.second);
+	}
+}
+
+escape_analysis::escape_analysis()
+	: has_inline_asm(false)
+{
+}
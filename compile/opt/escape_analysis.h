@@ -0,0 +1,59 @@
+/*
+
+SIN Toolchain (x86 target)
+opt/escape_analysis.h
+Copyright 2021 Riley Lannon
+
+A pass to give automatic storage to dynamic objects that never leave their function
+
+*/
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "ast_transform.h"
+
+class escape_analysis: public ast_transform {
+	/*
+
+	escape_analysis
+	Demotes '&dynamic' allocations to automatic memory when no reference to them can outlive the function
+
+	A dynamic object escapes if its name is used directly where a reference to it may be kept:
+		* it is returned, passed as an argument, or used in a list
+		* its address is taken (including the address of one of its elements)
+		* it is moved, freed, or used to initialize a pointer or reference
+	Any other use (reading it, indexing it, assigning to it, selecting an attribute) only copies its value, so the object may live on the stack. This removes the calls to the SRE to request and release the memory.
+
+	Only objects whose size is known at compile time are demoted: dynamic primitives, and dynamic arrays of primitives with a literal length.
+	Names are tracked per function; if a function allocates a name more than once, or contains inline assembly, none of those allocations are demoted.
+
+	*/
+
+	std::unordered_map<std::string, unsigned int> allocated;	// the number of times each name is allocated in the current function
+	std::unordered_set<std::string> escaped;
+	std::unordered_set<std::string> to_demote;
+
+	std::string current_function;
+	bool has_inline_asm;
+
+	// the demoted allocations, for the report
+	std::vector<std::pair<std::string, unsigned int>> demoted;
+
+	static bool is_demotable(const DataType &t);
+
+	void analyze_block(const StatementBlock &block);
+	void analyze_statement(const Statement &s);
+	void analyze_expression(const Expression &e, bool escapes);
+protected:
+	std::unique_ptr<Statement> transform_statement(const Statement &s) override;
+public:
+	std::string get_name() const override;
+	void report() const override;
+
+	escape_analysis();
+};
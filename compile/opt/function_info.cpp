@@ -0,0 +1,191 @@
+/*
+
+SIN Toolchain (x86 target)
+opt/function_info.cpp
+Copyright 2021 Riley Lannon
+
+Implementation of the function_info class
+
+*/
+
+#include "function_info.h"
+
+void function_info::collect_locals(const Statement &s) {
+	/*
+
+	collect_locals
+	Records the types of a function's locals and the names that may be modified without being named
+
+	*/
+
+	switch (s.get_statement_type()) {
+		case ALLOCATION:
+		{
+			auto &alloc = static_cast<const Allocation&>(s);
+			if (!this->local_types.emplace(alloc.get_name(), alloc.get_type_information()).second) {
+				this->ambiguous.insert(alloc.get_name());
+			}
+
+			if (alloc.get_initial_value()) {
+				// binding a reference aliases the initial value (e.g., the struct 'p' in 'alloc ref<int> r: p.x')
+				const Expression &init = *alloc.get_initial_value();
+				if (alloc.get_type_information().get_primary() == REFERENCE) {
+					this->add_root(&init);
+				}
+				this->collect_address_taken(init);
+			}
+			break;
+		}
+		case ASSIGNMENT:
+		case COMPOUND_ASSIGNMENT:
+		case MOVEMENT:
+		{
+			auto &assign = static_cast<const Assignment&>(s);
+			this->collect_address_taken(assign.get_lvalue());
+			this->collect_address_taken(assign.get_rvalue());
+			break;
+		}
+		case RETURN_STATEMENT:
+			this->collect_address_taken(static_cast<const ReturnStatement&>(s).get_return_exp());
+			break;
+		case IF_THEN_ELSE:
+		{
+			auto &ite = static_cast<const IfThenElse&>(s);
+			this->collect_address_taken(ite.get_condition());
+			if (ite.get_if_branch()) this->collect_locals(*ite.get_if_branch());
+			if (ite.get_else_branch()) this->collect_locals(*ite.get_else_branch());
+			break;
+		}
+		case WHILE_LOOP:
+		{
+			auto &loop = static_cast<const WhileLoop&>(s);
+			this->collect_address_taken(loop.get_condition());
+			if (loop.get_branch()) this->collect_locals(*loop.get_branch());
+			break;
+		}
+		case CALL:
+			this->collect_address_taken(static_cast<const Call&>(s));
+			break;
+		case FREE_MEMORY:
+			this->collect_address_taken(static_cast<const FreeMemory&>(s).get_freed_memory());
+			break;
+		case SCOPE_BLOCK:
+			for (auto stmt: static_cast<const ScopedBlock&>(s).get_statements().statements_list) {
+				this->collect_locals(*stmt);
+			}
+			break;
+		default:
+			break;
+	}
+}
+
+void function_info::add_root(const Expression *root) {
+	// marks the variable an lvalue refers to (e.g., 'a' in 'a[i].x') as address taken
+	while (root) {
+		if (root->get_expression_type() == IDENTIFIER) {
+			this->address_taken.insert(static_cast<const Identifier*>(root)->getValue());
+			break;
+		}
+		else if (root->get_expression_type() == INDEXED) {
+			root = &static_cast<const Indexed*>(root)->get_to_index();
+		}
+		else if (root->get_expression_type() == BINARY && static_cast<const Binary*>(root)->get_operator() == DOT) {
+			root = &static_cast<const Binary*>(root)->get_left();
+		}
+		else {
+			break;
+		}
+	}
+}
+
+void function_info::collect_address_taken(const Expression &e) {
+	// names whose address is taken, or that are passed to a function (which may take them by reference)
+	switch (e.get_expression_type()) {
+		case LIST:
+			for (auto member: static_cast<const ListExpression&>(e).get_list()) {
+				this->collect_address_taken(*member);
+			}
+			break;
+		case INDEXED:
+		{
+			auto &idx = static_cast<const Indexed&>(e);
+			this->collect_address_taken(idx.get_to_index());
+			this->collect_address_taken(idx.get_index_value());
+			break;
+		}
+		case BINARY:
+		{
+			auto &b = static_cast<const Binary&>(e);
+			this->collect_address_taken(b.get_left());
+			this->collect_address_taken(b.get_right());
+			break;
+		}
+		case UNARY:
+		{
+			auto &u = static_cast<const Unary&>(e);
+			if (u.get_operator() == ADDRESS) {
+				this->add_root(&u.get_operand());
+			}
+			this->collect_address_taken(u.get_operand());
+			break;
+		}
+		case CALL_EXP:
+		case PROC_EXP:
+		{
+			auto &proc = static_cast<const Procedure&>(e);
+			this->add_root(&proc.get_func_name());	// the object a method is called on
+			for (auto arg: proc.get_args().get_list()) {
+				this->add_root(arg);
+				this->collect_address_taken(*arg);
+			}
+			break;
+		}
+		case CAST:
+			this->collect_address_taken(static_cast<const Cast&>(e).get_exp());
+			break;
+		case ATTRIBUTE:
+			this->collect_address_taken(static_cast<const AttributeSelection&>(e).get_selected());
+			break;
+		default:
+			break;
+	}
+}
+
+bool function_info::is_local(const std::string &name) const {
+	return this->local_types.count(name);
+}
+
+bool function_info::is_param(const std::string &name) const {
+	return this->params.count(name);
+}
+
+bool function_info::is_address_taken(const std::string &name) const {
+	return this->address_taken.count(name);
+}
+
+bool function_info::get_local_type(const std::string &name, DataType &t) const {
+	auto it = this->local_types.find(name);
+	if (it == this->local_types.end() || this->ambiguous.count(name)) {
+		return false;
+	}
+
+	t = it->second;
+	return true;
+}
+
+void function_info::analyze(const FunctionDefinition &def) {
+	this->local_types.clear();
+	this->ambiguous.clear();
+	this->params.clear();
+	this->address_taken.clear();
+
+	for (auto param: def.get_formal_parameters()) {
+		if (param->get_statement_type() == ALLOCATION) {
+			this->params.insert(static_cast<const Allocation*>(param)->get_name());
+		}
+		this->collect_locals(*param);
+	}
+	for (auto stmt: def.get_procedure().statements_list) {
+		this->collect_locals(*stmt);
+	}
+}
@@ -0,0 +1,46 @@
+/*
+
+SIN Toolchain (x86 target)
+opt/function_info.h
+Copyright 2021 Riley Lannon
+
+Information about the names in a function, shared by the passes that need it
+
+*/
+
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "../../parser/Statement.h"
+#include "../../util/DataType.h"
+
+class function_info {
+	/*
+
+	function_info
+	Records the types of a function's locals and which of them may be modified without being named
+
+	The optimizer works on the AST before any symbols exist, so the types come from the allocations themselves. A name allocated more than once (in different scopes) is ambiguous, and its type is unknown.
+	A name is 'address taken' if its address is taken, a reference is bound to it, or it is passed to a function (which may take it by reference); calls and stores through pointers may modify these.
+
+	*/
+
+	std::unordered_map<std::string, DataType> local_types;
+	std::unordered_set<std::string> ambiguous;
+	std::unordered_set<std::string> params;
+	std::unordered_set<std::string> address_taken;
+
+	void collect_locals(const Statement &s);
+	void add_root(const Expression *root);
+	void collect_address_taken(const Expression &e);
+public:
+	bool is_local(const std::string &name) const;
+	bool is_param(const std::string &name) const;
+	bool is_address_taken(const std::string &name) const;
+	bool get_local_type(const std::string &name, DataType &t) const;
+
+	void analyze(const FunctionDefinition &def);
+};
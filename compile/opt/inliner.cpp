@@ -0,0 +1,637 @@
+/*
+
+SIN Toolchain (x86 target)
+opt/inliner.cpp
+Copyright 2021 Riley Lannon
+
+Implementation of the inlining pass
+
+*/
+
+#include <iostream>
+#include <functional>
+
+#include "inliner.h"
+#include "../../util/Exceptions.h"
+
+class inline_renamer: public ast_transform {
+	/*
+
+	inline_renamer
+	Copies the body of an inlined function, giving its locals unique names and turning its 'return' into an assignment to the result
+
+	*/
+
+	std::string prefix;
+	const std::unordered_set<std::string> &locals;
+	std::string result;	// empty if the function returns void
+protected:
+	std::unique_ptr<Statement> transform_statement(const Statement &s) override {
+		if (s.get_statement_type() == ALLOCATION) {
+			auto &alloc = static_cast<const Allocation&>(s);
+			std::unique_ptr<Statement> t = std::make_unique<Allocation>(
+				alloc.get_type_information(),
+				this->prefix + alloc.get_name(),
+				alloc.was_initialized(),
+				alloc.get_initial_value() ? this->transform_expression(*alloc.get_initial_value()) : nullptr
+			);
+			t->set_line_number(s.get_line_number());
+			return t;
+		}
+		else if (s.get_statement_type() == RETURN_STATEMENT) {
+			if (this->result.empty()) {
+				return nullptr;
+			}
+
+			auto &ret = static_cast<const ReturnStatement&>(s);
+			std::unique_ptr<Statement> t = std::make_unique<Assignment>(
+				Identifier(this->result),
+				this->transform_expression(ret.get_return_exp())
+			);
+			t->set_line_number(s.get_line_number());
+			return t;
+		}
+
+		return ast_transform::transform_statement(s);
+	}
+
+	std::unique_ptr<Expression> transform_expression(const Expression &e) override {
+		if (e.get_expression_type() == IDENTIFIER) {
+			auto &id = static_cast<const Identifier&>(e);
+			if (this->locals.count(id.getValue())) {
+				return std::make_unique<Identifier>(this->prefix + id.getValue());
+			}
+		}
+		else if (e.get_expression_type() == BINARY) {
+			// the right side of a member selection names a member, not a variable
+			auto &b = static_cast<const Binary&>(e);
+			if (b.get_operator() == DOT && b.get_right().get_expression_type() == IDENTIFIER) {
+				return std::make_unique<Binary>(
+					this->transform_expression(b.get_left()),
+					b.get_right().clone(),
+					DOT
+				);
+			}
+		}
+
+		return ast_transform::transform_expression(e);
+	}
+public:
+	std::string get_name() const override {
+		return "inline-renamer";
+	}
+
+	std::unique_ptr<Statement> rename(const Statement &s) {
+		return this->transform_statement(s);
+	}
+
+	inline_renamer(const std::string &prefix, const std::unordered_set<std::string> &locals, const std::string &result)
+		: prefix(prefix)
+		, locals(locals)
+		, result(result)
+	{
+	}
+};
+
+std::string inliner::get_name() const {
+	return "inliner";
+}
+
+void inliner::collect_names(const Statement &s, std::unordered_set<std::string> &names) {
+	// collects every name allocated in a statement
+	switch (s.get_statement_type()) {
+		case ALLOCATION:
+			names.insert(static_cast<const Allocation&>(s).get_name());
+			break;
+		case IF_THEN_ELSE:
+		{
+			auto &ite = static_cast<const IfThenElse&>(s);
+			if (ite.get_if_branch()) collect_names(*ite.get_if_branch(), names);
+			if (ite.get_else_branch()) collect_names(*ite.get_else_branch(), names);
+			break;
+		}
+		case WHILE_LOOP:
+		{
+			auto &loop = static_cast<const WhileLoop&>(s);
+			if (loop.get_branch()) collect_names(*loop.get_branch(), names);
+			break;
+		}
+		case SCOPE_BLOCK:
+			for (auto stmt: static_cast<const ScopedBlock&>(s).get_statements().statements_list) {
+				collect_names(*stmt, names);
+			}
+			break;
+		case FUNCTION_DEFINITION:
+		{
+			auto &def = static_cast<const FunctionDefinition&>(s);
+			for (auto param: def.get_formal_parameters()) {
+				collect_names(*param, names);
+			}
+			for (auto stmt: def.get_procedure().statements_list) {
+				collect_names(*stmt, names);
+			}
+			break;
+		}
+		default:
+			break;
+	}
+}
+
+void inliner::analyze_statement(const Statement &s, candidate &c) {
+	/*
+
+	analyze_statement
+	Adds a statement to a function's cost, recording the names it allocates and references and anything that prevents the function from being inlined
+
+	*/
+
+	c.cost += 1;
+
+	switch (s.get_statement_type()) {
+		case ALLOCATION:
+		{
+			auto &alloc = static_cast<const Allocation&>(s);
+			const DataType &t = alloc.get_type_information();
+			c.locals.insert(alloc.get_name());
+			if (t.get_qualities().is_static() && c.reason.empty()) {
+				c.reason = "it contains static data";
+			}
+			else if ((t.must_free() || t.get_qualities().is_dynamic()) && c.reason.empty()) {
+				c.reason = "its local '" + alloc.get_name() + "' must be freed";
+			}
+
+			if (alloc.get_initial_value()) {
+				this->analyze_expression(*alloc.get_initial_value(), c);
+			}
+			break;
+		}
+		case ASSIGNMENT:
+		case COMPOUND_ASSIGNMENT:
+		case MOVEMENT:
+		{
+			auto &assign = static_cast<const Assignment&>(s);
+			this->analyze_expression(assign.get_lvalue(), c);
+			this->analyze_expression(assign.get_rvalue(), c);
+			break;
+		}
+		case RETURN_STATEMENT:
+			this->analyze_expression(static_cast<const ReturnStatement&>(s).get_return_exp(), c);
+			break;
+		case IF_THEN_ELSE:
+		{
+			auto &ite = static_cast<const IfThenElse&>(s);
+			this->analyze_expression(ite.get_condition(), c);
+			if (ite.get_if_branch()) this->analyze_statement(*ite.get_if_branch(), c);
+			if (ite.get_else_branch()) this->analyze_statement(*ite.get_else_branch(), c);
+			break;
+		}
+		case WHILE_LOOP:
+		{
+			auto &loop = static_cast<const WhileLoop&>(s);
+			this->analyze_expression(loop.get_condition(), c);
+			if (loop.get_branch()) this->analyze_statement(*loop.get_branch(), c);
+			break;
+		}
+		case CALL:
+			this->analyze_expression(static_cast<const Call&>(s), c);
+			break;
+		case FREE_MEMORY:
+			this->analyze_expression(static_cast<const FreeMemory&>(s).get_freed_memory(), c);
+			break;
+		case SCOPE_BLOCK:
+			for (auto stmt: static_cast<const ScopedBlock&>(s).get_statements().statements_list) {
+				this->analyze_statement(*stmt, c);
+			}
+			break;
+		case INLINE_ASM:
+			if (c.reason.empty()) c.reason = "it contains inline assembly";
+			break;
+		default:
+			if (c.reason.empty()) c.reason = "it contains a nested definition or declaration";
+			break;
+	}
+}
+
+void inliner::analyze_expression(const Expression &e, candidate &c) {
+	c.cost += 1;
+
+	switch (e.get_expression_type()) {
+		case IDENTIFIER:
+			c.free_names.insert(static_cast<const Identifier&>(e).getValue());
+			break;
+		case LIST:
+			for (auto member: static_cast<const ListExpression&>(e).get_list()) {
+				this->analyze_expression(*member, c);
+			}
+			break;
+		case INDEXED:
+		{
+			auto &idx = static_cast<const Indexed&>(e);
+			this->analyze_expression(idx.get_to_index(), c);
+			this->analyze_expression(idx.get_index_value(), c);
+			break;
+		}
+		case BINARY:
+		{
+			auto &b = static_cast<const Binary&>(e);
+			this->analyze_expression(b.get_left(), c);
+			if (b.get_operator() != DOT || b.get_right().get_expression_type() != IDENTIFIER) {
+				this->analyze_expression(b.get_right(), c);
+			}
+			break;
+		}
+		case UNARY:
+			this->analyze_expression(static_cast<const Unary&>(e).get_operand(), c);
+			break;
+		case CALL_EXP:
+		case PROC_EXP:
+		{
+			auto &proc = static_cast<const Procedure&>(e);
+			this->analyze_expression(proc.get_func_name(), c);
+			for (auto arg: proc.get_args().get_list()) {
+				this->analyze_expression(*arg, c);
+			}
+			break;
+		}
+		case CAST:
+			this->analyze_expression(static_cast<const Cast&>(e).get_exp(), c);
+			break;
+		case ATTRIBUTE:
+			this->analyze_expression(static_cast<const AttributeSelection&>(e).get_selected(), c);
+			break;
+		default:
+			break;
+	}
+}
+
+inliner::candidate inliner::analyze_function(const FunctionDefinition &def) {
+	/*
+
+	analyze_function
+	Determines the cost of a function and whether it may be inlined at all
+
+	*/
+
+	auto is_passable = [](const DataType &t) {
+		Type p = t.get_primary();
+		return (p == INT || p == FLOAT || p == BOOL || p == CHAR || p == PTR) && !t.must_free() &&
+			!t.get_qualities().is_const() && !t.get_qualities().is_final() &&
+			!t.get_qualities().is_static() && !t.get_qualities().is_dynamic();
+	};
+
+	candidate c;
+	c.def = &def;
+	c.cost = 0;
+
+	if (def.get_calling_convention() != SINCALL) {
+		c.reason = "it doesn't use the SIN calling convention";
+	}
+	else if (!is_passable(def.get_type_information()) && def.get_type_information().get_primary() != VOID) {
+		c.reason = "its return type can't be held in a local";
+	}
+
+	for (auto param: def.get_formal_parameters()) {
+		if (param->get_statement_type() != ALLOCATION) {
+			if (c.reason.empty()) c.reason = "its parameters can't be allocated as locals";
+			continue;
+		}
+
+		auto &alloc = static_cast<const Allocation&>(*param);
+		if (!is_passable(alloc.get_type_information()) && c.reason.empty()) {
+			c.reason = "parameter '" + alloc.get_name() + "' can't be allocated as a local";
+		}
+		c.locals.insert(alloc.get_name());
+	}
+
+	// the only 'return' must be the last statement, as there is no way to leave the inlined body early
+	unsigned int returns = 0;
+	auto &body = def.get_procedure().statements_list;
+	for (auto s: body) {
+		this->analyze_statement(*s, c);
+	}
+
+	std::function<void(const Statement&)> count_returns = [&](const Statement &s) {
+		if (s.get_statement_type() == RETURN_STATEMENT) {
+			returns += 1;
+		}
+		else if (s.get_statement_type() == IF_THEN_ELSE) {
+			auto &ite = static_cast<const IfThenElse&>(s);
+			if (ite.get_if_branch()) count_returns(*ite.get_if_branch());
+			if (ite.get_else_branch()) count_returns(*ite.get_else_branch());
+		}
+		else if (s.get_statement_type() == WHILE_LOOP) {
+			auto &loop = static_cast<const WhileLoop&>(s);
+			if (loop.get_branch()) count_returns(*loop.get_branch());
+		}
+		else if (s.get_statement_type() == SCOPE_BLOCK) {
+			for (auto stmt: static_cast<const ScopedBlock&>(s).get_statements().statements_list) {
+				count_returns(*stmt);
+			}
+		}
+	};
+	for (auto s: body) {
+		count_returns(*s);
+	}
+
+	if (c.reason.empty() && (returns != 1 || body.empty() || body.back()->get_statement_type() != RETURN_STATEMENT)) {
+		c.reason = "it doesn't return only at the end of its body";
+	}
+
+	for (auto &name: c.locals) {
+		c.free_names.erase(name);
+	}
+
+	if (c.free_names.count(def.get_name()) && c.reason.empty()) {
+		c.reason = "it is recursive";
+	}
+
+	return c;
+}
+
+const CallExpression *inliner::get_inlinable_call(const Statement &s) const {
+	/*
+
+	get_inlinable_call
+	Gets the call in a statement that may be hoisted in front of it, if there is one
+
+	The call must be the entire expression, as anything evaluated alongside it might observe the order of evaluation
+
+	*/
+
+	auto as_call = [](const Expression *e) -> const CallExpression* {
+		if (e && e->get_expression_type() == CALL_EXP) {
+			return static_cast<const CallExpression*>(e);
+		}
+		return nullptr;
+	};
+
+	switch (s.get_statement_type()) {
+		case CALL:
+			return &static_cast<const Call&>(s);
+		case ALLOCATION:
+		{
+			auto &alloc = static_cast<const Allocation&>(s);
+			const DataType &t = alloc.get_type_information();
+			if (t.get_primary() == REFERENCE || t.get_qualities().is_static() || t.get_qualities().is_const()) {
+				return nullptr;
+			}
+			return as_call(alloc.get_initial_value());
+		}
+		case ASSIGNMENT:
+			return as_call(&static_cast<const Assignment&>(s).get_rvalue());
+		case RETURN_STATEMENT:
+			return as_call(&static_cast<const ReturnStatement&>(s).get_return_exp());
+		case IF_THEN_ELSE:
+			return as_call(&static_cast<const IfThenElse&>(s).get_condition());
+		default:
+			return nullptr;
+	}
+}
+
+bool inliner::should_inline(const CallExpression &call, unsigned int line) {
+	/*
+
+	should_inline
+	Applies the cost model to a call
+
+	*/
+
+	if (call.get_func_name().get_expression_type() != IDENTIFIER) {
+		return false;
+	}
+
+	std::string name = static_cast<const Identifier&>(call.get_func_name()).getValue();
+	auto it = this->candidates.find(name);
+	if (it == this->candidates.end() || name == this->current_function) {
+		return false;
+	}
+
+	auto &c = it->second;
+	const symbol_qualities &q = c.def->get_type_information().get_qualities();
+	if (q.is_noinline()) {
+		return false;
+	}
+
+	std::string reason = c.reason;
+	if (reason.empty()) {
+		if (call.get_args().get_list().size() != c.def->get_formal_parameters().size()) {
+			reason = "not every parameter is given an argument";
+		}
+		else if (c.free_names.count(this->current_function)) {
+			reason = "it calls '" + this->current_function + "'";
+		}
+		else {
+			for (auto &free_name: c.free_names) {
+				if (this->caller_names.count(free_name)) {
+					reason = "'" + free_name + "' would be shadowed by a local in '" + this->current_function + "'";
+					break;
+				}
+			}
+		}
+	}
+
+	if (!reason.empty()) {
+		if (q.is_inline()) {
+			this->missed[name] = std::make_pair("Function '" + name + "' is marked 'inline', but can't be inlined into '" + this->current_function + "' because " + reason, line);
+		}
+		return false;
+	}
+
+	// calls inside of loops are assumed to be hot
+	unsigned int threshold = this->loop_depth > 0 ? INLINE_THRESHOLD * 2 : INLINE_THRESHOLD;
+	return q.is_inline() || c.cost <= threshold;
+}
+
+std::unique_ptr<Statement> inliner::replace_call(const Statement &s, const std::string &result) {
+	/*
+
+	replace_call
+	Rebuilds the statement containing an inlined call, using the result variable in place of the call
+
+	*/
+
+	std::unique_ptr<Statement> t;
+
+	switch (s.get_statement_type()) {
+		case ALLOCATION:
+		{
+			auto &alloc = static_cast<const Allocation&>(s);
+			t = std::make_unique<Allocation>(alloc.get_type_information(), alloc.get_name(), true, std::make_unique<Identifier>(result));
+			break;
+		}
+		case ASSIGNMENT:
+		{
+			auto &assign = static_cast<const Assignment&>(s);
+			t = std::make_unique<Assignment>(this->transform_expression(assign.get_lvalue()), std::make_unique<Identifier>(result));
+			break;
+		}
+		case RETURN_STATEMENT:
+			t = std::make_unique<ReturnStatement>(std::make_unique<Identifier>(result));
+			break;
+		case IF_THEN_ELSE:
+		{
+			auto &ite = static_cast<const IfThenElse&>(s);
+			t = std::make_unique<IfThenElse>(
+				std::make_unique<Identifier>(result),
+				this->transform_branch(ite.get_if_branch()),
+				this->transform_branch(ite.get_else_branch())
+			);
+			break;
+		}
+		default:
+			// a call statement's result is discarded
+			return nullptr;
+	}
+
+	t->set_line_number(s.get_line_number());
+	return t;
+}
+
+StatementBlock inliner::transform_block(const StatementBlock &block) {
+	/*
+
+	transform_block
+	Rebuilds a block, hoisting the bodies of inlined calls in front of the statements that contain them
+
+	*/
+
+	StatementBlock transformed;
+	transformed.has_return = block.has_return;
+
+	for (auto s: block.statements_list) {
+		const CallExpression *call = this->current_function.empty() ? nullptr : this->get_inlinable_call(*s);
+		if (!call || !this->should_inline(*call, s->get_line_number())) {
+			std::unique_ptr<Statement> t = this->transform_statement(*s);
+			if (t) {
+				transformed.statements_list.push_back(std::move(t));
+			}
+			continue;
+		}
+
+		std::string name = static_cast<const Identifier&>(call->get_func_name()).getValue();
+		auto &c = this->candidates.at(name);
+		std::string prefix = "__inl" + std::to_string(++this->inlined_count) + "_";
+
+		// void functions may only be inlined from call statements, as there is no result to use
+		std::string result;
+		DataType return_type = c.def->get_type_information();
+		if (return_type.get_primary() != VOID) {
+			result = prefix + "result";
+			return_type.remove_quality(EXTERN);
+
+			std::unique_ptr<Statement> result_alloc = std::make_unique<Allocation>(return_type, result);
+			result_alloc->set_line_number(s->get_line_number());
+			transformed.statements_list.push_back(std::move(result_alloc));
+		}
+		else if (s->get_statement_type() != CALL) {
+			transformed.statements_list.push_back(this->transform_statement(*s));
+			continue;
+		}
+
+		// the parameters are initialized with the arguments, in order
+		StatementBlock body;
+		auto params = c.def->get_formal_parameters();
+		auto args = call->get_args().get_list();
+		for (size_t i = 0; i < params.size(); i++) {
+			auto &param = static_cast<const Allocation&>(*params[i]);
+			std::unique_ptr<Statement> param_alloc = std::make_unique<Allocation>(
+				param.get_type_information(),
+				prefix + param.get_name(),
+				true,
+				this->transform_expression(*args[i])
+			);
+			param_alloc->set_line_number(s->get_line_number());
+			body.statements_list.push_back(std::move(param_alloc));
+		}
+
+		inline_renamer renamer(prefix, c.locals, result);
+		for (auto stmt: c.def->get_procedure().statements_list) {
+			std::unique_ptr<Statement> t = renamer.rename(*stmt);
+			if (t) {
+				body.statements_list.push_back(std::move(t));
+			}
+		}
+
+		std::unique_ptr<Statement> inlined_body = std::make_unique<ScopedBlock>(body);
+		inlined_body->set_line_number(s->get_line_number());
+		transformed.statements_list.push_back(std::move(inlined_body));
+
+		std::unique_ptr<Statement> t = this->replace_call(*s, result);
+		if (t) {
+			transformed.statements_list.push_back(std::move(t));
+		}
+
+		this->inlined.push_back(std::make_pair("Call to '" + name + "' was inlined into '" + this->current_function + "'", s->get_line_number()));
+		this->changed = true;
+	}
+
+	return transformed;
+}
+
+std::unique_ptr<Statement> inliner::transform_statement(const Statement &s) {
+	if (s.get_statement_type() == FUNCTION_DEFINITION) {
+		auto &def = static_cast<const FunctionDefinition&>(s);
+
+		this->current_function = def.get_name();
+		this->caller_names.clear();
+		collect_names(def, this->caller_names);
+		this->loop_depth = 0;
+
+		std::unique_ptr<Statement> t = ast_transform::transform_statement(s);
+		this->current_function = "";
+		return t;
+	}
+	else if (s.get_statement_type() == WHILE_LOOP) {
+		this->loop_depth += 1;
+		std::unique_ptr<Statement> t = ast_transform::transform_statement(s);
+		this->loop_depth -= 1;
+		return t;
+	}
+
+	return ast_transform::transform_statement(s);
+}
+
+bool inliner::run(StatementBlock &ast) {
+	/*
+
+	run
+	Analyzes every top-level function before transforming the program
+
+	The candidates refer to the definitions in the original tree, which remains valid until the transformed tree replaces it
+
+	*/
+
+	this->candidates.clear();
+	for (auto s: ast.statements_list) {
+		if (s->get_statement_type() == FUNCTION_DEFINITION) {
+			auto &def = static_cast<const FunctionDefinition&>(*s);
+			this->candidates.emplace(def.get_name(), this->analyze_function(def));
+		}
+	}
+
+	this->current_function = "";
+	bool changed = ast_transform::run(ast);
+	this->candidates.clear();
+
+	return changed;
+}
+
+void inliner::report() const {
+	for (auto &i: this->inlined) {
+		compiler_note(i.first, i.second);
+	}
+
+	for (auto &m: this->missed) {
+		compiler_note(m.second.first, m.second.second);
+	}
+
+	if (!this->inlined.empty()) {
+		std::cout << "\t" << this->get_name() << ": inlined " << this->inlined.size() << " call(s)" << std::endl;
+	}
+}
+
+inliner::inliner()
+	: loop_depth(0)
+	, inlined_count(0)
+{
+}
@@ -0,0 +1,87 @@
+/*
+
+SIN Toolchain (x86 target)
+opt/inliner.h
+Copyright 2021 Riley Lannon
+
+A pass to substitute the bodies of small functions at their call sites
+
+*/
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "ast_transform.h"
+
+class inliner: public ast_transform {
+	/*
+
+	inliner
+	Replaces calls to small functions with the body of the function
+
+	SIN has no expression statements, so a call can't be replaced by its body in place. Instead, the body is hoisted in front of the statement containing the call:
+		alloc T __inlN_result;
+		{
+			alloc <param 1>: <arg 1>;
+			...
+			<body, with its locals renamed and 'return x' replaced with 'let __inlN_result = x'>
+		}
+	and the call is replaced with '__inlN_result'. To preserve the order of evaluation, a call is only inlined when it is the entire expression of a call statement, an allocation's initial value, an assignment's right-hand side, a 'return', or an 'if' condition.
+
+	A function may be inlined if:
+		* it uses the SIN calling convention and is not recursive;
+		* its only 'return' is the last statement of its body;
+		* it contains no inline assembly, static data, or nested definitions;
+		* its parameters, return value, and locals are primitives or unmanaged pointers without storage qualities (locals of a scope block are not freed when it ends, so the body can't own anything that needs to be freed); and
+		* no name it refers to from outside of its body is shadowed by a local in the caller
+	Among those, a function is inlined when its cost (the number of statements and expressions in its body) is within the threshold; the threshold is doubled for calls made inside of loops. A function defined with the 'inline' quality is inlined regardless of its cost, and one with 'noinline' never is.
+
+	The function itself is left in place; dead code elimination will remove it once it is no longer referenced.
+
+	*/
+
+	static const unsigned int INLINE_THRESHOLD = 40;
+
+	struct candidate {
+		const FunctionDefinition *def;
+		unsigned int cost;
+		std::string reason;	// why the function can't be inlined; empty if it can
+		std::unordered_set<std::string> locals;	// names allocated by the function, including its parameters
+		std::unordered_set<std::string> free_names;	// names referenced by the function that it doesn't allocate
+	};
+
+	std::unordered_map<std::string, candidate> candidates;
+
+	// the function being transformed
+	std::string current_function;
+	std::unordered_set<std::string> caller_names;
+	unsigned int loop_depth;
+
+	unsigned int inlined_count;	// used to create unique names
+
+	// remarks: inlined call sites, and 'inline' functions that couldn't be
+	std::vector<std::pair<std::string, unsigned int>> inlined;
+	std::unordered_map<std::string, std::pair<std::string, unsigned int>> missed;
+
+	static void collect_names(const Statement &s, std::unordered_set<std::string> &names);
+	void analyze_statement(const Statement &s, candidate &c);
+	void analyze_expression(const Expression &e, candidate &c);
+	candidate analyze_function(const FunctionDefinition &def);
+
+	const CallExpression *get_inlinable_call(const Statement &s) const;
+	bool should_inline(const CallExpression &call, unsigned int line);
+	std::unique_ptr<Statement> replace_call(const Statement &s, const std::string &result);
+protected:
+	StatementBlock transform_block(const StatementBlock &block) override;
+	std::unique_ptr<Statement> transform_statement(const Statement &s) override;
+public:
+	std::string get_name() const override;
+	bool run(StatementBlock &ast) override;
+	void report() const override;
+
+	inliner();
+};
@@ -0,0 +1,224 @@
+/*
+
+SIN Toolchain (x86 target)
+opt/licm.cpp
+Copyright 2021 Riley Lannon
+
+Implementation of the loop-invariant code motion pass
+
+*/
+
+#include <iostream>
+#include <functional>
+
+#include "licm.h"
+#include "../../util/Exceptions.h"
+
+std::string licm::get_name() const {
+	return "licm";
+}
+
+bool licm::is_invariant(const Expression &e, const loop_context &loop) const {
+	/*
+
+	is_invariant
+	Determines whether an expression computes the same value on every iteration of a loop, without faulting or side effects
+
+	*/
+
+	switch (e.get_expression_type()) {
+		case LITERAL:
+			return true;
+		case IDENTIFIER:
+		{
+			return !this->program.may_modify(this->locals, loop.effects, static_cast<const Identifier&>(e).getValue());
+		}
+		case ATTRIBUTE:
+		{
+			auto &attr = static_cast<const AttributeSelection&>(e);
+			return attr.get_attribute() == LENGTH && attr.get_selected().get_expression_type() == IDENTIFIER &&
+				this->is_invariant(attr.get_selected(), loop);
+		}
+		case BINARY:
+		{
+			auto &b = static_cast<const Binary&>(e);
+			switch (b.get_operator()) {
+				case DOT:
+					return b.get_left().get_expression_type() == IDENTIFIER && this->is_invariant(b.get_left(), loop);
+				case PLUS:
+				case MINUS:
+				case MULT:
+				case BIT_AND:
+				case BIT_OR:
+				case BIT_XOR:
+				case LEFT_SHIFT:
+				case RIGHT_SHIFT:
+					return this->is_invariant(b.get_left(), loop) && this->is_invariant(b.get_right(), loop);
+				default:
+					// division may fault, and the remaining operators aren't worth a temporary
+					return false;
+			}
+		}
+		case UNARY:
+		{
+			auto &u = static_cast<const Unary&>(e);
+			return (u.get_operator() == UNARY_MINUS || u.get_operator() == BIT_NOT) && this->is_invariant(u.get_operand(), loop);
+		}
+		default:
+			return false;
+	}
+}
+
+bool licm::is_hoistable(const Expression &e) const {
+	// a computation (not a plain load) on primitives that isn't already a compile-time constant
+	exp_type type = e.get_expression_type();
+	if ((type != ATTRIBUTE && type != BINARY && type != UNARY) || e.is_const()) {
+		return false;
+	}
+
+	std::function<bool(const Expression&)> refers_to_name = [&](const Expression &sub) {
+		switch (sub.get_expression_type()) {
+			case IDENTIFIER:
+			case ATTRIBUTE:
+				return true;
+			case BINARY:
+				return refers_to_name(static_cast<const Binary&>(sub).get_left()) || refers_to_name(static_cast<const Binary&>(sub).get_right());
+			case UNARY:
+				return refers_to_name(static_cast<const Unary&>(sub).get_operand());
+			default:
+				return false;
+		}
+	};
+
+	DataType t;
+	if (!refers_to_name(e) || !this->program.get_type(this->locals, e, t)) {
+		return false;
+	}
+
+	Type p = t.get_primary();
+	return p == INT || p == FLOAT || p == BOOL || p == CHAR;
+}
+
+std::unique_ptr<Expression> licm::transform_expression(const Expression &e) {
+	if (!this->loops.empty() && this->is_hoistable(e)) {
+		// hoist as far out as possible; anything invariant in an outer loop is also invariant in the loops it contains
+		for (auto &loop: this->loops) {
+			if (!this->is_invariant(e, loop)) {
+				continue;
+			}
+
+			std::string key = program_info::expression_key(e);
+			auto it = loop.temps.find(key);
+			std::string name;
+			if (!key.empty() && it != loop.temps.end()) {
+				name = it->second;
+			}
+			else {
+				name = "__licm" + std::to_string(++this->temp_count);
+
+				DataType t;
+				this->program.get_type(this->locals, e, t);
+				t.remove_quality(CONSTANT);
+				t.remove_quality(FINAL);
+				t.remove_quality(STATIC);
+				t.remove_quality(DYNAMIC);
+				t.remove_quality(EXTERN);
+
+				std::unique_ptr<Statement> temp = std::make_unique<Allocation>(t, name, true, e.clone());
+				temp->set_line_number(loop.line);
+				loop.preheader.push_back(std::move(temp));
+				if (!key.empty()) {
+					loop.temps[key] = name;
+				}
+			}
+
+			this->changed = true;
+			return std::make_unique<Identifier>(name);
+		}
+	}
+
+	if (e.get_expression_type() == UNARY && static_cast<const Unary&>(e).get_operator() == ADDRESS) {
+		// the address of a member must not become the address of a temporary
+		std::unique_ptr<Expression> t = e.clone();
+		if (e.is_const()) {
+			t->set_const();
+		}
+		return t;
+	}
+
+	return ast_transform::transform_expression(e);
+}
+
+std::unique_ptr<Statement> licm::transform_statement(const Statement &s) {
+	if (s.get_statement_type() == FUNCTION_DEFINITION) {
+		auto &def = static_cast<const FunctionDefinition&>(s);
+
+		this->current_function = def.get_name();
+		this->locals.analyze(def);
+
+		std::unique_ptr<Statement> t = ast_transform::transform_statement(s);
+		this->current_function = "";
+		return t;
+	}
+	else if (s.get_statement_type() == WHILE_LOOP && !this->current_function.empty()) {
+		loop_context loop;
+		loop.line = s.get_line_number();
+		this->program.collect_effects(this->locals, s, loop.effects);
+
+		this->loops.push_back(std::move(loop));
+		std::unique_ptr<Statement> t = ast_transform::transform_statement(s);
+		loop_context done = std::move(this->loops.back());
+		this->loops.pop_back();
+
+		if (done.preheader.empty()) {
+			return t;
+		}
+
+		this->hoisted_count += done.preheader.size();
+		this->hoisted.push_back(std::make_pair(
+			"Moved " + std::to_string(done.preheader.size()) + " loop-invariant expression(s) out of a loop in '" + this->current_function + "'",
+			s.get_line_number()
+		));
+
+		StatementBlock block;
+		for (auto &p: done.preheader) {
+			block.statements_list.push_back(std::move(p));
+		}
+		block.statements_list.push_back(std::move(t));
+
+		std::unique_ptr<Statement> preheader = std::make_unique<ScopedBlock>(block);
+		preheader->set_line_number(s.get_line_number());
+		return preheader;
+	}
+
+	return ast_transform::transform_statement(s);
+}
+
+bool licm::run(StatementBlock &ast) {
+	/*
+
+	run
+	Collects the types of globals and struct members before transforming the program
+
+	*/
+
+	this->program.analyze(ast);
+	this->current_function = "";
+	return ast_transform::run(ast);
+}
+
+void licm::report() const {
+	for (auto &h: this->hoisted) {
+		compiler_note(h.first, h.second);
+	}
+
+	if (this->hoisted_count > 0) {
+		std::cout << "\t" << this->get_name() << ": moved " << this->hoisted_count << " expression(s) into loop preheaders" << std::endl;
+	}
+}
+
+licm::licm()
+	: temp_count(0)
+	, hoisted_count(0)
+{
+}
@@ -0,0 +1,69 @@
+/*
+
+SIN Toolchain (x86 target)
+opt/licm.h
+Copyright 2021 Riley Lannon
+
+A pass to move loop-invariant computations out of 'while' loops
+
+*/
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+#include "ast_transform.h"
+#include "function_info.h"
+#include "program_info.h"
+
+class licm: public ast_transform {
+	/*
+
+	licm
+	Loop-invariant code motion
+
+	A 'while' loop evaluates its condition and body from scratch on every iteration. Any computation whose operands can't change inside of the loop -- e.g., 'n - 1', 'a:len', or 's.width' when none of 'n', 'a', or 's' are written in the loop -- is evaluated once, in a preheader, and the loop refers to the result instead:
+		{
+			alloc T __licmN: <invariant expression>;
+			while (...) { ... __licmN ... }
+		}
+	The scope block keeps the temporaries from outliving the loop.
+
+	A name is invariant if it isn't assigned, moved, freed, or allocated anywhere in the loop. Stores through pointers and references, and calls, may modify data that isn't named in the loop, so when a loop contains them, names whose address is taken (or that are bound to a reference or passed to a function) are not invariant; when a loop contains calls, neither are globals.
+	Because the preheader is evaluated even when the loop runs zero times, only computations that can't fault or have side effects are hoisted: integer and floating-point arithmetic other than division, lengths, and struct member selection, on primitive types. Plain loads are not hoisted, as a variable is already a single memory operand.
+
+	*/
+
+	struct loop_context {
+		program_info::effects effects;	// everything the loop may modify
+		unsigned int line;
+
+		std::unordered_map<std::string, std::string> temps;	// expression key -> temporary
+		std::vector<std::unique_ptr<Statement>> preheader;
+	};
+
+	program_info program;
+
+	// the function being transformed
+	std::string current_function;
+	function_info locals;
+	std::vector<loop_context> loops;
+
+	unsigned int temp_count;
+	unsigned int hoisted_count;
+	std::vector<std::pair<std::string, unsigned int>> hoisted;
+
+	bool is_invariant(const Expression &e, const loop_context &loop) const;
+	bool is_hoistable(const Expression &e) const;
+protected:
+	std::unique_ptr<Statement> transform_statement(const Statement &s) override;
+	std::unique_ptr<Expression> transform_expression(const Expression &e) override;
+public:
+	std::string get_name() const override;
+	bool run(StatementBlock &ast) override;
+	void report() const override;
+
+	licm();
+};
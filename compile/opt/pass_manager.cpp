@@ -0,0 +1,84 @@
+/*
+
+SIN Toolchain (x86 target)
+opt/pass_manager.cpp
+Copyright 2021 Riley Lannon
+
+Implementation of the pass manager and the default optimization pipeline
+
+*/
+
+#include "pass_manager.h"
+#include "bounds_check_elimination.h"
+#include "constant_folding.h"
+#include "cse.h"
+#include "dead_code_elimination.h"
+#include "escape_analysis.h"
+#include "inliner.h"
+#include "licm.h"
+#include "rc_elimination.h"
+
+void optimization_pass::report() const {
+}
+
+optimization_pass::~optimization_pass() {
+}
+
+unsigned int pass_manager::get_opt_level() const {
+	return this->opt_level;
+}
+
+void pass_manager::add_pass(std::unique_ptr<optimization_pass> pass) {
+	this->passes.push_back(std::move(pass));
+}
+
+void pass_manager::run(StatementBlock &ast) {
+	/*
+
+	run
+	Runs the pipeline over a program
+
+	@param	ast	The program to optimize; it is updated in place
+
+	*/
+
+	unsigned int iterations = (this->opt_level > 1) ? MAX_ITERATIONS : 1;
+	bool changed = true;
+
+	for (unsigned int i = 0; changed && i < iterations; i++) {
+		changed = false;
+		for (auto &pass: this->passes) {
+			if (pass->run(ast)) {
+				changed = true;
+			}
+		}
+	}
+
+	for (auto &pass: this->passes) {
+		pass->report();
+	}
+}
+
+pass_manager::pass_manager(unsigned int opt_level)
+	: opt_level(opt_level)
+{
+	/*
+
+	Constructs the default pipeline for the given level; at -O0, no passes are run
+
+	*/
+
+	if (opt_level >= 1) {
+		this->add_pass(std::make_unique<constant_folding>());
+		this->add_pass(std::make_unique<inliner>());
+		this->add_pass(std::make_unique<dead_code_elimination>());
+		this->add_pass(std::make_unique<bounds_check_elimination>());	// before licm, which hoists the lengths in loop guards
+		this->add_pass(std::make_unique<licm>());
+		this->add_pass(std::make_unique<cse>());
+		this->add_pass(std::make_unique<escape_analysis>());
+		this->add_pass(std::make_unique<rc_elimination>());
+	}
+}
+
+pass_manager::~pass_manager() {
+}
@@ -0,0 +1,66 @@
+/*
+
+SIN Toolchain (x86 target)
+opt/pass_manager.h
+Copyright 2021 Riley Lannon
+
+The optimization pass interface and the pass manager
+
+Optimizations are performed on the AST after it has been parsed and before any code is generated. Each pass receives the program's top-level StatementBlock and may replace it; the pass manager decides which passes run based on the optimization level given to the compiler (-O0, -O1, or -O2).
+
+*/
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../../parser/Statement.h"
+
+class optimization_pass {
+	/*
+
+	optimization_pass
+	The base class for all optimization passes
+
+	*/
+public:
+	// the name of the pass, used in diagnostics
+	virtual std::string get_name() const = 0;
+
+	// run the pass over the program; returns whether anything was changed
+	virtual bool run(StatementBlock &ast) = 0;
+
+	// print a summary of what the pass did, once the pipeline has finished; by default, nothing is printed
+	virtual void report() const;
+
+	virtual ~optimization_pass();
+};
+
+class pass_manager {
+	/*
+
+	pass_manager
+	Holds the optimization pipeline and runs it over a program
+
+	At -O1, every pass is run once, in the order in which it was added.
+	At -O2, the pipeline is repeated until no pass makes a change (or until MAX_ITERATIONS is reached), as one pass often exposes opportunities for another.
+
+	*/
+
+	static const unsigned int MAX_ITERATIONS = 8;
+
+	unsigned int opt_level;
+	std::vector<std::unique_ptr<optimization_pass>> passes;
+public:
+	static const unsigned int MAX_OPT_LEVEL = 2;
+
+	unsigned int get_opt_level() const;
+	void add_pass(std::unique_ptr<optimization_pass> pass);
+
+	void run(StatementBlock &ast);
+
+	pass_manager(unsigned int opt_level);
+	~pass_manager();
+};
@@ -0,0 +1,373 @@
+/*
+
+SIN Toolchain (x86 target)
+opt/program_info.cpp
+Copyright 2021 Riley Lannon
+
+Implementation of the program_info class
+
+*/
+
+#include "program_info.h"
+
+program_info::effects::effects()
+	: has_call(false)
+	, has_indirect_store(false)
+	, opaque(false)
+{
+}
+
+std::string program_info::expression_key(const Expression &e) {
+	/*
+
+	expression_key
+	Gets a string that is equal for two expressions only if they compute the same value from the same names
+
+	Returns an empty string for expressions that can't be compared
+
+	*/
+
+	switch (e.get_expression_type()) {
+		case LITERAL:
+		{
+			auto &literal = static_cast<const Literal&>(e);
+			const DataType &t = literal.get_data_type();
+			return "L" + std::to_string(t.get_primary()) + "." + std::to_string(t.get_width()) + "." +
+				std::to_string(t.get_qualities().is_signed()) + ":" + literal.get_value();
+		}
+		case IDENTIFIER:
+			return "I:" + static_cast<const Identifier&>(e).getValue();
+		case INDEXED:
+		{
+			auto &idx = static_cast<const Indexed&>(e);
+			std::string array = expression_key(idx.get_to_index());
+			std::string index = expression_key(idx.get_index_value());
+			return (array.empty() || index.empty()) ? "" : "X(" + array + "," + index + ")";
+		}
+		case ATTRIBUTE:
+		{
+			auto &attr = static_cast<const AttributeSelection&>(e);
+			std::string selected = expression_key(attr.get_selected());
+			return selected.empty() ? "" : "A" + std::to_string(attr.get_attribute()) + "(" + selected + ")";
+		}
+		case BINARY:
+		{
+			auto &b = static_cast<const Binary&>(e);
+			std::string left = expression_key(b.get_left());
+			std::string right = expression_key(b.get_right());
+			return (left.empty() || right.empty()) ? "" : "B" + std::to_string(b.get_operator()) + "(" + left + "," + right + ")";
+		}
+		case UNARY:
+		{
+			auto &u = static_cast<const Unary&>(e);
+			std::string operand = expression_key(u.get_operand());
+			return operand.empty() ? "" : "U" + std::to_string(u.get_operator()) + "(" + operand + ")";
+		}
+		default:
+			return "";
+	}
+}
+
+bool program_info::get_name_type(const function_info &locals, const std::string &name, DataType &t) const {
+	if (locals.is_local(name)) {
+		return locals.get_local_type(name, t);
+	}
+
+	auto it = this->global_types.find(name);
+	if (it != this->global_types.end()) {
+		t = it->second;
+		return true;
+	}
+
+	return false;
+}
+
+bool program_info::get_type(const function_info &locals, const Expression &e, DataType &t) const {
+	/*
+
+	get_type
+	Gets the type of an expression, following the same rules as expression_util::get_expression_data_type
+
+	Only literals, names, element accesses, lengths, struct member selection, and arithmetic are supported
+
+	*/
+
+	switch (e.get_expression_type()) {
+		case LITERAL:
+			t = static_cast<const Literal&>(e).get_data_type();
+			return true;
+		case IDENTIFIER:
+			return this->get_name_type(locals, static_cast<const Identifier&>(e).getValue(), t);
+		case INDEXED:
+		{
+			DataType container;
+			if (!this->get_type(locals, static_cast<const Indexed&>(e).get_to_index(), container)) {
+				return false;
+			}
+
+			if (container.get_primary() == STRING) {
+				t = DataType(CHAR);
+				return true;
+			}
+			else if (container.get_primary() == ARRAY) {
+				t = container.get_subtype();
+				return true;
+			}
+
+			return false;
+		}
+		case ATTRIBUTE:
+		{
+			auto &attr = static_cast<const AttributeSelection&>(e);
+			t = DataType();
+			t.set_primary(INT);
+			t.add_qualities(std::vector<SymbolQuality>{ CONSTANT, UNSIGNED });
+			return attr.get_attribute() == LENGTH;
+		}
+		case BINARY:
+		{
+			auto &b = static_cast<const Binary&>(e);
+			if (b.get_operator() == DOT) {
+				DataType struct_type;
+				if (b.get_right().get_expression_type() != IDENTIFIER || !this->get_type(locals, b.get_left(), struct_type) || struct_type.get_primary() != STRUCT) {
+					return false;
+				}
+
+				auto s = this->struct_members.find(struct_type.get_struct_name());
+				if (s == this->struct_members.end()) {
+					return false;
+				}
+
+				auto member = s->second.find(static_cast<const Identifier&>(b.get_right()).getValue());
+				if (member == s->second.end()) {
+					return false;
+				}
+
+				t = member->second;
+				return true;
+			}
+
+			DataType left, right;
+			if (!this->get_type(locals, b.get_left(), left) || !this->get_type(locals, b.get_right(), right) || left.get_primary() != right.get_primary()) {
+				return false;
+			}
+
+			t = left.get_width() >= right.get_width() ? left : right;
+			return true;
+		}
+		case UNARY:
+			return this->get_type(locals, static_cast<const Unary&>(e).get_operand(), t);
+		default:
+			return false;
+	}
+}
+
+void program_info::mark_written(const function_info &locals, const Expression &lvalue, effects &fx) const {
+	switch (lvalue.get_expression_type()) {
+		case IDENTIFIER:
+		{
+			// assigning to a reference writes to whatever it refers to
+			std::string name = static_cast<const Identifier&>(lvalue).getValue();
+			DataType t;
+			fx.written.insert(name);
+			if (!this->get_name_type(locals, name, t) || t.get_primary() == REFERENCE) {
+				fx.has_indirect_store = true;
+			}
+			break;
+		}
+		case INDEXED:
+			this->mark_written(locals, static_cast<const Indexed&>(lvalue).get_to_index(), fx);
+			break;
+		case BINARY:
+		{
+			auto &b = static_cast<const Binary&>(lvalue);
+			if (b.get_operator() == DOT) {
+				this->mark_written(locals, b.get_left(), fx);
+			}
+			else {
+				fx.has_indirect_store = true;
+			}
+			break;
+		}
+		default:
+			// dereferences and anything else we can't trace back to a name
+			fx.has_indirect_store = true;
+			break;
+	}
+}
+
+void program_info::collect_effects(const function_info &locals, const Statement &s, effects &fx) const {
+	/*
+
+	collect_effects
+	Records everything a statement may modify
+
+	*/
+
+	switch (s.get_statement_type()) {
+		case ALLOCATION:
+		{
+			// an allocation gives its name a new value
+			auto &alloc = static_cast<const Allocation&>(s);
+			fx.written.insert(alloc.get_name());
+			if (alloc.get_initial_value()) {
+				this->collect_effects(locals, *alloc.get_initial_value(), fx);
+			}
+			break;
+		}
+		case ASSIGNMENT:
+		case COMPOUND_ASSIGNMENT:
+		{
+			auto &assign = static_cast<const Assignment&>(s);
+			this->mark_written(locals, assign.get_lvalue(), fx);
+			this->collect_effects(locals, assign.get_lvalue(), fx);
+			this->collect_effects(locals, assign.get_rvalue(), fx);
+			break;
+		}
+		case MOVEMENT:
+		{
+			auto &move = static_cast<const Movement&>(s);
+			this->mark_written(locals, move.get_lvalue(), fx);
+			this->mark_written(locals, move.get_rvalue(), fx);
+			this->collect_effects(locals, move.get_lvalue(), fx);
+			this->collect_effects(locals, move.get_rvalue(), fx);
+			break;
+		}
+		case RETURN_STATEMENT:
+			this->collect_effects(locals, static_cast<const ReturnStatement&>(s).get_return_exp(), fx);
+			break;
+		case IF_THEN_ELSE:
+		{
+			auto &ite = static_cast<const IfThenElse&>(s);
+			this->collect_effects(locals, ite.get_condition(), fx);
+			if (ite.get_if_branch()) this->collect_effects(locals, *ite.get_if_branch(), fx);
+			if (ite.get_else_branch()) this->collect_effects(locals, *ite.get_else_branch(), fx);
+			break;
+		}
+		case WHILE_LOOP:
+		{
+			auto &loop = static_cast<const WhileLoop&>(s);
+			this->collect_effects(locals, loop.get_condition(), fx);
+			if (loop.get_branch()) this->collect_effects(locals, *loop.get_branch(), fx);
+			break;
+		}
+		case CALL:
+			this->collect_effects(locals, static_cast<const Expression&>(static_cast<const Call&>(s)), fx);
+			break;
+		case FREE_MEMORY:
+		{
+			auto &free_stmt = static_cast<const FreeMemory&>(s);
+			this->mark_written(locals, free_stmt.get_freed_memory(), fx);
+			this->collect_effects(locals, free_stmt.get_freed_memory(), fx);
+			break;
+		}
+		case SCOPE_BLOCK:
+			for (auto stmt: static_cast<const ScopedBlock&>(s).get_statements().statements_list) {
+				this->collect_effects(locals, *stmt, fx);
+			}
+			break;
+		default:
+			// inline assembly may do anything at all
+			fx.has_call = true;
+			fx.has_indirect_store = true;
+			fx.opaque = true;
+			break;
+	}
+}
+
+void program_info::collect_effects(const function_info &locals, const Expression &e, effects &fx) const {
+	switch (e.get_expression_type()) {
+		case LIST:
+			for (auto member: static_cast<const ListExpression&>(e).get_list()) {
+				this->collect_effects(locals, *member, fx);
+			}
+			break;
+		case INDEXED:
+		{
+			auto &idx = static_cast<const Indexed&>(e);
+			this->collect_effects(locals, idx.get_to_index(), fx);
+			this->collect_effects(locals, idx.get_index_value(), fx);
+			break;
+		}
+		case BINARY:
+		{
+			auto &b = static_cast<const Binary&>(e);
+			this->collect_effects(locals, b.get_left(), fx);
+			this->collect_effects(locals, b.get_right(), fx);
+			break;
+		}
+		case UNARY:
+			this->collect_effects(locals, static_cast<const Unary&>(e).get_operand(), fx);
+			break;
+		case CALL_EXP:
+		case PROC_EXP:
+		{
+			auto &proc = static_cast<const Procedure&>(e);
+			fx.has_call = true;
+			this->collect_effects(locals, proc.get_func_name(), fx);
+			for (auto arg: proc.get_args().get_list()) {
+				this->collect_effects(locals, *arg, fx);
+			}
+			break;
+		}
+		case CAST:
+			this->collect_effects(locals, static_cast<const Cast&>(e).get_exp(), fx);
+			break;
+		case ATTRIBUTE:
+			this->collect_effects(locals, static_cast<const AttributeSelection&>(e).get_selected(), fx);
+			break;
+		default:
+			break;
+	}
+}
+
+bool program_info::may_modify(const function_info &locals, const effects &fx, const std::string &name) const {
+	/*
+
+	may_modify
+	Determines whether code with the given effects may change the value of a name
+
+	Names we know nothing about, and references (which may refer to anything), are always assumed to be modified
+
+	*/
+
+	DataType t;
+	if (fx.opaque || fx.written.count(name) || !this->get_name_type(locals, name, t) || t.get_primary() == REFERENCE) {
+		return true;
+	}
+
+	// calls and indirect stores may modify globals (whose addresses may have been passed in), as well as any local whose address has escaped
+	if ((fx.has_call || fx.has_indirect_store) && !locals.is_local(name)) {
+		return true;
+	}
+	return (fx.has_call || fx.has_indirect_store) && locals.is_address_taken(name);
+}
+
+void program_info::analyze(const StatementBlock &ast) {
+	/*
+
+	analyze
+	Collects the types of a program's globals and struct members
+
+	*/
+
+	this->global_types.clear();
+	this->struct_members.clear();
+
+	for (auto s: ast.statements_list) {
+		if (s->get_statement_type() == ALLOCATION) {
+			auto &alloc = static_cast<const Allocation&>(*s);
+			this->global_types.emplace(alloc.get_name(), alloc.get_type_information());
+		}
+		else if (s->get_statement_type() == STRUCT_DEFINITION) {
+			auto &def = static_cast<const StructDefinition&>(*s);
+			auto &members = this->struct_members[def.get_name()];
+			for (auto member: def.get_procedure().statements_list) {
+				if (member->get_statement_type() == ALLOCATION) {
+					auto &alloc = static_cast<const Allocation&>(*member);
+					members.emplace(alloc.get_name(), alloc.get_type_information());
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,55 @@
+/*
+
+SIN Toolchain (x86 target)
+opt/program_info.h
+Copyright 2021 Riley Lannon
+
+Information about a program's globals and structs, shared by the passes that reason about expressions
+
+*/
+
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "function_info.h"
+#include "../../parser/Statement.h"
+#include "../../util/DataType.h"
+
+class program_info {
+	/*
+
+	program_info
+	Records the types of a program's globals and struct members, and determines the types of (and the names modified by) the code in its functions
+
+	Names are looked up in the function being analyzed first (through its function_info), and then in the globals.
+
+	*/
+
+	std::unordered_map<std::string, std::unordered_map<std::string, DataType>> struct_members;
+	std::unordered_map<std::string, DataType> global_types;
+public:
+	// everything a statement (or a sequence of them) may modify
+	struct effects {
+		std::unordered_set<std::string> written;	// names assigned, moved, freed, or allocated
+		bool has_call;
+		bool has_indirect_store;	// stores through pointers and references
+		bool opaque;	// contains inline assembly
+
+		effects();
+	};
+
+	static std::string expression_key(const Expression &e);
+
+	bool get_name_type(const function_info &locals, const std::string &name, DataType &t) const;
+	bool get_type(const function_info &locals, const Expression &e, DataType &t) const;
+
+	void mark_written(const function_info &locals, const Expression &lvalue, effects &fx) const;
+	void collect_effects(const function_info &locals, const Statement &s, effects &fx) const;
+	void collect_effects(const function_info &locals, const Expression &e, effects &fx) const;
+	bool may_modify(const function_info &locals, const effects &fx, const std::string &name) const;
+
+	void analyze(const StatementBlock &ast);
+};
@@ -0,0 +1,270 @@
+/*
+
+SIN Toolchain (x86 target)
+opt/rc_elimination.cpp
+Copyright 2021 Riley Lannon
+
+Implementation of the reference counting optimization pass
+
+*/
+
+#include "rc_elimination.h"
+#include "../../util/Exceptions.h"
+
+std::string rc_elimination::get_name() const {
+	return "rc-elimination";
+}
+
+void rc_elimination::analyze_block(const StatementBlock &block) {
+	for (auto s: block.statements_list) {
+		this->analyze_statement(*s);
+	}
+}
+
+void rc_elimination::analyze_statement(const Statement &s) {
+	/*
+
+	analyze_statement
+	Records the names a statement modifies or keeps a reference to
+
+	*/
+
+	switch (s.get_statement_type()) {
+		case ALLOCATION:
+		{
+			auto &alloc = static_cast<const Allocation&>(s);
+			if (!this->allocated.insert(alloc.get_name()).second) {
+				this->reallocated.insert(alloc.get_name());
+			}
+
+			if (alloc.get_initial_value()) {
+				Type primary = alloc.get_type_information().get_primary();
+				this->analyze_expression(*alloc.get_initial_value(), primary == PTR || primary == REFERENCE);
+			}
+			break;
+		}
+		case ASSIGNMENT:
+		case COMPOUND_ASSIGNMENT:
+		{
+			auto &assign = static_cast<const Assignment&>(s);
+			this->analyze_expression(assign.get_lvalue(), true);
+			this->analyze_expression(assign.get_rvalue(), false);
+			break;
+		}
+		case MOVEMENT:
+		{
+			auto &move = static_cast<const Movement&>(s);
+			this->analyze_expression(move.get_lvalue(), true);
+			this->analyze_expression(move.get_rvalue(), true);
+			break;
+		}
+		case RETURN_STATEMENT:
+			this->analyze_expression(static_cast<const ReturnStatement&>(s).get_return_exp(), true);
+			break;
+		case IF_THEN_ELSE:
+		{
+			auto &ite = static_cast<const IfThenElse&>(s);
+			this->analyze_expression(ite.get_condition(), false);
+			if (ite.get_if_branch()) this->analyze_statement(*ite.get_if_branch());
+			if (ite.get_else_branch()) this->analyze_statement(*ite.get_else_branch());
+			break;
+		}
+		case WHILE_LOOP:
+		{
+			auto &loop = static_cast<const WhileLoop&>(s);
+			this->analyze_expression(loop.get_condition(), false);
+			if (loop.get_branch()) this->analyze_statement(*loop.get_branch());
+			break;
+		}
+		case CALL:
+			this->analyze_expression(static_cast<const Call&>(s), false);
+			break;
+		case FREE_MEMORY:
+			this->analyze_expression(static_cast<const FreeMemory&>(s).get_freed_memory(), true);
+			break;
+		case INLINE_ASM:
+			this->has_inline_asm = true;
+			break;
+		case SCOPE_BLOCK:
+			this->analyze_block(static_cast<const ScopedBlock&>(s).get_statements());
+			break;
+		default:
+			break;
+	}
+}
+
+void rc_elimination::analyze_expression(const Expression &e, bool unsafe_use) {
+	/*
+
+	analyze_expression
+	Walks an expression, marking names that are used unsafely
+
+	@param	e	The expression to analyze
+	@param	unsafe_use	Whether the value of 'e' may be modified or have a reference kept to it
+
+	*/
+
+	switch (e.get_expression_type()) {
+		case IDENTIFIER:
+			if (unsafe_use) {
+				this->unsafe.insert(static_cast<const Identifier&>(e).getValue());
+			}
+			break;
+		case LIST:
+			for (auto member: static_cast<const ListExpression&>(e).get_list()) {
+				this->analyze_expression(*member, true);
+			}
+			break;
+		case INDEXED:
+		{
+			auto &idx = static_cast<const Indexed&>(e);
+			this->analyze_expression(idx.get_to_index(), unsafe_use);
+			this->analyze_expression(idx.get_index_value(), false);
+			break;
+		}
+		case BINARY:
+		{
+			auto &b = static_cast<const Binary&>(e);
+			this->analyze_expression(b.get_left(), false);
+			this->analyze_expression(b.get_right(), false);
+			break;
+		}
+		case UNARY:
+		{
+			auto &u = static_cast<const Unary&>(e);
+			this->analyze_expression(u.get_operand(), u.get_operator() == ADDRESS);
+			break;
+		}
+		case CALL_EXP:
+		case PROC_EXP:
+		{
+			// SIN functions copy or borrow their arguments; we can't know what other functions will do with them
+			auto &proc = static_cast<const Procedure&>(e);
+			bool sin_function = proc.get_func_name().get_expression_type() == IDENTIFIER &&
+				this->sincall_functions.count(static_cast<const Identifier&>(proc.get_func_name()).getValue());
+
+			this->analyze_expression(proc.get_func_name(), false);
+			for (auto arg: proc.get_args().get_list()) {
+				this->analyze_expression(*arg, !sin_function);
+			}
+			break;
+		}
+		case CAST:
+			this->analyze_expression(static_cast<const Cast&>(e).get_exp(), unsafe_use);
+			break;
+		case ATTRIBUTE:
+			this->analyze_expression(static_cast<const AttributeSelection&>(e).get_selected(), false);
+			break;
+		default:
+			break;
+	}
+}
+
+std::unique_ptr<Statement> rc_elimination::transform_statement(const Statement &s) {
+	if (s.get_statement_type() != FUNCTION_DEFINITION) {
+		return ast_transform::transform_statement(s);
+	}
+
+	auto &def = static_cast<const FunctionDefinition&>(s);
+	auto params = this->transform_parameters(def.get_formal_parameters());
+
+	if (def.get_calling_convention() == SINCALL && !this->exported.count(def.get_name())) {
+		this->unsafe.clear();
+		this->allocated.clear();
+		this->reallocated.clear();
+		this->has_inline_asm = false;
+
+		for (auto param: def.get_formal_parameters()) {
+			this->analyze_statement(*param);
+		}
+		this->analyze_block(def.get_procedure());
+
+		for (auto &param: params) {
+			if (param->get_statement_type() != ALLOCATION || this->has_inline_asm) {
+				continue;
+			}
+
+			auto &alloc = static_cast<const Allocation&>(*param);
+			const DataType &t = alloc.get_type_information();
+			if (
+				t.get_primary() == STRING &&
+				!t.get_qualities().is_borrowed() &&
+				!t.get_qualities().is_dynamic() &&
+				!this->unsafe.count(alloc.get_name()) &&
+				!this->reallocated.count(alloc.get_name())
+			) {
+				DataType borrowed_type = t;
+				borrowed_type.add_quality(BORROWED);
+
+				std::unique_ptr<Statement> borrowed_param = std::make_unique<Allocation>(
+					borrowed_type,
+					alloc.get_name(),
+					alloc.was_initialized(),
+					alloc.get_initial_value() ? alloc.get_initial_value()->clone() : nullptr
+				);
+				borrowed_param->set_line_number(param->get_line_number());
+				param = std::move(borrowed_param);
+
+				this->borrowed.push_back(std::make_pair(def.get_name() + "::" + alloc.get_name(), param->get_line_number()));
+				this->changed = true;
+			}
+		}
+	}
+
+	std::unique_ptr<Statement> t = std::make_unique<FunctionDefinition>(
+		def.get_name(),
+		def.get_type_information(),
+		params,
+		std::make_unique<StatementBlock>(this->transform_block(def.get_procedure())),
+		def.get_calling_convention()
+	);
+	t->set_line_number(s.get_line_number());
+
+	return t;
+}
+
+bool rc_elimination::run(StatementBlock &ast) {
+	/*
+
+	run
+	Finds which functions may be called from other files, and which use the SIN calling convention, before transforming the program
+
+	*/
+
+	this->exported.clear();
+	this->sincall_functions.clear();
+
+	for (auto s: ast.statements_list) {
+		if (s->get_statement_type() == FUNCTION_DEFINITION) {
+			auto &def = static_cast<const FunctionDefinition&>(*s);
+			if (def.get_type_information().get_qualities().is_extern()) {
+				this->exported.insert(def.get_name());
+			}
+			if (def.get_calling_convention() == SINCALL) {
+				this->sincall_functions.insert(def.get_name());
+			}
+		}
+		else if (s->get_statement_type() == DECLARATION) {
+			auto &decl = static_cast<const Declaration&>(*s);
+			if (decl.is_function()) {
+				this->exported.insert(decl.get_name());
+				if (decl.get_calling_convention() == SINCALL) {
+					this->sincall_functions.insert(decl.get_name());
+				}
+			}
+		}
+	}
+
+	return ast_transform::run(ast);
+}
+
+void rc_elimination::report() const {
+	for (auto &b: this->borrowed) {
+		compiler_note("String parameter '" + b.first + "' is never modified or stored, and will be borrowed from the caller rather than copied", b.second);
+	}
+}
+
+rc_elimination::rc_elimination()
+	: has_inline_asm(false)
+{
+}
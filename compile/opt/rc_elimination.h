@@ -0,0 +1,58 @@
+/*
+
+SIN Toolchain (x86 target)
+opt/rc_elimination.h
+Copyright 2021 Riley Lannon
+
+A pass to remove reference counting traffic for function parameters
+
+*/
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <unordered_set>
+
+#include "ast_transform.h"
+
+class rc_elimination: public ast_transform {
+	/*
+
+	rc_elimination
+	Marks string parameters that may be borrowed from the caller
+
+	A string argument is normally copy-constructed by the caller and freed by the callee when it returns, which costs an allocation, a copy, and a call into the MAM for every call. If the callee never modifies the parameter or keeps a reference to it, it may instead refer to the caller's object directly; such parameters are given the (internal) 'borrowed' quality, which
+		* tells the caller to pass locals, literals, and temporaries as-is (see compiler::sincall), and
+		* keeps the callee from freeing the parameter when it returns (see DataType::set_must_free)
+
+	A parameter is borrowed only when its function uses the SIN calling convention and isn't visible outside of the file ('extern' or declared), since every caller must agree on how it is passed.
+	Passing the parameter on to another SIN function is allowed, as that call will copy or borrow it in turn.
+
+	The remaining RC optimizations are done in code generation: when a function returns one of its locals, the increment for the caller and the decrement for the local cancel out, so neither is emitted.
+
+	*/
+
+	std::unordered_set<std::string> exported;	// functions whose signatures may be used by other files
+	std::unordered_set<std::string> sincall_functions;	// functions known to use the SIN calling convention
+
+	std::unordered_set<std::string> unsafe;	// names that are modified or referenced in the current function
+	std::unordered_set<std::string> allocated;
+	std::unordered_set<std::string> reallocated;
+	bool has_inline_asm;
+
+	// the borrowed parameters, for the report
+	std::vector<std::pair<std::string, unsigned int>> borrowed;
+
+	void analyze_block(const StatementBlock &block);
+	void analyze_statement(const Statement &s);
+	void analyze_expression(const Expression &e, bool unsafe_use);
+protected:
+	std::unique_ptr<Statement> transform_statement(const Statement &s) override;
+public:
+	std::string get_name() const override;
+	bool run(StatementBlock &ast) override;
+	void report() const override;
+
+	rc_elimination();
+};
@@ -8,6 +8,8 @@ Implements various functionality for pointers within the compiler
 
 */
 
+#include <cstdlib>
+
 #include "compiler.h"
 
 std::stringstream compiler::get_exp_address(const Expression &exp, reg r, unsigned int line) {
@@ -18,6 +20,33 @@ std::stringstream compiler::get_exp_address(const Expression &exp, reg r, unsign
 
     */
 
+    // accesses in a loop may use a pointer that was derived from the induction variable (see compiler::reduce_loop)
+    if (exp.get_expression_type() == INDEXED) {
+        auto it = this->induction_pointers.find(&static_cast<const Indexed&>(exp));
+        if (it != this->induction_pointers.end()) {
+            std::stringstream addr_ss;
+            addr_ss << "\t" << "mov " << register_usage::get_register_name(r) << ", [rbp - " << it->second << "]" << std::endl;
+            if (r != RBX) {
+                this->reg_stack.peek().set(r);
+            }
+            return addr_ss;
+        }
+    }
+
+    // vector lanes are selected with literals, so their offsets (and bounds) are known at compile time
+    if (exp.get_expression_type() == INDEXED) {
+        auto &i = static_cast<const Indexed&>(exp);
+        DataType idx_type = expression_util::get_expression_data_type(i.get_to_index(), this->symbols, this->structs, line);
+        if (idx_type.get_primary() == VECTOR) {
+            size_t lane = expression_util::get_vector_lane(i, idx_type, line);
+            std::stringstream addr_ss = this->get_exp_address(i.get_to_index(), r, line);
+            if (lane != 0) {
+                addr_ss << "\t" << "add " << register_usage::get_register_name(r) << ", " << lane * idx_type.get_subtype().get_width() << std::endl;
+            }
+            return addr_ss;
+        }
+    }
+
     // first, use the utility function
     std::stringstream addr_ss = expression_util::get_exp_address(exp, this->symbols, this->structs, r, line);
 
@@ -68,14 +97,17 @@ std::stringstream compiler::get_exp_address(const Expression &exp, reg r, unsign
             }
         }
 
-        // ensure we are within the bounds of the array
-        addr_ss << "\t" << "cmp [rbx], eax" << std::endl;
-        addr_ss << "\t" << "jg .sinl_rtbounds_" << this->rtbounds_num << std::endl;
+        // ensure we are within the bounds of the array, unless the optimizer proved that we are (see opt/bounds_check_elimination.h)
+        if (i.is_bounds_checked()) {
+            // the comparison is unsigned so that negative indices are out of bounds, too
+            addr_ss << "\t" << "cmp [rbx], eax" << std::endl;
+            addr_ss << "\t" << "ja .sinl_rtbounds_" << this->rtbounds_num << std::endl;
 
-        // if we were out of bounds, call the appropriate function
-        addr_ss << "\t" << "call " << magic_numbers::SINL_RTE_OUT_OF_BOUNDS << std::endl;
-        
-        addr_ss << ".sinl_rtbounds_" << this->rtbounds_num << ":" << std::endl;
+            // if we were out of bounds, call the appropriate function
+            addr_ss << "\t" << "call " << magic_numbers::SINL_RTE_OUT_OF_BOUNDS << std::endl;
+            
+            addr_ss << ".sinl_rtbounds_" << this->rtbounds_num << ":" << std::endl;
+        }
 
         // todo: check to see if rdx is in use so the value can be preserved
         addr_ss << "\t" << "mov edx, 0" << std::endl;
@@ -97,6 +129,91 @@ std::stringstream compiler::get_exp_address(const Expression &exp, reg r, unsign
     return addr_ss;
 }
 
+std::stringstream compiler::reduce_loop(const WhileLoop &loop, const std::string &body_label, std::string &condition, size_t &reserved) {
+    /*
+
+    reduce_loop
+    Sets up the pointers used by a loop's array accesses in place of their induction variables
+
+    Each pointer is derived once, before the loop, and stored on the stack; the statements that step the induction variable advance it by the step times the element width, and the accesses just load it.
+    If the exit test is the only other use of the variable, the test compares the pointer against the address it would have once the test fails, and the variable's steps are removed. In that case, 'condition' is set to the code for the new test.
+
+    @param  loop    The loop to reduce
+    @param  body_label  The label of the loop body, where the exit test jumps while it is true
+    @param  condition   Set to the code for the exit test if it was rewritten, or cleared otherwise
+    @param  reserved    Set to the stack space used by the pointers, which must be released after the loop
+    @return The code to execute before entering the loop
+
+    */
+
+    std::stringstream preheader_ss;
+    condition.clear();
+    reserved = 0;
+
+    if (this->_opt_level == 0 || !this->current_definition) {
+        return preheader_ss;
+    }
+
+    unsigned int line = loop.get_line_number();
+    auto ivs = induction_util::analyze_loop(loop, this->current_definition->get_procedure(), this->current_locals, this->symbols);
+    for (auto &iv: ivs) {
+        // if an enclosing loop removed this variable's steps, it no longer holds its value
+        if (this->removed_steps.count(iv.steps.front().first)) {
+            continue;
+        }
+
+        // computes &array[index + offset] and stores it in a new stack slot, returning the slot's offset
+        auto derive = [&](const Expression &index, const induction_util::derived_pointer &p) {
+            preheader_ss << this->evaluate_expression(index, line).first;
+            if (iv.is_signed) {
+                preheader_ss << "\t" << "movsxd rax, eax" << std::endl;
+            }
+            preheader_ss << "\t" << "push rax" << std::endl;
+            preheader_ss << expression_util::get_exp_address(*p.array_exp, this->symbols, this->structs, RBX, line).str();
+            preheader_ss << "\t" << "pop rax" << std::endl;
+
+            long long displacement = sin_widths::INT_WIDTH + p.offset * static_cast<long long>(p.width);
+            preheader_ss << "\t" << "lea rbx, [rbx + rax*" << p.width << (displacement < 0 ? " - " : " + ") << std::llabs(displacement) << "]" << std::endl;
+
+            this->max_offset += sin_widths::PTR_WIDTH;
+            reserved += sin_widths::PTR_WIDTH;
+            preheader_ss << "\t" << "sub rsp, " << sin_widths::PTR_WIDTH << std::endl;
+            preheader_ss << "\t" << "mov [rbp - " << this->max_offset << "], rbx" << std::endl;
+            return this->max_offset;
+        };
+
+        Identifier iv_exp(iv.name);
+        std::vector<size_t> offsets;
+        for (auto &p: iv.pointers) {
+            size_t offset = derive(iv_exp, p);
+            offsets.push_back(offset);
+            for (auto access: p.accesses) {
+                this->induction_pointers[access] = offset;
+            }
+            for (auto &step: iv.steps) {
+                this->induction_steps[step.first].push_back(std::make_pair(offset, step.second * static_cast<long long>(p.width)));
+            }
+        }
+
+        // rewrite the exit test against the end of the first pointer, if we can
+        if (iv.limit && condition.empty()) {
+            size_t end = derive(*iv.limit, iv.pointers.front());
+
+            std::stringstream condition_ss;
+            condition_ss << "\t" << "mov rax, [rbp - " << offsets.front() << "]" << std::endl;
+            condition_ss << "\t" << "cmp rax, [rbp - " << end << "]" << std::endl;
+            condition_ss << "\t" << (iv.inclusive ? "jbe " : "jb ") << body_label << std::endl;
+            condition = condition_ss.str();
+
+            for (auto &step: iv.steps) {
+                this->removed_steps.insert(step.first);
+            }
+        }
+    }
+
+    return preheader_ss;
+}
+
 std::stringstream compiler::get_address_of(const Unary &u, reg r, unsigned int line) {
     /*
 
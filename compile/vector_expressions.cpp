@@ -0,0 +1,1094 @@
+/*
+
+SIN Toolchain (x86 target)
+vector_expressions.cpp
+Copyright 2021 Riley Lannon
+
+Generates code for the SIMD vector types, 'vec<N, T>'
+
+A vector is computed into XMM0 (or YMM0, for 256-bit vectors) as a whole, so that each operation on it is a single packed instruction wherever the instruction set has one. The right operand of a binary expression goes in XMM1, and XMM2 is used as scratch.
+Vectors in memory are always accessed with unaligned loads and stores, as neither the stack nor arrays guarantee 16-byte alignment.
+
+*/
+
+#include "compiler.h"
+
+namespace
+{
+    struct vector_isa {
+        /*
+
+        The instructions for a vector type, in either their SSE or VEX-encoded (AVX) forms
+
+        */
+
+        bool avx;   // whether to use the VEX-encoded forms; these are used for all vectors when targeting x86-64-v3
+        bool wide;  // whether the vector fills a YMM register
+        bool is_float;
+        bool is_long;   // whether the lanes are 8 bytes wide
+        bool is_unsigned;
+        size_t width;
+        size_t lanes;
+        size_t lane_width;
+        std::string suffix; // 'ps' or 'pd' for floating-point lanes, 'd' or 'q' for integer lanes
+
+        std::string reg(unsigned int n) const {
+            return (this->wide ? "ymm" : "xmm") + std::to_string(n);
+        }
+
+        std::string op(const std::string &instruction, unsigned int dest, unsigned int src) const {
+            // AVX instructions take a separate destination
+            if (this->avx) {
+                return "\tv" + instruction + " " + this->reg(dest) + ", " + this->reg(dest) + ", " + this->reg(src) + "\n";
+            }
+            return "\t" + instruction + " " + this->reg(dest) + ", " + this->reg(src) + "\n";
+        }
+
+        std::string op(const std::string &instruction, unsigned int dest, const std::string &src) const {
+            // for shifts, whose counts are immediates or XMM registers
+            if (this->avx) {
+                return "\tv" + instruction + " " + this->reg(dest) + ", " + this->reg(dest) + ", " + src + "\n";
+            }
+            return "\t" + instruction + " " + this->reg(dest) + ", " + src + "\n";
+        }
+
+        std::string mov(const std::string &instruction, const std::string &dest, const std::string &src) const {
+            return "\t" + std::string(this->avx ? "v" : "") + instruction + " " + dest + ", " + src + "\n";
+        }
+
+        std::string load() const {
+            return this->is_float ? "movu" + this->suffix : "movdqu";
+        }
+
+        std::string move() const {
+            return this->is_float ? "mova" + this->suffix : "movdqa";
+        }
+
+        std::string scalar_move() const {
+            return this->is_long ? "movsd" : "movss";
+        }
+
+        std::string arithmetic(const std::string &name) const {
+            // e.g., 'add' gives 'addps' or 'paddd'
+            return this->is_float ? name + this->suffix : "p" + name + this->suffix;
+        }
+
+        std::string bitwise(const std::string &name) const {
+            // e.g., 'and' gives 'andps' or 'pand'
+            return this->is_float ? name + this->suffix : "p" + name;
+        }
+
+        std::string all_ones(unsigned int n) const {
+            return this->op("pcmpeqd", n, n);
+        }
+
+        vector_isa(const DataType &type, target_cpu cpu)
+        {
+            DataType lane = type.get_subtype();
+            this->avx = cpu >= X86_64_V3;
+            this->width = type.get_width();
+            this->wide = this->width == 32;
+            this->lanes = type.get_array_length();
+            this->lane_width = lane.get_width();
+            this->is_float = lane.get_primary() == FLOAT;
+            this->is_long = this->lane_width == 8;
+            this->is_unsigned = lane.get_qualities().is_unsigned();
+            if (this->is_float) {
+                this->suffix = this->is_long ? "pd" : "ps";
+            }
+            else {
+                this->suffix = this->is_long ? "q" : "d";
+            }
+        }
+    };
+
+    bool is_simple(const Expression &e) {
+        /*
+
+        Simple operands can be loaded without evaluating anything else, so they can go straight into the second register of a binary expression
+
+        */
+
+        if (e.get_expression_type() == IDENTIFIER || e.get_expression_type() == LITERAL) {
+            return true;
+        }
+        else if (e.get_expression_type() == LIST) {
+            for (auto m: static_cast<const ListExpression&>(e).get_list()) {
+                if (m->get_expression_type() != LITERAL) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        return false;
+    }
+
+    std::string broadcast(const vector_isa &isa, unsigned int n) {
+        /*
+
+        Copies a scalar into every lane of register 'n'
+        Integers are taken from RAX, and floating-point values from the low lane of the register itself
+
+        */
+
+        std::stringstream broadcast_ss;
+        std::string x = "xmm" + std::to_string(n);
+        std::string r = isa.reg(n);
+
+        if (isa.is_float) {
+            if (isa.avx) {
+                if (isa.is_long && !isa.wide) {
+                    broadcast_ss << "\t" << "vmovddup " << x << ", " << x << std::endl;
+                }
+                else {
+                    broadcast_ss << "\t" << (isa.is_long ? "vbroadcastsd " : "vbroadcastss ") << r << ", " << x << std::endl;
+                }
+            }
+            else if (isa.is_long) {
+                broadcast_ss << "\t" << "unpcklpd " << x << ", " << x << std::endl;
+            }
+            else {
+                broadcast_ss << "\t" << "shufps " << x << ", " << x << ", 0" << std::endl;
+            }
+        }
+        else if (isa.avx) {
+            broadcast_ss << "\t" << (isa.is_long ? "vmovq " : "vmovd ") << x << ", " << (isa.is_long ? "rax" : "eax") << std::endl;
+            broadcast_ss << "\t" << (isa.is_long ? "vpbroadcastq " : "vpbroadcastd ") << r << ", " << x << std::endl;
+        }
+        else if (isa.is_long) {
+            broadcast_ss << "\t" << "movq " << x << ", rax" << std::endl;
+            broadcast_ss << "\t" << "punpcklqdq " << x << ", " << x << std::endl;
+        }
+        else {
+            broadcast_ss << "\t" << "movd " << x << ", eax" << std::endl;
+            broadcast_ss << "\t" << "pshufd " << x << ", " << x << ", 0" << std::endl;
+        }
+
+        return broadcast_ss.str();
+    }
+
+    std::string vector_operand(const symbol &sym, std::stringstream &load_ss) {
+        /*
+
+        Gets the memory operand for a vector variable, adding any code needed to address it to 'load_ss'
+
+        */
+
+        if (sym.get_data_type().get_qualities().is_static()) {
+            load_ss << "\t" << "lea rbx, [" << sym.get_name() << "]" << std::endl;
+            return "[rbx]";
+        }
+        else if (sym.get_offset() < 0) {
+            return "[rbp + " + std::to_string(-sym.get_offset()) + "]";
+        }
+        else {
+            return "[rbp - " + std::to_string(sym.get_offset()) + "]";
+        }
+    }
+
+    std::string displacement(long long d) {
+        // formats an address displacement, e.g. ' + 4' or ' - 12'
+        if (d < 0) {
+            return " - " + std::to_string(-d);
+        }
+        else if (d > 0) {
+            return " + " + std::to_string(d);
+        }
+        return "";
+    }
+}
+
+std::string compiler::evaluate_vector_expression(const Expression &e, const DataType &type, unsigned int line, unsigned int n) {
+    /*
+
+    evaluate_vector_expression
+    Generates code to compute a vector-typed expression
+
+    Scalars are broadcast to every lane of the vector. Note that only simple expressions (see 'is_simple') may be evaluated into a register other than the first, as anything else could clobber it.
+
+    @param  e   The expression to evaluate
+    @param  type    The vector type of the result
+    @param  line    The line number where the expression occurs
+    @param  n   The register for the result -- XMMn, or YMMn if the vector is 32 bytes wide
+    @return The generated code
+
+    */
+
+    vector_isa isa(type, this->_cpu);
+    if (isa.wide && !isa.avx) {
+        throw CompilerException(
+            "256-bit vectors require AVX2 (use --march=x86-64-v3)",
+            compiler_errors::UNSUPPORTED_FEATURE,
+            line
+        );
+    }
+
+    // lists give one value per lane
+    if (e.get_expression_type() == LIST) {
+        return this->evaluate_vector_list(static_cast<const ListExpression&>(e), type, line, n);
+    }
+
+    std::stringstream vector_ss;
+    DataType e_type = expression_util::get_expression_data_type(e, this->symbols, this->structs, line);
+
+    // anything else that isn't a vector is broadcast
+    if (e_type.get_primary() != VECTOR) {
+        vector_ss << this->evaluate_vector_scalar(e, type.get_subtype(), line, n);
+        vector_ss << broadcast(isa, n);
+        return vector_ss.str();
+    }
+
+    switch (e.get_expression_type()) {
+        case IDENTIFIER:
+        {
+            symbol &sym = *this->lookup(static_cast<const Identifier&>(e).getValue(), line);
+            if (!sym.was_initialized()) {
+                throw ReferencedBeforeInitializationException(sym.get_name(), line);
+            }
+            else if (!this->is_in_scope(sym)) {
+                throw OutOfScopeException(line);
+            }
+
+            std::string operand = vector_operand(sym, vector_ss);
+            vector_ss << isa.mov(isa.load(), isa.reg(n), operand);
+            break;
+        }
+        case BINARY:
+        {
+            auto &b = static_cast<const Binary&>(e);
+            if (b.get_operator() == DOT) {
+                vector_ss << this->get_exp_address(e, RBX, line).str();
+                vector_ss << isa.mov(isa.load(), isa.reg(n), "[rbx]");
+            }
+            else {
+                vector_ss << this->evaluate_vector_binary(b, line);
+            }
+            break;
+        }
+        case UNARY:
+        {
+            auto &u = static_cast<const Unary&>(e);
+            if (u.get_operator() == DEREFERENCE) {
+                vector_ss << this->get_exp_address(e, RBX, line).str();
+                vector_ss << isa.mov(isa.load(), isa.reg(n), "[rbx]");
+            }
+            else {
+                vector_ss << this->evaluate_vector_unary(u, type, line);
+            }
+            break;
+        }
+        case INDEXED:
+        {
+            // a vector indexed by a list of lanes is shuffled; otherwise, we have an element of an array of vectors
+            auto &idx = static_cast<const Indexed&>(e);
+            if (idx.get_index_value().get_expression_type() == LIST) {
+                vector_ss << this->evaluate_vector_shuffle(idx, type, line);
+            }
+            else {
+                vector_ss << this->get_exp_address(e, RBX, line).str();
+                vector_ss << isa.mov(isa.load(), isa.reg(n), "[rbx]");
+            }
+            break;
+        }
+        case CAST:
+        {
+            /*
+
+            Casts between vectors convert each lane; only 'int' and 'float' lanes may be converted, as there are no packed conversions between 64-bit integers and doubles before AVX-512.
+            Lanes that only differ in sign are reinterpreted.
+
+            */
+
+            auto &c = static_cast<const Cast&>(e);
+            DataType old_type = expression_util::get_expression_data_type(c.get_exp(), this->symbols, this->structs, line);
+            if (old_type.get_primary() == VECTOR) {
+                vector_isa old_isa(old_type, this->_cpu);
+                vector_ss << this->evaluate_vector_expression(c.get_exp(), old_type, line);
+                if (old_isa.is_float && !isa.is_float) {
+                    vector_ss << isa.mov("cvttps2dq", isa.reg(0), isa.reg(0));
+                }
+                else if (!old_isa.is_float && isa.is_float) {
+                    vector_ss << isa.mov("cvtdq2ps", isa.reg(0), isa.reg(0));
+                }
+            }
+            else {
+                vector_ss << this->evaluate_vector_scalar(c.get_exp(), type.get_subtype(), line, 0);
+                vector_ss << broadcast(isa, 0);
+            }
+            break;
+        }
+        default:
+        {
+            // calls (and anything else producing a vector) leave the result in XMM0
+            auto eval_p = this->evaluate_expression(e, line, &type);
+            vector_ss << eval_p.first;
+            if (n != 0) {
+                vector_ss << isa.mov(isa.move(), isa.reg(n), isa.reg(0));
+            }
+            break;
+        }
+    }
+
+    return vector_ss.str();
+}
+
+std::string compiler::evaluate_vector_scalar(const Expression &e, const DataType &lane, unsigned int line, unsigned int n) {
+    /*
+
+    evaluate_vector_scalar
+    Evaluates a scalar to be broadcast to, or placed in, the lanes of a vector
+
+    Floating-point values are left in the low lane of XMMn, converted to the width of the lane if necessary; integers are left in RAX, extended to the width of the lane.
+
+    @param  e   The scalar expression
+    @param  lane    The vector's lane type
+    @param  line    The line number where the expression occurs
+    @param  n   The register for floating-point values
+    @return The generated code
+
+    */
+
+    std::stringstream scalar_ss;
+    DataType t = expression_util::get_expression_data_type(e, this->symbols, this->structs, line);
+    if (t.get_primary() != lane.get_primary()) {
+        throw TypeException(line);
+    }
+
+    if (lane.get_primary() == FLOAT) {
+        std::string x = "xmm" + std::to_string(n);
+        std::string inst = t.get_width() == sin_widths::DOUBLE_WIDTH ? "movsd" : "movss";
+
+        if (e.get_expression_type() == LITERAL) {
+            // literals are written at the width of the lane, so they never need conversion
+            std::string float_label = magic_numbers::FLOAT_LITERAL_LABEL + std::to_string(this->fltc_num);
+            this->fltc_num += 1;
+            bool is_double = lane.get_width() == sin_widths::DOUBLE_WIDTH;
+            this->data_segment << float_label << ": " << (is_double ? "dq" : "dd") << " " << static_cast<const Literal&>(e).get_value() << std::endl;
+            scalar_ss << "\t" << (is_double ? "movsd " : "movss ") << x << ", [" << float_label << "]" << std::endl;
+            return scalar_ss.str();
+        }
+        else if (e.get_expression_type() == IDENTIFIER) {
+            symbol &sym = *this->lookup(static_cast<const Identifier&>(e).getValue(), line);
+            if (!sym.was_initialized()) {
+                throw ReferencedBeforeInitializationException(sym.get_name(), line);
+            }
+
+            if (sym.get_register() != NO_REGISTER) {
+                if (sym.get_register() != static_cast<reg>(XMM0 + n)) {
+                    scalar_ss << "\t" << "movaps " << x << ", " << register_usage::get_register_name(sym.get_register()) << std::endl;
+                }
+            }
+            else {
+                scalar_ss << get_address(sym, RBX);
+                scalar_ss << "\t" << inst << " " << x << ", [rbx]" << std::endl;
+            }
+        }
+        else if (
+            e.get_expression_type() == INDEXED &&
+            expression_util::get_expression_data_type(
+                static_cast<const Indexed&>(e).get_to_index(), this->symbols, this->structs, line
+            ).get_primary() != VECTOR
+        ) {
+            scalar_ss << this->get_exp_address(e, RBX, line).str();
+            scalar_ss << "\t" << inst << " " << x << ", [rbx]" << std::endl;
+        }
+        else {
+            // everything else leaves floating-point values in XMM0
+            scalar_ss << this->evaluate_expression(e, line, &t).first;
+            if (n != 0) {
+                scalar_ss << "\t" << "movaps " << x << ", xmm0" << std::endl;
+            }
+        }
+
+        if (t.get_width() < lane.get_width()) {
+            scalar_ss << "\t" << "cvtss2sd " << x << ", " << x << std::endl;
+        }
+        else if (t.get_width() > lane.get_width()) {
+            scalar_ss << "\t" << "cvtsd2ss " << x << ", " << x << std::endl;
+        }
+    }
+    else {
+        scalar_ss << this->evaluate_expression(e, line, &lane).first;
+        if (lane.get_width() == sin_widths::LONG_WIDTH && t.get_width() < sin_widths::LONG_WIDTH) {
+            if (t.get_qualities().is_unsigned()) {
+                scalar_ss << "\t" << "mov eax, eax" << std::endl;
+            }
+            else {
+                scalar_ss << "\t" << "movsxd rax, eax" << std::endl;
+            }
+        }
+    }
+
+    return scalar_ss.str();
+}
+
+std::string compiler::evaluate_vector_list(const ListExpression &l, const DataType &type, unsigned int line, unsigned int n) {
+    /*
+
+    evaluate_vector_list
+    Loads a list of values into the lanes of a vector
+
+    A list of literals is written to the .rodata segment and loaded with a single instruction; otherwise, each value is evaluated and written to the stack before the vector is loaded.
+
+    */
+
+    vector_isa isa(type, this->_cpu);
+    DataType lane = type.get_subtype();
+    std::stringstream list_ss;
+
+    auto values = l.get_list();
+    if (values.size() != isa.lanes) {
+        throw CompilerException(
+            "Expected " + std::to_string(isa.lanes) + " values for vector (one per lane)",
+            compiler_errors::TYPE_ERROR,
+            line
+        );
+    }
+
+    if (is_simple(l)) {
+        std::string label = magic_numbers::VECTOR_CONSTANT_LABEL + std::to_string(this->vecc_num);
+        this->vecc_num += 1;
+
+        this->rodata_segment << label << ": " << (isa.is_long ? "dq " : "dd ");
+        for (size_t i = 0; i < values.size(); i++) {
+            auto &value = static_cast<const Literal&>(*values[i]);
+            if (value.get_data_type().get_primary() != lane.get_primary()) {
+                throw TypeException(line);
+            }
+            this->rodata_segment << (i ? ", " : "") << value.get_value();
+        }
+        this->rodata_segment << std::endl;
+
+        list_ss << isa.mov(isa.load(), isa.reg(n), "[" + label + "]");
+    }
+    else {
+        list_ss << "\t" << "sub rsp, " << isa.width << std::endl;
+        for (size_t i = 0; i < values.size(); i++) {
+            list_ss << this->evaluate_vector_scalar(*values[i], lane, line, 0);
+            std::string destination = "[rsp" + displacement(i * isa.lane_width) + "]";
+            if (isa.is_float) {
+                list_ss << "\t" << isa.scalar_move() << " " << destination << ", xmm0" << std::endl;
+            }
+            else {
+                list_ss << "\t" << "mov " << destination << ", " << (isa.is_long ? "rax" : "eax") << std::endl;
+            }
+        }
+        list_ss << isa.mov(isa.load(), isa.reg(n), "[rsp]");
+        list_ss << "\t" << "add rsp, " << isa.width << std::endl;
+    }
+
+    return list_ss.str();
+}
+
+std::string compiler::evaluate_vector_binary(const Binary &b, unsigned int line) {
+    /*
+
+    evaluate_vector_binary
+    Generates code for a binary expression on vectors
+
+    The left operand is computed into XMM0 and the right into XMM1. If the right operand isn't simple, the left is held on the stack while the right is computed, unless the operator is commutative and the left operand is simple (in which case they are swapped).
+
+    @param  b   The binary expression
+    @param  line    The line number where the expression occurs
+    @return The generated code; the result is in XMM0
+
+    */
+
+    std::stringstream binary_ss;
+
+    DataType left_type = expression_util::get_expression_data_type(b.get_left(), this->symbols, this->structs, line);
+    DataType right_type = expression_util::get_expression_data_type(b.get_right(), this->symbols, this->structs, line);
+    exp_operator op = b.get_operator();
+
+    // the operation is performed on the type of the vector operand (the left one, if both are)
+    DataType operand_type = left_type.get_primary() == VECTOR ? left_type : right_type;
+    vector_isa isa(operand_type, this->_cpu);
+
+    // shifts take a scalar count, which is either an immediate or in XMM1
+    if (op == LEFT_SHIFT || op == RIGHT_SHIFT) {
+        std::string inst;
+        if (op == LEFT_SHIFT) {
+            inst = "psll" + isa.suffix;
+        }
+        else {
+            inst = (isa.is_unsigned || isa.is_long) ? "psrl" + isa.suffix : "psrad";
+        }
+
+        long long count;
+        if (induction_util::get_int_literal(b.get_right(), count)) {
+            binary_ss << this->evaluate_vector_expression(b.get_left(), operand_type, line);
+            binary_ss << isa.op(inst, 0, std::to_string(count));
+        }
+        else {
+            binary_ss << this->evaluate_expression(b.get_right(), line).first;
+            binary_ss << "\t" << "push rax" << std::endl;
+            binary_ss << this->evaluate_vector_expression(b.get_left(), operand_type, line);
+            binary_ss << "\t" << "pop rax" << std::endl;
+            binary_ss << "\t" << (isa.avx ? "vmovd" : "movd") << " xmm1, eax" << std::endl;
+            binary_ss << isa.op(inst, 0, "xmm1");
+        }
+
+        return binary_ss.str();
+    }
+
+    // with --fp-contract=fast, a product that is added or subtracted is fused with it; the product's right operand and the addend must be simple, as they are loaded straight into the second and third registers
+    if (this->_fp_contract && isa.is_float && this->_cpu >= X86_64_V3 && (op == PLUS || op == MINUS)) {
+        const Binary *product = nullptr;
+        const Expression *addend = nullptr;
+        bool negate_product = false;
+        if (b.get_left().get_expression_type() == BINARY && static_cast<const Binary&>(b.get_left()).get_operator() == MULT) {
+            product = static_cast<const Binary*>(&b.get_left());
+            addend = &b.get_right();
+        }
+        else if (b.get_right().get_expression_type() == BINARY && static_cast<const Binary&>(b.get_right()).get_operator() == MULT) {
+            product = static_cast<const Binary*>(&b.get_right());
+            addend = &b.get_left();
+            negate_product = op == MINUS;
+        }
+
+        if (product && is_simple(product->get_right()) && is_simple(*addend)) {
+            const Expression *operands[] = { &product->get_left(), &product->get_right(), addend };
+            for (unsigned int i = 0; i < 3; i++) {
+                DataType t = expression_util::get_expression_data_type(*operands[i], this->symbols, this->structs, line);
+                binary_ss << this->evaluate_vector_expression(*operands[i], t.get_primary() == VECTOR ? t : operand_type, line, i);
+            }
+
+            std::string inst = negate_product ? "vfnmadd213" : (op == MINUS ? "vfmsub213" : "vfmadd213");
+            binary_ss << "\t" << inst << isa.suffix << " " << isa.reg(0) << ", " << isa.reg(1) << ", " << isa.reg(2) << std::endl;
+            return binary_ss.str();
+        }
+    }
+
+    // get the operands in XMM0 and XMM1
+    bool commutative = (
+        op == PLUS || op == MULT || op == BIT_AND || op == BIT_OR || op == BIT_XOR || op == EQUAL || op == NOT_EQUAL
+    );
+    const Expression *left = &b.get_left();
+    const Expression *right = &b.get_right();
+    DataType left_eval_type = left_type.get_primary() == VECTOR ? left_type : operand_type;
+    DataType right_eval_type = right_type.get_primary() == VECTOR ? right_type : operand_type;
+    if (commutative && !is_simple(*right) && is_simple(*left)) {
+        std::swap(left, right);
+        std::swap(left_eval_type, right_eval_type);
+    }
+
+    binary_ss << this->evaluate_vector_expression(*left, left_eval_type, line);
+    if (is_simple(*right)) {
+        binary_ss << this->evaluate_vector_expression(*right, right_eval_type, line, 1);
+    }
+    else {
+        binary_ss << "\t" << "sub rsp, " << isa.width << std::endl;
+        binary_ss << isa.mov(isa.load(), "[rsp]", isa.reg(0));
+        binary_ss << this->evaluate_vector_expression(*right, right_eval_type, line);
+        binary_ss << isa.mov(isa.move(), isa.reg(1), isa.reg(0));
+        binary_ss << isa.mov(isa.load(), isa.reg(0), "[rsp]");
+        binary_ss << "\t" << "add rsp, " << isa.width << std::endl;
+    }
+
+    switch (op) {
+        case PLUS:
+            binary_ss << isa.op(isa.arithmetic("add"), 0, 1);
+            break;
+        case MINUS:
+            binary_ss << isa.op(isa.arithmetic("sub"), 0, 1);
+            break;
+        case MULT:
+            if (isa.is_float) {
+                binary_ss << isa.op("mul" + isa.suffix, 0, 1);
+            }
+            else if (this->_cpu >= X86_64_V2) {
+                binary_ss << isa.op("pmulld", 0, 1);
+            }
+            else {
+                // SSE2 can only multiply unsigned doublewords into quadwords, so multiply the even and odd lanes separately and interleave the low halves of the products
+                binary_ss << "\t" << "movdqa xmm2, xmm0" << std::endl;
+                binary_ss << "\t" << "pmuludq xmm0, xmm1" << std::endl;
+                binary_ss << "\t" << "psrlq xmm2, 32" << std::endl;
+                binary_ss << "\t" << "psrlq xmm1, 32" << std::endl;
+                binary_ss << "\t" << "pmuludq xmm2, xmm1" << std::endl;
+                binary_ss << "\t" << "pshufd xmm0, xmm0, 0x08" << std::endl;
+                binary_ss << "\t" << "pshufd xmm2, xmm2, 0x08" << std::endl;
+                binary_ss << "\t" << "punpckldq xmm0, xmm2" << std::endl;
+            }
+            break;
+        case DIV:
+            binary_ss << isa.op("div" + isa.suffix, 0, 1);
+            break;
+        case BIT_AND:
+            binary_ss << isa.op(isa.bitwise("and"), 0, 1);
+            break;
+        case BIT_OR:
+            binary_ss << isa.op(isa.bitwise("or"), 0, 1);
+            break;
+        case BIT_XOR:
+            binary_ss << isa.op(isa.bitwise("xor"), 0, 1);
+            break;
+        case EQUAL:
+        case NOT_EQUAL:
+        case LESS:
+        case GREATER:
+        case LESS_OR_EQUAL:
+        case GREATER_OR_EQUAL:
+        {
+            /*
+
+            Comparisons set every bit of a lane where they are true.
+            Floating-point lanes use 'cmpps' or 'cmppd', which only have less-than predicates in SSE, so greater-than comparisons swap their operands.
+            Integer lanes only have equality and (signed) greater-than; the other comparisons swap operands and invert the result, and unsigned lanes are biased by their sign bit first.
+
+            */
+
+            bool swap = op == GREATER || op == GREATER_OR_EQUAL;
+            if (isa.is_float) {
+                int predicate;
+                if (op == EQUAL) {
+                    predicate = 0;
+                }
+                else if (op == NOT_EQUAL) {
+                    predicate = 4;
+                }
+                else if (op == LESS || op == GREATER) {
+                    predicate = 1;
+                }
+                else {
+                    predicate = 2;
+                }
+
+                std::string inst = "cmp" + isa.suffix;
+                if (isa.avx) {
+                    binary_ss << "\t" << "v" << inst << " " << isa.reg(0) << ", " << isa.reg(swap ? 1 : 0) << ", " << isa.reg(swap ? 0 : 1) << ", " << predicate << std::endl;
+                }
+                else if (swap) {
+                    binary_ss << "\t" << inst << " xmm1, xmm0, " << predicate << std::endl;
+                    binary_ss << isa.mov(isa.move(), "xmm0", "xmm1");
+                }
+                else {
+                    binary_ss << "\t" << inst << " xmm0, xmm1, " << predicate << std::endl;
+                }
+            }
+            else {
+                if (isa.is_long && this->_cpu < X86_64_V2) {
+                    throw CompilerException(
+                        "Comparing vectors of 'long int' requires SSE4.2 (use --march=x86-64-v2)",
+                        compiler_errors::UNSUPPORTED_FEATURE,
+                        line
+                    );
+                }
+
+                bool invert = op == NOT_EQUAL || op == LESS_OR_EQUAL || op == GREATER_OR_EQUAL;
+                if (op == EQUAL || op == NOT_EQUAL) {
+                    binary_ss << isa.op("pcmpeq" + isa.suffix, 0, 1);
+                }
+                else {
+                    // 'a <= b' is 'not (a > b)', and 'a >= b' is 'not (b > a)'
+                    bool reverse = (op == LESS || op == GREATER_OR_EQUAL);
+
+                    if (isa.is_unsigned) {
+                        binary_ss << isa.all_ones(2);
+                        binary_ss << isa.op("psll" + isa.suffix, 2, isa.is_long ? "63" : "31");
+                        binary_ss << isa.op("pxor", 0, 2);
+                        binary_ss << isa.op("pxor", 1, 2);
+                    }
+
+                    if (!reverse) {
+                        binary_ss << isa.op("pcmpgt" + isa.suffix, 0, 1);
+                    }
+                    else if (isa.avx) {
+                        binary_ss << "\t" << "vpcmpgt" << isa.suffix << " " << isa.reg(0) << ", " << isa.reg(1) << ", " << isa.reg(0) << std::endl;
+                    }
+                    else {
+                        binary_ss << "\t" << "pcmpgt" << isa.suffix << " xmm1, xmm0" << std::endl;
+                        binary_ss << "\t" << "movdqa xmm0, xmm1" << std::endl;
+                    }
+                }
+
+                if (invert) {
+                    binary_ss << isa.all_ones(2);
+                    binary_ss << isa.op("pxor", 0, 2);
+                }
+            }
+            break;
+        }
+        default:
+            // get_vector_result_type has already rejected anything else
+            throw UndefinedOperatorError("vector", line);
+    }
+
+    return binary_ss.str();
+}
+
+std::string compiler::evaluate_vector_unary(const Unary &u, const DataType &type, unsigned int line) {
+    /*
+
+    evaluate_vector_unary
+    Generates code for a unary expression on a vector, leaving the result in XMM0
+
+    */
+
+    std::stringstream unary_ss;
+    vector_isa isa(type, this->_cpu);
+
+    unary_ss << this->evaluate_vector_expression(u.get_operand(), type, line);
+    switch (u.get_operator()) {
+        case UNARY_PLUS:
+            break;
+        case UNARY_MINUS:
+            if (isa.is_float) {
+                // flip the sign bits
+                unary_ss << isa.all_ones(1);
+                unary_ss << isa.op(isa.is_long ? "psllq" : "pslld", 1, isa.is_long ? "63" : "31");
+                unary_ss << isa.op("xor" + isa.suffix, 0, 1);
+            }
+            else if (isa.avx) {
+                unary_ss << isa.op("pxor", 1, 1);
+                unary_ss << "\t" << "vpsub" << isa.suffix << " " << isa.reg(0) << ", " << isa.reg(1) << ", " << isa.reg(0) << std::endl;
+            }
+            else {
+                unary_ss << "\t" << "pxor xmm1, xmm1" << std::endl;
+                unary_ss << "\t" << "psub" << isa.suffix << " xmm1, xmm0" << std::endl;
+                unary_ss << "\t" << "movdqa xmm0, xmm1" << std::endl;
+            }
+            break;
+        case BIT_NOT:
+            unary_ss << isa.all_ones(1);
+            unary_ss << isa.op(isa.bitwise("xor"), 0, 1);
+            break;
+        default:
+            throw UndefinedOperatorError("unary", line);
+    }
+
+    return unary_ss.str();
+}
+
+std::string compiler::evaluate_vector_shuffle(const Indexed &s, const DataType &type, unsigned int line) {
+    /*
+
+    evaluate_vector_shuffle
+    Rearranges the lanes of a vector
+
+    Indexing a vector with a list of lane numbers, as in 'v[{3, 2, 1, 0}]', gives a vector whose lanes are the selected lanes of 'v'. The lane numbers must be literals, as they are encoded in the instruction (or, for 8-lane vectors, in a constant).
+
+    */
+
+    std::stringstream shuffle_ss;
+    vector_isa isa(type, this->_cpu);
+
+    auto values = static_cast<const ListExpression&>(s.get_index_value()).get_list();
+    if (values.size() != isa.lanes) {
+        throw CompilerException(
+            "Expected " + std::to_string(isa.lanes) + " lanes for shuffle",
+            compiler_errors::TYPE_ERROR,
+            line
+        );
+    }
+
+    std::vector<unsigned int> lanes;
+    for (auto value: values) {
+        long long selected;
+        if (!induction_util::get_int_literal(*value, selected)) {
+            throw CompilerException(
+                "Vector lanes must be selected with an integer literal",
+                compiler_errors::TYPE_ERROR,
+                line
+            );
+        }
+        else if (selected < 0 || static_cast<size_t>(selected) >= isa.lanes) {
+            throw CompilerException("Vector lane out of range", compiler_errors::OUT_OF_BOUNDS, line);
+        }
+        lanes.push_back(static_cast<unsigned int>(selected));
+    }
+
+    shuffle_ss << this->evaluate_vector_expression(s.get_to_index(), type, line);
+
+    if (isa.wide && isa.lanes == 8) {
+        // 'vpermd' and 'vpermps' take their lane numbers from a register
+        std::string label = magic_numbers::VECTOR_CONSTANT_LABEL + std::to_string(this->vecc_num);
+        this->vecc_num += 1;
+        this->rodata_segment << label << ": dd ";
+        for (size_t i = 0; i < lanes.size(); i++) {
+            this->rodata_segment << (i ? ", " : "") << lanes[i];
+        }
+        this->rodata_segment << std::endl;
+
+        shuffle_ss << "\t" << "vmovdqu ymm1, [" << label << "]" << std::endl;
+        shuffle_ss << "\t" << (isa.is_float ? "vpermps" : "vpermd") << " ymm0, ymm1, ymm0" << std::endl;
+    }
+    else {
+        unsigned int imm = 0;
+        if (isa.lanes == 4) {
+            for (size_t i = 0; i < 4; i++) {
+                imm |= lanes[i] << (2 * i);
+            }
+        }
+        else if (isa.is_float) {
+            imm = lanes[0] | (lanes[1] << 1);
+        }
+        else {
+            // quadword lanes are shuffled as pairs of doublewords
+            imm = (2 * lanes[0]) | ((2 * lanes[0] + 1) << 2) | ((2 * lanes[1]) << 4) | ((2 * lanes[1] + 1) << 6);
+        }
+
+        std::string v = isa.avx ? "v" : "";
+        if (isa.wide) {
+            shuffle_ss << "\t" << (isa.is_float ? "vpermpd" : "vpermq") << " ymm0, ymm0, " << imm << std::endl;
+        }
+        else if (!isa.is_float) {
+            shuffle_ss << "\t" << v << "pshufd xmm0, xmm0, " << imm << std::endl;
+        }
+        else if (isa.avx) {
+            shuffle_ss << "\t" << "vshuf" << isa.suffix << " xmm0, xmm0, xmm0, " << imm << std::endl;
+        }
+        else {
+            shuffle_ss << "\t" << "shuf" << isa.suffix << " xmm0, xmm0, " << imm << std::endl;
+        }
+    }
+
+    return shuffle_ss.str();
+}
+
+std::string compiler::evaluate_vector_lane(const Indexed &lane, unsigned int line) {
+    /*
+
+    evaluate_vector_lane
+    Reads a single lane of a vector, as in 'v[2]'
+
+    Vectors held in variables are read straight from memory; anything else is computed and written to the stack first.
+    Floating-point lanes are left in XMM0 and integer lanes in RAX.
+
+    */
+
+    std::stringstream lane_ss;
+    DataType vector_type = expression_util::get_expression_data_type(lane.get_to_index(), this->symbols, this->structs, line);
+    vector_isa isa(vector_type, this->_cpu);
+
+    std::string operand;
+    bool spilled = false;
+    exp_type selected = lane.get_to_index().get_expression_type();
+    if (
+        selected == IDENTIFIER ||
+        (selected == BINARY && static_cast<const Binary&>(lane.get_to_index()).get_operator() == DOT)
+    ) {
+        lane_ss << this->get_exp_address(lane, RBX, line).str();
+        operand = "[rbx]";
+    }
+    else {
+        size_t k = expression_util::get_vector_lane(lane, vector_type, line);
+        lane_ss << this->evaluate_vector_expression(lane.get_to_index(), vector_type, line);
+        lane_ss << "\t" << "sub rsp, " << isa.width << std::endl;
+        lane_ss << isa.mov(isa.load(), "[rsp]", isa.reg(0));
+        if (isa.wide) {
+            lane_ss << "\t" << "vzeroupper" << std::endl;
+        }
+        operand = "[rsp" + displacement(k * isa.lane_width) + "]";
+        spilled = true;
+    }
+
+    if (isa.is_float) {
+        lane_ss << isa.mov(isa.scalar_move(), "xmm0", operand);
+    }
+    else {
+        lane_ss << "\t" << "mov " << (isa.is_long ? "rax" : "eax") << ", " << operand << std::endl;
+    }
+
+    if (spilled) {
+        lane_ss << "\t" << "add rsp, " << isa.width << std::endl;
+    }
+
+    return lane_ss.str();
+}
+
+std::string compiler::evaluate_vector_reduction(const AttributeSelection &attr, unsigned int line) {
+    /*
+
+    evaluate_vector_reduction
+    Combines the lanes of a vector with the 'sum', 'min', or 'max' attributes
+
+    The upper half of a 256-bit vector is first folded into the lower half; the lanes are then combined pairwise in log2(N) steps.
+    Floating-point results are left in XMM0 and integer results in RAX.
+
+    */
+
+    std::stringstream reduction_ss;
+    DataType vector_type = expression_util::get_expression_data_type(attr.get_selected(), this->symbols, this->structs, line);
+    vector_isa isa(vector_type, this->_cpu);
+
+    std::string inst;
+    if (attr.get_attribute() == SUM) {
+        inst = isa.arithmetic("add");
+    }
+    else {
+        std::string name = attr.get_attribute() == MINIMUM ? "min" : "max";
+        if (isa.is_float) {
+            inst = name + isa.suffix;
+        }
+        else if (isa.is_long) {
+            throw CompilerException(
+                "The min and max attributes are not supported for vectors of 'long int'",
+                compiler_errors::UNSUPPORTED_FEATURE,
+                line
+            );
+        }
+        else if (this->_cpu < X86_64_V2) {
+            throw CompilerException(
+                "The min and max attributes of 'int' vectors require SSE4.1 (use --march=x86-64-v2)",
+                compiler_errors::UNSUPPORTED_FEATURE,
+                line
+            );
+        }
+        else {
+            inst = "p" + name + (isa.is_unsigned ? "ud" : "sd");
+        }
+    }
+
+    reduction_ss << this->evaluate_vector_expression(attr.get_selected(), vector_type, line);
+
+    // all of the folding happens in 128-bit registers
+    vector_isa narrow(vector_type, this->_cpu);
+    narrow.wide = false;
+    std::string v = isa.avx ? "v" : "";
+    if (isa.wide) {
+        reduction_ss << "\t" << (isa.is_float ? "vextractf128" : "vextracti128") << " xmm1, ymm0, 1" << std::endl;
+        reduction_ss << narrow.op(inst, 0, 1);
+    }
+
+    reduction_ss << "\t" << v << "pshufd xmm1, xmm0, 0x4e" << std::endl;
+    reduction_ss << narrow.op(inst, 0, 1);
+    if (!isa.is_long) {
+        reduction_ss << "\t" << v << "pshufd xmm1, xmm0, 0xb1" << std::endl;
+        reduction_ss << narrow.op(inst, 0, 1);
+    }
+
+    if (!isa.is_float) {
+        reduction_ss << "\t" << v << (isa.is_long ? "movq rax, xmm0" : "movd eax, xmm0") << std::endl;
+    }
+
+    if (isa.wide) {
+        reduction_ss << "\t" << "vzeroupper" << std::endl;
+    }
+
+    return reduction_ss.str();
+}
+
+std::string compiler::get_vector_element_address(const Indexed &element, const DataType &type, unsigned int line) {
+    /*
+
+    get_vector_element_address
+    Gets the address of the array elements to load a vector from, or store one to, in RAX
+
+    A vector covers as many elements as it has lanes, starting with 'element', so the last of them must be within the array as well; this check is always performed, even if the access was already found to be within bounds.
+    The array's address is left in RBX.
+
+    */
+
+    std::stringstream address_ss;
+    vector_isa isa(type, this->_cpu);
+
+    DataType array_type = expression_util::get_expression_data_type(element.get_to_index(), this->symbols, this->structs, line);
+    if (
+        array_type.get_primary() != ARRAY ||
+        array_type.get_subtype().get_primary() != type.get_subtype().get_primary() ||
+        array_type.get_subtype().get_width() != isa.lane_width
+    ) {
+        throw TypeException(line);
+    }
+
+    // accesses in a loop may have a pointer that was derived from the induction variable (see compiler::reduce_loop)
+    auto it = this->induction_pointers.find(&element);
+    if (it != this->induction_pointers.end()) {
+        address_ss << expression_util::get_exp_address(element.get_to_index(), this->symbols, this->structs, RBX, line).str();
+        address_ss << "\t" << "mov rax, [rbp - " << it->second << "]" << std::endl;
+    }
+    else {
+        address_ss << this->evaluate_expression(element.get_index_value(), line).first;
+        address_ss << "\t" << "push rax" << std::endl;
+        address_ss << expression_util::get_exp_address(element.get_to_index(), this->symbols, this->structs, RBX, line).str();
+        address_ss << "\t" << "pop rax" << std::endl;
+        address_ss << "\t" << "mov eax, eax" << std::endl;
+        address_ss << "\t" << "lea rax, [rbx + rax*" << isa.lane_width << " + " << sin_widths::INT_WIDTH << "]" << std::endl;
+    }
+
+    // the vector must start at or before the last 'N' elements
+    long long last = static_cast<long long>(sin_widths::INT_WIDTH) - static_cast<long long>(isa.width);
+    address_ss << "\t" << "mov edx, [rbx]" << std::endl;
+    address_ss << "\t" << "lea rdx, [rbx + rdx*" << isa.lane_width << displacement(last) << "]" << std::endl;
+    address_ss << "\t" << "cmp rax, rdx" << std::endl;
+    address_ss << "\t" << "jbe .sinl_rtbounds_" << this->rtbounds_num << std::endl;
+    address_ss << "\t" << "call " << magic_numbers::SINL_RTE_OUT_OF_BOUNDS << std::endl;
+    address_ss << ".sinl_rtbounds_" << this->rtbounds_num << ":" << std::endl;
+    this->rtbounds_num += 1;
+
+    return address_ss.str();
+}
+
+std::stringstream compiler::assign_vector(
+    const DataType &lhs_type,
+    const DataType &rhs_type,
+    const assign_utilities::destination_information &dest,
+    const Expression &rvalue,
+    unsigned int line
+) {
+    /*
+
+    assign_vector
+    Generates code to assign a value to a vector
+
+    The value may be another vector, a list with one value per lane, or a scalar (which is broadcast to every lane). An array element, as in
+        let v = a[i];
+    loads the vector from that element and those following it.
+
+    */
+
+    std::stringstream assign_ss;
+    vector_isa isa(lhs_type, this->_cpu);
+
+    if (rhs_type.get_primary() == VECTOR && !lhs_type.is_compatible(rhs_type)) {
+        throw TypeException(line);
+    }
+
+    if (
+        rvalue.get_expression_type() == INDEXED &&
+        expression_util::get_expression_data_type(
+            static_cast<const Indexed&>(rvalue).get_to_index(), this->symbols, this->structs, line
+        ).get_primary() == ARRAY
+    ) {
+        assign_ss << this->get_vector_element_address(static_cast<const Indexed&>(rvalue), lhs_type, line);
+        assign_ss << isa.mov(isa.load(), isa.reg(0), "[rax]");
+    }
+    else {
+        assign_ss << this->evaluate_vector_expression(rvalue, lhs_type, line);
+    }
+
+    assign_ss << dest.fetch_instructions;
+    assign_ss << isa.mov(isa.load(), dest.dest_location, isa.reg(0));
+    if (isa.wide) {
+        assign_ss << "\t" << "vzeroupper" << std::endl;
+    }
+
+    return assign_ss;
+}
+
+std::stringstream compiler::store_vector(const Indexed &element, const Expression &rvalue, unsigned int line) {
+    /*
+
+    store_vector
+    Stores a vector to an array element and those following it, as in
+        let a[i] = v;
+
+    */
+
+    std::stringstream store_ss;
+    DataType type = expression_util::get_expression_data_type(rvalue, this->symbols, this->structs, line);
+    vector_isa isa(type, this->_cpu);
+
+    store_ss << this->get_vector_element_address(element, type, line);
+    store_ss << "\t" << "push rax" << std::endl;
+    store_ss << this->evaluate_vector_expression(rvalue, type, line);
+    store_ss << "\t" << "pop rax" << std::endl;
+    store_ss << isa.mov(isa.load(), "[rax]", isa.reg(0));
+    if (isa.wide) {
+        store_ss << "\t" << "vzeroupper" << std::endl;
+    }
+
+    return store_ss;
+}
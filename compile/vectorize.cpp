@@ -0,0 +1,534 @@
+/*
+
+SIN Toolchain (x86 target)
+vectorize.cpp
+Copyright 2021 Riley Lannon
+
+Generates packed SSE and AVX code for loops over arrays (see compile_util/vector_util.h)
+
+*/
+
+#include <algorithm>
+
+#include "compiler.h"
+#include "opt/program_info.h"
+
+namespace
+{
+    // the vector registers used by vectorized loops; the compiler never allocates these to symbols
+    const unsigned int FIRST_VECTOR_REGISTER = 8;
+    const unsigned int VECTOR_REGISTER_COUNT = 8;
+
+    struct vector_isa {
+        /*
+
+        The instructions for an element type, in either their SSE or AVX forms
+
+        */
+
+        bool avx;
+        std::string load;   // unaligned load/store
+        std::string move;   // register to register
+        std::string add;
+        std::string sub;
+        std::string mul;
+        std::string div;
+        std::string zero;
+        std::string suffix; // 'ps' or 'pd' for floating-point elements
+
+        std::string reg(unsigned int n) const {
+            return (this->avx ? "ymm" : "xmm") + std::to_string(FIRST_VECTOR_REGISTER + n);
+        }
+
+        std::string op(const std::string &instruction, unsigned int dest, unsigned int src) const {
+            // AVX instructions take a separate destination
+            if (this->avx) {
+                return "\tv" + instruction + " " + this->reg(dest) + ", " + this->reg(dest) + ", " + this->reg(src) + "\n";
+            }
+            return "\t" + instruction + " " + this->reg(dest) + ", " + this->reg(src) + "\n";
+        }
+
+        std::string mov(const std::string &instruction, const std::string &dest, const std::string &src) const {
+            return "\t" + std::string(this->avx ? "v" : "") + instruction + " " + dest + ", " + src + "\n";
+        }
+
+        std::string fma(const std::string &form, unsigned int dest, unsigned int a, unsigned int b) const {
+            // FMA3 instructions only have VEX encodings, e.g. 'fmadd231' gives 'vfmadd231ps'
+            return "\tv" + form + this->suffix + " " + this->reg(dest) + ", " + this->reg(a) + ", " + this->reg(b) + "\n";
+        }
+
+        vector_isa(vector_util::element_kind kind, bool avx)
+            : avx(avx)
+        {
+            if (kind == vector_util::VECTOR_INT) {
+                this->load = "movdqu";
+                this->move = "movdqa";
+                this->add = "paddd";
+                this->sub = "psubd";
+                this->mul = "pmulld";
+                this->zero = "pxor";
+            }
+            else {
+                this->suffix = (kind == vector_util::VECTOR_FLOAT) ? "ps" : "pd";
+                this->load = "movu" + this->suffix;
+                this->move = "mova" + this->suffix;
+                this->add = "add" + this->suffix;
+                this->sub = "sub" + this->suffix;
+                this->mul = "mul" + this->suffix;
+                this->div = "div" + this->suffix;
+                this->zero = "xor" + this->suffix;
+            }
+        }
+    };
+
+    bool in_register(const Expression &e) {
+        // temporaries and invariants are always in registers
+        return e.get_expression_type() == IDENTIFIER || e.get_expression_type() == LITERAL;
+    }
+
+    unsigned int find_operand(const Expression &e, const vector_util::vector_loop &plan) {
+        /*
+
+        Gets the register holding a temporary or invariant; the accumulators come first, then the temporaries, then the invariants
+
+        */
+
+        unsigned int first_temporary = plan.accumulators.size();
+        if (e.get_expression_type() == IDENTIFIER) {
+            auto it = std::find(plan.temporaries.begin(), plan.temporaries.end(), static_cast<const Identifier&>(e).getValue());
+            if (it != plan.temporaries.end()) {
+                return first_temporary + (it - plan.temporaries.begin());
+            }
+        }
+
+        unsigned int first_invariant = first_temporary + plan.temporaries.size();
+        std::string key = program_info::expression_key(e);
+        for (unsigned int i = 0; i < plan.invariants.size(); i++) {
+            if (program_info::expression_key(*plan.invariants[i]) == key) {
+                return first_invariant + i;
+            }
+        }
+
+        throw CompilerException("Value was not broadcast before vectorized loop", compiler_errors::UNSUPPORTED_FEATURE, 0);
+    }
+
+    const Binary *get_product(const Expression &e) {
+        // gets a multiplication that could be fused with an addition
+        if (e.get_expression_type() == BINARY && static_cast<const Binary&>(e).get_operator() == MULT) {
+            return &static_cast<const Binary&>(e);
+        }
+        return nullptr;
+    }
+
+    unsigned int find_array(const std::string &name, const vector_util::vector_loop &plan) {
+        return std::find(plan.arrays.begin(), plan.arrays.end(), name) - plan.arrays.begin();
+    }
+}
+
+std::string compiler::evaluate_vector(
+    const Expression &e,
+    const vector_util::vector_loop &plan,
+    const std::vector<reg> &bases,
+    unsigned int temp
+) {
+    /*
+
+    evaluate_vector
+    Computes a value for every element in the current chunk of a vectorized loop
+
+    The element index is in RAX, and the address of each array's first element is in its register from 'bases'. The left operand of a binary expression is computed into 'temp' and the right into the next register, unless it is a temporary or invariant (which is already in a register).
+
+    @param  e   The value to compute
+    @param  plan    The loop's vectorization plan
+    @param  bases   The registers holding the arrays' element addresses
+    @param  temp    The vector register to compute the value into
+    @return The generated code
+
+    */
+
+    vector_isa isa(plan.kind, this->_cpu >= X86_64_V3);
+    std::stringstream vector_ss;
+
+    if (e.get_expression_type() == INDEXED) {
+        auto &idx = static_cast<const Indexed&>(e);
+        reg base = bases[find_array(static_cast<const Identifier&>(idx.get_to_index()).getValue(), plan)];
+        vector_ss << isa.mov(isa.load, isa.reg(temp), "[" + register_usage::get_register_name(base) + " + rax*" + std::to_string(plan.width) + "]");
+    }
+    else if (in_register(e)) {
+        vector_ss << isa.mov(isa.move, isa.reg(temp), isa.reg(find_operand(e, plan)));
+    }
+    else {
+        auto &b = static_cast<const Binary&>(e);
+
+        // with --fp-contract=fast, 'a * b + c' is fused when 'b' or 'c' is already in a register, so it needs no more registers than it would otherwise
+        bool contract = this->_fp_contract && isa.avx && plan.kind != vector_util::VECTOR_INT && (b.get_operator() == PLUS || b.get_operator() == MINUS);
+        const Binary *product = contract ? get_product(b.get_left()) : nullptr;
+        const Expression *addend = &b.get_right();
+        if (contract && !product && get_product(b.get_right())) {
+            product = get_product(b.get_right());
+            addend = &b.get_left();
+        }
+
+        if (product && (in_register(product->get_right()) || in_register(*addend))) {
+            vector_ss << this->evaluate_vector(product->get_left(), plan, bases, temp);
+
+            unsigned int operands[2];
+            const Expression *sources[] = { &product->get_right(), addend };
+            for (unsigned int i = 0; i < 2; i++) {
+                if (in_register(*sources[i])) {
+                    operands[i] = find_operand(*sources[i], plan);
+                }
+                else {
+                    vector_ss << this->evaluate_vector(*sources[i], plan, bases, temp + 1);
+                    operands[i] = temp + 1;
+                }
+            }
+
+            std::string form;
+            if (b.get_operator() == PLUS) {
+                form = "fmadd213";
+            }
+            else if (addend == &b.get_right()) {
+                form = "fmsub213";
+            }
+            else {
+                form = "fnmadd213";
+            }
+            vector_ss << isa.fma(form, temp, operands[0], operands[1]);
+            return vector_ss.str();
+        }
+
+        std::string instruction;
+        switch (b.get_operator()) {
+            case PLUS:
+                instruction = isa.add;
+                break;
+            case MINUS:
+                instruction = isa.sub;
+                break;
+            case MULT:
+                instruction = isa.mul;
+                break;
+            default:
+                instruction = isa.div;
+                break;
+        }
+
+        vector_ss << this->evaluate_vector(b.get_left(), plan, bases, temp);
+        if (in_register(b.get_right())) {
+            vector_ss << isa.op(instruction, temp, find_operand(b.get_right(), plan));
+        }
+        else {
+            vector_ss << this->evaluate_vector(b.get_right(), plan, bases, temp + 1);
+            vector_ss << isa.op(instruction, temp, temp + 1);
+        }
+    }
+
+    return vector_ss.str();
+}
+
+std::stringstream compiler::vectorize_loop(const WhileLoop &loop, size_t block_num) {
+    /*
+
+    vectorize_loop
+    Generates a vectorized version of a loop, to be executed before the loop itself
+
+    The vectorized loop handles as many elements as it can in whole vectors -- four 'int' or 'float' or two 'double' elements at a time with SSE, or twice as many with AVX2 (at -march=x86-64-v3) -- and then updates the index (and any accumulators) so that the original loop handles the rest.
+    Before it begins, the vectorized loop checks that every element it will touch is in bounds, and that no array it stores to overlaps with another array within the span of a vector (which is only possible for dynamic arrays). If either check fails, it is skipped entirely and the original loop, with its own bounds checks, does all of the work.
+
+    @param  loop    The loop to vectorize
+    @param  block_num   The number of the loop's block, used for labels
+    @return The code for the vectorized loop, or nothing if it can't be vectorized
+
+    */
+
+    std::stringstream vector_ss;
+    vector_util::vector_loop plan;
+    if (
+        this->_opt_level == 0 ||
+        !this->current_definition ||
+        !vector_util::analyze_loop(loop, this->current_locals, this->symbols, plan)
+    ) {
+        return vector_ss;
+    }
+
+    // a vectorized floating-point sum adds the elements in a different order, which may change the result
+    if (plan.kind != vector_util::VECTOR_INT && !plan.accumulators.empty() && !this->_fp_reassociate) {
+        return vector_ss;
+    }
+
+    // packed 32-bit multiplication requires SSE4.1
+    bool avx = this->_cpu >= X86_64_V3;
+    if (plan.uses_int_multiply && this->_cpu < X86_64_V2) {
+        return vector_ss;
+    }
+
+    // we need a vector register for each accumulator, temporary, and invariant, plus those used to compute values
+    unsigned int accumulators = plan.accumulators.size();
+    unsigned int first_invariant = accumulators + plan.temporaries.size();
+    unsigned int first_temp = first_invariant + plan.invariants.size();
+    if (first_temp + plan.registers > VECTOR_REGISTER_COUNT) {
+        return vector_ss;
+    }
+
+    // each array's element address is held in a register for the duration of the loop
+    if (this->reg_stack.peek().is_in_use(RCX) || this->reg_stack.peek().is_in_use(RDX)) {
+        return vector_ss;
+    }
+
+    std::vector<reg> bases;
+    for (reg r: { R8, R9, R10, R11, R12, R13, R14, R15 }) {
+        if (bases.size() < plan.arrays.size() && !this->reg_stack.peek().is_in_use(r)) {
+            bases.push_back(r);
+        }
+    }
+    if (bases.size() < plan.arrays.size()) {
+        return vector_ss;
+    }
+
+    vector_isa isa(plan.kind, avx);
+    size_t elements = (avx ? 32 : 16) / plan.width;
+    size_t vector_width = elements * plan.width;
+    std::string body_label = magic_numbers::VECTOR_BODY_LABEL + std::to_string(block_num);
+    std::string skip_label = magic_numbers::VECTOR_SKIP_LABEL + std::to_string(block_num);
+
+    // clear the accumulators and broadcast every invariant into all of its register's lanes
+    for (unsigned int i = 0; i < accumulators; i++) {
+        vector_ss << isa.op(isa.zero, i, i);
+    }
+
+    for (unsigned int i = 0; i < plan.invariants.size(); i++) {
+        const Expression &invariant = *plan.invariants[i];
+        std::string r = isa.reg(first_invariant + i);
+        std::string r_xmm = "xmm" + std::to_string(FIRST_VECTOR_REGISTER + first_invariant + i);
+
+        if (plan.kind == vector_util::VECTOR_INT) {
+            long long value;
+            if (induction_util::get_int_literal(invariant, value)) {
+                vector_ss << "\t" << "mov eax, " << value << std::endl;
+            }
+            else {
+                vector_ss << get_address(this->symbols.find(static_cast<const Identifier&>(invariant).getValue()), RBX);
+                vector_ss << "\t" << "mov eax, [rbx]" << std::endl;
+            }
+
+            if (avx) {
+                vector_ss << "\t" << "vmovd " << r_xmm << ", eax" << std::endl;
+                vector_ss << "\t" << "vpbroadcastd " << r << ", " << r_xmm << std::endl;
+            }
+            else {
+                vector_ss << "\t" << "movd " << r << ", eax" << std::endl;
+                vector_ss << "\t" << "pshufd " << r << ", " << r << ", 0" << std::endl;
+            }
+        }
+        else {
+            bool is_double = plan.kind == vector_util::VECTOR_DOUBLE;
+            if (invariant.get_expression_type() == LITERAL) {
+                std::string float_label = magic_numbers::FLOAT_LITERAL_LABEL + std::to_string(this->fltc_num);
+                this->fltc_num += 1;
+                this->data_segment << float_label << ": " << (is_double ? "dq" : "dd") << " " << static_cast<const Literal&>(invariant).get_value() << std::endl;
+                vector_ss << "\t" << "lea rbx, [" << float_label << "]" << std::endl;
+            }
+            else {
+                vector_ss << get_address(this->symbols.find(static_cast<const Identifier&>(invariant).getValue()), RBX);
+            }
+
+            if (avx) {
+                vector_ss << "\t" << (is_double ? "vbroadcastsd " : "vbroadcastss ") << r << ", [rbx]" << std::endl;
+            }
+            else if (is_double) {
+                vector_ss << "\t" << "movsd " << r << ", [rbx]" << std::endl;
+                vector_ss << "\t" << "unpcklpd " << r << ", " << r << std::endl;
+            }
+            else {
+                vector_ss << "\t" << "movss " << r << ", [rbx]" << std::endl;
+                vector_ss << "\t" << "shufps " << r << ", " << r << ", 0" << std::endl;
+            }
+        }
+    }
+
+    // get the index in RAX and the end of the last whole vector in RDX, skipping to the original loop if there isn't one
+    auto &index_sym = this->symbols.find(plan.index);
+    if (plan.limit->get_expression_type() == LITERAL) {
+        long long value;
+        induction_util::get_int_literal(*plan.limit, value);
+        vector_ss << "\t" << "mov edx, " << value << std::endl;
+    }
+    else {
+        const Expression &limit_name = (plan.limit->get_expression_type() == ATTRIBUTE) ?
+            static_cast<const AttributeSelection&>(*plan.limit).get_selected() :
+            *plan.limit;
+        vector_ss << get_address(this->symbols.find(static_cast<const Identifier&>(limit_name).getValue()), RBX);
+        vector_ss << "\t" << "mov edx, [rbx]" << std::endl;     // an array's length is stored at its address
+    }
+
+    vector_ss << get_address(index_sym, RBX);
+    vector_ss << "\t" << "mov eax, [rbx]" << std::endl;
+    vector_ss << "\t" << "mov ecx, edx" << std::endl;
+    vector_ss << "\t" << "sub ecx, eax" << std::endl;
+    vector_ss << "\t" << "jbe " << skip_label << std::endl;
+    vector_ss << "\t" << "and ecx, -" << elements << std::endl;
+    vector_ss << "\t" << "jz " << skip_label << std::endl;
+    vector_ss << "\t" << "lea rdx, [rax + rcx]" << std::endl;
+
+    // check the bounds once, for the last element we will touch
+    for (size_t i = 0; i < plan.arrays.size(); i++) {
+        vector_ss << get_address(this->symbols.find(plan.arrays[i]), bases[i]);
+        vector_ss << "\t" << "cmp edx, [" << register_usage::get_register_name(bases[i]) << "]" << std::endl;
+        vector_ss << "\t" << "ja " << skip_label << std::endl;
+        vector_ss << "\t" << "add " << register_usage::get_register_name(bases[i]) << ", " << sin_widths::INT_WIDTH << std::endl;
+    }
+
+    // dynamic arrays may share memory; the arrays we store to must not overlap any other within a vector's width
+    for (auto &stored: plan.stored) {
+        size_t s = find_array(stored, plan);
+        for (size_t i = 0; i < plan.arrays.size(); i++) {
+            if (
+                i == s ||
+                !this->symbols.find(stored).get_data_type().is_reference_type() ||
+                !this->symbols.find(plan.arrays[i]).get_data_type().is_reference_type() ||
+                (std::find(plan.stored.begin(), plan.stored.end(), plan.arrays[i]) != plan.stored.end() && i < s)   // already checked
+            ) {
+                continue;
+            }
+
+            vector_ss << "\t" << "mov rcx, " << register_usage::get_register_name(bases[s]) << std::endl;
+            vector_ss << "\t" << "sub rcx, " << register_usage::get_register_name(bases[i]) << std::endl;
+            vector_ss << "\t" << "add rcx, " << vector_width - 1 << std::endl;
+            vector_ss << "\t" << "cmp rcx, " << 2 * vector_width - 1 << std::endl;
+            vector_ss << "\t" << "jb " << skip_label << std::endl;
+        }
+    }
+
+    // the vectorized loop itself
+    vector_ss << body_label << ":" << std::endl;
+    unsigned int accumulator = 0;
+    for (auto &vs: plan.statements) {
+        // values already in a register can be accumulated directly
+        if (!vs.accumulator.empty() && in_register(*vs.value)) {
+            vector_ss << isa.op(vs.subtract ? isa.sub : isa.add, accumulator, find_operand(*vs.value, plan));
+            accumulator += 1;
+            continue;
+        }
+
+        // with --fp-contract=fast, products are fused with their accumulation
+        const Binary *product = get_product(*vs.value);
+        if (!vs.accumulator.empty() && product && this->_fp_contract && avx && plan.kind != vector_util::VECTOR_INT) {
+            vector_ss << this->evaluate_vector(product->get_left(), plan, bases, first_temp);
+
+            unsigned int right = first_temp + 1;
+            if (in_register(product->get_right())) {
+                right = find_operand(product->get_right(), plan);
+            }
+            else {
+                vector_ss << this->evaluate_vector(product->get_right(), plan, bases, right);
+            }
+
+            vector_ss << isa.fma(vs.subtract ? "fnmadd231" : "fmadd231", accumulator, first_temp, right);
+            accumulator += 1;
+            continue;
+        }
+
+        vector_ss << this->evaluate_vector(*vs.value, plan, bases, first_temp);
+        if (!vs.temporary.empty()) {
+            vector_ss << isa.mov(isa.move, isa.reg(find_operand(Identifier(vs.temporary), plan)), isa.reg(first_temp));
+        }
+        else if (!vs.accumulator.empty()) {
+            vector_ss << isa.op(vs.subtract ? isa.sub : isa.add, accumulator, first_temp);
+            accumulator += 1;
+        }
+        else {
+            std::string dest = "[" + register_usage::get_register_name(bases[find_array(vs.array, plan)]) + " + rax*" + std::to_string(plan.width) + "]";
+            vector_ss << isa.mov(isa.load, dest, isa.reg(first_temp));
+        }
+    }
+    vector_ss << "\t" << "add rax, " << elements << std::endl;
+    vector_ss << "\t" << "cmp rax, rdx" << std::endl;
+    vector_ss << "\t" << "jb " << body_label << std::endl;
+
+    // the original loop picks up where we left off
+    vector_ss << get_address(index_sym, RBX);
+    vector_ss << "\t" << "mov [rbx], eax" << std::endl;
+
+    // sum the lanes of each accumulator into its variable
+    accumulator = 0;
+    std::string t = "xmm" + std::to_string(FIRST_VECTOR_REGISTER + first_temp);
+    for (auto &vs: plan.statements) {
+        if (vs.accumulator.empty()) {
+            continue;
+        }
+
+        std::string a = "xmm" + std::to_string(FIRST_VECTOR_REGISTER + accumulator);
+        std::string v = avx ? "v" : "";
+        auto op = [&](const std::string &instruction, const std::string &dest, const std::string &src) {
+            if (avx) {
+                vector_ss << "\t" << "v" << instruction << " " << dest << ", " << dest << ", " << src << std::endl;
+            }
+            else {
+                vector_ss << "\t" << instruction << " " << dest << ", " << src << std::endl;
+            }
+        };
+
+        vector_ss << get_address(this->symbols.find(vs.accumulator), RBX);
+        if (avx) {
+            // fold the upper half into the lower half first
+            vector_ss << "\t" << (plan.kind == vector_util::VECTOR_INT ? "vextracti128 " : "vextractf128 ") << t << ", " << isa.reg(accumulator) << ", 1" << std::endl;
+        }
+
+        if (plan.kind == vector_util::VECTOR_INT) {
+            if (avx) {
+                op("paddd", a, t);
+            }
+            vector_ss << "\t" << v << "pshufd " << t << ", " << a << ", 0x4e" << std::endl;
+            op("paddd", a, t);
+            vector_ss << "\t" << v << "pshufd " << t << ", " << a << ", 0xb1" << std::endl;
+            op("paddd", a, t);
+            vector_ss << "\t" << v << "movd ecx, " << a << std::endl;
+            vector_ss << "\t" << "add [rbx], ecx" << std::endl;
+        }
+        else if (plan.kind == vector_util::VECTOR_FLOAT) {
+            if (avx) {
+                op("addps", a, t);
+                vector_ss << "\t" << "vmovhlps " << t << ", " << t << ", " << a << std::endl;
+            }
+            else {
+                vector_ss << "\t" << "movhlps " << t << ", " << a << std::endl;
+            }
+            op("addps", a, t);
+            if (avx) {
+                vector_ss << "\t" << "vshufps " << t << ", " << a << ", " << a << ", 0x55" << std::endl;
+            }
+            else {
+                vector_ss << "\t" << "movaps " << t << ", " << a << std::endl;
+                vector_ss << "\t" << "shufps " << t << ", " << t << ", 0x55" << std::endl;
+            }
+            op("addss", a, t);
+            op("addss", a, "[rbx]");
+            vector_ss << "\t" << v << "movss [rbx], " << a << std::endl;
+        }
+        else {
+            if (avx) {
+                op("addpd", a, t);
+                vector_ss << "\t" << "vunpckhpd " << t << ", " << a << ", " << a << std::endl;
+            }
+            else {
+                vector_ss << "\t" << "movapd " << t << ", " << a << std::endl;
+                vector_ss << "\t" << "unpckhpd " << t << ", " << t << std::endl;
+            }
+            op("addsd", a, t);
+            op("addsd", a, "[rbx]");
+            vector_ss << "\t" << v << "movsd [rbx], " << a << std::endl;
+        }
+
+        accumulator += 1;
+    }
+
+    vector_ss << skip_label << ":" << std::endl;
+
+    // avoid the penalty for mixing AVX and legacy SSE instructions in the code that follows
+    if (avx) {
+        vector_ss << "\t" << "vzeroupper" << std::endl;
+    }
+
+    return vector_ss;
+}
@@ -11,6 +11,13 @@ For a documentation of the language, see either the doc folder in this project o
 // C++/STL headers
 #include <fstream>
 #include <iostream>
+#include <cstdio>
+#include <cstdlib>
+
+// POSIX headers
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
 
 // Third-party libraries
 #include <args.hxx>
@@ -24,6 +31,59 @@ For a documentation of the language, see either the doc folder in this project o
 static const std::string VERSION = "0.0.0a";
 static const std::string YEAR = "2021";
 
+extern char **environ;
+
+static bool assemble(const std::string &asm_name, const std::string &obj_name) {
+	/*
+
+	assemble
+	Assembles a file with NASM, producing an ELF64 object file
+
+	NASM is run directly, rather than through a shell, so that file names are passed to it as they are
+
+	*/
+
+	std::string program = "nasm";
+	std::string format = "-felf64";
+	std::string output = "-o";
+	std::string obj = obj_name;
+	std::string source = asm_name;
+	char *argv[] = { &program[0], &format[0], &output[0], &obj[0], &source[0], nullptr };
+
+	pid_t pid;
+	if (posix_spawnp(&pid, "nasm", nullptr, nullptr, argv, environ) != 0) {
+		return false;
+	}
+
+	int status;
+	if (waitpid(pid, &status, 0) == -1) {
+		return false;
+	}
+
+	return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+static bool make_temp_file(std::string &name) {
+	/*
+
+	make_temp_file
+	Creates a new, empty file in the temporary directory for the intermediate assembly, so that no existing file is overwritten
+
+	*/
+
+	const char *dir = std::getenv("TMPDIR");
+	std::string path_template = std::string(dir && *dir ? dir : "/tmp") + "/sinx86-XXXXXX";
+
+	int fd = mkstemp(&path_template[0]);
+	if (fd == -1) {
+		return false;
+	}
+	close(fd);
+
+	name = path_template;
+	return true;
+}
+
 int main (int argc, char **argv) {
 	// Create the argument parser
 	args::ArgumentParser parser("Compiler for the SIN programming language.", "See the GitHub repository for bug tracking, documentation, etc.");
@@ -34,11 +94,19 @@ int main (int argc, char **argv) {
 	// File name options
 	args::Positional<std::string> filename(parser, "filename", "The .sin file to compile");
 	args::ValueFlag<std::string> outfile(parser, "outfile", "Specify an output assmembly file", {'o', "outfile"});
+	args::ValueFlag<std::string> emit(parser, "emit", "Determines what the compiler produces; accepted options are 'asm' (the default) or 'obj' (an ELF64 object file)", {"emit"});
 
 	// Compiler mode options
 	args::Flag use_micro(parser, "micro", "Compile in uSIN mode", {"micro"});
 	args::ValueFlag<std::string> mode(parser, "mode", "Determines how strict the compiler is; accepted options are 'lax', 'normal', or 'strict'", {'m', "mode"});
 
+	// Optimization options
+	args::ValueFlag<unsigned int> opt_level(parser, "level", "The optimization level; accepted options are 0 (the default), 1, or 2", {'O'});
+	args::ValueFlag<std::string> march(parser, "arch", "The instruction set level to target; accepted options are 'x86-64' (the default), 'x86-64-v2', or 'x86-64-v3'", {"march"});
+	args::Flag fp_reassociate(parser, "fp-reassociate", "Allow vectorized loops to sum floating-point values in a different order", {"fp-reassociate"});
+	args::ValueFlag<std::string> fp_contract(parser, "mode", "Whether floating-point multiplies and adds may be fused; accepted options are 'off' (the default) or 'fast'", {"fp-contract"});
+	args::Flag sre_get_rc(parser, "sre-get-rc", "The SRE provides SRE_GET_RC, allowing copy-on-write assignment and taking ownership of returned strings", {"sre-get-rc"});
+
 	// parse arguments
 	try {
 		parser.ParseCLI(argc, argv);
@@ -104,8 +172,55 @@ int main (int argc, char **argv) {
 		
 		bool compile_micro = (use_micro ? args::get(use_micro) : false);
 
-		// get the name for the generated assembly file
-        // remove the extension from the file name and append ".s"
+		// get the optimization level
+		unsigned int optimization_level = opt_level ? args::get(opt_level) : 0;
+		if (optimization_level > pass_manager::MAX_OPT_LEVEL)
+		{
+			throw CompilerException("Argument error: unknown optimization level '" + std::to_string(optimization_level) + "'");
+		}
+
+		// get the target instruction set level
+		std::string arch_name{ march ? args::get(march) : "x86-64" };
+		target_cpu cpu;
+		if (arch_name == "x86-64")
+		{
+			cpu = X86_64;
+		}
+		else if (arch_name == "x86-64-v2")
+		{
+			cpu = X86_64_V2;
+		}
+		else if (arch_name == "x86-64-v3")
+		{
+			cpu = X86_64_V3;
+		}
+		else
+		{
+			throw CompilerException("Argument error: unknown target architecture '" + arch_name + "'");
+		}
+
+		bool reassociate_fp = (fp_reassociate ? args::get(fp_reassociate) : false);
+
+		// get the floating-point contraction mode
+		std::string contract_mode{ fp_contract ? args::get(fp_contract) : "off" };
+		if (contract_mode != "off" && contract_mode != "fast")
+		{
+			throw CompilerException("Argument error: unknown floating-point contraction mode '" + contract_mode + "'");
+		}
+		bool contract_fp = (contract_mode == "fast");
+
+		bool use_get_rc = (sre_get_rc ? args::get(sre_get_rc) : false);
+
+		// get the output type
+		std::string emit_type{ emit ? args::get(emit) : "asm" };
+		if (emit_type != "asm" && emit_type != "obj")
+		{
+			throw CompilerException("Argument error: unknown output type '" + emit_type + "'");
+		}
+		bool emit_obj = (emit_type == "obj");
+
+		// get the name for the output file
+        // remove the extension from the file name and append ".s" (or ".o" for object files)
 		std::string outfile_name;
 
 		if (outfile)
@@ -117,12 +232,42 @@ int main (int argc, char **argv) {
 			size_t last_index = infile_name.find_last_of(".");
 			if (last_index != std::string::npos)
 				outfile_name = infile_name.substr(0, last_index);
-			outfile_name += ".s";
+			outfile_name += emit_obj ? ".o" : ".s";
+		}
+
+		// if we are producing an object file, the assembly is an intermediate (temporary) file
+		std::string asm_name = outfile_name;
+		if (emit_obj && !make_temp_file(asm_name))
+		{
+			std::cerr << "Could not create a temporary file for the assembly" << std::endl;
+			return 1;
 		}
 
 		// create our compiler
-		compiler c { allow_unsafe, use_strict, compile_micro };
-		c.generate_asm(infile_name, outfile_name);
+		compiler c { allow_unsafe, use_strict, compile_micro, optimization_level, cpu, reassociate_fp, contract_fp, use_get_rc };
+		// if compilation failed, the error has already been reported
+		if (!c.generate_asm(infile_name, asm_name))
+		{
+			if (emit_obj)
+			{
+				std::remove(asm_name.c_str());
+			}
+			return 1;
+		}
+
+		if (emit_obj)
+		{
+			// the generated code relies on NASM's preprocessor for the SRE macros, so we assemble with it here
+			std::cout << "Assembling..." << std::endl;
+			bool assembled = assemble(asm_name, outfile_name);
+			std::remove(asm_name.c_str());
+
+			if (!assembled)
+			{
+				std::cerr << "Could not assemble '" << outfile_name << "' (is NASM installed?)" << std::endl;
+				return 1;
+			}
+		}
 	}
 	catch (std::exception &e) {
         std::cout << "Exception occurred: " << e.what() << std::endl;
@@ -142,6 +142,15 @@ attribute AttributeSelection::to_attribute(const std::string& to_convert) {
     else if (to_convert == "var") {
         return VARIABILITY;
     }
+    else if (to_convert == "sum") {
+        return SUM;
+    }
+    else if (to_convert == "min") {
+        return MINIMUM;
+    }
+    else if (to_convert == "max") {
+        return MAXIMUM;
+    }
     else {
         return NO_ATTRIBUTE;
     }
@@ -189,6 +198,14 @@ AttributeSelection::AttributeSelection(std::unique_ptr<Binary>&& to_deconstruct)
 		auto right = static_cast<const KeywordExpression&>(to_deconstruct->get_right());
 		this->attrib = to_attribute(right.get_keyword());
 	}
+	else if (
+		to_deconstruct->get_right().get_expression_type() == IDENTIFIER &&
+		is_attribute(static_cast<const Identifier&>(to_deconstruct->get_right()).getValue())
+	) {
+		// the vector reductions (sum, min, max) aren't keywords, so they get parsed as identifiers
+		this->selected = std::move(to_deconstruct->get_left_unique());
+		this->attrib = to_attribute(static_cast<const Identifier&>(to_deconstruct->get_right()).getValue());
+	}
 	else {
 		this->expression_type = EXPRESSION_GENERAL;
 		this->selected = nullptr;
@@ -212,7 +229,8 @@ AttributeSelection::AttributeSelection(std::unique_ptr<Binary>&& to_deconstruct)
 }
 
 AttributeSelection::AttributeSelection(std::unique_ptr<Expression>&& selected, attribute attrib, const DataType& t)
-	: selected(std::move(selected))
+	: Expression(ATTRIBUTE)
+	, selected(std::move(selected))
 	, attrib(attrib)
 	, t(t) { }
 
@@ -458,10 +476,21 @@ const Expression &Indexed::get_to_index() const
 	return *this->to_index.get();
 }
 
+bool Indexed::is_bounds_checked() const
+{
+	return this->_bounds_checked;
+}
+
+void Indexed::remove_bounds_check()
+{
+	this->_bounds_checked = false;
+}
+
 Indexed::Indexed(std::unique_ptr<Expression> to_index, std::unique_ptr<Expression> index_value)
 	: Expression(INDEXED)
 	, to_index(std::move(to_index))
-	, index_value(std::move(index_value)) { }
+	, index_value(std::move(index_value))
+	, _bounds_checked(true) { }
 
 Indexed::Indexed(): Indexed(nullptr, nullptr)
 {
@@ -121,16 +121,22 @@ class Indexed : public Expression
 {
 	std::unique_ptr<Expression> index_value;	// the index value is simply an expression
 	std::unique_ptr<Expression> to_index;	// what we are indexing
+	bool _bounds_checked;	// cleared by the optimizer when the index is known to be within bounds
 public:
 	const Expression &get_index_value() const;
 	const Expression &get_to_index() const;
 
+	bool is_bounds_checked() const;
+	void remove_bounds_check();
+
 	inline virtual std::unique_ptr<Expression> clone() const override
 	{
-		return std::make_unique<Indexed>(
+		auto c = std::make_unique<Indexed>(
 			to_index->clone(),
 			index_value->clone()
 		);
+		c->_bounds_checked = this->_bounds_checked;
+		return c;
 	}
 
 	Indexed(std::unique_ptr<Expression> to_index, std::unique_ptr<Expression> index_value);
@@ -250,6 +256,12 @@ public:
 class CallExpression : public Procedure
 {
 public:
+	inline virtual std::unique_ptr<Expression> clone() const override
+	{
+		Procedure proc(get_func_name().clone(), get_args().clone());
+		return std::make_unique<CallExpression>(&proc);
+	}
+
 	CallExpression(Procedure *proc);
 	CallExpression(CallExpression& other);
 	CallExpression();
@@ -13,9 +13,9 @@ The implementation of the lexer
 // The list of language keywords
 const std::set<std::string> Lexer::keywords{
 	"alloc", "and", "array", "as", "asm", "bool", "char", "const", 
-	"constexpr", "c64", "decl", "def", "dynamic", "else", "extern", "final", "float", "free", "if", "include", "int", 
-	"len", "let", "long", "move", "not", "null", "or", "pass", "private", "proc", "ptr", "public", "raw", "readonly", "realloc", 
-	"return", "short", "signed", "sincall", "size",  "static", "string", "struct", "tuple", "typename", "unmanaged", "unsigned", "var", "void", 
+	"constexpr", "c64", "decl", "def", "dynamic", "else", "extern", "final", "float", "free", "if", "include", "inline", "int", 
+	"len", "let", "long", "move", "noinline", "not", "null", "or", "pass", "private", "proc", "ptr", "public", "raw", "readonly", "realloc", 
+	"return", "short", "signed", "sincall", "size",  "static", "string", "struct", "tuple", "typename", "unmanaged", "unsigned", "var", "vec", "void", 
 	"while", "windows", "xor"
 };
 
@@ -275,6 +275,17 @@ std::unique_ptr<Statement> Parser::parse_declaration(lexeme current_lex, bool is
 				}
 
 				this->next();	// eat the closing paren
+
+				// qualities (such as the calling convention) may also follow the formal parameters
+				if (this->peek().value == "&") {
+					this->next();
+					symbol_qualities postfixed_qualities = this->get_postfix_qualities();
+					try {
+						symbol_type_data.add_qualities(postfixed_qualities);
+					} catch(std::string &offending_quality) {
+						throw QualityConflictException(offending_quality, this->current_token().line_number);
+					}
+				}
 			}
 			// otherwise, if the name is followed by a colon, we have a default value
 			else if (this->peek().value == ":") {
@@ -292,7 +303,9 @@ std::unique_ptr<Statement> Parser::parse_declaration(lexeme current_lex, bool is
 			
 			// finally, we must have a semicolon, a comma, or a closing paren
 			if (this->peek().value == ";" || this->peek().value == "," || this->peek().value == ")") {
-				stmt = std::make_unique<Declaration>(symbol_type_data, var_name, std::move(initial_value), is_function, false, formal_parameters);
+				// function declarations need to know how the function is called
+				calling_convention call_con = is_function ? Parser::get_calling_convention(symbol_type_data.get_qualities(), next_lexeme.line_number) : SINCALL;
+				stmt = std::make_unique<Declaration>(symbol_type_data, var_name, std::move(initial_value), is_function, false, formal_parameters, call_con);
 				stmt->set_line_number(next_lexeme.line_number);
 			}
 			else if (this->peek().value == ":") {
@@ -220,6 +220,7 @@ bool Parser::is_type(std::string lex_value)
 		"array",
 		"struct",
 		"tuple",
+		"vec",
 		"void"
 	};
 
@@ -404,8 +405,8 @@ DataType Parser::get_type(std::string grouping_symbol)
 		if (this->peek().value == "<") {
 			this->next();	// eat the angle bracket
 
-			// if the next value is a keyword, we can leave array_length_exp as a nullptr
-			if (this->peek().type == KEYWORD_LEX) {
+			// if the next value is a keyword (other than a 'constexpr' length), we can leave array_length_exp as a nullptr
+			if (this->peek().type == KEYWORD_LEX && this->peek().value != "constexpr") {
 				new_var_subtype = this->parse_subtype("<");
 			} else {
 				// parse an expression to obtain the array length; the _current lexeme_ should be the first lexeme of the expression		
@@ -438,6 +439,41 @@ DataType Parser::get_type(std::string grouping_symbol)
 			);
 		}
 	}
+	else if (current_lex.value == "vec") {
+		// vectors are written like arrays, but the number of lanes must be a literal -- it determines which registers and instructions are used
+		new_var_type = VECTOR;
+		if (this->peek().value == "<") {
+			this->next();
+			this->next();
+			if (this->current_token().type != INT_LEX) {
+				throw ParserException(
+					"The number of lanes in a vector must be an integer literal",
+					compiler_errors::INVALID_TYPE_SYNTAX,
+					current_lex.line_number
+				);
+			}
+			array_length_exp = std::make_shared<Literal>(INT, this->current_token().value);
+
+			if (this->peek().value == ",") {
+				this->next();
+				new_var_subtype = this->parse_subtype("<");
+			}
+			else {
+				throw ParserException(
+					"The number of lanes in a vector must be followed by the type",
+					compiler_errors::INVALID_TYPE_SYNTAX,
+					current_lex.line_number
+				);
+			}
+		}
+		else {
+			throw ParserException(
+				"Proper syntax is 'vec< N, T >' where N is the number of lanes and T is the lane type",
+				compiler_errors::INVALID_TYPE_SYNTAX,
+				current_lex.line_number
+			);
+		}
+	}
 	else if (current_lex.value == "tuple") {
 		// tuples contain an arbitrarily long list of types separated by commas
 		new_var_type = TUPLE;
@@ -495,7 +531,7 @@ DataType Parser::get_type(std::string grouping_symbol)
 		// if we have an int, but we haven't pushed back signed/unsigned, default to signed
 		if (current_lex.value == "int") {
 			// if our symbol doesn't have signed or unsigned, set, it must be signed by default
-			if (!qualities.is_signed() && !qualities.is_unsigned()) {
+			if (!qualities.has_sign_quality()) {
 				qualities.add_quality(SIGNED);
 			}
 		}
@@ -528,6 +564,11 @@ DataType Parser::get_type(std::string grouping_symbol)
 	}
 	else {
 		symbol_type_data = DataType(new_var_type, new_var_subtype, qualities, array_length_exp, struct_name);
+
+		// the width of a vector depends on its number of lanes, which is known now
+		if (new_var_type == VECTOR) {
+			symbol_type_data.set_array_length(std::stoul(static_cast<const Literal&>(*array_length_exp).get_value()));
+		}
 	}
 	return symbol_type_data;
 }
@@ -113,6 +113,11 @@ Expression *Declaration::get_initial_value()
 	return this->initial_value.get();
 }
 
+const Expression *Declaration::get_initial_value() const
+{
+	return this->initial_value.get();
+}
+
 std::vector<Statement*> Declaration::get_formal_parameters() {
 	std::vector<Statement*> to_return;
     for (auto it = this->formal_parameters.begin(); it != this->formal_parameters.end(); it++) {
@@ -144,9 +149,10 @@ Declaration::Declaration(const DataType& type, const std::string& var_name, std:
 {
 	this->call_con = SINCALL;
 }
-Declaration::Declaration(const DataType& type, const std::string& var_name, std::unique_ptr<Expression>&& initial_value, bool is_function, bool is_struct, std::vector<std::unique_ptr<Statement>>& formal_parameters)
+Declaration::Declaration(const DataType& type, const std::string& var_name, std::unique_ptr<Expression>&& initial_value, bool is_function, bool is_struct, std::vector<std::unique_ptr<Statement>>& formal_parameters, calling_convention call_con)
 	: Declaration(type, var_name, std::move(initial_value), is_function, is_struct)
 {
+	this->call_con = call_con;
 	for (auto it = formal_parameters.begin(); it != formal_parameters.end(); it++)
 	{
 		this->formal_parameters.push_back(std::move(*it));
@@ -253,6 +259,7 @@ CompoundAssignment::CompoundAssignment(
 	std::unique_ptr<Expression>&& rvalue,
 	exp_operator op
 )	: Assignment(std::move(lvalue), std::make_unique<Binary>(lvalue->clone(), std::move(rvalue), op))
+	, _op(op)
 {
 	this->statement_type = COMPOUND_ASSIGNMENT;
 }
@@ -105,13 +105,14 @@ public:
 	bool is_struct() const;
 
 	Expression *get_initial_value();
+	const Expression *get_initial_value() const;
 
 	std::vector<Statement*> get_formal_parameters();
 	std::vector<const Statement*> get_formal_parameters() const;
 	calling_convention get_calling_convention() const;
 
 	Declaration(const DataType& type, const std::string& var_name, std::unique_ptr<Expression>&& initial_value = std::make_unique<Expression>(EXPRESSION_GENERAL), bool is_function = false, bool is_struct = false);
-	Declaration(const DataType& type, const std::string& var_name, std::unique_ptr<Expression>&& initial_value, bool is_function, bool is_struct, std::vector<std::unique_ptr<Statement>>& formal_parameters);
+	Declaration(const DataType& type, const std::string& var_name, std::unique_ptr<Expression>&& initial_value, bool is_function, bool is_struct, std::vector<std::unique_ptr<Statement>>& formal_parameters, calling_convention call_con = SINCALL);
 	Declaration();
 };
 
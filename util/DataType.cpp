@@ -73,6 +73,15 @@ void DataType::set_width() {
 			it++;
 		}
 	}
+	else if (this->primary == VECTOR) {
+		// vectors are packed lanes of their subtype, and their lane count must be known at compile time
+		if (!this->contained_types.empty()) {
+			this->width = this->array_length * this->get_subtype().get_width();
+		}
+		else {
+			this->width = 0;
+		}
+	}
 	else {
 		/*
 
@@ -100,6 +109,13 @@ void DataType::set_must_free() {
 
     */
 
+    this->_must_free = false;
+
+    // borrowed data is freed by its owner
+    if (this->qualities.is_borrowed()) {
+        return;
+    }
+
     if (
         (
             this->primary == PTR &&
@@ -268,6 +284,14 @@ bool DataType::is_compatible(DataType to_compare) const
 			throw CompilerException("Expected subtype", 0, 0);
 		}
 	}
+	else if (this->primary == VECTOR && to_compare.get_primary() == VECTOR) {
+		// vectors must have the same number of lanes of the same width; lanes may only differ in sign
+		compatible = (
+			this->array_length == to_compare.array_length &&
+			this->get_subtype().get_width() == to_compare.get_subtype().get_width() &&
+			this->get_subtype().is_compatible(to_compare.get_subtype())
+		);
+	}
 	else if (this->primary == TUPLE && to_compare.get_primary() == TUPLE) {
 		// tuples must have the same number of elements, and in the same order, to be compatible
 		if (this->contained_types.size() == to_compare.contained_types.size()) {
@@ -363,6 +387,11 @@ void DataType::set_contained_types(std::vector<DataType> types_list) {
 
 void DataType::set_array_length(size_t new_length) {
 	this->array_length = new_length;
+
+	// the width of a vector depends on its lane count
+	if (this->primary == VECTOR) {
+		this->set_width();
+	}
 }
 
 void DataType::add_qualities(symbol_qualities to_add) {
@@ -384,8 +413,16 @@ void DataType::add_quality(SymbolQuality to_add) {
 		}
 	}
 
-    // update the width
+    // update the width and whether the data must be freed
     this->set_width();
+    this->set_must_free();
+}
+
+void DataType::remove_quality(SymbolQuality to_remove) {
+    // remove a quality from the data type; this may change whether it must be freed
+    this->qualities.remove_quality(to_remove);
+    this->set_width();
+    this->set_must_free();
 }
 
 void DataType::set_struct_name(std::string name) {
@@ -393,6 +430,13 @@ void DataType::set_struct_name(std::string name) {
 	this->struct_name = name;
 }
 
+void DataType::set_struct_width(size_t struct_width) {
+	// Struct widths are only known once the struct has been defined, so they must be supplied from the struct table
+	if (this->primary == STRUCT) {
+		this->width = struct_width;
+	}
+}
+
 size_t DataType::get_width() const {
 	return this->width;
 }
@@ -437,6 +481,18 @@ bool DataType::is_valid_type(const DataType &t) {
 	{
 		return t.qualities.is_managed();
 	}
+	else if (t.primary == VECTOR) {
+		// vectors must fill an SSE or AVX register with 'int', 'long int', 'float', or 'long float' lanes
+		if (t.contained_types.empty()) {
+			is_valid = false;
+		}
+		else {
+			DataType lane = t.get_subtype();
+			is_valid = (lane.primary == INT || lane.primary == FLOAT) && !lane.qualities.is_short() && !lane.qualities.is_dynamic();
+			is_valid = is_valid && (t.width == 16 || t.width == 32);
+			is_valid = is_valid && !t.qualities.is_dynamic() && !t.qualities.is_long() && !t.qualities.is_short() && !t.qualities.has_sign_quality();
+		}
+	}
 
 	// todo: more type checks where needed
 
@@ -504,7 +560,7 @@ DataType::DataType
 	this->array_length = 0;
 	
     // if the type is int, set signed to true if it is not unsigned
-	if (primary == INT && !this->qualities.is_unsigned()) {
+	if (primary == INT && !this->qualities.has_sign_quality()) {
 		this->qualities.add_quality(SIGNED);
 	}
 	else if (primary == FLOAT)
@@ -74,8 +74,10 @@ public:
 
 	void add_qualities(symbol_qualities to_add);
     void add_quality(SymbolQuality to_add);
+    void remove_quality(SymbolQuality to_remove);
 
 	void set_struct_name(std::string name);
+	void set_struct_width(size_t struct_width);
 
 	bool is_compatible(DataType to_compare) const;
 
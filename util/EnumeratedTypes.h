@@ -69,7 +69,10 @@ enum attribute {
 	NO_ATTRIBUTE,
 	LENGTH,
 	SIZE,
-	VARIABILITY
+	VARIABILITY,
+	SUM,
+	MINIMUM,
+	MAXIMUM
 };
 
 enum SymbolType {
@@ -95,7 +98,10 @@ enum SymbolQuality {
 	C64_CONVENTION,
 	WINDOWS_CONVENTION,
 	EXTERN,
-    UNMANAGED
+    UNMANAGED,
+    BORROWED,   // set by the optimizer; has no keyword
+    INLINE,     // inlining hints; only meaningful on function definitions
+    NOINLINE
 };
 
 
@@ -164,7 +170,8 @@ enum Type {
 	RAW,
 	ARRAY,
 	STRUCT,
-	TUPLE
+	TUPLE,
+	VECTOR
 };
 
 enum reg {
@@ -209,3 +216,10 @@ enum calling_convention {
 	SYSTEM_V,
 	WIN_64
 };
+
+enum target_cpu {
+	// The instruction set levels the generated code may target (selected with --march)
+	X86_64,	// the baseline, with SSE and SSE2
+	X86_64_V2,	// adds SSE3, SSSE3, SSE4.1, SSE4.2, and POPCNT
+	X86_64_V3	// adds AVX, AVX2, BMI1, BMI2, and FMA3
+};
@@ -75,3 +75,46 @@ bool general_utilities::is_bitwise(const exp_operator op) {
 
     return (op == BIT_AND || op == BIT_OR || op == BIT_XOR || op == BIT_NOT);
 }
+
+bool general_utilities::is_relational(const exp_operator op) {
+    /*
+
+    is_relational
+    Returns whether the operator is a comparison operator (yielding a boolean from two operands)
+
+    */
+
+    return (
+        op == EQUAL || op == NOT_EQUAL ||
+        op == GREATER || op == LESS ||
+        op == GREATER_OR_EQUAL || op == LESS_OR_EQUAL
+    );
+}
+
+exp_operator general_utilities::negate_relational(const exp_operator op) {
+    /*
+
+    negate_relational
+    Returns the comparison operator that yields the opposite result of the one given
+
+    Note that this does not hold for unordered floating-point comparisons (NaN)
+
+    */
+
+    switch (op) {
+    case EQUAL:
+        return NOT_EQUAL;
+    case NOT_EQUAL:
+        return EQUAL;
+    case GREATER:
+        return LESS_OR_EQUAL;
+    case LESS:
+        return GREATER_OR_EQUAL;
+    case GREATER_OR_EQUAL:
+        return LESS;
+    case LESS_OR_EQUAL:
+        return GREATER;
+    default:
+        return NO_OP;
+    }
+}
@@ -15,9 +15,12 @@ Contains some general compiler utilities
 
 namespace general_utilities {
     const int BASE_PARAMETER_OFFSET = 16;
+    const int SYSTEM_V_PARAMETER_OFFSET = 56;   // saved rbp, rbx, r12 - r15, and the return address
 
     bool returns(const StatementBlock& to_check);
     bool returns(const Statement &to_check);
     bool ite_returns(const IfThenElse *to_check);
     bool is_bitwise(const exp_operator op);
+    bool is_relational(const exp_operator op);
+    exp_operator negate_relational(const exp_operator op);
 }
@@ -23,7 +23,9 @@ const std::unordered_map<std::string, SymbolQuality> symbol_qualities::quality_s
 	{ "c64", C64_CONVENTION },
 	{ "windows", WINDOWS_CONVENTION },
 	{ "extern", EXTERN },
-    { "unmanaged", UNMANAGED }
+    { "unmanaged", UNMANAGED },
+    { "inline", INLINE },
+    { "noinline", NOINLINE }
 };
 
 bool symbol_qualities::operator==(const symbol_qualities& right) const {
@@ -101,6 +103,21 @@ bool symbol_qualities::is_managed() const
     return _managed;
 }
 
+bool symbol_qualities::is_borrowed() const
+{
+    return _borrowed;
+}
+
+bool symbol_qualities::is_inline() const
+{
+    return _inline;
+}
+
+bool symbol_qualities::is_noinline() const
+{
+    return _noinline;
+}
+
 bool symbol_qualities::is_sincall() const
 {
 	return sincall_con;
@@ -129,12 +146,14 @@ void symbol_qualities::add_qualities(symbol_qualities to_add) {
 	if (to_add.long_q) this->add_quality(LONG);
 	if (to_add.short_q) this->add_quality(SHORT);
 	if (to_add.signed_q) this->add_quality(SIGNED);
-	if (to_add.is_unsigned()) this->add_quality(UNSIGNED);
+	if (to_add._listed_unsigned) this->add_quality(UNSIGNED);
 	if (to_add.sincall_con) this->add_quality(SINCALL_CONVENTION);
 	if (to_add.c64_con) this->add_quality(C64_CONVENTION);
 	if (to_add.windows_con) this->add_quality(WINDOWS_CONVENTION);
 	if (to_add.extern_q) this->add_quality(EXTERN);
     if (!to_add._managed) this->add_quality(UNMANAGED);
+    if (to_add._inline) this->add_quality(INLINE);
+    if (to_add._noinline) this->add_quality(NOINLINE);
 }
 
 void symbol_qualities::add_quality(SymbolQuality to_add)
@@ -156,8 +175,10 @@ void symbol_qualities::add_quality(SymbolQuality to_add)
         dynamic_q = true;
     } else if (to_add == SIGNED) {
         signed_q = true;
+        _listed_unsigned = false;
     } else if (to_add == UNSIGNED) {
         signed_q = false;
+        _listed_unsigned = true;
 	}
 	else if (to_add == LONG) {
 		long_q = true;
@@ -186,6 +207,19 @@ void symbol_qualities::add_quality(SymbolQuality to_add)
 	}
     else if (to_add == UNMANAGED) {
         _managed = false;
+    }
+    else if (to_add == BORROWED) {
+        _borrowed = true;
+    }
+    else if (to_add == INLINE) {
+        _inline = true;
+
+        // a function can't be both
+        if (_noinline) throw std::string("inline");
+    }
+    else if (to_add == NOINLINE) {
+        _noinline = true;
+        if (_inline) throw std::string("noinline");
     }
 	else {
 		// invalid quality; throw an exception
@@ -193,6 +227,25 @@ void symbol_qualities::add_quality(SymbolQuality to_add)
 	}
 }
 
+void symbol_qualities::remove_quality(SymbolQuality to_remove)
+{
+    // Remove a single storage or linkage quality; sign, width, and calling convention qualities must be replaced with add_quality instead
+    if (to_remove == CONSTANT) {
+        const_q = false;
+    } else if (to_remove == FINAL) {
+        final_q = false;
+    } else if (to_remove == STATIC) {
+        static_q = false;
+    } else if (to_remove == DYNAMIC) {
+        dynamic_q = false;
+    } else if (to_remove == EXTERN) {
+        extern_q = false;
+    }
+    else {
+        throw CompilerException("Quality cannot be removed");	// todo: proper exception type
+    }
+}
+
 symbol_qualities::symbol_qualities(std::vector<SymbolQuality> qualities):
     symbol_qualities()
 {
@@ -242,6 +295,12 @@ symbol_qualities::symbol_qualities(std::vector<SymbolQuality> qualities):
 		}
         else if (*it == UNMANAGED) {
             _managed = false;
+        }
+        else if (*it == INLINE) {
+            _inline = true;
+        }
+        else if (*it == NOINLINE) {
+            _noinline = true;
         }
 		else {
 			continue;
@@ -277,7 +336,11 @@ symbol_qualities::symbol_qualities(bool is_const, bool is_static, bool is_dynami
 	this->sincall_con = false;
 	this->c64_con = false;
 	this->windows_con = false;
+    this->_listed_unsigned = false;
     this->_managed = true;
+    this->_borrowed = false;
+    this->_inline = false;
+    this->_noinline = false;
 }
 
 symbol_qualities::symbol_qualities()
@@ -297,6 +360,9 @@ symbol_qualities::symbol_qualities()
 
     _listed_unsigned = false;
     _managed = true;
+    _borrowed = false;
+    _inline = false;
+    _noinline = false;
 }
 
 symbol_qualities::~symbol_qualities()
@@ -29,6 +29,9 @@ class symbol_qualities
 	bool short_q;
 	bool extern_q;
     bool _managed;
+    bool _borrowed;   // a parameter that refers to the caller's object rather than a copy; see opt/rc_elimination.h
+    bool _inline;   // inlining hints for function definitions; see opt/inliner.h
+    bool _noinline;
 
 	// function qualities -- for calling conventions, unused by other data
 	// todo: create additional, inherited class 'function_symbol_qualities' to use with functions?
@@ -51,6 +54,9 @@ public:
 	bool is_short() const;
 	bool is_extern() const;
     bool is_managed() const;
+    bool is_borrowed() const;
+    bool is_inline() const;
+    bool is_noinline() const;
 
 	// function-specific qualities
 	bool is_sincall() const;
@@ -62,6 +68,7 @@ public:
 	// void add_qualities(std::vector<SymbolQuality> to_add);
 	void add_qualities(symbol_qualities to_add);
     void add_quality(SymbolQuality to_add);
+    void remove_quality(SymbolQuality to_remove);
 
 	symbol_qualities(std::vector<SymbolQuality> qualities);
 	symbol_qualities(bool is_const, bool is_static, bool is_dynamic, bool is_signed, bool is_long = false, bool is_short = false, bool is_extern = false);